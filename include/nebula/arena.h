@@ -0,0 +1,383 @@
+/*
+ * arena.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_ARENA_H_
+#define _BrianZ_NEBULA_ARENA_H_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <new>
+#include "nebula/attributes.h"
+#include "nebula/standard.h"
+
+namespace nebula
+{
+  /*
+   * Description:
+   *   Region allocator: memory is handed out by bumping a pointer through
+   *   large chunks, and only given back all at once, by rewind() to an
+   *   earlier mark(), reset() or destruction.  Allocating is a compare and
+   *   an add, and a set of objects which die together (everything built
+   *   for a request, a parsed line, ...) is freed without visiting them.
+   *
+   *   Objects created with create() have their destructor run when their
+   *   memory is released, in reverse order of creation; memory from
+   *   allocate() is raw.  An arena is not thread safe, threadLocal() gives
+   *   every thread its own.
+   *
+   *   Usage:
+   *
+   *     nebula::ArenaScope scope(nebula::Arena::threadLocal());
+   *     Request * req = scope.arena().create<Request>();
+   *     char * copy = scope.arena().strdup(line, len);
+   *     ...
+   *     // all released when `scope' goes away
+   */
+  class Arena: public Standard::NoCopy
+  {
+  public:
+    enum
+    {
+      DEFAULT_CHUNK_SIZE = 64 << 10,
+      // alignment of allocate() by default, enough for any scalar type
+      DEFAULT_ALIGNMENT = 16,
+    };
+
+    typedef void (*Destructor)(void * object);
+
+  private:
+    struct Chunk
+    {
+      Chunk * prev;
+      size_t size;              // including this header
+    };
+
+    struct Cleanup
+    {
+      Cleanup * prev;
+      Destructor destructor;
+      void * object;
+    };
+
+    Chunk * chunk_;             // newest chunk, NULL before the first allocation
+    char * ptr_;
+    char * end_;
+    Chunk * large_;             // newest chunk of a single large allocation
+    Chunk * spare_;             // a released chunk kept for reuse
+    Cleanup * cleanups_;
+    size_t chunk_size_;
+    size_t bytes_allocated_;    // in chunks, including the spare
+
+    static pthread_once_t key_created_;
+    static pthread_key_t key_;
+
+    void * allocateSlow(size_t size, size_t align);
+    void releaseChunk(Chunk * chunk);
+    static void createKey();
+    static void destroyThreadArena(void * arena);
+
+    template<typename T>
+    static void destroy(void * object)
+    {
+      ((T *) object)->~T();
+    }
+
+    int addCleanup(Destructor destructor, void * object);
+
+  public:
+    /*
+     * A position in the arena; rewinding to it releases everything
+     * allocated after it was taken.
+     */
+    struct Mark
+    {
+      Chunk * chunk;
+      char * ptr;
+      Chunk * large;
+      Cleanup * cleanups;
+    };
+
+    /*
+     * `chunk_size' is the size of the chunks requested from malloc(),
+     * allocations larger than a quarter of it get a chunk of their own,
+     * leaving the current chunk in use for the smaller ones.
+     */
+    explicit Arena(size_t chunk_size = DEFAULT_CHUNK_SIZE);
+    ~Arena();
+
+    /*
+     * Description:
+     *   `size' bytes aligned on `align', a power of two.
+     * Return value:
+     *   NULL with errno set to ENOMEM if malloc() failed.
+     */
+    void * allocate(size_t size, size_t align = DEFAULT_ALIGNMENT)
+    {
+      char * p = (char *) (((uintptr_t) ptr_ + align - 1) & ~(uintptr_t) (align - 1));
+      if (likely(p < end_ && size <= (size_t) (end_ - p))) {
+        ptr_ = p + size;
+        return p;
+      }
+      return allocateSlow(size, align);
+    }
+
+    // array of `n' uninitialized T
+    template<typename T>
+    T * allocateArray(size_t n)
+    {
+      if (n > (size_t) -1 / sizeof(T)) {
+        return NULL;
+      }
+      return (T *) allocate(n * sizeof(T), __alignof__(T));
+    }
+
+    /*
+     * Description:
+     *   Default constructed T, destroyed when released if its destructor
+     *   is not trivial.
+     * Return value:
+     *   NULL with errno set to ENOMEM if malloc() failed.
+     */
+    template<typename T>
+    T * create()
+    {
+      void * p = allocate(sizeof(T), __alignof__(T));
+      if (!p) {
+        return NULL;
+      }
+      T * object = new (p) T();
+      if (!__has_trivial_destructor(T) && addCleanup(destroy<T>, object) < 0) {
+        object->~T();
+        return NULL;
+      }
+      return object;
+    }
+
+    // copy constructed T, as create()
+    template<typename T>
+    T * create(const T & value)
+    {
+      void * p = allocate(sizeof(T), __alignof__(T));
+      if (!p) {
+        return NULL;
+      }
+      T * object = new (p) T(value);
+      if (!__has_trivial_destructor(T) && addCleanup(destroy<T>, object) < 0) {
+        object->~T();
+        return NULL;
+      }
+      return object;
+    }
+
+    // NUL terminated copy of `len' bytes at `s'
+    char * strdup(const char * s, size_t len)
+    {
+      char * p = (char *) allocate(len + 1, 1);
+      if (p) {
+        ::memcpy(p, s, len);
+        p[len] = '\0';
+      }
+      return p;
+    }
+
+    char * strdup(const char * s)
+    {
+      return strdup(s, ::strlen(s));
+    }
+
+    Mark mark() const
+    {
+      Mark m = { chunk_, ptr_, large_, cleanups_ };
+      return m;
+    }
+
+    /*
+     * Description:
+     *   Release everything allocated since `m' was taken, running the
+     *   destructors of the objects created since.  Marks taken after `m'
+     *   become invalid.
+     */
+    void rewind(const Mark & m);
+
+    // release everything, keeping one chunk for reuse
+    void reset()
+    {
+      Mark m = { NULL, NULL, NULL, NULL };
+      rewind(m);
+    }
+
+    // bytes obtained from malloc()
+    size_t bytesAllocated() const
+    {
+      return bytes_allocated_;
+    }
+
+    /*
+     * Description:
+     *   Arena of the calling thread, created on first use and destroyed
+     *   when the thread exits.  Released through ArenaScope, it keeps its
+     *   chunks from one use to the next.
+     * Return value:
+     *   The arena, or NULL with errno set to ENOMEM.
+     */
+    static Arena * threadLocal();
+  };
+
+  /*
+   * Description:
+   *   Rewinds an arena on destruction to where it was on construction.
+   *   Scopes nest, and must be destroyed in reverse order.
+   */
+  class ArenaScope: public Standard::NoCopy
+  {
+  private:
+    Arena * arena_;
+    Arena::Mark mark_;
+
+  public:
+    explicit ArenaScope(Arena * arena) :
+      arena_(arena), mark_(arena->mark())
+    {
+    }
+
+    ~ArenaScope()
+    {
+      arena_->rewind(mark_);
+    }
+
+    Arena & arena() const
+    {
+      return *arena_;
+    }
+  };
+
+  /*
+   * Description:
+   *   Standard allocator drawing from an Arena, for containers living
+   *   within the scope of the arena.  deallocate() releases nothing, the
+   *   memory returns with the arena; a growing std::vector thus leaves its
+   *   old buffers behind, reserve() ahead where it matters.  Like every
+   *   standard allocator it throws std::bad_alloc when out of memory.
+   *
+   *     typedef std::vector<int, nebula::ArenaAllocator<int> > IntVector;
+   *     IntVector v((nebula::ArenaAllocator<int>(arena)));
+   */
+  template<typename T>
+  class ArenaAllocator
+  {
+  private:
+    template<typename U>
+    friend class ArenaAllocator;
+
+    Arena * arena_;
+
+  public:
+    typedef T value_type;
+    typedef T * pointer;
+    typedef const T * const_pointer;
+    typedef T & reference;
+    typedef const T & const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template<typename U>
+    struct rebind
+    {
+      typedef ArenaAllocator<U> other;
+    };
+
+    explicit ArenaAllocator(Arena * arena) :
+      arena_(arena)
+    {
+    }
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U> & other) :
+      arena_(other.arena_)
+    {
+    }
+
+    Arena * arena() const
+    {
+      return arena_;
+    }
+
+    pointer allocate(size_type n, const void * hint = NULL)
+    {
+      (void) hint;
+      pointer p = arena_->allocateArray<T>(n);
+      if (!p) {
+        throw std::bad_alloc();
+      }
+      return p;
+    }
+
+    void deallocate(pointer, size_type)
+    {
+    }
+
+    size_type max_size() const
+    {
+      return (size_type) -1 / sizeof(T);
+    }
+
+    pointer address(reference x) const
+    {
+      return &x;
+    }
+
+    const_pointer address(const_reference x) const
+    {
+      return &x;
+    }
+
+    void construct(pointer p, const T & value)
+    {
+      new (p) T(value);
+    }
+
+    void destroy(pointer p)
+    {
+      p->~T();
+    }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U> & other) const
+    {
+      return arena_ == other.arena_;
+    }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U> & other) const
+    {
+      return arena_ != other.arena_;
+    }
+  };
+}
+
+#endif /* _BrianZ_NEBULA_ARENA_H_ */
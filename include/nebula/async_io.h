@@ -28,6 +28,7 @@
 #define _BrianZ_NEBULA_ASYNC_IO_H_
 
 #include <errno.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/types.h>
@@ -36,6 +37,7 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include "nebula/standard.h"
 
 namespace nebula
 {
@@ -218,6 +220,70 @@ namespace nebula
       return createAsyncUnixClientSocket(fs_pathname, 0);
     }
 
+    // Zero copy ------------------------------------------------------------------------------------------------------
+
+    /*
+     * Description:
+     *   sendfile() up to `count' bytes of `in_fd' (a regular file) from
+     *   `*offset' to `out_sockfd', until done or the socket is full; the
+     *   offset is advanced, the file position is not used.
+     * Return value:
+     *   Bytes sent, 0 at end of file, -1 with errno set on error (EAGAIN
+     *   if the socket is full before anything was sent).
+     */
+    static ssize_t sendFile(int out_sockfd, int in_fd, off_t * offset, size_t count);
+
+    /*
+     * Description:
+     *   One non-blocking splice() of up to `len' bytes, one of the two
+     *   descriptors must be a pipe; a NULL offset means the file position.
+     * Return value:
+     *   Bytes moved, 0 at end of input, -1 with errno set on error (EAGAIN
+     *   when the pipe is full or empty, or the socket would block).
+     */
+    static ssize_t splice(int in_fd, off_t * in_off, int out_fd, off_t * out_off, size_t len);
+
+    /*
+     * Description:
+     *   One non-blocking tee(), duplicating up to `len' bytes from the front
+     *   of pipe `in_pipe' into pipe `out_pipe' without consuming them.
+     * Return value:
+     *   As splice().
+     */
+    static ssize_t tee(int in_pipe, int out_pipe, size_t len);
+
+    /*
+     * Description:
+     *   Copies `len' bytes between two files inside the kernel, sharing the
+     *   extents on file systems which support it.  Where copy_file_range()
+     *   is not available (old kernels, different file systems before 5.3)
+     *   the data goes through a pooled pipe with splice().  A NULL offset
+     *   means the file position.  Blocking.
+     * Return value:
+     *   Bytes copied, less than `len' only at end of input, -1 with errno
+     *   set if nothing could be copied.
+     */
+    static ssize_t copyFileRange(int in_fd, off_t * in_off, int out_fd, off_t * out_off, size_t len);
+
+    /*
+     * Description:
+     *   Gets an empty non-blocking close-on-exec pipe, from a process wide
+     *   pool if possible, resized to PIPE_SIZE where permitted.
+     * Return value:
+     *   0      ok
+     *   -1     error, errno set
+     */
+    static int acquirePipe(int pipefd[2]);
+
+    // gives a pipe back to the pool if it is `empty', closes it otherwise
+    static void releasePipe(int pipefd[2], bool empty);
+
+    enum
+    {
+      PIPE_SIZE = 256 << 10, // bytes a pooled pipe is asked to hold
+      MAX_POOLED_PIPES = 64,
+    };
+
   private:
     AsyncIo();
     ~AsyncIo();
@@ -228,6 +294,64 @@ namespace nebula
     static int createAsyncUnixServerSocket(const char * fs_pathname, int use_tcp);
     static int createAsyncUnixClientSocket(const char * fs_pathname, int use_tcp);
   };
+
+  /*
+   * Description:
+   *   Pipe from the pool of AsyncIo used to move data between descriptors
+   *   without copying it into user space, e.g. from one socket to another:
+   *   fill() splices from the input into the pipe, drain() from the pipe
+   *   to the output, and what the output did not take stays in the pipe
+   *   until it is writable again.  The pipe is acquired on first use and
+   *   given back when the object is released or destroyed.
+   */
+  class SplicePipe: public Standard::NoCopy
+  {
+  private:
+    int fds_[2];
+    size_t buffered_;
+
+  public:
+    SplicePipe() :
+      buffered_(0)
+    {
+      fds_[0] = fds_[1] = -1;
+    }
+
+    ~SplicePipe()
+    {
+      release();
+    }
+
+    // bytes in the pipe
+    size_t buffered() const
+    {
+      return buffered_;
+    }
+
+    /*
+     * Description:
+     *   Moves up to `len' bytes from `in_fd' into the pipe, from `*in_off'
+     *   if it is not NULL.
+     * Return value:
+     *   As AsyncIo::splice(), or -1 with errno set if no pipe is available.
+     */
+    ssize_t fill(int in_fd, size_t len, off_t * in_off = NULL);
+
+    // moves up to `len' buffered bytes to `out_fd', the return value is as AsyncIo::splice()
+    ssize_t drain(int out_fd, size_t len, off_t * out_off = NULL);
+
+    /*
+     * Description:
+     *   Duplicates up to `len' buffered bytes into `other', e.g. to mirror
+     *   a stream, they stay in this pipe as well.
+     * Return value:
+     *   As AsyncIo::tee().
+     */
+    ssize_t tee(SplicePipe & other, size_t len);
+
+    // back to the pool, any buffered bytes are dropped
+    void release();
+  };
 }
 
 #endif /* _BrianZ_NEBULA_ASYNC_IO_H_ */
@@ -47,6 +47,7 @@
 #define WARN_UNUSED_RESULT        __attribute__((warn_unused_result))
 #define UNUSED                    __attribute__((unused))
 #define DEPRECATED                __attribute__((deprecated))
+#define TARGET(X)                 __attribute__((target(X)))
 #else
 #define PRINTF_FORMAT(M, N)
 #define SCANF_FORMAT(M, N)
@@ -59,6 +60,7 @@
 #define WARN_UNUSED_RESULT
 #define UNUSED
 #define DEPRECATED
+#define TARGET(X)
 #endif
 
 #endif /* _BrianZ_NEBULA_ATTRIBUTES_H_ */
@@ -0,0 +1,327 @@
+/*
+ * big_int.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_BIG_INT_H_
+#define _BrianZ_NEBULA_BIG_INT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+namespace nebula
+{
+  /*
+   * Description:
+   *   Arbitrary-precision signed integer, sign and magnitude, the magnitude
+   *   being little endian 64-bit limbs.  Values up to INLINE_LIMBS limbs
+   *   (128 bits) live inside the object, larger ones on the heap; running
+   *   out of memory aborts, like the operators of a built-in integer type
+   *   cannot report it.
+   *
+   *   Multiplication is schoolbook below KARATSUBA_THRESHOLD limbs and
+   *   Karatsuba above it; division by a single limb uses a precomputed
+   *   reciprocal instead of a hardware divide per limb, longer divisors
+   *   Knuth's algorithm D.  Division truncates toward zero and the
+   *   remainder takes the sign of the dividend, as in C.  Decimal strings
+   *   are converted divide and conquer, split around 10^(19 * 2^k), so
+   *   that parsing a long number costs a few Karatsuba products rather
+   *   than one multiply-add pass per 19 digits.
+   */
+  class BigInt
+  {
+  public:
+    enum
+    {
+      INLINE_LIMBS = 2,
+      // default of karatsubaThreshold(), chosen with poc/bigint_bench.cc
+      KARATSUBA_THRESHOLD = 32,
+      // below this many limbs conversions to and from decimal are linear
+      // passes of 19 digits per step, above it they split recursively
+      CONVERSION_THRESHOLD = 40,
+    };
+
+  private:
+    uint64_t * limbs_;
+    uint32_t size_;             // significant limbs, 0 for zero
+    uint32_t capacity_;
+    bool negative_;             // never set for zero
+    uint64_t inline_[INLINE_LIMBS];
+
+    void reserve(size_t n);
+    // set the number of limbs, new ones are not initialized
+    void resize(size_t n);
+    void trim();
+    void assignU64(uint64_t v);
+
+    static void addAbs(const BigInt & a, const BigInt & b, BigInt * r);
+    // |a| - |b|, requires |a| >= |b|
+    static void subAbs(const BigInt & a, const BigInt & b, BigInt * r);
+    static void addSigned(const BigInt & a, const BigInt & b, bool negate_b, BigInt * r);
+
+  public:
+    BigInt() :
+      limbs_(inline_), size_(0), capacity_(INLINE_LIMBS), negative_(false)
+    {
+    }
+
+    BigInt(int64_t v) :
+      limbs_(inline_), size_(0), capacity_(INLINE_LIMBS), negative_(false)
+    {
+      assignU64(v < 0 ? -(uint64_t) v : (uint64_t) v);
+      negative_ = v < 0;
+    }
+
+    BigInt(const BigInt & other);
+
+    ~BigInt()
+    {
+      if (limbs_ != inline_) {
+        ::free(limbs_);
+      }
+    }
+
+    BigInt & operator=(const BigInt & other);
+
+    static BigInt fromU64(uint64_t v)
+    {
+      BigInt r;
+      r.assignU64(v);
+      return r;
+    }
+
+    void swap(BigInt & other);
+
+    /*
+     * Description:
+     *   Parse an optional sign followed by decimal digits, or by "0x" (or
+     *   "0X") and hexadecimal digits.
+     * Return value:
+     *   0 on success, -1 with errno set to EINVAL if `s' is not a number,
+     *   in which case `out' is not modified.
+     */
+    static int parse(const char * s, size_t len, BigInt * out);
+
+    static int parse(const char * s, BigInt * out)
+    {
+      return parse(s, ::strlen(s), out);
+    }
+
+    /*
+     * Description:
+     *   Decimal (`base' 10) or hexadecimal with a "0x" prefix (`base' 16)
+     *   representation; any other `base' is treated as 10.
+     */
+    std::string toString(int base = 10) const;
+
+    bool isZero() const
+    {
+      return !size_;
+    }
+
+    bool isNegative() const
+    {
+      return negative_;
+    }
+
+    size_t numLimbs() const
+    {
+      return size_;
+    }
+
+    // limb `i' of the magnitude, 0 beyond the most significant one
+    uint64_t limb(size_t i) const
+    {
+      return i < size_ ? limbs_[i] : 0;
+    }
+
+    size_t bitLength() const
+    {
+      return size_ ? (size_t) size_ * 64 - __builtin_clzll(limbs_[size_ - 1]) : 0;
+    }
+
+    bool fitsI64() const
+    {
+      return size_ <= 1 && (size_ == 0 || limbs_[0] <= (uint64_t) INT64_MAX + negative_);
+    }
+
+    // the value modulo 2^64 in two's complement, exact if fitsI64()
+    int64_t toI64() const
+    {
+      uint64_t v = size_ ? limbs_[0] : 0;
+      return (int64_t) (negative_ ? -v : v);
+    }
+
+    /*
+     * Return value:
+     *   negative, zero or positive as `*this' is less than, equal to or
+     *   greater than `other'.
+     */
+    int compare(const BigInt & other) const;
+    // same, of the absolute values
+    int compareAbs(const BigInt & other) const;
+
+    /*
+     * Description:
+     *   Quotient and remainder of `a' divided by `b'; either of `q' and `r'
+     *   may be NULL, and may be the same object as `a' or `b'.
+     * Return value:
+     *   0 on success, -1 with errno set to EDOM if `b' is zero.
+     */
+    static int divMod(const BigInt & a, const BigInt & b, BigInt * q, BigInt * r);
+
+    /*
+     * Description:
+     *   Divide the magnitude by `d' (non zero) in place, keeping the sign.
+     * Return value:
+     *   Remainder of the magnitude, in [0, d).
+     */
+    uint64_t divModSmall(uint64_t d);
+
+    // multiply the magnitude by `m', then add `a' to it
+    void mulAddSmall(uint64_t m, uint64_t a);
+
+    static BigInt pow(const BigInt & base, uint32_t exponent);
+
+    /*
+     * Description:
+     *   Operand length, in limbs, from which multiplication switches from
+     *   schoolbook to Karatsuba; process wide, meant for benchmarks and
+     *   tests.  Values below 4 are raised to 4.
+     */
+    static size_t karatsubaThreshold();
+    static void setKaratsubaThreshold(size_t limbs);
+
+    BigInt operator-() const
+    {
+      BigInt r(*this);
+      r.negative_ = r.size_ && !negative_;
+      return r;
+    }
+
+    BigInt & operator+=(const BigInt & other)
+    {
+      addSigned(*this, other, false, this);
+      return *this;
+    }
+
+    BigInt & operator-=(const BigInt & other)
+    {
+      addSigned(*this, other, true, this);
+      return *this;
+    }
+
+    BigInt & operator*=(const BigInt & other);
+    // dividing by zero leaves the value unchanged, see divMod()
+    BigInt & operator/=(const BigInt & other);
+    BigInt & operator%=(const BigInt & other);
+    BigInt & operator<<=(size_t bits);
+    // shifts the magnitude, i.e. rounds toward zero
+    BigInt & operator>>=(size_t bits);
+  };
+
+  inline BigInt operator+(const BigInt & a, const BigInt & b)
+  {
+    BigInt r(a);
+    r += b;
+    return r;
+  }
+
+  inline BigInt operator-(const BigInt & a, const BigInt & b)
+  {
+    BigInt r(a);
+    r -= b;
+    return r;
+  }
+
+  inline BigInt operator*(const BigInt & a, const BigInt & b)
+  {
+    BigInt r(a);
+    r *= b;
+    return r;
+  }
+
+  inline BigInt operator/(const BigInt & a, const BigInt & b)
+  {
+    BigInt r(a);
+    r /= b;
+    return r;
+  }
+
+  inline BigInt operator%(const BigInt & a, const BigInt & b)
+  {
+    BigInt r(a);
+    r %= b;
+    return r;
+  }
+
+  inline BigInt operator<<(const BigInt & a, size_t bits)
+  {
+    BigInt r(a);
+    r <<= bits;
+    return r;
+  }
+
+  inline BigInt operator>>(const BigInt & a, size_t bits)
+  {
+    BigInt r(a);
+    r >>= bits;
+    return r;
+  }
+
+  inline bool operator==(const BigInt & a, const BigInt & b)
+  {
+    return a.compare(b) == 0;
+  }
+
+  inline bool operator!=(const BigInt & a, const BigInt & b)
+  {
+    return a.compare(b) != 0;
+  }
+
+  inline bool operator<(const BigInt & a, const BigInt & b)
+  {
+    return a.compare(b) < 0;
+  }
+
+  inline bool operator<=(const BigInt & a, const BigInt & b)
+  {
+    return a.compare(b) <= 0;
+  }
+
+  inline bool operator>(const BigInt & a, const BigInt & b)
+  {
+    return a.compare(b) > 0;
+  }
+
+  inline bool operator>=(const BigInt & a, const BigInt & b)
+  {
+    return a.compare(b) >= 0;
+  }
+}
+
+#endif /* _BrianZ_NEBULA_BIG_INT_H_ */
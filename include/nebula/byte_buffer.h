@@ -0,0 +1,515 @@
+/*
+ * byte_buffer.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_BYTE_BUFFER_H_
+#define _BrianZ_NEBULA_BYTE_BUFFER_H_
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "nebula/attributes.h"
+#include "nebula/endian.h"
+#include "nebula/standard.h"
+
+namespace nebula
+{
+  /*
+   * Description:
+   *   Encoding and decoding helpers shared by ByteWriter and ByteReader.
+   *   Varints are LEB128: 7 bits per byte, least significant group first,
+   *   the high bit set on every byte but the last, so values below 128 take
+   *   one byte and a uint64_t at most 10.  Signed varints are zig-zag
+   *   encoded first (0, -1, 1, -2, ... become 0, 1, 2, 3, ...) so that small
+   *   negative values stay short.
+   */
+  struct Varint
+  {
+    enum
+    {
+      MAX_LENGTH_32 = 5, MAX_LENGTH_64 = 10
+    };
+
+    static uint32_t zigZag32(int32_t v)
+    {
+      return ((uint32_t) v << 1) ^ (uint32_t) (v >> 31);
+    }
+
+    static uint64_t zigZag64(int64_t v)
+    {
+      return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+    }
+
+    static int32_t unZigZag32(uint32_t v)
+    {
+      return (int32_t) ((v >> 1) ^ -(v & 1));
+    }
+
+    static int64_t unZigZag64(uint64_t v)
+    {
+      return (int64_t) ((v >> 1) ^ -(v & 1));
+    }
+
+    static size_t length(uint64_t v)
+    {
+      // 1 + (index of the highest set bit) / 7, computed without a loop
+      int bits = 64 - __builtin_clzll(v | 1);
+      return (bits * 9 + 64) / 64;
+    }
+
+    /*
+     * Description:
+     *   Encode `v' at `p', which must have room for MAX_LENGTH_64 bytes.
+     * Return value:
+     *   Number of bytes written.
+     */
+    static size_t encode(uint8_t * p, uint64_t v)
+    {
+      uint8_t * start = p;
+      while (v >= 0x80) {
+        *p++ = (uint8_t) (v | 0x80);
+        v >>= 7;
+      }
+      *p++ = (uint8_t) v;
+      return p - start;
+    }
+
+    /*
+     * Description:
+     *   Decode a varint from the `len' bytes at `p'.  When at least 8 bytes
+     *   are available, varints of up to 8 bytes (values below 2^56) are
+     *   decoded from a single unaligned load without a loop.
+     * Return value:
+     *   Number of bytes consumed, 0 if the input ends before the varint
+     *   (ENODATA) or if it is longer than 10 bytes or exceeds 64 bits
+     *   (EBADMSG), errno is set in both cases.
+     */
+    static size_t decode(const uint8_t * p, size_t len, uint64_t * out)
+    {
+      if (likely(len > 0 && p[0] < 0x80)) {
+        *out = p[0];
+        return 1;
+      }
+      if (likely(len >= 8)) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        word = Endian::fromLe64(word);
+        uint64_t stops = ~word & 0x8080808080808080ULL;
+        if (likely(stops != 0)) {
+          size_t n = (__builtin_ctzll(stops) + 1) / 8; // index of the last byte, plus one
+          uint64_t x = word & (~0ULL >> (64 - 8 * n)) & 0x7f7f7f7f7f7f7f7fULL;
+          // squeeze the 7 bit groups together: pairs, quads, then the two halves
+          x = (x & 0x007f007f007f007fULL) | ((x & 0x7f007f007f007f00ULL) >> 1);
+          x = (x & 0x00003fff00003fffULL) | ((x & 0x3fff00003fff0000ULL) >> 2);
+          x = (x & 0x000000000fffffffULL) | ((x & 0x0fffffff00000000ULL) >> 4);
+          *out = x;
+          return n;
+        }
+      }
+      return decodeSlow(p, len, out);
+    }
+
+    static size_t decodeSlow(const uint8_t * p, size_t len, uint64_t * out);
+  };
+
+  /*
+   * Description:
+   *   Growable buffer records are serialized into: fixed width integers in
+   *   either byte order, varints and raw bytes, appended at the end.  The
+   *   storage is kept by clear(), so that one writer can be reused for many
+   *   records without allocating.  put*() return 0 on success, -1 if the
+   *   buffer could not grow (errno is ENOMEM), in which case nothing is
+   *   written.
+   */
+  class ByteWriter: public Standard::NoCopy
+  {
+  private:
+    uint8_t * data_;
+    size_t size_;
+    size_t capacity_;
+
+    int grow(size_t extra);
+
+    int ensure(size_t extra)
+    {
+      return likely(capacity_ - size_ >= extra) ? 0 : grow(extra);
+    }
+
+    template<typename T>
+    int putRaw(T v)
+    {
+      if (unlikely(ensure(sizeof(v)) < 0)) {
+        return -1;
+      }
+      memcpy(data_ + size_, &v, sizeof(v));
+      size_ += sizeof(v);
+      return 0;
+    }
+
+  public:
+    explicit ByteWriter(size_t capacity = 0);
+    ~ByteWriter();
+
+    const uint8_t * data() const
+    {
+      return data_;
+    }
+
+    uint8_t * data()
+    {
+      return data_;
+    }
+
+    size_t size() const
+    {
+      return size_;
+    }
+
+    size_t capacity() const
+    {
+      return capacity_;
+    }
+
+    /*
+     * Description:
+     *   Make sure that at least `capacity' bytes can be held without
+     *   reallocating.
+     * Return value:
+     *   0 on success, -1 on error (errno is set).
+     */
+    int reserve(size_t capacity)
+    {
+      return capacity <= capacity_ ? 0 : grow(capacity - size_);
+    }
+
+    /*
+     * Description:
+     *   Forget the content, but keep the storage for the next record.
+     */
+    void clear()
+    {
+      size_ = 0;
+    }
+
+    /*
+     * Description:
+     *   Drop everything after the first `size' bytes, e.g. to roll back a
+     *   partially written record.
+     */
+    void truncate(size_t size)
+    {
+      if (size < size_) {
+        size_ = size;
+      }
+    }
+
+    void swap(ByteWriter & other);
+
+    int putU8(uint8_t v)
+    {
+      return putRaw(v);
+    }
+
+    int putBe16(uint16_t v)
+    {
+      return putRaw(Endian::toBe16(v));
+    }
+
+    int putBe32(uint32_t v)
+    {
+      return putRaw(Endian::toBe32(v));
+    }
+
+    int putBe64(uint64_t v)
+    {
+      return putRaw(Endian::toBe64(v));
+    }
+
+    int putLe16(uint16_t v)
+    {
+      return putRaw(Endian::toLe16(v));
+    }
+
+    int putLe32(uint32_t v)
+    {
+      return putRaw(Endian::toLe32(v));
+    }
+
+    int putLe64(uint64_t v)
+    {
+      return putRaw(Endian::toLe64(v));
+    }
+
+    int putVarU64(uint64_t v)
+    {
+      if (unlikely(ensure(Varint::MAX_LENGTH_64) < 0)) {
+        return -1;
+      }
+      size_ += Varint::encode(data_ + size_, v);
+      return 0;
+    }
+
+    int putVarU32(uint32_t v)
+    {
+      return putVarU64(v);
+    }
+
+    int putVarI64(int64_t v)
+    {
+      return putVarU64(Varint::zigZag64(v));
+    }
+
+    int putVarI32(int32_t v)
+    {
+      return putVarU64(Varint::zigZag32(v));
+    }
+
+    int putBytes(const void * src, size_t len)
+    {
+      if (unlikely(ensure(len) < 0)) {
+        return -1;
+      }
+      memcpy(data_ + size_, src, len);
+      size_ += len;
+      return 0;
+    }
+
+    /*
+     * Description:
+     *   Overwrite 4 bytes already written at `offset' with `v' in big endian
+     *   order, e.g. a length prefix only known once the record is complete.
+     * Return value:
+     *   0 on success, -1 if the bytes were not written yet (errno is EINVAL).
+     */
+    int patchBe32(size_t offset, uint32_t v)
+    {
+      if (offset > size_ || size_ - offset < sizeof(v)) {
+        errno = EINVAL;
+        return -1;
+      }
+      v = Endian::toBe32(v);
+      memcpy(data_ + offset, &v, sizeof(v));
+      return 0;
+    }
+  };
+
+  /*
+   * Description:
+   *   Bounds-checked decoder of the formats written by ByteWriter, reading
+   *   from memory it does not own and which need not be aligned.  get*()
+   *   return 0 on success; -1 if the input ends before the value (errno is
+   *   ENODATA) or for malformed varints (EBADMSG) or varints out of range of
+   *   the requested type (ERANGE), in which case the position is unchanged.
+   */
+  class ByteReader
+  {
+  private:
+    const uint8_t * data_;
+    size_t size_;
+    size_t position_;
+
+    template<typename T>
+    int getRaw(T * v)
+    {
+      if (unlikely(size_ - position_ < sizeof(*v))) {
+        errno = ENODATA;
+        return -1;
+      }
+      memcpy(v, data_ + position_, sizeof(*v));
+      position_ += sizeof(*v);
+      return 0;
+    }
+
+  public:
+    ByteReader(const void * data, size_t size) :
+      data_((const uint8_t *) data), size_(size), position_(0)
+    {
+    }
+
+    explicit ByteReader(const ByteWriter & writer) :
+      data_(writer.data()), size_(writer.size()), position_(0)
+    {
+    }
+
+    size_t size() const
+    {
+      return size_;
+    }
+
+    size_t position() const
+    {
+      return position_;
+    }
+
+    size_t remaining() const
+    {
+      return size_ - position_;
+    }
+
+    const uint8_t * current() const
+    {
+      return data_ + position_;
+    }
+
+    int seek(size_t position)
+    {
+      if (position > size_) {
+        errno = EINVAL;
+        return -1;
+      }
+      position_ = position;
+      return 0;
+    }
+
+    int skip(size_t len)
+    {
+      if (unlikely(remaining() < len)) {
+        errno = ENODATA;
+        return -1;
+      }
+      position_ += len;
+      return 0;
+    }
+
+    int getU8(uint8_t * v)
+    {
+      return getRaw(v);
+    }
+
+    int getBe16(uint16_t * v)
+    {
+      if (unlikely(getRaw(v) < 0)) {
+        return -1;
+      }
+      *v = Endian::fromBe16(*v);
+      return 0;
+    }
+
+    int getBe32(uint32_t * v)
+    {
+      if (unlikely(getRaw(v) < 0)) {
+        return -1;
+      }
+      *v = Endian::fromBe32(*v);
+      return 0;
+    }
+
+    int getBe64(uint64_t * v)
+    {
+      if (unlikely(getRaw(v) < 0)) {
+        return -1;
+      }
+      *v = Endian::fromBe64(*v);
+      return 0;
+    }
+
+    int getLe16(uint16_t * v)
+    {
+      if (unlikely(getRaw(v) < 0)) {
+        return -1;
+      }
+      *v = Endian::fromLe16(*v);
+      return 0;
+    }
+
+    int getLe32(uint32_t * v)
+    {
+      if (unlikely(getRaw(v) < 0)) {
+        return -1;
+      }
+      *v = Endian::fromLe32(*v);
+      return 0;
+    }
+
+    int getLe64(uint64_t * v)
+    {
+      if (unlikely(getRaw(v) < 0)) {
+        return -1;
+      }
+      *v = Endian::fromLe64(*v);
+      return 0;
+    }
+
+    int getVarU64(uint64_t * v)
+    {
+      size_t n = Varint::decode(data_ + position_, size_ - position_, v);
+      if (unlikely(!n)) {
+        return -1;
+      }
+      position_ += n;
+      return 0;
+    }
+
+    int getVarU32(uint32_t * v)
+    {
+      uint64_t v64;
+      size_t n = Varint::decode(data_ + position_, size_ - position_, &v64);
+      if (unlikely(!n)) {
+        return -1;
+      }
+      if (unlikely(v64 > UINT32_MAX)) {
+        errno = ERANGE;
+        return -1;
+      }
+      position_ += n;
+      *v = (uint32_t) v64;
+      return 0;
+    }
+
+    int getVarI64(int64_t * v)
+    {
+      uint64_t u;
+      if (unlikely(getVarU64(&u) < 0)) {
+        return -1;
+      }
+      *v = Varint::unZigZag64(u);
+      return 0;
+    }
+
+    int getVarI32(int32_t * v)
+    {
+      uint32_t u;
+      if (unlikely(getVarU32(&u) < 0)) {
+        return -1;
+      }
+      *v = Varint::unZigZag32(u);
+      return 0;
+    }
+
+    int getBytes(void * dst, size_t len)
+    {
+      if (unlikely(remaining() < len)) {
+        errno = ENODATA;
+        return -1;
+      }
+      memcpy(dst, data_ + position_, len);
+      position_ += len;
+      return 0;
+    }
+  };
+}
+
+#endif /* _BrianZ_NEBULA_BYTE_BUFFER_H_ */
@@ -0,0 +1,276 @@
+/*
+ * connection.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_CONNECTION_H_
+#define _BrianZ_NEBULA_CONNECTION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include "nebula/async_event.h"
+#include "nebula/async_io.h"
+#include "nebula/io_buffer.h"
+#include "nebula/standard.h"
+
+namespace nebula
+{
+  /*
+   * Description:
+   *   Buffered non-blocking stream connection driven by an AsyncEvent, so
+   *   that users write message handlers instead of read/write loops and
+   *   READABLE/WRITABLE guesses.
+   *
+   *   Input is read into an IoBuffer until EAGAIN (or READ_BUDGET bytes
+   *   per event, the rest being left for the ready list so that one busy
+   *   peer does not starve the others), then handed to the message
+   *   callback, which consumes what it could parse and leaves the rest.
+   *   send() writes at once while nothing is queued and queues the
+   *   remainder; WRITABLE is only monitored while output is pending.
+   *   Files (sendFile()) and data spliced from other descriptors
+   *   (spliceFrom()) are queued in order with it and reach the socket
+   *   without passing through user space.
+   *
+   *   The watermark callback is told when pending output grows beyond
+   *   the high watermark, and again once it drained down to the low one,
+   *   for backpressure: an echo server pauses and resumes reading from
+   *   the same connection, a proxy from the other side.
+   *
+   *   The close callback is always the last thing a Connection does with
+   *   itself, it may delete the Connection.  Closing from inside a
+   *   callback of the same connection is deferred until that returns.
+   */
+  class Connection: public Standard::NoCopy
+  {
+  public:
+    typedef void (*message_callback_t)(Connection * conn, IoBuffer * input, void * data);
+    // `error' is 0 after an orderly close by either side, an errno value otherwise
+    typedef void (*close_callback_t)(Connection * conn, int error, void * data);
+    // `above' is true when output passed the high watermark, false when drained to the low one
+    typedef void (*watermark_callback_t)(Connection * conn, bool above, void * data);
+
+    enum
+    {
+      // bytes read per event before yielding to other descriptors
+      READ_BUDGET = 1 << 20,
+      DEFAULT_HIGH_WATERMARK = 4 << 20,
+      DEFAULT_LOW_WATERMARK = 1 << 20,
+    };
+
+  private:
+    enum State
+    {
+      CONNECTED, DRAINING, CLOSED
+    };
+
+    AsyncEvent * ae_;
+    int fd_;
+    State state_;
+    uint32_t monitored_;
+    bool reading_paused_;
+    bool above_high_;       // told the watermark callback about the high watermark
+    int in_callback_;
+    bool close_pending_;    // close callback deferred until the event callback returns
+    int error_;
+
+    /*
+     * Output kept outside of output_: a range of a file sent with
+     * sendfile(), or data spliced into a pipe.  It follows the first `gap'
+     * bytes of output_, those queued before it.
+     */
+    struct Segment
+    {
+      size_t gap;
+      SplicePipe * pipe;      // NULL for a file range
+      int file_fd;
+      bool close_file;
+      off_t offset;
+      size_t remaining;
+    };
+
+    IoBuffer input_;
+    IoBuffer output_;
+    std::deque<Segment> segments_;
+    size_t spliced_;        // bytes in the pipes of segments_
+    size_t high_watermark_;
+    size_t low_watermark_;
+    uint64_t bytes_read_;
+    uint64_t bytes_written_;
+
+    message_callback_t on_message_;
+    close_callback_t on_close_;
+    watermark_callback_t on_watermark_;
+    void * data_;
+
+    static uint32_t onEvent(int fd, uint32_t mask, void * data, AsyncEvent * ae);
+    static uint32_t onError(int fd, uint32_t mask_place_holder, void * data, AsyncEvent * ae);
+
+    uint32_t handleRead();
+    bool hasOutput() const
+    {
+      return !output_.empty() || !segments_.empty();
+    }
+
+    // a segment following what output_ holds now
+    Segment * queueSegment();
+    void popSegment();
+    void dropSegments();
+    // write until done or EAGAIN, return false if the connection got closed
+    bool flush();
+    // watermark check and WRITABLE after output was queued, the return value of send()
+    int afterQueued(bool write_now);
+    // monitor exactly what the state asks for
+    int updateEvents();
+    // updateEvents(), closing the connection if epoll refuses
+    void rearm();
+    void closeWith(int error);
+    void finishClose();
+
+  public:
+    /*
+     * Description:
+     *   Takes over the connected socket `fd', which is closed when the
+     *   connection is.  Nothing is monitored before init().
+     */
+    Connection(AsyncEvent * ae, int fd) :
+      ae_(ae), fd_(fd), state_(CONNECTED), monitored_(AsyncEvent::NONE), //
+          reading_paused_(false), above_high_(false), //
+          in_callback_(0), close_pending_(false), error_(0), spliced_(0), //
+          high_watermark_(DEFAULT_HIGH_WATERMARK), low_watermark_(DEFAULT_LOW_WATERMARK), //
+          bytes_read_(0), bytes_written_(0), //
+          on_message_(NULL), on_close_(NULL), on_watermark_(NULL), data_(NULL)
+    {
+    }
+
+    // closes the socket if still open, without calling the close callback
+    ~Connection();
+
+    void setCallbacks(message_callback_t on_message, close_callback_t on_close, void * data)
+    {
+      on_message_ = on_message;
+      on_close_ = on_close;
+      data_ = data;
+    }
+
+    // `low' must be less than `high'
+    void setWatermarks(size_t high, size_t low, watermark_callback_t on_watermark)
+    {
+      high_watermark_ = high;
+      low_watermark_ = low < high ? low : high / 2;
+      on_watermark_ = on_watermark;
+    }
+
+    /*
+     * Description:
+     *   Makes the socket non-blocking and starts reading.
+     * Return value:
+     *   0      ok
+     *   -1     error, errno set
+     */
+    int init() WARN_UNUSED_RESULT;
+
+    /*
+     * Description:
+     *   Sends `len' bytes, or all of `data' which is left empty, without
+     *   blocking; what can not be written now is queued.  A write error
+     *   closes the connection (the close callback runs unless called from
+     *   a callback of this connection).
+     * Return value:
+     *   0      ok, sent or queued
+     *   -1     the connection is closed or closing, errno set (EPIPE or
+     *          the write error), or no memory (ENOMEM)
+     */
+    int send(const void * data, size_t len);
+    int send(IoBuffer & data);
+
+    /*
+     * Description:
+     *   Queues `len' bytes of the regular file `file_fd' from `offset',
+     *   sent with sendfile() as the socket takes them; `file_fd' is closed
+     *   once they are sent (or the connection closed) if `close_it' is
+     *   true, otherwise it must stay open as long as the connection.
+     *   Like write(), sendfile() raises SIGPIPE when the peer is gone,
+     *   which servers ignore.
+     * Return value:
+     *   As send(); a file shorter than promised closes the connection
+     *   with EIO.
+     */
+    int sendFile(int file_fd, off_t offset, size_t len, bool close_it = false);
+
+    /*
+     * Description:
+     *   Moves up to `len' bytes that can be read from `fd' now (a socket,
+     *   pipe or file) into a pooled pipe queued for output, and on to the
+     *   socket as far as it takes them.  A relay calls it when `fd' is
+     *   readable, and pauses while pendingOutput() is above the high
+     *   watermark, spliced bytes count there.  SIGPIPE as for sendFile().
+     * Return value:
+     *   Bytes moved, 0 at end of input, -1 with errno set (EAGAIN if
+     *   nothing is to be read or the pipe is full; or as send()).
+     */
+    ssize_t spliceFrom(int fd, size_t len);
+
+    void pauseReading();
+    void resumeReading();
+
+    // close once pending output is written
+    void shutdown();
+    // close now, dropping pending output
+    void close();
+
+    int fd() const
+    {
+      return fd_;
+    }
+
+    bool connected() const
+    {
+      return state_ == CONNECTED;
+    }
+
+    // bytes buffered for output, files queued by sendFile() not included
+    size_t pendingOutput() const
+    {
+      return output_.size() + spliced_;
+    }
+
+    uint64_t bytesRead() const
+    {
+      return bytes_read_;
+    }
+
+    uint64_t bytesWritten() const
+    {
+      return bytes_written_;
+    }
+
+    void * data() const
+    {
+      return data_;
+    }
+  };
+}
+
+#endif /* _BrianZ_NEBULA_CONNECTION_H_ */
@@ -27,7 +27,18 @@
 #ifndef _BrianZ_NEBULA_ENDIAN_H_
 #define _BrianZ_NEBULA_ENDIAN_H_
 
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && defined(__ORDER_BIG_ENDIAN__)
+#define NEBULA_LITTLE_ENDIAN (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define NEBULA_BIG_ENDIAN    (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#else
+#include <endian.h>
+#define NEBULA_LITTLE_ENDIAN (__BYTE_ORDER == __LITTLE_ENDIAN)
+#define NEBULA_BIG_ENDIAN    (__BYTE_ORDER == __BIG_ENDIAN)
+#endif
 
 namespace nebula
 {
@@ -36,42 +47,43 @@ namespace nebula
   private:
     static uint16_t swap16(uint16_t in)
     {
-      return (((in & 0xff) << 8) | (in >> 8));
+      return __builtin_bswap16(in);
     }
 
     static uint32_t swap32(uint32_t in)
     {
-      uint32_t out = 0;
-      for (int i = 0; i < 4; ++i) {
-        out = (out << 8) | (in & 0xff);
-        in >>= 8;
-      }
-      return out;
+      return __builtin_bswap32(in);
     }
 
     static uint64_t swap64(uint64_t in)
     {
-      uint64_t out = 0;
-      for (int i = 0; i < 8; ++i) {
-        out = (out << 8) | (in & 0xff);
-        in >>= 8;
+      return __builtin_bswap64(in);
+    }
+
+    /*
+     * Byte swap `n' integers from `src' to `dst', which may be the same
+     * array, using the widest SIMD kernel available (see multiversion.h).
+     */
+    static void swap16(uint16_t * dst, const uint16_t * src, size_t n);
+    static void swap32(uint32_t * dst, const uint32_t * src, size_t n);
+    static void swap64(uint64_t * dst, const uint64_t * src, size_t n);
+
+    static void copy(void * dst, const void * src, size_t len)
+    {
+      if (dst != src) {
+        memmove(dst, src, len);
       }
-      return out;
     }
 
   public:
     static bool isLittleEndian()
     {
-      uint16_t test = 0x1234;
-      uint8_t * ptr = (uint8_t *) &test;
-      return ptr[0] > ptr[1];
+      return NEBULA_LITTLE_ENDIAN;
     }
 
     static bool isBigEndian()
     {
-      uint16_t test = 0x1234;
-      uint8_t * ptr = (uint8_t *) &test;
-      return ptr[0] < ptr[1];
+      return NEBULA_BIG_ENDIAN;
     }
 
     static uint16_t toBe16(uint16_t h16)
@@ -133,6 +145,120 @@ namespace nebula
     {
       return isLittleEndian() ? le64 : swap64(le64);
     }
+
+    /*
+     * Description:
+     *   Bulk conversions of `n' integers from `src' to `dst'.  `dst' and `src'
+     *   may be the same array (in place conversion), but must not otherwise
+     *   overlap.  Neither needs to be aligned beyond the alignment of its type.
+     */
+    static void toBe16(uint16_t * dst, const uint16_t * src, size_t n)
+    {
+#if NEBULA_LITTLE_ENDIAN
+      swap16(dst, src, n);
+#else
+      copy(dst, src, n * sizeof(*src));
+#endif
+    }
+
+    static void toLe16(uint16_t * dst, const uint16_t * src, size_t n)
+    {
+#if NEBULA_BIG_ENDIAN
+      swap16(dst, src, n);
+#else
+      copy(dst, src, n * sizeof(*src));
+#endif
+    }
+
+    static void fromBe16(uint16_t * dst, const uint16_t * src, size_t n)
+    {
+#if NEBULA_LITTLE_ENDIAN
+      swap16(dst, src, n);
+#else
+      copy(dst, src, n * sizeof(*src));
+#endif
+    }
+
+    static void fromLe16(uint16_t * dst, const uint16_t * src, size_t n)
+    {
+#if NEBULA_BIG_ENDIAN
+      swap16(dst, src, n);
+#else
+      copy(dst, src, n * sizeof(*src));
+#endif
+    }
+
+    static void toBe32(uint32_t * dst, const uint32_t * src, size_t n)
+    {
+#if NEBULA_LITTLE_ENDIAN
+      swap32(dst, src, n);
+#else
+      copy(dst, src, n * sizeof(*src));
+#endif
+    }
+
+    static void toLe32(uint32_t * dst, const uint32_t * src, size_t n)
+    {
+#if NEBULA_BIG_ENDIAN
+      swap32(dst, src, n);
+#else
+      copy(dst, src, n * sizeof(*src));
+#endif
+    }
+
+    static void fromBe32(uint32_t * dst, const uint32_t * src, size_t n)
+    {
+#if NEBULA_LITTLE_ENDIAN
+      swap32(dst, src, n);
+#else
+      copy(dst, src, n * sizeof(*src));
+#endif
+    }
+
+    static void fromLe32(uint32_t * dst, const uint32_t * src, size_t n)
+    {
+#if NEBULA_BIG_ENDIAN
+      swap32(dst, src, n);
+#else
+      copy(dst, src, n * sizeof(*src));
+#endif
+    }
+
+    static void toBe64(uint64_t * dst, const uint64_t * src, size_t n)
+    {
+#if NEBULA_LITTLE_ENDIAN
+      swap64(dst, src, n);
+#else
+      copy(dst, src, n * sizeof(*src));
+#endif
+    }
+
+    static void toLe64(uint64_t * dst, const uint64_t * src, size_t n)
+    {
+#if NEBULA_BIG_ENDIAN
+      swap64(dst, src, n);
+#else
+      copy(dst, src, n * sizeof(*src));
+#endif
+    }
+
+    static void fromBe64(uint64_t * dst, const uint64_t * src, size_t n)
+    {
+#if NEBULA_LITTLE_ENDIAN
+      swap64(dst, src, n);
+#else
+      copy(dst, src, n * sizeof(*src));
+#endif
+    }
+
+    static void fromLe64(uint64_t * dst, const uint64_t * src, size_t n)
+    {
+#if NEBULA_BIG_ENDIAN
+      swap64(dst, src, n);
+#else
+      copy(dst, src, n * sizeof(*src));
+#endif
+    }
   }; /* class Endian */
 }
 
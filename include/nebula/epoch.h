@@ -0,0 +1,283 @@
+/*
+ * epoch.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_EPOCH_H_
+#define _BrianZ_NEBULA_EPOCH_H_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "nebula/standard.h"
+#include "nebula/thread.h"
+
+namespace nebula
+{
+  /*
+   * Description:
+   *   Epoch-based memory reclamation for lock-free data structures.  Readers
+   *   bracket every access to shared objects with enter() and leave() (or an
+   *   EpochGuard), which only publish the current epoch in a per-thread
+   *   record: no lock, no loop, no shared write.  A writer which unlinked an
+   *   object passes it to retire() instead of deleting it; retired objects
+   *   are kept in per-thread lists and deleted in batches, once the global
+   *   epoch advanced twice, i.e. once every thread which could still see
+   *   them has left its critical section.
+   *
+   *   Threads are registered on their first call, and unregistered when they
+   *   exit (through a pthread key destructor), their pending objects being
+   *   handed over to the domain.  Threads which do not exit through
+   *   pthread_exit() or by returning from their start routine, such as the
+   *   main thread, may call unregisterThread() explicitly.  A thread which
+   *   stays inside a critical section blocks reclamation for everybody.
+   */
+  class EpochDomain: public Standard::NoCopy
+  {
+  public:
+    typedef void (*Deleter)(void * ptr);
+
+    enum
+    {
+      RECLAIM_BATCH = 64 // retired objects per thread between reclamation attempts
+    };
+
+  private:
+    struct Retired
+    {
+      void * ptr;
+      Deleter deleter;
+    };
+
+    // cache line aligned, see attach()
+    struct __attribute__((aligned(64))) ThreadRecord
+    {
+      // hot fields, written by the owner only, on a cache line of their own
+      uint64_t epoch; // (epoch << 1) | 1 inside a critical section, 0 outside
+      int nesting;
+      int in_use;
+      ThreadRecord * next;
+      EpochDomain * domain;
+      char padding[64 - sizeof(uint64_t) - 2 * sizeof(int) - 2 * sizeof(void *)];
+
+      std::vector<Retired> limbo[3]; // indexed by epoch % 3
+      uint64_t limbo_epoch[3];
+      size_t num_retired; // since the last reclamation attempt
+    };
+
+    struct Orphan
+    {
+      uint64_t epoch;
+      Retired retired;
+    };
+
+    uint64_t global_epoch_;
+    ThreadRecord * records_; // never shrinks, records of exited threads are reused
+    bool initialized_;
+    pthread_key_t key_;
+    pthread_mutex_t orphans_lock_;
+    std::vector<Orphan> orphans_; // left behind by exited threads
+
+  public:
+    /*
+     * Available after init().
+     */
+    EpochDomain();
+
+    /*
+     * Deletes all retired objects, no thread may be using the domain.
+     */
+    ~EpochDomain();
+
+    /*
+     * Description:
+     *   Create the pthread key holding the record of each thread.
+     * Return value:
+     *   0 on success, -1 with errno set on failure.
+     */
+    int init();
+
+    /*
+     * Description:
+     *   Domain shared by the whole process, initialized on first use (the
+     *   process is aborted if that fails).
+     */
+    static EpochDomain & defaultDomain();
+
+    void enter()
+    {
+      ThreadRecord * r = (ThreadRecord *) pthread_getspecific(key_);
+      if (!r) {
+        r = attach();
+      }
+      if (r->nesting++ == 0) {
+        __atomic_store_n(&r->epoch, (__atomic_load_n(&global_epoch_, __ATOMIC_RELAXED) << 1) | 1, __ATOMIC_RELAXED);
+        // the announcement must be visible before any shared pointer is loaded
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      }
+    }
+
+    void leave()
+    {
+      ThreadRecord * r = (ThreadRecord *) pthread_getspecific(key_);
+      if (--r->nesting == 0) {
+        __atomic_store_n(&r->epoch, 0, __ATOMIC_RELEASE);
+      }
+    }
+
+    /*
+     * Description:
+     *   Have `deleter(ptr)' called once no reader can hold a reference to
+     *   `ptr' any more.  `ptr' must already be unreachable for new readers.
+     *   May be called inside or outside a critical section.
+     */
+    void retire(void * ptr, Deleter deleter);
+
+    template<typename T>
+    void retire(T * ptr)
+    {
+      retire((void *) ptr, &deleteObject<T>);
+    }
+
+    /*
+     * Description:
+     *   Try to advance the global epoch, and delete whatever became safe to
+     *   delete in the caller's lists and in the lists of exited threads.
+     * Return value:
+     *   Number of objects deleted.
+     */
+    size_t reclaim();
+
+    /*
+     * Description:
+     *   Wait until every object retired so far by the calling thread has been
+     *   deleted.  Must not be called inside a critical section.
+     */
+    void synchronize();
+
+    /*
+     * Description:
+     *   Make the calling thread a member of the domain, done implicitly by
+     *   enter() and retire().
+     */
+    void registerThread()
+    {
+      if (!pthread_getspecific(key_)) {
+        attach();
+      }
+    }
+
+    /*
+     * Description:
+     *   Hand the pending objects of the calling thread over to the domain,
+     *   and release its record.  Must not be called inside a critical
+     *   section.
+     */
+    void unregisterThread();
+
+    uint64_t epoch() const
+    {
+      return __atomic_load_n(&global_epoch_, __ATOMIC_RELAXED);
+    }
+
+    /*
+     * Description:
+     *   Number of objects retired by the calling thread and by exited
+     *   threads, which were not yet deleted.
+     */
+    size_t pending();
+
+  private:
+    template<typename T>
+    static void deleteObject(void * ptr)
+    {
+      delete (T *) ptr;
+    }
+
+    ThreadRecord * attach();
+    bool tryAdvance();
+    size_t reclaimRecord(ThreadRecord * r, uint64_t epoch);
+    size_t reclaimOrphans(uint64_t epoch);
+    void releaseRecord(ThreadRecord * r);
+    static void threadExit(void * record);
+  }; /* class EpochDomain */
+
+  /*
+   * Description:
+   *   Critical section of an EpochDomain for the lifetime of the object.
+   */
+  class EpochGuard: public Standard::NoCopy
+  {
+  private:
+    EpochDomain & domain_;
+
+  public:
+    explicit EpochGuard(EpochDomain & domain = EpochDomain::defaultDomain()) :
+      domain_(domain)
+    {
+      domain_.enter();
+    }
+
+    ~EpochGuard()
+    {
+      domain_.leave();
+    }
+  };
+
+  /*
+   * Description:
+   *   Thread which is registered with `domain' before routine() starts, and
+   *   unregistered after it returns.  Subclasses overriding startHandler()
+   *   or exitHandler() have to call the versions of this class.
+   */
+  class EpochThread: public Thread
+  {
+  private:
+    EpochDomain * domain_;
+
+  public:
+    EpochThread(EpochDomain * domain = &EpochDomain::defaultDomain()) :
+      domain_(domain)
+    {
+    }
+
+    EpochDomain * domain() const
+    {
+      return domain_;
+    }
+
+    virtual void startHandler()
+    {
+      domain_->registerThread();
+    }
+
+    virtual void exitHandler()
+    {
+      domain_->unregisterThread();
+    }
+  };
+}
+
+#endif /* _BrianZ_NEBULA_EPOCH_H_ */
@@ -0,0 +1,161 @@
+/*
+ * file_status_cache.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_FILE_STATUS_CACHE_H_
+#define _BrianZ_NEBULA_FILE_STATUS_CACHE_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <map>
+#include <string>
+#include "nebula/standard.h"
+
+namespace nebula
+{
+  namespace internal
+  {
+    class StatusWatcherThread;
+  }
+
+  /*
+   * Description:
+   *   In-process cache of file status, keyed by path as given by the caller.
+   *   The parent directory of every cached path, and every cached directory
+   *   itself, is watched with inotify, and entries are dropped as soon as an
+   *   event for them is processed, so
+   *   repeated queries of unchanged files cost no system call at all.
+   *   Events are processed either by a background thread (FSC_WATCHER_THREAD)
+   *   or by the owner calling processEvents() whenever fd() is readable, in
+   *   which case a change may go unnoticed until then.
+   *
+   *   Missing files are cached too (as their errno).  Paths which are
+   *   symbolic links are never cached when FSC_FOLLOW_LINK is set, since the
+   *   target may live in a directory which is not watched.  Renaming or
+   *   replacing a directory in the middle of a cached path is not noticed.
+   */
+  class FileStatusCache: public Standard::NoCopy
+  {
+    friend class internal::StatusWatcherThread;
+  public:
+    enum
+    {
+      FSC_NONE = 0x00, //
+      FSC_FOLLOW_LINK = 0x01, // stat() rather than lstat() semantic
+      FSC_WATCHER_THREAD = 0x02 // process inotify events in a background thread
+    };
+
+  private:
+    struct Entry
+    {
+      struct statx sb;
+      int error; // errno if the status could not be fetched, or 0
+    };
+
+    typedef std::map<std::string, Entry> EntryMap;
+    typedef std::multimap<int, std::string> WatchMap;
+    typedef std::map<std::string, int> DirectoryMap;
+
+    unsigned int mask_;
+    int flags_;
+    int inotify_fd_;
+    int wakeup_fd_;
+    internal::StatusWatcherThread * watcher_;
+
+    pthread_mutex_t lock_;
+    EntryMap entries_;
+    WatchMap watches_; // watch descriptor => directory prefix of cached paths (ends with '/', or is empty)
+    DirectoryMap directories_; // directory prefix => watch descriptor
+    uint64_t generation_; // bumped by every invalidation
+    uint64_t hits_;
+    uint64_t misses_;
+
+  public:
+    FileStatusCache(unsigned int mask = STATX_BASIC_STATS, int flags = FSC_WATCHER_THREAD);
+
+    ~FileStatusCache();
+
+    /*
+     * Description:
+     *   Create the inotify instance, and start the watcher thread if
+     *   FSC_WATCHER_THREAD was given.  Before (or without) a successful call,
+     *   getFileStatus() works but nothing is cached.
+     * Return value:
+     *   0 on success, -1 on error (errno is set).
+     */
+    int init();
+
+    /*
+     * Description:
+     *   The inotify descriptor, readable when there are events to process,
+     *   -1 if init() was not called.
+     */
+    int fd() const
+    {
+      return inotify_fd_;
+    }
+
+    /*
+     * Description:
+     *   Read all pending inotify events without blocking, and drop the
+     *   entries they refer to.
+     * Return value:
+     *   Number of events processed, or -1 on error (errno is set).
+     */
+    int processEvents();
+
+    /*
+     * Description:
+     *   Copy status of `path' into `*buf', from the cache if possible.
+     * Return value:
+     *   0 on success, -1 on error (errno is set, the error may be cached).
+     */
+    int getFileStatus(const char * path, struct statx * buf);
+
+    /*
+     * Description:
+     *   Last modification time of `path', or -1 on error.
+     */
+    time_t mtime(const char * path);
+
+    void invalidate(const char * path);
+
+    void clear();
+
+    size_t size();
+
+    uint64_t hits();
+
+    uint64_t misses();
+
+  private:
+    int watchDirectory(const std::string & prefix);
+    void invalidatePrefix(const std::string & prefix);
+    void handleEvent(int wd, uint32_t mask, const char * name);
+  }; /* class FileStatusCache */
+}
+
+#endif /* _BrianZ_NEBULA_FILE_STATUS_CACHE_H_ */
@@ -29,9 +29,15 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <limits.h>
 #include <dirent.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <set>
+#include <string>
+#include "nebula/standard.h"
 #include "nebula/string.h"
 
 namespace nebula
@@ -43,21 +49,87 @@ namespace nebula
     ~FileSystem();
 
   public:
+    /*
+     * Description:
+     *   Create directory `pathname' with permission `mode' (as shown by
+     *   `ls -l', e.g. "rwxr-x---", subject to the umask).  If `recursive'
+     *   is true, missing parent directories are created as well, and an
+     *   already existing directory is not an error.
+     * Return value:
+     *   0 on success, -1 on error (errno is set).
+     */
     static int mkdir(const char * pathname, bool recursive = false, const char * mode = "rwxr-xr-x");
+
+    /*
+     * Description:
+     *   Remove directory `pathname', which must be empty unless `recursive'
+     *   is true, see removeTree().  Fails with ENOTDIR if `pathname' is not
+     *   a directory, recursive or not.
+     * Return value:
+     *   0 on success, -1 on error (errno is set).
+     */
     static int rmdir(const char * pathname, bool recursive = false);
 
+    /*
+     * Counters updated by removeTree() while it is running, may be read from
+     * another thread to report progress.
+     */
+    struct RemoveProgress
+    {
+      volatile uint64_t files; // non-directories unlinked
+      volatile uint64_t directories; // directories removed
+      volatile uint64_t errors; // entries which could not be removed
+      volatile int first_error; // errno of the first failure
+    };
+
+    /*
+     * Description:
+     *   Remove `pathname' and, if it is a directory, everything under it.
+     *   Non-directories are unlinked relative to their parent's descriptor
+     *   by the treeWalk() threads (`num_threads' as in treeWalk()), then the
+     *   emptied directories are removed depth first, each relative to the
+     *   descriptor of its parent as well, the subtrees of the top directory
+     *   spread over as many threads.  The depth of the tree is limited
+     *   neither by the stack nor by the number of descriptors.  Entries
+     *   which can not be removed are counted and skipped.  `progress', if
+     *   not NULL, must be zeroed by the caller.
+     * Return value:
+     *   0 on success, -1 if anything could not be removed (errno is set to
+     *   the first error).
+     */
+    static int removeTree(const char * pathname, RemoveProgress * progress = NULL, int num_threads = 0);
+
+    /*
+     * Description:
+     *   Convert `mode' such as "rwxr-xr-x" (setuid, setgid and sticky bits as
+     *   's', 'S', 't' and 'T') into `*result'.
+     * Return value:
+     *   0 on success, -1 if `mode' is malformed.
+     */
+    static int parseMode(const char * mode, mode_t * result);
+
     static int getFileStatus(const char * path, struct stat * buf, bool follow_link = false)
     {
-      if ((follow_link && stat(path, buf) < 0) || lstat(path, buf) < 0) {
-        return -1;
-      }
-      return 0;
+      return follow_link ? stat(path, buf) : lstat(path, buf);
     }
 
+    /*
+     * Description:
+     *   Fetch status of `path', relative to `dir_fd' unless it is absolute,
+     *   with statx(2).  `mask' (STATX_MTIME, STATX_SIZE, ...) tells which
+     *   fields are wanted, the kernel may fill in more, check `buf->stx_mask'
+     *   for what is actually valid.  Falls back to fstatat() on kernels
+     *   without statx(2).
+     * Return value:
+     *   0 on success, -1 on error (errno is set).
+     */
+    static int getFileStatusX(const char * path, unsigned int mask, struct statx * buf, bool follow_link = false,
+      int dir_fd = AT_FDCWD);
+
     static time_t atime(const char * path, bool follow_link = false)
     {
       struct stat buf;
-      if ((follow_link && stat(path, &buf) < 0) || lstat(path, &buf) < 0) {
+      if (getFileStatus(path, &buf, follow_link) < 0) {
         return ((time_t) -1);
       }
       return buf.st_atime;
@@ -66,7 +138,7 @@ namespace nebula
     static time_t ctime(const char * path, bool follow_link = false)
     {
       struct stat buf;
-      if ((follow_link && stat(path, &buf) < 0) || lstat(path, &buf) < 0) {
+      if (getFileStatus(path, &buf, follow_link) < 0) {
         return ((time_t) -1);
       }
       return buf.st_ctime;
@@ -75,7 +147,7 @@ namespace nebula
     static time_t mtime(const char * path, bool follow_link = false)
     {
       struct stat buf;
-      if ((follow_link && stat(path, &buf) < 0) || lstat(path, &buf) < 0) {
+      if (getFileStatus(path, &buf, follow_link) < 0) {
         return ((time_t) -1);
       }
       return buf.st_mtime;
@@ -84,6 +156,100 @@ namespace nebula
     static int fileTreeTraversal(const char * dir_path, //
       int(*fn)(const char * fpath, const struct stat * sb, void * arg), //
       void * fn_last_arg);
+
+    /*
+     * Entry reported by treeWalk().
+     */
+    struct TreeEntry
+    {
+      int dir_fd; // open descriptor of the parent directory, for use with openat(), fstatat(), unlinkat(), ...
+      const char * dir_path; // path of the parent directory, always ends with '/'
+      size_t dir_path_len;
+      const char * name; // name of this entry in the parent directory
+      unsigned char type; // DT_REG, DT_DIR, DT_LNK, ...
+      int depth; // 1 for entries of the top directory
+      const struct stat * sb; // NULL unless the entry was stat()ed, see TW_STAT
+
+      /*
+       * Description:
+       *   Copy "dir_path/name" into `buf' of size `buflen'.
+       * Return value:
+       *   Length of the full path, truncation occurred if it is >= `buflen'.
+       */
+      size_t fullPath(char * buf, size_t buflen) const
+      {
+        String::strlcpy(buf, dir_path, buflen);
+        return String::strlcat(buf, name, buflen);
+      }
+    };
+
+    enum
+    {
+      TW_NONE = 0x00, //
+      TW_STAT = 0x01 // fstatat() every entry, otherwise only if d_type is DT_UNKNOWN
+    };
+
+    enum
+    {
+      TW_CONTINUE = 0, //
+      TW_SKIP_SUBTREE = 1 // do not descend into this directory
+    };
+
+    /*
+     * Description:
+     *   Recursively walk the tree under `dir_path' (not including itself,
+     *   symbolic links are not followed) with `num_threads' threads, the
+     *   calling thread included, or one thread per processor if `num_threads'
+     *   is 0.  Directories are read with getdents64() and opened relative to
+     *   their parent, and entries are only stat()ed if required.  `fn' is
+     *   called for every entry, concurrently from different threads, and
+     *   before the contents of a directory.  If it returns anything other
+     *   than TW_CONTINUE or TW_SKIP_SUBTREE, the walk stops as soon as
+     *   possible.  Subdirectories which can not be opened are skipped.
+     * Return value:
+     *   0 if all entries were visited, -1 if `dir_path' can not be opened, or
+     *   the value returned by `fn' that stopped the walk.
+     */
+    static int treeWalk(const char * dir_path, int(*fn)(const TreeEntry * entry, void * arg), void * fn_last_arg,
+      int num_threads = 0, int flags = TW_NONE);
+  };
+
+  /*
+   * Description:
+   *   Creates directories recursively, like FileSystem::mkdir(path, true),
+   *   but remembers the directories which were created or found to exist,
+   *   so that creating many directories sharing the same ancestors costs
+   *   one mkdir() per call rather than one per path component.  A known
+   *   directory is still checked by that mkdir(), so directories removed
+   *   behind its back are created again, and the cache is dropped when a
+   *   known ancestor turns out to be gone.  Thread safe.
+   */
+  class DirectoryCreator: public Standard::NoCopy
+  {
+  private:
+    mode_t mode_;
+    pthread_mutex_t lock_;
+    std::set<std::string> known_; // without trailing '/'
+
+  public:
+    DirectoryCreator(mode_t mode = 0755);
+
+    ~DirectoryCreator();
+
+    /*
+     * Return value:
+     *   0 on success, -1 on error (errno is set).
+     */
+    int create(const char * pathname);
+
+    void clear();
+
+    size_t size();
+
+  private:
+    bool isKnown(const std::string & path);
+    void remember(const std::string & path);
+    int createFrom(const std::string & path, size_t start);
   };
 }
 #endif /* _BrianZ_NEBULA_FILE_SYSTEM_H_ */
@@ -28,13 +28,233 @@
 #define _BrianZ_NEBULA_HARDWAREINFO_H_
 
 #include <pthread.h>
+#include <sched.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
 #include "string.h"
 
 namespace nebula
 {
+  /*
+   * Description:
+   *   Instruction set extensions reported by cpuid.  AVX and AVX-512 features
+   *   are only reported when the operating system also saves the wider
+   *   registers (XCR0), i.e. when they can actually be used.
+   */
+  struct CpuFeature
+  {
+    enum Constants
+    {
+      SSE2 = 1 << 0, //
+      SSSE3 = 1 << 1, //
+      SSE41 = 1 << 2, //
+      SSE42 = 1 << 3, //
+      POPCNT = 1 << 4, //
+      AVX = 1 << 5, //
+      AVX2 = 1 << 6, //
+      FMA = 1 << 7, //
+      BMI1 = 1 << 8, //
+      BMI2 = 1 << 9, //
+      LZCNT = 1 << 10, //
+      AVX512F = 1 << 11, //
+      AVX512DQ = 1 << 12, //
+      AVX512BW = 1 << 13, //
+      AVX512VL = 1 << 14, //
+      ERMS = 1 << 15, // enhanced rep movsb/stosb
+      RDTSCP = 1 << 16, //
+      INVARIANT_TSC = 1 << 17, // constant rate in all P-, C- and T-states
+      NUM_FEATURES = 18
+    };
+
+    static const char * toString(Constants v);
+  };
+
+  /*
+   * Description:
+   *   Levels of SIMD kernels, each one requires all features of the previous
+   *   one plus those listed below.
+   *     SSE42:  SSE2, SSSE3, SSE4.1, SSE4.2, POPCNT
+   *     AVX2:   AVX, AVX2, FMA, BMI1, BMI2, LZCNT (x86-64-v3)
+   *     AVX512: AVX512F, AVX512DQ, AVX512BW, AVX512VL (x86-64-v4)
+   */
+  struct SimdLevel
+  {
+    enum Constants
+    {
+      SCALAR = 0, SSE42 = 1, AVX2 = 2, AVX512 = 3, NUM_LEVELS = 4
+    };
+
+    static const char * toString(Constants v);
+
+    /*
+     * Description:
+     *   Parse a level name as returned by toString() ("avx2"), or a number.
+     * Return value:
+     *   The level, or -1 if `s' is not recognized.
+     */
+    static int parse(const char * s);
+
+    /*
+     * Description:
+     *   Bitwise or of CpuFeature::Constants required by `level'.
+     */
+    static uint64_t requiredFeatures(Constants level);
+  };
+
+  /*
+   * Description:
+   *   Processor topology as described by the kernel in /sys/devices/system
+   *   (packages, cores, SMT siblings, caches, NUMA nodes), together with the
+   *   processors the process is allowed to run on and its cgroup CPU quota.
+   *   Everything is read relative to a root directory, so that a copy of the
+   *   relevant files can be loaded for testing.
+   */
+  class CpuTopology
+  {
+  public:
+    struct Cpu
+    {
+      int id;
+      int package; // physical package id, -1 if offline or unknown
+      int core; // core id, unique within its package only
+      int node; // NUMA node, -1 if unknown
+      bool online;
+      bool allowed; // in the affinity mask of the process
+      cpu_set_t siblings; // SMT siblings, including itself
+    };
+
+    struct Cache
+    {
+      int level; // 1, 2, 3, ...
+      char type[16]; // "Data", "Instruction" or "Unified"
+      uint64_t size; // in bytes
+      int line_size;
+      int ways;
+      int num_sharing; // processors sharing this cache
+      cpu_set_t shared_cpus;
+    };
+
+    struct Node
+    {
+      int id;
+      cpu_set_t cpus;
+      uint64_t memory_total; // in bytes
+      std::vector<int> distances; // indexed by node id, 10 means local
+    };
+
+  private:
+    std::vector<Cpu> cpus_; // indexed by processor id, possible processors only
+    std::vector<Cache> caches_; // each distinct cache once
+    std::vector<Node> nodes_; // indexed by node id, absent nodes have id -1
+    int num_online_;
+    int num_allowed_;
+    int num_cores_;
+    int num_packages_;
+    double cpu_quota_;
+
+  public:
+    CpuTopology();
+
+    /*
+     * Description:
+     *   Read the topology of this machine, or of the copy of /sys and /proc
+     *   found under `root'.
+     * Return value:
+     *   0 on success, -1 if the processor list can not be read (errno is set).
+     */
+    int load(const char * root = "");
+
+    const std::vector<Cpu> & cpus() const
+    {
+      return cpus_;
+    }
+
+    const std::vector<Cache> & caches() const
+    {
+      return caches_;
+    }
+
+    const std::vector<Node> & nodes() const
+    {
+      return nodes_;
+    }
+
+    int numOnlineCpus() const
+    {
+      return num_online_;
+    }
+
+    int numAllowedCpus() const
+    {
+      return num_allowed_;
+    }
+
+    /*
+     * Description:
+     *   Number of physical cores, SMT siblings counted once, online
+     *   processors only.
+     */
+    int numPhysicalCores() const
+    {
+      return num_cores_;
+    }
+
+    int numPackages() const
+    {
+      return num_packages_;
+    }
+
+    int numNodes() const;
+
+    /*
+     * Description:
+     *   Distance between NUMA nodes `from' and `to' as reported by the
+     *   firmware (10 for local), -1 if unknown.
+     */
+    int distance(int from, int to) const;
+
+    /*
+     * Description:
+     *   Cache of `level' seen by processor `cpu', data or unified caches only
+     *   unless `instruction' is true.
+     * Return value:
+     *   The cache, NULL if there is none.
+     */
+    const Cache * cache(int level, int cpu = 0, bool instruction = false) const;
+
+    /*
+     * Description:
+     *   Coherency line size of the level 1 data cache, 64 if unknown.
+     */
+    int cacheLineSize() const;
+
+    /*
+     * Description:
+     *   Processors available according to the cgroup CPU bandwidth limit
+     *   (e.g. 1.5 for 150ms every 100ms), -1 if unlimited.
+     */
+    double cpuQuota() const
+    {
+      return cpu_quota_;
+    }
+
+    /*
+     * Description:
+     *   Number of threads worth running in parallel: the allowed processors,
+     *   bounded by the CPU quota rounded up, at least 1.
+     */
+    int effectiveCpus() const;
+
+  private:
+    void loadCpus(const char * root);
+    void loadCaches(const char * root);
+    void loadNodes(const char * root);
+    void loadAllowed(const char * root);
+    void loadQuota(const char * root);
+  };
+
   class HardwareInfo
   {
   private:
@@ -57,6 +277,15 @@ namespace nebula
     static void parseProcFiles();
     static void checkAndParse();
 
+    static pthread_once_t topology_loaded_;
+    static CpuTopology * topology_; // allocated by loadTopology(), safe for other static initializers
+    static void loadTopology();
+
+    static pthread_once_t features_probed_;
+    static uint64_t cpu_features_;
+    static SimdLevel::Constants simd_level_;
+    static void probeCpuFeatures();
+
   public:
     static const char * cpuModelName()
     {
@@ -87,6 +316,58 @@ namespace nebula
       (void) pthread_once(&parsed_, checkAndParse);
       return swap_total_;
     }
+
+    /*
+     * Description:
+     *   Topology of this machine, read once.
+     */
+    static const CpuTopology & topology()
+    {
+      (void) pthread_once(&topology_loaded_, loadTopology);
+      return *topology_;
+    }
+
+    /*
+     * Description:
+     *   Bitwise or of CpuFeature::Constants supported by this machine.
+     */
+    static uint64_t cpuFeatures()
+    {
+      (void) pthread_once(&features_probed_, probeCpuFeatures);
+      return cpu_features_;
+    }
+
+    static bool hasCpuFeatures(uint64_t features)
+    {
+      return (cpuFeatures() & features) == features;
+    }
+
+    /*
+     * Description:
+     *   Highest SimdLevel whose features are all supported by this machine.
+     */
+    static SimdLevel::Constants simdLevel()
+    {
+      (void) pthread_once(&features_probed_, probeCpuFeatures);
+      return simd_level_;
+    }
+
+    /*
+     * Description:
+     *   Parse a processor list in the format used by the kernel, such as
+     *   "0-3,8,10-11", and add the processors to `*cpus'.
+     * Return value:
+     *   Number of processors in the list, -1 if the list is malformed.
+     */
+    static int parseCpuList(const char * list, cpu_set_t * cpus);
+
+    /*
+     * Description:
+     *   Add the processors of NUMA node `node' to `*cpus'.
+     * Return value:
+     *   Number of processors added, -1 on error (errno is set).
+     */
+    static int numaNodeCpus(int node, cpu_set_t * cpus);
   };
 }
 
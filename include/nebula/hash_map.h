@@ -0,0 +1,644 @@
+/*
+ * hash_map.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_HASH_MAP_H_
+#define _BrianZ_NEBULA_HASH_MAP_H_
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <string>
+#include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "nebula/attributes.h"
+#include "nebula/standard.h"
+
+namespace nebula
+{
+  namespace internal
+  {
+    // fold of the 128-bit product, every input bit reaches both halves
+    inline uint64_t hashMix(uint64_t a, uint64_t b)
+    {
+      unsigned __int128 p = (unsigned __int128) a * b;
+      return (uint64_t) p ^ (uint64_t) (p >> 64);
+    }
+
+    inline uint64_t hashBytes(const void * data, size_t len)
+    {
+      const uint64_t K0 = 0x9e3779b97f4a7c15ULL, K1 = 0xbf58476d1ce4e5b9ULL;
+      const unsigned char * p = (const unsigned char *) data;
+      uint64_t h = K0 ^ len;
+      for (; len >= 8; len -= 8, p += 8) {
+        uint64_t w;
+        ::memcpy(&w, p, 8);
+        h = hashMix(h ^ w, K1);
+      }
+      if (len) {
+        uint64_t w = 0;
+        ::memcpy(&w, p, len);
+        h = hashMix(h ^ w, K1);
+      }
+      return hashMix(h, K0);
+    }
+  }
+
+  /*
+   * Description:
+   *   Default hash of FlatHashMap, for integral types (the value is mixed,
+   *   FlatHashMap uses both the low and the high bits), pointers and
+   *   std::string, which also hashes `const char *' so that string keyed
+   *   maps can be searched without building a std::string.
+   */
+  template<typename K>
+  struct FlatHash
+  {
+    size_t operator()(uint64_t v) const
+    {
+      return internal::hashMix(v, 0x9e3779b97f4a7c15ULL);
+    }
+  };
+
+  template<typename T>
+  struct FlatHash<T *>
+  {
+    size_t operator()(const T * p) const
+    {
+      return internal::hashMix((uintptr_t) p, 0x9e3779b97f4a7c15ULL);
+    }
+  };
+
+  template<>
+  struct FlatHash<std::string>
+  {
+    size_t operator()(const std::string & s) const
+    {
+      return internal::hashBytes(s.data(), s.size());
+    }
+
+    size_t operator()(const char * s) const
+    {
+      return internal::hashBytes(s, ::strlen(s));
+    }
+  };
+
+  // key equality of FlatHashMap, `==' between the key and the searched type
+  struct FlatEqual
+  {
+    template<typename A, typename B>
+    bool operator()(const A & a, const B & b) const
+    {
+      return a == b;
+    }
+  };
+
+  namespace internal
+  {
+    /*
+     * Control bytes of a FlatHashMap: one per slot, EMPTY, DELETED, or the
+     * low 7 bits of the hash of the key stored there, so that a probe
+     * compares 16 of them at once and only touches the slots whose bits
+     * match.
+     */
+    struct FlatControl
+    {
+      enum Constants
+      {
+        EMPTY = -128, DELETED = -2, SENTINEL = -1, GROUP_WIDTH = 16
+      };
+
+      static const int8_t * emptyGroup()
+      {
+        static const int8_t group[GROUP_WIDTH] = { SENTINEL, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY,
+                                                   EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY };
+        return group;
+      }
+    };
+
+#if defined(__SSE2__)
+    class FlatGroup
+    {
+    private:
+      __m128i ctrl_;
+
+    public:
+      explicit FlatGroup(const int8_t * ctrl) :
+        ctrl_(_mm_loadu_si128((const __m128i *) ctrl))
+      {
+      }
+
+      // bit i set if byte i equals `h'
+      uint32_t match(int8_t h) const
+      {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h), ctrl_));
+      }
+
+      uint32_t matchEmpty() const
+      {
+        return match(FlatControl::EMPTY);
+      }
+
+      uint32_t matchEmptyOrDeleted() const
+      {
+        return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(FlatControl::SENTINEL), ctrl_));
+      }
+    };
+#else
+    class FlatGroup
+    {
+    private:
+      const int8_t * ctrl_;
+
+    public:
+      explicit FlatGroup(const int8_t * ctrl) :
+        ctrl_(ctrl)
+      {
+      }
+
+      uint32_t match(int8_t h) const
+      {
+        uint32_t mask = 0;
+        for (int i = 0; i < FlatControl::GROUP_WIDTH; ++i) {
+          mask |= (uint32_t) (ctrl_[i] == h) << i;
+        }
+        return mask;
+      }
+
+      uint32_t matchEmpty() const
+      {
+        return match(FlatControl::EMPTY);
+      }
+
+      uint32_t matchEmptyOrDeleted() const
+      {
+        uint32_t mask = 0;
+        for (int i = 0; i < FlatControl::GROUP_WIDTH; ++i) {
+          mask |= (uint32_t) (ctrl_[i] < FlatControl::SENTINEL) << i;
+        }
+        return mask;
+      }
+    };
+#endif
+  }
+
+  /*
+   * Description:
+   *   Open addressing hash map with the layout of a Swiss table: entries
+   *   are stored in place in one flat array, next to an array of control
+   *   bytes holding 7 bits of the hash of each entry.  A lookup loads 16
+   *   control bytes with SSE2, compares them with the hash bits of the key
+   *   and only compares keys of the matching slots, groups being probed
+   *   quadratically until one with an empty slot; the load factor is kept
+   *   below 7/8.  Erased slots become tombstones when a probe could have
+   *   gone past them, which the next rehash drops.
+   *
+   *   Entries never move except when the table is rehashed, i.e. when an
+   *   insertion finds no free slot left: pointers and iterators stay valid
+   *   across insertions after a reserve() of enough entries, and across
+   *   erasing other entries; erasing while iterating is allowed with
+   *   erase(iterator).  Iteration order is the slot order, the same for
+   *   the same sequence of operations.
+   *
+   *   find(), contains() and erase() take any type the hash and the
+   *   equality accept, e.g. `const char *' on a std::string keyed map.
+   *   Running out of memory while growing on insertion aborts; reserve()
+   *   reports it.
+   */
+  template<typename K, typename V, typename Hash = FlatHash<K>, typename Eq = FlatEqual>
+  class FlatHashMap: public Standard::NoCopy
+  {
+  public:
+    typedef std::pair<const K, V> value_type;
+
+  private:
+    typedef internal::FlatControl Control;
+    typedef internal::FlatGroup Group;
+
+    enum
+    {
+      WIDTH = Control::GROUP_WIDTH
+    };
+
+    int8_t * ctrl_;
+    value_type * slots_;
+    size_t capacity_;           // 0 or 2^k - 1, a mask of the slot index
+    size_t size_;
+    size_t growth_left_;        // insertions into empty slots before a rehash
+    Hash hash_;
+    Eq eq_;
+
+    static size_t maxLoad(size_t capacity)
+    {
+      return capacity - capacity / 8;
+    }
+
+    // ctrl bytes (with the mirrored first group), then the slots
+    static size_t slotsOffset(size_t capacity)
+    {
+      size_t align = __alignof__(value_type);
+      return (capacity + WIDTH + align - 1) / align * align;
+    }
+
+    void setCtrl(size_t i, int8_t h)
+    {
+      ctrl_[i] = h;
+      // the bytes after the sentinel repeat the first WIDTH - 1 ones
+      ctrl_[((i - (WIDTH - 1)) & capacity_) + (WIDTH - 1)] = h;
+    }
+
+    // first slot not holding an entry along the probe sequence of `hash'
+    size_t findFreeSlot(size_t hash) const
+    {
+      size_t offset = (hash >> 7) & capacity_;
+      for (size_t step = WIDTH;; step += WIDTH) {
+        uint32_t mask = Group(ctrl_ + offset).matchEmptyOrDeleted();
+        if (mask) {
+          return (offset + __builtin_ctz(mask)) & capacity_;
+        }
+        offset = (offset + step) & capacity_;
+      }
+    }
+
+    template<typename Q>
+    size_t findIndex(const Q & key, size_t hash) const
+    {
+      if (!capacity_) {
+        return capacity_;
+      }
+      int8_t h2 = hash & 0x7f;
+      size_t offset = (hash >> 7) & capacity_;
+      for (size_t step = WIDTH;; step += WIDTH) {
+        Group g(ctrl_ + offset);
+        for (uint32_t mask = g.match(h2); mask; mask &= mask - 1) {
+          size_t i = (offset + __builtin_ctz(mask)) & capacity_;
+          if (likely(eq_(slots_[i].first, key))) {
+            return i;
+          }
+        }
+        if (likely(g.matchEmpty())) {
+          return capacity_;
+        }
+        offset = (offset + step) & capacity_;
+      }
+    }
+
+    int rehash(size_t capacity)
+    {
+      size_t offset = slotsOffset(capacity);
+      char * mem = (char *) ::malloc(offset + capacity * sizeof(value_type));
+      if (!mem) {
+        errno = ENOMEM;
+        return -1;
+      }
+
+      int8_t * old_ctrl = ctrl_;
+      value_type * old_slots = slots_;
+      size_t old_capacity = capacity_;
+
+      ctrl_ = (int8_t *) mem;
+      slots_ = (value_type *) (mem + offset);
+      capacity_ = capacity;
+      ::memset(ctrl_, Control::EMPTY, capacity + WIDTH);
+      ctrl_[capacity] = Control::SENTINEL;
+      growth_left_ = maxLoad(capacity) - size_;
+
+      if (old_capacity) {
+        for (size_t i = 0; i < old_capacity; ++i) {
+          if (old_ctrl[i] >= 0) {
+            size_t hash = hash_(old_slots[i].first);
+            size_t j = findFreeSlot(hash);
+            setCtrl(j, hash & 0x7f);
+            new (slots_ + j) value_type(old_slots[i]);
+            old_slots[i].~value_type();
+          }
+        }
+        ::free(old_ctrl);
+      }
+      return 0;
+    }
+
+    void growIfFull()
+    {
+      // mostly tombstones: rehash to the same size to drop them
+      size_t capacity = capacity_ > WIDTH && size_ * 32 <= capacity_ * 25 ? capacity_ : capacity_ * 2 + 1;
+      if (rehash(capacity < WIDTH - 1 ? WIDTH - 1 : capacity) < 0) {
+        ::abort();
+      }
+    }
+
+    void destroyAll()
+    {
+      for (size_t i = 0; i < capacity_; ++i) {
+        if (ctrl_[i] >= 0) {
+          slots_[i].~value_type();
+        }
+      }
+    }
+
+  public:
+    template<typename Map, typename Value>
+    class IteratorBase
+    {
+    private:
+      friend class FlatHashMap;
+      Map * map_;
+      size_t index_;
+
+      IteratorBase(Map * map, size_t index) :
+        map_(map), index_(index)
+      {
+      }
+
+      void skipFree()
+      {
+        // stops at the sentinel at ctrl_[capacity_]
+        while (map_->ctrl_[index_] < Control::SENTINEL) {
+          ++index_;
+        }
+      }
+
+    public:
+      IteratorBase() :
+        map_(NULL), index_(0)
+      {
+      }
+
+      template<typename M, typename W>
+      IteratorBase(const IteratorBase<M, W> & other) :
+        map_(other.map()), index_(other.index())
+      {
+      }
+
+      Map * map() const
+      {
+        return map_;
+      }
+
+      size_t index() const
+      {
+        return index_;
+      }
+
+      Value & operator*() const
+      {
+        return map_->slots_[index_];
+      }
+
+      Value * operator->() const
+      {
+        return map_->slots_ + index_;
+      }
+
+      IteratorBase & operator++()
+      {
+        ++index_;
+        skipFree();
+        return *this;
+      }
+
+      IteratorBase operator++(int)
+      {
+        IteratorBase tmp(*this);
+        ++*this;
+        return tmp;
+      }
+
+      template<typename M, typename W>
+      bool operator==(const IteratorBase<M, W> & other) const
+      {
+        return index_ == other.index();
+      }
+
+      template<typename M, typename W>
+      bool operator!=(const IteratorBase<M, W> & other) const
+      {
+        return index_ != other.index();
+      }
+    };
+
+    typedef IteratorBase<FlatHashMap, value_type> iterator;
+    typedef IteratorBase<const FlatHashMap, const value_type> const_iterator;
+
+    FlatHashMap() :
+      ctrl_((int8_t *) Control::emptyGroup()), slots_(NULL), capacity_(0), size_(0), growth_left_(0)
+    {
+    }
+
+    ~FlatHashMap()
+    {
+      if (capacity_) {
+        destroyAll();
+        ::free(ctrl_);
+      }
+    }
+
+    size_t size() const
+    {
+      return size_;
+    }
+
+    bool empty() const
+    {
+      return !size_;
+    }
+
+    // number of slots, the map holds up to 7/8 of it before rehashing
+    size_t capacity() const
+    {
+      return capacity_;
+    }
+
+    // bytes allocated by the map, i.e. excluding what the entries own
+    size_t memoryUsage() const
+    {
+      return capacity_ ? slotsOffset(capacity_) + capacity_ * sizeof(value_type) : 0;
+    }
+
+    /*
+     * Description:
+     *   Make room for `n' entries in total, so that inserting up to them
+     *   does not rehash.
+     * Return value:
+     *   0 on success, -1 with errno set to ENOMEM on failure, the map being
+     *   unchanged.
+     */
+    int reserve(size_t n)
+    {
+      if (n <= size_ + growth_left_) {
+        return 0;
+      }
+      size_t capacity = WIDTH - 1;
+      while (maxLoad(capacity) < n) {
+        capacity = capacity * 2 + 1;
+      }
+      return rehash(capacity);
+    }
+
+    // remove every entry, keeping the allocated slots
+    void clear()
+    {
+      if (!capacity_) {
+        return;
+      }
+      destroyAll();
+      ::memset(ctrl_, Control::EMPTY, capacity_ + WIDTH);
+      ctrl_[capacity_] = Control::SENTINEL;
+      size_ = 0;
+      growth_left_ = maxLoad(capacity_);
+    }
+
+    void swap(FlatHashMap & other)
+    {
+      std::swap(ctrl_, other.ctrl_);
+      std::swap(slots_, other.slots_);
+      std::swap(capacity_, other.capacity_);
+      std::swap(size_, other.size_);
+      std::swap(growth_left_, other.growth_left_);
+      std::swap(hash_, other.hash_);
+      std::swap(eq_, other.eq_);
+    }
+
+    iterator begin()
+    {
+      iterator it(this, 0);
+      it.skipFree();
+      return it;
+    }
+
+    iterator end()
+    {
+      return iterator(this, capacity_);
+    }
+
+    const_iterator begin() const
+    {
+      const_iterator it(this, 0);
+      it.skipFree();
+      return it;
+    }
+
+    const_iterator end() const
+    {
+      return const_iterator(this, capacity_);
+    }
+
+    template<typename Q>
+    iterator find(const Q & key)
+    {
+      return iterator(this, findIndex(key, hash_(key)));
+    }
+
+    template<typename Q>
+    const_iterator find(const Q & key) const
+    {
+      return const_iterator(this, findIndex(key, hash_(key)));
+    }
+
+    template<typename Q>
+    bool contains(const Q & key) const
+    {
+      return findIndex(key, hash_(key)) != capacity_;
+    }
+
+    /*
+     * Description:
+     *   Insert (key, value) unless `key' is already there.
+     * Return value:
+     *   Iterator to the entry of `key', and whether it was inserted.
+     */
+    std::pair<iterator, bool> insert(const K & key, const V & value)
+    {
+      size_t hash = hash_(key);
+      size_t i = findIndex(key, hash);
+      if (i != capacity_) {
+        return std::make_pair(iterator(this, i), false);
+      }
+      i = findFreeSlot(hash);
+      if (unlikely(!growth_left_ && ctrl_[i] != Control::DELETED)) {
+        growIfFull();
+        i = findFreeSlot(hash);
+      }
+      growth_left_ -= ctrl_[i] == Control::EMPTY;
+      setCtrl(i, hash & 0x7f);
+      new (slots_ + i) value_type(key, value);
+      ++size_;
+      return std::make_pair(iterator(this, i), true);
+    }
+
+    std::pair<iterator, bool> insert(const value_type & entry)
+    {
+      return insert(entry.first, entry.second);
+    }
+
+    // value of `key', inserting a default constructed one if absent
+    V & operator[](const K & key)
+    {
+      return insert(key, V()).first->second;
+    }
+
+    iterator erase(iterator it)
+    {
+      size_t i = it.index_;
+      slots_[i].~value_type();
+      --size_;
+
+      // if no probe sequence went past this slot, it can be empty again:
+      // a full group around it would have been needed for that
+      size_t before = (i - WIDTH) & capacity_;
+      uint32_t empty_after = Group(ctrl_ + i).matchEmpty();
+      uint32_t empty_before = Group(ctrl_ + before).matchEmpty();
+      bool never_full = empty_before && empty_after
+          && (size_t) (__builtin_ctz(empty_after) + __builtin_clz(empty_before << 16)) < (size_t) WIDTH;
+      if (never_full) {
+        setCtrl(i, Control::EMPTY);
+        ++growth_left_;
+      }
+      else {
+        setCtrl(i, Control::DELETED);
+      }
+      return ++it;
+    }
+
+    // number of entries erased, 0 or 1
+    template<typename Q>
+    size_t erase(const Q & key)
+    {
+      size_t i = findIndex(key, hash_(key));
+      if (i == capacity_) {
+        return 0;
+      }
+      erase(iterator(this, i));
+      return 1;
+    }
+  };
+}
+
+#endif /* _BrianZ_NEBULA_HASH_MAP_H_ */
@@ -0,0 +1,238 @@
+/*
+ * io_buffer.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_IO_BUFFER_H_
+#define _BrianZ_NEBULA_IO_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <deque>
+#include "nebula/standard.h"
+
+namespace nebula
+{
+  /*
+   * Description:
+   *   Reference counted block of memory the slices of IoBuffers point
+   *   into.  Blocks of the standard size come from a process wide
+   *   SlabPool, larger ones (only made by coalesce()) from malloc().
+   */
+  struct IoBlock
+  {
+    enum
+    {
+      // header included, so that pooled blocks are a power of two
+      STANDARD_SIZE = 16 << 10,
+    };
+
+    int refs;
+    uint32_t capacity;
+    uint32_t pooled;
+    uint32_t padding;
+
+    char * data()
+    {
+      return (char *) (this + 1);
+    }
+
+    static uint32_t standardCapacity()
+    {
+      return STANDARD_SIZE - sizeof(IoBlock);
+    }
+
+    // NULL with errno set to ENOMEM
+    static IoBlock * create(size_t capacity = standardCapacity());
+
+    void ref()
+    {
+      __atomic_add_fetch(&refs, 1, __ATOMIC_RELAXED);
+    }
+
+    void unref();
+
+    // whether the caller holds the only reference, i.e. may write anywhere
+    bool exclusive() const
+    {
+      return __atomic_load_n(&refs, __ATOMIC_ACQUIRE) == 1;
+    }
+  };
+
+  struct IoSlice
+  {
+    IoBlock * block;
+    uint32_t begin;
+    uint32_t end;
+
+    const char * data() const
+    {
+      return block->data() + begin;
+    }
+
+    size_t size() const
+    {
+      return end - begin;
+    }
+  };
+
+  /*
+   * Description:
+   *   Byte queue made of slices of pooled blocks, for data passing through
+   *   a server: bytes are read from a descriptor into free block space with
+   *   readv(), moved between buffers by handing slices over, and written
+   *   out from the slices in place with writev(), without being copied in
+   *   between.  A block may be shared by slices of several buffers (see
+   *   split() and appendShared()), it is only written while exclusively
+   *   owned, so shared bytes never change; blocks may be shared across
+   *   threads, a buffer itself is not thread safe.
+   *
+   *   Methods which may allocate return 0 on success, -1 with errno set to
+   *   ENOMEM otherwise, leaving the buffer unchanged.
+   */
+  class IoBuffer: public Standard::NoCopy
+  {
+  public:
+    enum
+    {
+      // slices passed to a single readv() or writev()
+      MAX_IOV = 64,
+      // fresh blocks a readFrom() may add, 4 * 16K
+      READ_BLOCKS = 4,
+    };
+
+  private:
+    std::deque<IoSlice> slices_;
+    size_t size_;
+
+    // free space at the end of the last block, if it may be written
+    size_t tailRoom() const;
+
+  public:
+    IoBuffer() :
+      size_(0)
+    {
+    }
+
+    ~IoBuffer()
+    {
+      clear();
+    }
+
+    size_t size() const
+    {
+      return size_;
+    }
+
+    bool empty() const
+    {
+      return !size_;
+    }
+
+    size_t numSlices() const
+    {
+      return slices_.size();
+    }
+
+    const IoSlice & slice(size_t i) const
+    {
+      return slices_[i];
+    }
+
+    void clear();
+    void swap(IoBuffer & other);
+
+    // copy `len' bytes at the end
+    int append(const void * data, size_t len);
+    // copy `len' bytes at the front
+    int prepend(const void * data, size_t len);
+
+    /*
+     * Description:
+     *   Move all of `other' to the end of this buffer, without copying;
+     *   `other' is left empty.
+     */
+    void append(IoBuffer & other);
+
+    // share the bytes of `other' (which is not modified), without copying
+    void appendShared(const IoBuffer & other);
+
+    /*
+     * Description:
+     *   Move the first `len' bytes (at most size()) to the end of `front'
+     *   without copying; a slice cut in two shares its block.
+     */
+    void split(size_t len, IoBuffer * front);
+
+    // drop the first `len' bytes (at most size())
+    void consume(size_t len);
+
+    // copy up to `len' bytes from the front into `dst', return the number copied
+    size_t copyOut(void * dst, size_t len) const;
+
+    /*
+     * Description:
+     *   Make the first `len' bytes (at most size()) contiguous, copying
+     *   them into one block if they span several slices, e.g. to parse a
+     *   header.
+     * Return value:
+     *   Pointer to them, or NULL with errno set to ENOMEM.
+     */
+    const char * coalesce(size_t len);
+
+    // fill `iov' with up to `max' slices from the front, return the number filled
+    size_t peekIov(struct iovec * iov, size_t max) const;
+
+    /*
+     * Description:
+     *   One readv() from `fd' into the free space of the last block and up
+     *   to READ_BLOCKS fresh ones, the ones left unused are given back.
+     * Return value:
+     *   Bytes read, 0 at end of file, -1 with errno set on error (EAGAIN
+     *   for a non-blocking descriptor with nothing to read).
+     */
+    ssize_t readFrom(int fd);
+
+    /*
+     * Description:
+     *   One writev() of up to MAX_IOV slices to `fd', consuming what was
+     *   written.
+     * Return value:
+     *   Bytes written, -1 with errno set on error (EAGAIN for a full
+     *   non-blocking descriptor).
+     */
+    ssize_t writeTo(int fd);
+
+    /*
+     * Description:
+     *   As writeTo(), with sendmsg() and MSG_NOSIGNAL for a socket whose
+     *   peer may be gone, and at most `max' bytes.
+     */
+    ssize_t sendTo(int sockfd, size_t max = SIZE_MAX);
+  };
+}
+
+#endif /* _BrianZ_NEBULA_IO_BUFFER_H_ */
@@ -0,0 +1,187 @@
+/*
+ * multiversion.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_MULTIVERSION_H_
+#define _BrianZ_NEBULA_MULTIVERSION_H_
+
+#include <pthread.h>
+#include <stddef.h>
+#include "nebula/attributes.h"
+#include "nebula/hardwareinfo.h"
+
+namespace nebula
+{
+  /*
+   * Description:
+   *   Base of all Multiversion objects, which are linked in a global list so
+   *   that they can be resolved again when the level limit changes.
+   *
+   *   The level used is the one of the machine (HardwareInfo::simdLevel()),
+   *   lowered to the limit set by limitLevel() or, initially, by the
+   *   environment variable NEBULA_SIMD_LEVEL ("scalar", "sse4.2", "avx2",
+   *   "avx512"), so that a faulty or slow kernel can be switched off without
+   *   rebuilding.
+   */
+  class MultiversionBase
+  {
+  private:
+    MultiversionBase * prev_;
+    MultiversionBase * next_;
+    bool attached_;
+
+    static MultiversionBase * head_;
+    static pthread_mutex_t lock_;
+    static pthread_once_t limit_read_;
+    static int limit_;
+    static void readLimit();
+
+    // not copyable, Standard::NoCopy has no constexpr constructor
+    MultiversionBase(const MultiversionBase &);
+    MultiversionBase & operator=(const MultiversionBase &);
+
+  protected:
+    constexpr MultiversionBase(): prev_(NULL), next_(NULL), attached_(false)
+    {
+    }
+
+    virtual ~MultiversionBase()
+    {
+    }
+
+    virtual void resolve(SimdLevel::Constants level) = 0;
+
+    /*
+     * Resolve and add to the global list unless already done, called by the
+     * most derived class on first use; remove from the list, called before
+     * it is destroyed.
+     */
+    void attach();
+    void detach();
+
+  public:
+    /*
+     * Description:
+     *   Level implementations are currently selected for.
+     */
+    static SimdLevel::Constants level();
+
+    static SimdLevel::Constants levelLimit();
+
+    /*
+     * Description:
+     *   Select, for every Multiversion object, the best implementation not
+     *   above `limit' (and not above what the machine supports).  Calls made
+     *   concurrently by other threads use either the old or the new
+     *   implementation.
+     */
+    static void limitLevel(SimdLevel::Constants limit);
+  };
+
+  /*
+   * Description:
+   *   Function pointer resolved to the best implementation available on this
+   *   machine, once, on first use.  The constructor is constexpr, so a
+   *   namespace scope object built from function addresses is constant
+   *   initialized and can be called from any other static initializer; a
+   *   call costs one predictable branch and one indirect call:
+   *
+   *     static Multiversion<size_t (*)(const char *, size_t)> count_impl(
+   *         countScalar, countSse42, countAvx2, NULL);
+   *     ...
+   *     return count_impl.get()(s, len);
+   *
+   *   Every implementation but the scalar one may be NULL, the one of the
+   *   next lower level available is used instead.  Implementations above
+   *   SCALAR should be compiled for their level with TARGET() (see
+   *   attributes.h) rather than by flags for the whole file, so that nothing
+   *   else in the file uses instructions the machine may not have.
+   */
+  template<typename F>
+  class Multiversion: public MultiversionBase
+  {
+  private:
+    F impls_[SimdLevel::NUM_LEVELS];
+    F fn_;
+    SimdLevel::Constants level_;
+
+  protected:
+    virtual void resolve(SimdLevel::Constants level)
+    {
+      int i = level;
+      while (i > SimdLevel::SCALAR && !impls_[i]) {
+        --i;
+      }
+      level_ = (SimdLevel::Constants) i;
+      __atomic_store_n(&fn_, impls_[i], __ATOMIC_RELEASE);
+    }
+
+  public:
+    // implementations in SimdLevel order: SCALAR, SSE42, AVX2, AVX512
+    constexpr Multiversion(F scalar, F sse42, F avx2, F avx512):
+        impls_{scalar, sse42, avx2, avx512}, fn_(NULL), level_(SimdLevel::SCALAR)
+    {
+    }
+
+    virtual ~Multiversion()
+    {
+      detach();
+    }
+
+    F get()
+    {
+      F fn = __atomic_load_n(&fn_, __ATOMIC_ACQUIRE);
+      if (unlikely(!fn)) {
+        attach();
+        fn = __atomic_load_n(&fn_, __ATOMIC_ACQUIRE);
+      }
+      return fn;
+    }
+
+    /*
+     * Description:
+     *   Level of the implementation returned by get().
+     */
+    SimdLevel::Constants selectedLevel()
+    {
+      if (unlikely(!__atomic_load_n(&fn_, __ATOMIC_ACQUIRE))) {
+        attach();
+      }
+      return level_;
+    }
+
+    /*
+     * Description:
+     *   Implementation written for exactly `level', NULL if there is none.
+     *   It must not be called unless the machine supports `level'.
+     */
+    F implementation(SimdLevel::Constants level) const
+    {
+      return impls_[level];
+    }
+  };
+}
+
+#endif /* _BrianZ_NEBULA_MULTIVERSION_H_ */
@@ -28,9 +28,30 @@
 #define _BrianZ_NEBULA_MUTEX_H_
 
 #include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 
 namespace nebula
 {
+  /*
+   * Description:
+   *   Hint to the processor that the caller is busy-waiting.
+   */
+  inline void cpuRelax()
+  {
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#else
+    __asm__ __volatile__("" ::: "memory");
+#endif
+  }
+
   class Mutex
   {
   private:
@@ -72,6 +93,451 @@ namespace nebula
       return (native_handle_type) &impl_;
     }
   };
+
+  /*
+   * Description:
+   *   Mutex built directly on futex(2): spins for a bounded number of rounds
+   *   while the lock is held, then sleeps in the kernel.  Uncontended
+   *   lock()/unlock() are a single atomic instruction each, and unlock()
+   *   only enters the kernel if some thread is sleeping.
+   */
+  class AdaptiveMutex
+  {
+  private:
+    enum
+    {
+      UNLOCKED = 0, LOCKED = 1, CONTENDED = 2 // locked, and there may be sleeping waiters
+    };
+
+    int state_;
+    int spin_limit_;
+
+    AdaptiveMutex(const AdaptiveMutex &);
+    AdaptiveMutex & operator=(const AdaptiveMutex &);
+
+  public:
+    enum
+    {
+      DEFAULT_SPIN_LIMIT = 100
+    };
+
+    AdaptiveMutex(int spin_limit = DEFAULT_SPIN_LIMIT) :
+      state_(UNLOCKED), spin_limit_(spin_limit)
+    {
+    }
+
+    void lock()
+    {
+      int c = UNLOCKED;
+      if (__atomic_compare_exchange_n(&state_, &c, LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return;
+      }
+      for (int i = 0; i < spin_limit_ && c != CONTENDED; ++i) {
+        cpuRelax();
+        c = UNLOCKED;
+        if (__atomic_load_n(&state_, __ATOMIC_RELAXED) == UNLOCKED //
+            && __atomic_compare_exchange_n(&state_, &c, LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+          return;
+        }
+      }
+      // from now on the lock is taken as CONTENDED, the owner has to wake somebody up
+      while (__atomic_exchange_n(&state_, CONTENDED, __ATOMIC_ACQUIRE) != UNLOCKED) {
+        syscall(SYS_futex, &state_, FUTEX_WAIT_PRIVATE, CONTENDED, NULL, NULL, 0);
+      }
+    }
+
+    bool try_lock()
+    {
+      int c = UNLOCKED;
+      return __atomic_compare_exchange_n(&state_, &c, LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    }
+
+    void unlock()
+    {
+      if (__atomic_exchange_n(&state_, UNLOCKED, __ATOMIC_RELEASE) == CONTENDED) {
+        syscall(SYS_futex, &state_, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+      }
+    }
+  };
+
+  /*
+   * Description:
+   *   Test-and-test-and-set spinlock with exponential backoff, for very short
+   *   critical sections.  Waiters spin on a load, not on the atomic
+   *   exchange, so the cache line is not bounced while the lock is held.
+   *   Once the backoff reached its maximum the processor is yielded, so
+   *   that a preempted owner gets a chance to run.
+   */
+  class SpinLock
+  {
+  private:
+    int locked_;
+
+    SpinLock(const SpinLock &);
+    SpinLock & operator=(const SpinLock &);
+
+  public:
+    enum
+    {
+      MAX_BACKOFF = 1024 // pause instructions
+    };
+
+    SpinLock() :
+      locked_(0)
+    {
+    }
+
+    void lock()
+    {
+      int backoff = 1;
+      while (__atomic_exchange_n(&locked_, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&locked_, __ATOMIC_RELAXED)) {
+          if (backoff < MAX_BACKOFF) {
+            for (int i = 0; i < backoff; ++i) {
+              cpuRelax();
+            }
+            backoff <<= 1;
+          }
+          else {
+            sched_yield();
+          }
+        }
+      }
+    }
+
+    bool try_lock()
+    {
+      return !__atomic_load_n(&locked_, __ATOMIC_RELAXED) && !__atomic_exchange_n(&locked_, 1, __ATOMIC_ACQUIRE);
+    }
+
+    void unlock()
+    {
+      __atomic_store_n(&locked_, 0, __ATOMIC_RELEASE);
+    }
+  };
+
+  /*
+   * Description:
+   *   FIFO spinlock: threads take a ticket and are served in order, so no
+   *   waiter starves under contention.  Each waiter backs off in proportion
+   *   to its distance from the head of the queue, and yields the processor
+   *   when it is far behind or the queue did not move for a while.  Like
+   *   any FIFO lock, it degrades badly when there are more runnable threads
+   *   than processors, since a preempted waiter stalls everybody behind it.
+   */
+  class TicketLock
+  {
+  private:
+    unsigned int next_;
+    unsigned int serving_;
+
+    TicketLock(const TicketLock &);
+    TicketLock & operator=(const TicketLock &);
+
+  public:
+    enum
+    {
+      BACKOFF_PER_WAITER = 32, // pause instructions
+      YIELD_DISTANCE = 2, // waiters further behind yield the processor
+      SPIN_LIMIT = 16 // rounds of backoff without progress before yielding
+    };
+
+    TicketLock() :
+      next_(0), serving_(0)
+    {
+    }
+
+    void lock()
+    {
+      unsigned int ticket = __atomic_fetch_add(&next_, 1, __ATOMIC_RELAXED);
+      unsigned int last = ticket;
+      int rounds = 0;
+      for (;;) {
+        unsigned int distance = ticket - __atomic_load_n(&serving_, __ATOMIC_ACQUIRE);
+        if (!distance) {
+          return;
+        }
+        if (distance != last) {
+          last = distance;
+          rounds = 0;
+        }
+        if (distance >= YIELD_DISTANCE || ++rounds > SPIN_LIMIT) {
+          sched_yield(); // the owner, or the next in line, has probably been preempted
+        }
+        else {
+          for (unsigned int i = 0; i < distance * BACKOFF_PER_WAITER; ++i) {
+            cpuRelax();
+          }
+        }
+      }
+    }
+
+    bool try_lock()
+    {
+      unsigned int serving = __atomic_load_n(&serving_, __ATOMIC_ACQUIRE);
+      unsigned int ticket = serving;
+      return __atomic_compare_exchange_n(&next_, &ticket, serving + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    }
+
+    void unlock()
+    {
+      // only the owner writes serving_
+      __atomic_store_n(&serving_, __atomic_load_n(&serving_, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE);
+    }
+  };
+
+  /*
+   * Description:
+   *   Holds a lock of any of the types above for the lifetime of the object.
+   */
+  template<typename LockType>
+  class ScopedLock
+  {
+  private:
+    LockType & lock_;
+
+    ScopedLock(const ScopedLock &);
+    ScopedLock & operator=(const ScopedLock &);
+
+  public:
+    explicit ScopedLock(LockType & lock) :
+      lock_(lock)
+    {
+      lock_.lock();
+    }
+
+    ~ScopedLock()
+    {
+      lock_.unlock();
+    }
+  };
+
+  /*
+   * Description:
+   *   Reader-writer lock for read-mostly data.  Readers only increment a
+   *   counter in the slot of the processor they are running on, so readers
+   *   on different processors do not share any cache line; writers set a
+   *   flag and wait for every slot to drain, which makes writing expensive.
+   *   Writers have priority, readers arriving while a writer is waiting or
+   *   active step back until it is done.  lockShared() returns the slot it
+   *   used, which must be passed to unlockShared() (the thread may have
+   *   migrated to another processor meanwhile).
+   */
+  class DistributedRWLock
+  {
+  private:
+    enum
+    {
+      CACHE_LINE_SIZE = 64, MAX_SLOTS = 256
+    };
+
+    struct Slot
+    {
+      int readers;
+      char padding[CACHE_LINE_SIZE - sizeof(int)];
+    };
+
+    Slot * slots_;
+    unsigned int mask_;
+    int writer_; // a writer is waiting for, or holding the lock
+    AdaptiveMutex writer_lock_;
+    Slot single_; // the only slot if the array could not be allocated
+
+    DistributedRWLock(const DistributedRWLock &);
+    DistributedRWLock & operator=(const DistributedRWLock &);
+
+  public:
+    DistributedRWLock() :
+      slots_(NULL), mask_(0), writer_(0)
+    {
+      long n = sysconf(_SC_NPROCESSORS_CONF);
+      unsigned int num_slots = 1;
+      while ((long) num_slots < n && num_slots < MAX_SLOTS) {
+        num_slots <<= 1;
+      }
+      void * p = NULL;
+      if (posix_memalign(&p, CACHE_LINE_SIZE, num_slots * sizeof(Slot))) {
+        // still correct, all readers share one counter
+        memset(&single_, 0, sizeof(single_));
+        slots_ = &single_;
+        mask_ = 0;
+        return;
+      }
+      memset(p, 0, num_slots * sizeof(Slot));
+      slots_ = (Slot *) p;
+      mask_ = num_slots - 1;
+    }
+
+    ~DistributedRWLock()
+    {
+      if (slots_ != &single_) {
+        free(slots_);
+      }
+    }
+
+    int lockShared()
+    {
+      for (;;) {
+        int cpu = sched_getcpu();
+        int slot = (cpu < 0 ? 0 : cpu) & mask_;
+        // pairs with the store of `writer_' and the loads of the counters in lock()
+        __atomic_fetch_add(&slots_[slot].readers, 1, __ATOMIC_SEQ_CST);
+        if (!__atomic_load_n(&writer_, __ATOMIC_SEQ_CST)) {
+          return slot;
+        }
+        __atomic_fetch_sub(&slots_[slot].readers, 1, __ATOMIC_RELEASE);
+        for (int i = 0; __atomic_load_n(&writer_, __ATOMIC_RELAXED); ++i) {
+          if (i < 100) {
+            cpuRelax();
+          }
+          else {
+            sched_yield();
+          }
+        }
+      }
+    }
+
+    void unlockShared(int slot)
+    {
+      __atomic_fetch_sub(&slots_[slot].readers, 1, __ATOMIC_RELEASE);
+    }
+
+    void lock()
+    {
+      writer_lock_.lock();
+      __atomic_store_n(&writer_, 1, __ATOMIC_SEQ_CST);
+      for (unsigned int i = 0; i <= mask_; ++i) {
+        for (int j = 0; __atomic_load_n(&slots_[i].readers, __ATOMIC_SEQ_CST); ++j) {
+          if (j < 100) {
+            cpuRelax();
+          }
+          else {
+            sched_yield();
+          }
+        }
+      }
+    }
+
+    void unlock()
+    {
+      __atomic_store_n(&writer_, 0, __ATOMIC_RELEASE);
+      writer_lock_.unlock();
+    }
+  };
+
+  /*
+   * Description:
+   *   Holds a DistributedRWLock in shared mode for the lifetime of the object.
+   */
+  class ScopedSharedLock
+  {
+  private:
+    DistributedRWLock & lock_;
+    int slot_;
+
+    ScopedSharedLock(const ScopedSharedLock &);
+    ScopedSharedLock & operator=(const ScopedSharedLock &);
+
+  public:
+    explicit ScopedSharedLock(DistributedRWLock & lock) :
+      lock_(lock), slot_(lock.lockShared())
+    {
+    }
+
+    ~ScopedSharedLock()
+    {
+      lock_.unlockShared(slot_);
+    }
+  };
+
+  /*
+   * Description:
+   *   Sequence lock protecting a small value of plain old data type `T'.
+   *   Readers never write to shared memory: they copy the value and retry if
+   *   a writer was active meanwhile, so reads scale with the number of
+   *   processors but may spin while writes are frequent.  Writers are
+   *   serialized by a SpinLock.  The value is stored as machine words which
+   *   are accessed atomically, so torn copies are detected, never used.
+   */
+  template<typename T>
+  class SeqLock
+  {
+  private:
+    enum
+    {
+      NUM_WORDS = (sizeof(T) + sizeof(unsigned long) - 1) / sizeof(unsigned long)
+    };
+
+    unsigned int sequence_; // odd while a write is in progress
+    unsigned long words_[NUM_WORDS];
+    SpinLock writer_lock_;
+
+    SeqLock(const SeqLock &);
+    SeqLock & operator=(const SeqLock &);
+
+  public:
+    SeqLock() :
+      sequence_(0)
+    {
+      memset(words_, 0, sizeof(words_));
+    }
+
+    explicit SeqLock(const T & value) :
+      sequence_(0)
+    {
+      memset(words_, 0, sizeof(words_));
+      memcpy(words_, &value, sizeof(T));
+    }
+
+    /*
+     * Description:
+     *   Copy a consistent snapshot of the value into `*value'.
+     * Return value:
+     *   Number of retries, mostly for statistics.
+     */
+    int read(T * value) const
+    {
+      unsigned long copy[NUM_WORDS];
+      for (int retries = 0;; ++retries) {
+        unsigned int seq = __atomic_load_n(&sequence_, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+          cpuRelax();
+          continue;
+        }
+        for (int i = 0; i < NUM_WORDS; ++i) {
+          copy[i] = __atomic_load_n(&words_[i], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&sequence_, __ATOMIC_RELAXED) == seq) {
+          memcpy(value, copy, sizeof(T));
+          return retries;
+        }
+      }
+    }
+
+    T read() const
+    {
+      T value;
+      read(&value);
+      return value;
+    }
+
+    void write(const T & value)
+    {
+      unsigned long copy[NUM_WORDS];
+      memset(copy, 0, sizeof(copy));
+      memcpy(copy, &value, sizeof(T));
+      writer_lock_.lock();
+      unsigned int seq = __atomic_load_n(&sequence_, __ATOMIC_RELAXED);
+      __atomic_store_n(&sequence_, seq + 1, __ATOMIC_RELAXED);
+      __atomic_thread_fence(__ATOMIC_RELEASE);
+      for (int i = 0; i < NUM_WORDS; ++i) {
+        __atomic_store_n(&words_[i], copy[i], __ATOMIC_RELAXED);
+      }
+      __atomic_store_n(&sequence_, seq + 2, __ATOMIC_RELEASE);
+      writer_lock_.unlock();
+    }
+  };
 }
 
 #endif /* _BrianZ_NEBULA_MUTEX_H_ */
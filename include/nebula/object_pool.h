@@ -0,0 +1,253 @@
+/*
+ * object_pool.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_OBJECT_POOL_H_
+#define _BrianZ_NEBULA_OBJECT_POOL_H_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <vector>
+#include "nebula/attributes.h"
+#include "nebula/mutex.h"
+#include "nebula/standard.h"
+
+namespace nebula
+{
+  struct ObjectPoolStats
+  {
+    size_t object_size;         // bytes per object, after rounding
+    size_t live_objects;        // allocated and not freed yet
+    size_t depot_magazines;     // magazines holding objects in the depot
+    size_t depot_objects;       // objects in those magazines
+    size_t empty_magazines;     // empty magazines in the depot
+    size_t threads;             // threads with a cache
+    size_t slabs;
+    size_t huge_page_slabs;     // slabs backed by huge pages
+    size_t slab_bytes;
+  };
+
+  /*
+   * Description:
+   *   Type independent part of ObjectPool: fixed size blocks carved out of
+   *   large slabs, cached per thread in magazines (Bonwick and Adams,
+   *   "Magazines and Vmem", 2001).
+   *
+   *   Every thread owns two magazines, arrays of up to MAGAZINE_SIZE free
+   *   blocks, and allocates from and frees into them without any atomic
+   *   instruction.  Only when both are empty (allocating) or full (freeing)
+   *   does it go to the depot, a locked list of magazines shared by all
+   *   threads, to exchange a whole magazine.  Blocks may be freed by any
+   *   thread: with a producer allocating and a consumer freeing, the
+   *   consumer's full magazines travel to the producer through the depot.
+   *   When a thread exits its magazines are returned to the depot.
+   *
+   *   Slabs are mmap()ed, optionally on huge pages, and only unmapped when
+   *   the pool is destroyed, which must happen after every thread stopped
+   *   using it.
+   */
+  class SlabPool: public Standard::NoCopy
+  {
+  public:
+    enum
+    {
+      MAGAZINE_SIZE = 64,
+      DEFAULT_SLAB_SIZE = 256 << 10,
+      HUGE_PAGE_SIZE = 2 << 20,
+    };
+
+    enum Flags
+    {
+      // map slabs on huge pages (MAP_HUGETLB, or transparent huge pages
+      // when none are reserved), slabs are then at least HUGE_PAGE_SIZE
+      HUGE_PAGES = 1,
+    };
+
+  private:
+    struct Magazine
+    {
+      Magazine * next;
+      size_t count;
+      void * blocks[MAGAZINE_SIZE];
+    };
+
+    struct ThreadCache
+    {
+      Magazine * loaded;
+      Magazine * previous;
+      // written by the owner only, read by stats()
+      uint64_t allocs;
+      uint64_t frees;
+      ThreadCache * prev_cache;
+      ThreadCache * next_cache;
+      SlabPool * pool;
+    };
+
+    size_t object_size_;
+    size_t slab_size_;
+    int flags_;
+    bool initialized_;
+    pthread_key_t key_;
+
+    AdaptiveMutex lock_;        // protects everything below
+    Magazine * full_;           // magazines holding blocks (not necessarily MAGAZINE_SIZE)
+    Magazine * empty_;
+    size_t num_full_;
+    size_t num_full_blocks_;
+    size_t num_empty_;
+    ThreadCache * caches_;
+    size_t num_caches_;
+    uint64_t retired_allocs_;   // of exited threads
+    uint64_t retired_frees_;
+    char * slab_ptr_;           // not carved yet part of the newest slab
+    char * slab_end_;
+    std::vector<std::pair<void *, size_t> > slabs_;
+    size_t huge_page_slabs_;
+
+    ThreadCache * attach();
+    void detach(ThreadCache * cache);
+    static void threadExit(void * cache);
+
+    void * allocateSlow(ThreadCache * cache);
+    void freeSlow(ThreadCache * cache, void * block);
+    // carve up to MAGAZINE_SIZE blocks into `m', lock held
+    int refill(Magazine * m);
+    int mapSlab();
+
+    ThreadCache * cache()
+    {
+      ThreadCache * c = (ThreadCache *) pthread_getspecific(key_);
+      return likely(c != NULL) ? c : attach();
+    }
+
+  public:
+    /*
+     * Blocks of `object_size' bytes aligned on `align' (a power of two),
+     * available after init().
+     */
+    SlabPool(size_t object_size, size_t align);
+    ~SlabPool();
+
+    /*
+     * Description:
+     *   `flags' is a combination of Flags; `slab_size' the bytes carved at
+     *   a time.
+     * Return value:
+     *   0 on success, -1 with errno set on failure.
+     */
+    int init(int flags = 0, size_t slab_size = DEFAULT_SLAB_SIZE);
+
+    size_t objectSize() const
+    {
+      return object_size_;
+    }
+
+    /*
+     * Return value:
+     *   A block, or NULL with errno set to ENOMEM.
+     */
+    void * allocate()
+    {
+      ThreadCache * c = cache();
+      if (likely(c && c->loaded->count)) {
+        __atomic_store_n(&c->allocs, c->allocs + 1, __ATOMIC_RELAXED);
+        return c->loaded->blocks[--c->loaded->count];
+      }
+      return allocateSlow(c);
+    }
+
+    // `block' must come from allocate() of this pool, any thread may free it
+    void free(void * block)
+    {
+      ThreadCache * c = cache();
+      if (likely(c && c->loaded->count < MAGAZINE_SIZE)) {
+        __atomic_store_n(&c->frees, c->frees + 1, __ATOMIC_RELAXED);
+        c->loaded->blocks[c->loaded->count++] = block;
+        return;
+      }
+      freeSlow(c, block);
+    }
+
+    // counters of live objects are exact only while no thread is busy
+    ObjectPoolStats stats();
+  };
+
+  /*
+   * Description:
+   *   Pool of T, recycling the memory of destroyed objects for new ones,
+   *   see SlabPool:
+   *
+   *     nebula::ObjectPool<Connection> pool;
+   *     if (pool.init() < 0) ...
+   *     Connection * c = pool.create();
+   *     ...
+   *     pool.destroy(c);      // from any thread
+   */
+  template<typename T>
+  class ObjectPool: public Standard::NoCopy
+  {
+  private:
+    SlabPool pool_;
+
+  public:
+    ObjectPool() :
+      pool_(sizeof(T), __alignof__(T))
+    {
+    }
+
+    int init(int flags = 0, size_t slab_size = SlabPool::DEFAULT_SLAB_SIZE)
+    {
+      return pool_.init(flags, slab_size);
+    }
+
+    // default constructed T, NULL with errno set to ENOMEM
+    T * create()
+    {
+      void * p = pool_.allocate();
+      return p ? new (p) T() : NULL;
+    }
+
+    T * create(const T & value)
+    {
+      void * p = pool_.allocate();
+      return p ? new (p) T(value) : NULL;
+    }
+
+    void destroy(T * object)
+    {
+      object->~T();
+      pool_.free(object);
+    }
+
+    ObjectPoolStats stats()
+    {
+      return pool_.stats();
+    }
+  };
+}
+
+#endif /* _BrianZ_NEBULA_OBJECT_POOL_H_ */
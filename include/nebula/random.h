@@ -27,20 +27,431 @@
 #ifndef _BrianZ_NEBULA_RANDOM_H_
 #define _BrianZ_NEBULA_RANDOM_H_
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 namespace nebula
 {
-  typedef class Prng
+  /*
+   * Description:
+   *   Helpers shared by the generators below, `Derived' provides randomU32()
+   *   and randomU64().
+   */
+  template<typename Derived>
+  class RandomHelpers
+  {
+  private:
+    Derived & self()
+    {
+      return *static_cast<Derived *> (this);
+    }
+
+  public:
+    int32_t randomI32()
+    {
+      return (int32_t) self().randomU32();
+    }
+
+    int64_t randomI64()
+    {
+      return (int64_t) self().randomU64();
+    }
+
+    /*
+     * Description:
+     *   Uniformly distributed integer in [0, n), n > 0, without the bias of
+     *   `random() % n' and almost always without a division (D. Lemire,
+     *   "Fast Random Integer Generation in an Interval", 2019).
+     */
+    uint32_t nextBelow(uint32_t n)
+    {
+      uint64_t m = (uint64_t) self().randomU32() * n;
+      uint32_t low = (uint32_t) m;
+      if (low < n) {
+        uint32_t threshold = -n % n; // 2^32 mod n
+        while (low < threshold) {
+          m = (uint64_t) self().randomU32() * n;
+          low = (uint32_t) m;
+        }
+      }
+      return (uint32_t) (m >> 32);
+    }
+
+    uint64_t nextBelow64(uint64_t n)
+    {
+      unsigned __int128 m = (unsigned __int128) self().randomU64() * n;
+      uint64_t low = (uint64_t) m;
+      if (low < n) {
+        uint64_t threshold = -n % n;
+        while (low < threshold) {
+          m = (unsigned __int128) self().randomU64() * n;
+          low = (uint64_t) m;
+        }
+      }
+      return (uint64_t) (m >> 64);
+    }
+
+    /*
+     * Description:
+     *   Uniformly distributed integer in [low, high], low <= high.
+     */
+    int64_t nextInRange(int64_t low, int64_t high)
+    {
+      uint64_t span = (uint64_t) high - (uint64_t) low + 1;
+      return span ? (int64_t) ((uint64_t) low + nextBelow64(span)) : self().randomI64();
+    }
+
+    /*
+     * Description:
+     *   Uniformly distributed double in [0, 1), all 53 bits random.
+     */
+    double nextDouble()
+    {
+      return (self().randomU64() >> 11) * (1.0 / (1ULL << 53));
+    }
+
+    /*
+     * Description:
+     *   Uniformly distributed float in [0, 1), all 24 bits random.
+     */
+    float nextFloat()
+    {
+      return (self().randomU32() >> 8) * (1.0f / (1U << 24));
+    }
+
+    bool nextBool()
+    {
+      return self().randomU64() >> 63;
+    }
+  };
+
+  /*
+   * Description:
+   *   SplitMix64 (S. Vigna), a 64 bit counter through a mixing function.
+   *   Fast and good enough for one stream, mainly used to expand a small
+   *   seed into the state of the other generators.
+   */
+  class SplitMix64: public RandomHelpers<SplitMix64>
+  {
+  private:
+    uint64_t state_;
+
+  public:
+    explicit SplitMix64(uint64_t seed = 0) :
+      state_(seed)
+    {
+    }
+
+    void initialize(uint64_t seed = 0)
+    {
+      state_ = seed;
+    }
+
+    uint64_t randomU64()
+    {
+      uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+
+    uint32_t randomU32()
+    {
+      return (uint32_t) (randomU64() >> 32);
+    }
+  };
+
+  /*
+   * Description:
+   *   xoshiro256** (D. Blackman and S. Vigna), 256 bits of state, period
+   *   2^256 - 1, passes BigCrush and PractRand, a few cycles per 64 bit draw.
+   *   jump() advances by 2^128 draws and longJump() by 2^192, so that
+   *   threads can be given non overlapping streams from a single seed:
+   *   copy the generator, jump() the original, hand the copy to a thread.
+   */
+  class Xoshiro256ss: public RandomHelpers<Xoshiro256ss>
+  {
+  private:
+    uint64_t s_[4];
+
+    static uint64_t rotl(uint64_t x, int k)
+    {
+      return (x << k) | (x >> (64 - k));
+    }
+
+    void jump(const uint64_t * polynomial)
+    {
+      uint64_t t[4] = { 0, 0, 0, 0 };
+      for (int i = 0; i < 4; ++i) {
+        for (int b = 0; b < 64; ++b) {
+          if (polynomial[i] & (1ULL << b)) {
+            t[0] ^= s_[0];
+            t[1] ^= s_[1];
+            t[2] ^= s_[2];
+            t[3] ^= s_[3];
+          }
+          (void) randomU64();
+        }
+      }
+      memcpy(s_, t, sizeof(s_));
+    }
+
+  public:
+    explicit Xoshiro256ss(uint64_t seed = 1)
+    {
+      initialize(seed);
+    }
+
+    /*
+     * Description:
+     *   State expanded from `seed' by SplitMix64, never all zero.
+     */
+    void initialize(uint64_t seed = 1)
+    {
+      SplitMix64 sm(seed);
+      for (int i = 0; i < 4; ++i) {
+        s_[i] = sm.randomU64();
+      }
+    }
+
+    /*
+     * Description:
+     *   Use `state' as is, it must not be all zero.
+     */
+    void setState(const uint64_t state[4])
+    {
+      memcpy(s_, state, sizeof(s_));
+    }
+
+    const uint64_t * state() const
+    {
+      return s_;
+    }
+
+    uint64_t randomU64()
+    {
+      const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+      const uint64_t t = s_[1] << 17;
+      s_[2] ^= s_[0];
+      s_[3] ^= s_[1];
+      s_[1] ^= s_[2];
+      s_[0] ^= s_[3];
+      s_[2] ^= t;
+      s_[3] = rotl(s_[3], 45);
+      return result;
+    }
+
+    uint32_t randomU32()
+    {
+      return (uint32_t) (randomU64() >> 32);
+    }
+
+    void jump()
+    {
+      static const uint64_t polynomial[4] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL,
+          0x39abdc4529b1661cULL };
+      jump(polynomial);
+    }
+
+    void longJump()
+    {
+      static const uint64_t polynomial[4] = { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL,
+          0x39109bb02acbe635ULL };
+      jump(polynomial);
+    }
+  };
+
+  /*
+   * Description:
+   *   PCG32 (M. O'Neill, PCG-XSH-RR 64/32), 64 bits of state, 32 bits per
+   *   draw.  Every odd increment is a different stream, so independent
+   *   generators can simply be created with different `stream' numbers;
+   *   advance() skips ahead in O(log n).
+   */
+  class Pcg32: public RandomHelpers<Pcg32>
+  {
+  private:
+    static const uint64_t MULTIPLIER = 6364136223846793005ULL;
+
+    uint64_t state_;
+    uint64_t increment_;
+
+  public:
+    explicit Pcg32(uint64_t seed = 1, uint64_t stream = 1)
+    {
+      initialize(seed, stream);
+    }
+
+    void initialize(uint64_t seed = 1, uint64_t stream = 1)
+    {
+      state_ = 0;
+      increment_ = (stream << 1) | 1;
+      (void) randomU32();
+      state_ += seed;
+      (void) randomU32();
+    }
+
+    uint32_t randomU32()
+    {
+      uint64_t old = state_;
+      state_ = old * MULTIPLIER + increment_;
+      uint32_t xorshifted = (uint32_t) (((old >> 18) ^ old) >> 27);
+      uint32_t rot = (uint32_t) (old >> 59);
+      return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+
+    uint64_t randomU64()
+    {
+      uint64_t high = randomU32();
+      return (high << 32) | randomU32();
+    }
+
+    /*
+     * Description:
+     *   Skip `delta' draws of randomU32() (F. Brown, "Random Number
+     *   Generation with Arbitrary Stride", 1994).
+     */
+    void advance(uint64_t delta)
+    {
+      uint64_t cur_mult = MULTIPLIER;
+      uint64_t cur_plus = increment_;
+      uint64_t acc_mult = 1;
+      uint64_t acc_plus = 0;
+      while (delta) {
+        if (delta & 1) {
+          acc_mult *= cur_mult;
+          acc_plus = acc_plus * cur_mult + cur_plus;
+        }
+        cur_plus = (cur_mult + 1) * cur_plus;
+        cur_mult *= cur_mult;
+        delta >>= 1;
+      }
+      state_ = acc_mult * state_ + acc_plus;
+    }
+  };
+
+  /*
+   * Description:
+   *   Eight interleaved xoshiro256** generators, for filling large buffers:
+   *   the output is lane 0, lane 1, ..., lane 7, lane 0, ... and the lanes
+   *   advance together, 64 bytes per step, so that they map onto AVX2 (two
+   *   registers per state word) or AVX-512 registers (see multiversion.h).
+   *   The output only depends on the seed and on the sizes of the calls,
+   *   never on the kernel used: every call consumes whole steps, the unused
+   *   part of the last one is discarded.  Lanes are seeded from consecutive
+   *   SplitMix64 outputs.
+   */
+  class Xoshiro256x8
+  {
+  public:
+    enum
+    {
+      LANES = 8, BLOCK_SIZE = LANES * sizeof(uint64_t)
+    };
+
+  private:
+    uint64_t s_[4][LANES] __attribute__((aligned(64))); // s_[word][lane]
+
+  public:
+    explicit Xoshiro256x8(uint64_t seed = 1)
+    {
+      initialize(seed);
+    }
+
+    void initialize(uint64_t seed = 1);
+
+    /*
+     * Description:
+     *   Fill `len' bytes at `buf' (no alignment needed) with random bytes.
+     */
+    void fill(void * buf, size_t len);
+
+    void fillU32(uint32_t * dst, size_t n)
+    {
+      fill(dst, n * sizeof(*dst));
+    }
+
+    void fillU64(uint64_t * dst, size_t n)
+    {
+      fill(dst, n * sizeof(*dst));
+    }
+  };
+
+  /*
+   * Description:
+   *   Default generator, xoshiro256**.
+   */
+  class Prng: public Xoshiro256ss
+  {
+  public:
+    enum
+    {
+      BULK_THRESHOLD = 256 // smaller fills use randomU64() directly
+    };
+
+    Prng(unsigned int seed = 1) :
+      Xoshiro256ss(seed)
+    {
+    }
+
+    void initialize(unsigned int seed = 1)
+    {
+      Xoshiro256ss::initialize(seed);
+    }
+
+    /*
+     * Description:
+     *   Fill `len' bytes at `buf' with random bytes.  Large buffers are
+     *   filled by an Xoshiro256x8 seeded with one draw of this generator, so
+     *   the output is reproducible from the seed of the Prng.
+     */
+    void fill(void * buf, size_t len)
+    {
+      if (len >= BULK_THRESHOLD) {
+        Xoshiro256x8 bulk(randomU64());
+        bulk.fill(buf, len);
+        return;
+      }
+      char * p = (char *) buf;
+      for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t), p += sizeof(uint64_t)) {
+        uint64_t v = randomU64();
+        memcpy(p, &v, sizeof(v));
+      }
+      if (len) {
+        uint64_t v = randomU64();
+        memcpy(p, &v, len);
+      }
+    }
+
+    void fillU32(uint32_t * dst, size_t n)
+    {
+      fill(dst, n * sizeof(*dst));
+    }
+
+    void fillU64(uint64_t * dst, size_t n)
+    {
+      fill(dst, n * sizeof(*dst));
+    }
+  };
+
+  typedef Prng PseudoRandomNumberGenerator;
+
+  /*
+   * Description:
+   *   The former Prng, glibc random_r() with a 64 byte state, 31 bits per
+   *   call.  Several times slower and statistically weaker than the
+   *   generators above, kept to reproduce existing sequences.
+   */
+  class LibcPrng: public RandomHelpers<LibcPrng>
   {
   private:
     char statebuf_[64];
     struct random_data databuf_;
 
   public:
-    Prng(unsigned int seed = 1)
+    LibcPrng(unsigned int seed = 1)
     {
       initialize(seed);
     }
@@ -54,11 +465,6 @@ namespace nebula
       srandom_r(seed, &databuf_);
     }
 
-    int32_t randomI32()
-    {
-      return (int32_t) randomU32();
-    }
-
     uint32_t randomU32()
     {
       uint32_t r, r2;
@@ -77,12 +483,7 @@ namespace nebula
       r |= b;
       return r;
     }
-
-    int64_t randomI64()
-    {
-      return (int64_t) randomU64();
-    }
-  } PseudoRandomNumberGenerator;
+  };
 }
 
 #endif /* _BrianZ_NEBULA_RANDOM_H_ */
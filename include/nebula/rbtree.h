@@ -0,0 +1,366 @@
+/*
+ * rbtree.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_RBTREE_H_
+#define _BrianZ_NEBULA_RBTREE_H_
+
+#include <stddef.h>
+#include <functional>
+#include "nebula/standard.h"
+
+namespace nebula
+{
+  /*
+   * Description:
+   *   Link of an object in an RbTree, embedded in the object itself: the
+   *   tree never allocates, inserting and erasing only relink pointers.  An
+   *   object can be in as many trees as it has RbNode members.
+   */
+  struct RbNode
+  {
+    RbNode * parent;
+    RbNode * left;
+    RbNode * right;
+    int color;
+  };
+
+  /*
+   * Description:
+   *   Type independent part of RbTree: linking, rebalancing, iteration.
+   */
+  class RbTreeBase: public Standard::NoCopy
+  {
+  public:
+    enum
+    {
+      RED = 0, BLACK = 1
+    };
+
+  protected:
+    RbNode * root_;
+    RbNode * leftmost_;
+    size_t size_;
+
+    RbTreeBase() :
+      root_(NULL), leftmost_(NULL), size_(0)
+    {
+    }
+
+    /*
+     * Link `node' as the `left' (or right) child of `parent' (NULL for the
+     * root of an empty tree), then rebalance.
+     */
+    void link(RbNode * node, RbNode * parent, bool left);
+    void unlink(RbNode * node);
+
+    void rotateLeft(RbNode * x);
+    void rotateRight(RbNode * x);
+    void replace(RbNode * old_child, RbNode * new_child, RbNode * parent);
+
+  public:
+    size_t size() const
+    {
+      return size_;
+    }
+
+    bool empty() const
+    {
+      return !size_;
+    }
+
+    /*
+     * Description:
+     *   Forget all nodes (which are not touched).
+     */
+    void clear()
+    {
+      root_ = leftmost_ = NULL;
+      size_ = 0;
+    }
+
+    static RbNode * next(const RbNode * node);
+    static RbNode * prev(const RbNode * node);
+
+    /*
+     * Description:
+     *   Check parent links and red-black properties, for testing.
+     * Return value:
+     *   Black height of the tree (counting the NULL leaves), -1 if it is not
+     *   a valid red-black tree.
+     */
+    int verify() const;
+  };
+
+  /*
+   * Description:
+   *   Intrusive red-black tree of T ordered by the member `KEY', linked
+   *   through the member `NODE'.  Equal keys are allowed (kept in insertion
+   *   order).  first() is O(1), which makes it a priority queue as well,
+   *   e.g. of timers ordered by deadline:
+   *
+   *     struct Timer
+   *     {
+   *       uint64_t deadline;
+   *       nebula::RbNode link;
+   *       ...
+   *     };
+   *     typedef nebula::RbTree<Timer, uint64_t, &Timer::deadline, &Timer::link> TimerTree;
+   *
+   *     while ((t = timers.first()) && t->deadline <= now) {
+   *       timers.erase(t);
+   *       ...
+   *     }
+   *
+   *   The key of an object must not change while it is in the tree.
+   */
+  template<typename T, typename K, K T::*KEY, RbNode T::*NODE, typename Less = std::less<K> >
+  class RbTree: public RbTreeBase
+  {
+  private:
+    Less less_;
+
+    static size_t nodeOffset()
+    {
+      // offsetof() for a pointer to member, any properly aligned address will do
+      static char probe[sizeof(T)] __attribute__((aligned(16)));
+      return (char *) &(((T *) probe)->*NODE) - probe;
+    }
+
+    static T * object(RbNode * node)
+    {
+      return node ? (T *) ((char *) node - nodeOffset()) : NULL;
+    }
+
+    static const K & key(const RbNode * node)
+    {
+      return object(const_cast<RbNode *> (node))->*KEY;
+    }
+
+  public:
+    class Iterator
+    {
+    private:
+      RbNode * node_;
+
+    public:
+      explicit Iterator(RbNode * node = NULL) :
+        node_(node)
+      {
+      }
+
+      T & operator*() const
+      {
+        return *object(node_);
+      }
+
+      T * operator->() const
+      {
+        return object(node_);
+      }
+
+      Iterator & operator++()
+      {
+        node_ = RbTreeBase::next(node_);
+        return *this;
+      }
+
+      Iterator & operator--()
+      {
+        node_ = RbTreeBase::prev(node_);
+        return *this;
+      }
+
+      bool operator==(const Iterator & other) const
+      {
+        return node_ == other.node_;
+      }
+
+      bool operator!=(const Iterator & other) const
+      {
+        return node_ != other.node_;
+      }
+    };
+
+    explicit RbTree(const Less & less = Less()) :
+      less_(less)
+    {
+    }
+
+    Iterator begin() const
+    {
+      return Iterator(leftmost_);
+    }
+
+    Iterator end() const
+    {
+      return Iterator(NULL);
+    }
+
+    /*
+     * Description:
+     *   Object with the smallest key (the first inserted among equal ones),
+     *   NULL if the tree is empty.
+     */
+    T * first() const
+    {
+      return object(leftmost_);
+    }
+
+    T * last() const
+    {
+      RbNode * n = root_;
+      while (n && n->right) {
+        n = n->right;
+      }
+      return object(n);
+    }
+
+    static T * next(T * item)
+    {
+      return object(RbTreeBase::next(&(item->*NODE)));
+    }
+
+    static T * prev(T * item)
+    {
+      return object(RbTreeBase::prev(&(item->*NODE)));
+    }
+
+    /*
+     * Description:
+     *   Insert `item', after the objects with an equal key.
+     */
+    void insert(T * item)
+    {
+      const K & k = item->*KEY;
+      RbNode * parent = NULL;
+      bool left = true;
+      for (RbNode * n = root_; n;) {
+        parent = n;
+        left = less_(k, key(n));
+        n = left ? n->left : n->right;
+      }
+      link(&(item->*NODE), parent, left);
+    }
+
+    /*
+     * Description:
+     *   Insert `item' unless an object with an equal key is in the tree.
+     * Return value:
+     *   `item' if inserted, otherwise the object already there.
+     */
+    T * insertUnique(T * item)
+    {
+      const K & k = item->*KEY;
+      RbNode * parent = NULL;
+      bool left = true;
+      RbNode * candidate = NULL; // last node whose key is not greater than k
+      for (RbNode * n = root_; n;) {
+        parent = n;
+        left = less_(k, key(n));
+        if (left) {
+          n = n->left;
+        }
+        else {
+          candidate = n;
+          n = n->right;
+        }
+      }
+      if (candidate && !less_(key(candidate), k)) {
+        return object(candidate);
+      }
+      link(&(item->*NODE), parent, left);
+      return item;
+    }
+
+    void erase(T * item)
+    {
+      unlink(&(item->*NODE));
+    }
+
+    /*
+     * Description:
+     *   Remove and return the first object, NULL if the tree is empty.
+     */
+    T * popFirst()
+    {
+      T * item = first();
+      if (item) {
+        unlink(leftmost_);
+      }
+      return item;
+    }
+
+    /*
+     * Description:
+     *   First object whose key is not less than `k', NULL if none.
+     */
+    T * lowerBound(const K & k) const
+    {
+      RbNode * result = NULL;
+      for (RbNode * n = root_; n;) {
+        if (less_(key(n), k)) {
+          n = n->right;
+        }
+        else {
+          result = n;
+          n = n->left;
+        }
+      }
+      return object(result);
+    }
+
+    /*
+     * Description:
+     *   First object whose key is greater than `k', NULL if none.
+     */
+    T * upperBound(const K & k) const
+    {
+      RbNode * result = NULL;
+      for (RbNode * n = root_; n;) {
+        if (less_(k, key(n))) {
+          result = n;
+          n = n->left;
+        }
+        else {
+          n = n->right;
+        }
+      }
+      return object(result);
+    }
+
+    /*
+     * Description:
+     *   First object whose key equals `k', NULL if none.
+     */
+    T * find(const K & k) const
+    {
+      T * item = lowerBound(k);
+      return item && !less_(k, item->*KEY) ? item : NULL;
+    }
+  };
+}
+
+#endif /* _BrianZ_NEBULA_RBTREE_H_ */
@@ -0,0 +1,472 @@
+/*
+ * ring_buffer.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_RING_BUFFER_H_
+#define _BrianZ_NEBULA_RING_BUFFER_H_
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <new>
+#include "nebula/attributes.h"
+#include "nebula/standard.h"
+
+namespace nebula
+{
+  namespace internal
+  {
+    enum
+    {
+      RING_CACHE_LINE = 64
+    };
+
+    inline size_t roundUpToPowerOfTwo(size_t n)
+    {
+      size_t p = 1;
+      while (p < n) {
+        p <<= 1;
+      }
+      return p;
+    }
+
+    /*
+     * Indexes of a single producer single consumer ring.  Both indexes run
+     * freely (they are reduced modulo the capacity on access, which is a
+     * power of two).  Each side owns a cache line holding its own index and
+     * a cached copy of the other side's, which it only reloads when the
+     * ring looks full (producer) or empty (consumer), so that the two lines
+     * do not bounce between the processors on every operation.
+     */
+    struct RingIndexes
+    {
+      // producer
+      size_t tail;
+      size_t head_cache;
+      char producer_padding[RING_CACHE_LINE - 2 * sizeof(size_t)];
+      // consumer
+      size_t head;
+      size_t tail_cache;
+      char consumer_padding[RING_CACHE_LINE - 2 * sizeof(size_t)];
+
+      RingIndexes() :
+        tail(0), head_cache(0), head(0), tail_cache(0)
+      {
+      }
+
+      // called by the producer, free slots, at least `wanted' if possible
+      size_t writable(size_t capacity, size_t wanted)
+      {
+        size_t free_slots = capacity - (tail - head_cache);
+        if (free_slots < wanted) {
+          head_cache = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+          free_slots = capacity - (tail - head_cache);
+        }
+        return free_slots;
+      }
+
+      // called by the consumer, filled slots, at least `wanted' if possible
+      size_t readable(size_t wanted)
+      {
+        size_t filled = tail_cache - head;
+        if (filled < wanted) {
+          tail_cache = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+          filled = tail_cache - head;
+        }
+        return filled;
+      }
+
+      void produced(size_t n)
+      {
+        __atomic_store_n(&tail, tail + n, __ATOMIC_RELEASE);
+      }
+
+      void consumed(size_t n)
+      {
+        __atomic_store_n(&head, head + n, __ATOMIC_RELEASE);
+      }
+    };
+  }
+
+  /*
+   * Description:
+   *   Bounded lock-free queue between exactly one producer thread and one
+   *   consumer thread, with a power of two capacity.  Operations never
+   *   block: push*() fail when the ring is full and pop*() when it is empty,
+   *   the caller decides whether to spin, yield or sleep.  The batch
+   *   variants publish many elements with a single atomic store.
+   *
+   *   Elements are constructed when pushed and destroyed when popped (or
+   *   when the ring is destroyed), T needs a copy constructor only.
+   */
+  template<typename T>
+  class SpscRing: public Standard::NoCopy
+  {
+  private:
+    internal::RingIndexes idx_ __attribute__((aligned(internal::RING_CACHE_LINE)));
+    T * slots_;
+    size_t capacity_;
+    size_t mask_;
+
+    T * slot(size_t i) const
+    {
+      return slots_ + (i & mask_);
+    }
+
+  public:
+    SpscRing() :
+      slots_(NULL), capacity_(0), mask_(0)
+    {
+    }
+
+    ~SpscRing()
+    {
+      if (slots_) {
+        for (size_t i = idx_.head; i != idx_.tail; ++i) {
+          slot(i)->~T();
+        }
+        free(slots_);
+      }
+    }
+
+    /*
+     * Description:
+     *   Allocate room for at least `min_capacity' elements (rounded up to a
+     *   power of two), must be called once before the ring is shared.
+     * Return value:
+     *   0 on success, -1 on error (errno is set).
+     */
+    int init(size_t min_capacity)
+    {
+      if (slots_ || !min_capacity || min_capacity > ((size_t) -1 / 2) / sizeof(T)) {
+        errno = EINVAL;
+        return -1;
+      }
+      size_t capacity = internal::roundUpToPowerOfTwo(min_capacity);
+      void * p;
+      int rc = posix_memalign(&p, internal::RING_CACHE_LINE, capacity * sizeof(T));
+      if (rc) {
+        errno = rc;
+        return -1;
+      }
+      slots_ = (T *) p;
+      capacity_ = capacity;
+      mask_ = capacity - 1;
+      return 0;
+    }
+
+    size_t capacity() const
+    {
+      return capacity_;
+    }
+
+    /*
+     * Description:
+     *   Number of elements, exact when called by the producer or the
+     *   consumer while the other side is idle, a snapshot otherwise.
+     */
+    size_t size() const
+    {
+      size_t head = __atomic_load_n(&idx_.head, __ATOMIC_ACQUIRE);
+      size_t tail = __atomic_load_n(&idx_.tail, __ATOMIC_ACQUIRE);
+      return tail - head;
+    }
+
+    bool empty() const
+    {
+      return size() == 0;
+    }
+
+    // producer side
+
+    bool push(const T & item)
+    {
+      if (unlikely(!idx_.writable(capacity_, 1))) {
+        return false;
+      }
+      new (slot(idx_.tail)) T(item);
+      idx_.produced(1);
+      return true;
+    }
+
+    /*
+     * Return value:
+     *   Number of elements pushed, from the beginning of `items'.
+     */
+    size_t pushBatch(const T * items, size_t n)
+    {
+      size_t free_slots = idx_.writable(capacity_, n);
+      if (n > free_slots) {
+        n = free_slots;
+      }
+      for (size_t i = 0; i < n; ++i) {
+        new (slot(idx_.tail + i)) T(items[i]);
+      }
+      if (n) {
+        idx_.produced(n);
+      }
+      return n;
+    }
+
+    // consumer side
+
+    bool pop(T * item)
+    {
+      if (unlikely(!idx_.readable(1))) {
+        return false;
+      }
+      T * p = slot(idx_.head);
+      *item = *p;
+      p->~T();
+      idx_.consumed(1);
+      return true;
+    }
+
+    /*
+     * Return value:
+     *   Number of elements popped into `items', at most `max'.
+     */
+    size_t popBatch(T * items, size_t max)
+    {
+      size_t n = idx_.readable(max);
+      if (n > max) {
+        n = max;
+      }
+      for (size_t i = 0; i < n; ++i) {
+        T * p = slot(idx_.head + i);
+        items[i] = *p;
+        p->~T();
+      }
+      if (n) {
+        idx_.consumed(n);
+      }
+      return n;
+    }
+
+    /*
+     * Description:
+     *   Oldest element, left in the ring (NULL if empty), for consuming it
+     *   in place; followed by popFront().
+     */
+    T * front()
+    {
+      return idx_.readable(1) ? slot(idx_.head) : NULL;
+    }
+
+    void popFront()
+    {
+      slot(idx_.head)->~T();
+      idx_.consumed(1);
+    }
+  };
+
+  /*
+   * Description:
+   *   Single producer single consumer byte stream.  The buffer is mapped
+   *   twice, back to back, so that every free or filled region is
+   *   contiguous in memory even when it wraps around: the producer writes
+   *   directly into the region returned by reserve() (e.g. with read() or
+   *   recv()) and publishes it with commit(), the consumer processes the
+   *   region returned by peek() in place and releases it with consume().
+   *   The capacity is a power of two and a multiple of the page size.
+   */
+  class SpscByteRing: public Standard::NoCopy
+  {
+  private:
+    internal::RingIndexes idx_ __attribute__((aligned(internal::RING_CACHE_LINE)));
+    char * data_;
+    size_t capacity_;
+    size_t mask_;
+
+  public:
+    SpscByteRing() :
+      data_(NULL), capacity_(0), mask_(0)
+    {
+    }
+
+    ~SpscByteRing()
+    {
+      if (data_) {
+        munmap(data_, 2 * capacity_);
+      }
+    }
+
+    /*
+     * Description:
+     *   Map a buffer of at least `min_capacity' bytes, must be called once
+     *   before the ring is shared.
+     * Return value:
+     *   0 on success, -1 on error (errno is set).
+     */
+    int init(size_t min_capacity)
+    {
+      if (data_ || !min_capacity || min_capacity > ((size_t) -1) / 4) {
+        errno = EINVAL;
+        return -1;
+      }
+      size_t page = sysconf(_SC_PAGESIZE);
+      size_t capacity = internal::roundUpToPowerOfTwo(min_capacity < page ? page : min_capacity);
+
+      int fd = memfd_create("nebula_ring", MFD_CLOEXEC);
+      if (fd < 0) {
+        return -1;
+      }
+      int saved;
+      char * base = (char *) MAP_FAILED;
+      if (ftruncate(fd, capacity) < 0) {
+        goto error;
+      }
+      // reserve the address range, then map the file over both halves
+      base = (char *) mmap(NULL, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base == MAP_FAILED) {
+        goto error;
+      }
+      if (mmap(base, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED //
+          || mmap(base + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        goto error;
+      }
+      close(fd);
+      data_ = base;
+      capacity_ = capacity;
+      mask_ = capacity - 1;
+      return 0;
+
+    error:
+      saved = errno;
+      if (base != MAP_FAILED) {
+        munmap(base, 2 * capacity);
+      }
+      close(fd);
+      errno = saved;
+      return -1;
+    }
+
+    size_t capacity() const
+    {
+      return capacity_;
+    }
+
+    size_t size() const
+    {
+      size_t head = __atomic_load_n(&idx_.head, __ATOMIC_ACQUIRE);
+      size_t tail = __atomic_load_n(&idx_.tail, __ATOMIC_ACQUIRE);
+      return tail - head;
+    }
+
+    // producer side
+
+    /*
+     * Description:
+     *   Contiguous free region of at least `min_len' bytes, `*len' is set
+     *   to its actual size (which may be less than what is free, the
+     *   consumer's index is only reloaded when needed to reach `min_len').
+     * Return value:
+     *   Start of the region, NULL if less than `min_len' bytes are free.
+     */
+    char * reserve(size_t min_len, size_t * len)
+    {
+      size_t free_bytes = idx_.writable(capacity_, min_len ? min_len : 1);
+      if (free_bytes < min_len || !free_bytes) {
+        return NULL;
+      }
+      *len = free_bytes;
+      return data_ + (idx_.tail & mask_);
+    }
+
+    /*
+     * Description:
+     *   Publish the first `len' bytes of the region returned by reserve().
+     */
+    void commit(size_t len)
+    {
+      idx_.produced(len);
+    }
+
+    /*
+     * Return value:
+     *   Number of bytes copied from `src', at most `len'.
+     */
+    size_t write(const void * src, size_t len)
+    {
+      size_t free_bytes = idx_.writable(capacity_, len);
+      if (len > free_bytes) {
+        len = free_bytes;
+      }
+      memcpy(data_ + (idx_.tail & mask_), src, len);
+      commit(len);
+      return len;
+    }
+
+    // consumer side
+
+    /*
+     * Description:
+     *   Contiguous filled region of at least `min_len' bytes, `*len' is set
+     *   to its actual size (which may be less than what is filled, the
+     *   producer's index is only reloaded when needed to reach `min_len').
+     * Return value:
+     *   Start of the region, NULL if less than `min_len' bytes are filled.
+     */
+    const char * peek(size_t min_len, size_t * len)
+    {
+      size_t filled = idx_.readable(min_len ? min_len : 1);
+      if (filled < min_len || !filled) {
+        return NULL;
+      }
+      *len = filled;
+      return data_ + (idx_.head & mask_);
+    }
+
+    /*
+     * Description:
+     *   Release the first `len' bytes of the region returned by peek().
+     */
+    void consume(size_t len)
+    {
+      idx_.consumed(len);
+    }
+
+    /*
+     * Return value:
+     *   Number of bytes copied to `dst', at most `len'.
+     */
+    size_t read(void * dst, size_t len)
+    {
+      size_t filled = idx_.readable(len);
+      if (len > filled) {
+        len = filled;
+      }
+      memcpy(dst, data_ + (idx_.head & mask_), len);
+      consume(len);
+      return len;
+    }
+  };
+}
+
+#endif /* _BrianZ_NEBULA_RING_BUFFER_H_ */
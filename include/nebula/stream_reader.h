@@ -0,0 +1,162 @@
+/*
+ * stream_reader.h
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BrianZ_NEBULA_STREAM_READER_H_
+#define _BrianZ_NEBULA_STREAM_READER_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include "nebula/standard.h"
+
+namespace nebula
+{
+  namespace internal
+  {
+    class ReadAheadThread;
+    struct StreamSource;
+  }
+
+  /*
+   * Description:
+   *   Sequential reader of a file, pipe or socket which does not rely on
+   *   mmap() or seeking, and which optionally decompresses gzip data on
+   *   the fly (raw zlib streams are not recognized).  Data is read into
+   *   large buffers; with SR_READ_AHEAD a background thread fills (and
+   *   decompresses into) one buffer while the caller is consuming the
+   *   other one.
+   */
+  class StreamReader: public Standard::NoCopy
+  {
+    friend class internal::ReadAheadThread;
+  public:
+    enum
+    {
+      SR_NONE = 0x00, //
+      SR_READ_AHEAD = 0x01, // fill buffers in a background thread
+      SR_DECOMPRESS = 0x02 // decompress if the input starts with the gzip magic number
+    };
+
+    enum
+    {
+      DEFAULT_BUFFER_SIZE = (1 << 20), MIN_BUFFER_SIZE = 16
+    };
+
+  private:
+    struct Buffer
+    {
+      char * data_;
+      size_t length_;
+      int error_; // errno of a failed read, or 0
+      bool eof_;
+      bool full_; // filled and not yet consumed
+    };
+
+    size_t buffer_size_;
+    Buffer buffers_[2];
+    int current_; // index of the buffer being consumed, or -1
+    size_t pos_;
+    char * carry_; // a line spanning more than one buffer
+    size_t carry_size_;
+    int error_;
+    bool finished_;
+
+    char name_[256];
+    int flags_;
+    internal::StreamSource * source_;
+    internal::ReadAheadThread * reader_;
+    pthread_mutex_t lock_;
+    pthread_cond_t cond_;
+
+  public:
+    StreamReader(size_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+    ~StreamReader();
+
+    /*
+     * Description:
+     *   Open `path' for reading, "-" stands for the standard input.
+     * Return value:
+     *   0 on success, -1 on error (errno is set).
+     */
+    int open(const char * path, int flags = SR_READ_AHEAD | SR_DECOMPRESS);
+
+    /*
+     * Description:
+     *   Read from an already opened file descriptor.  If `take_ownership'
+     *   is true `fd' is closed by close(), or before returning if attach()
+     *   fails, so the caller must not close it in either case.  `name' is
+     *   only used for reporting.
+     * Return value:
+     *   0 on success, -1 on error (errno is set).
+     */
+    int attach(int fd, int flags = SR_READ_AHEAD | SR_DECOMPRESS, bool take_ownership = false,
+      const char * name = NULL);
+
+    void close();
+
+    /*
+     * Description:
+     *   Fetch the next line, without the trailing '\n'.  `*line' is NUL
+     *   terminated, may be modified by the caller, and is valid until the
+     *   next call to readLine() or close().
+     * Return value:
+     *   Length of the line, or -1 if end of input or error, check error() to
+     *   tell them apart.
+     */
+    ssize_t readLine(char ** line);
+
+    /*
+     * Description:
+     *   Fetch the next chunk of data, up to the end of the current buffer.
+     * Return value:
+     *   Number of bytes available at `*data', 0 at end of input, -1 on error.
+     */
+    ssize_t readChunk(const char ** data);
+
+    int error() const
+    {
+      return error_;
+    }
+
+    const char * name() const
+    {
+      return name_;
+    }
+
+    bool isCompressed() const;
+
+    static bool hasDecompressionSupport();
+
+  private:
+    bool nextBuffer();
+    void releaseBuffer();
+    bool appendCarry(size_t used, const char * data, size_t length);
+  }; /* class StreamReader */
+}
+
+#endif /* _BrianZ_NEBULA_STREAM_READER_H_ */
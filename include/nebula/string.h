@@ -39,11 +39,72 @@ namespace nebula
   class String
   {
   public:
+    struct ParseResult
+    {
+      enum Constants
+      {
+        SUCCESS = 0, EMPTY_INPUT = 1, INVALID_FORMAT = 2, OUT_OF_RANGE = 3, NO_MEMORY = 4
+      };
+
+      static const char * toString(Constants v)
+      {
+        switch (v) {
+          case SUCCESS:
+            return "SUCCESS";
+          case EMPTY_INPUT:
+            return "EMPTY_INPUT";
+          case INVALID_FORMAT:
+            return "INVALID_FORMAT";
+          case OUT_OF_RANGE:
+            return "OUT_OF_RANGE";
+          case NO_MEMORY:
+            return "NO_MEMORY";
+          default:
+            return "<unknown>";
+        }
+      }
+    };
+
     static size_t strlcat(char * dst, const char * src, size_t siz);
     static size_t strlcpy(char * dst, const char * src, size_t siz);
     static int64_t strToI64(const char * s, bool parse_suffix = false);
     static uint64_t strToU64(const char * s, bool parse_suffix = false);
 
+    /*
+     * Description:
+     *   Locale independent conversion of exactly `len' bytes starting at `s'
+     *   (need not be NUL terminated) into an integer.  An optional sign is
+     *   accepted, but neither leading nor trailing white spaces.  If
+     *   `parse_suffix' is true, a single trailing 'K' (2^10), 'k' (10^3), 'M'
+     *   (2^20), 'm' (10^6), 'G' (2^30) or 'g' (10^9) multiplies the value.
+     *   `*out' is only modified on success.
+     * Return value:
+     *   ParseResult::SUCCESS, or the reason of failure.
+     */
+    static ParseResult::Constants parseI64(const char * s, size_t len, int64_t * out, bool parse_suffix = false);
+    static ParseResult::Constants parseU64(const char * s, size_t len, uint64_t * out, bool parse_suffix = false);
+
+    /*
+     * Description:
+     *   Locale independent conversion of exactly `len' bytes starting at `s'
+     *   into a double, in the format accepted by strtod() in the "C" locale
+     *   (hexadecimal floats excluded), but like parseI64() without leading
+     *   or trailing white spaces.  Short decimal numbers are converted
+     *   without calling strtod().
+     * Return value:
+     *   ParseResult::SUCCESS, or the reason of failure; NO_MEMORY if a very
+     *   long input could not be copied for strtod().
+     */
+    static ParseResult::Constants parseDouble(const char * s, size_t len, double * out);
+
+    /*
+     * Description:
+     *   Number of occurrences of `c' in the `len' bytes starting at `s', e.g.
+     *   of '\n' to count lines.  Uses the widest SIMD kernel available (see
+     *   multiversion.h).
+     */
+    static size_t countChar(const char * s, size_t len, char c);
+
     static bool startsWith(const char * src_str, const char * prefix);
     static bool endsWith(const char * src_str, const char * suffix);
     static char * toUpperCase(char * input);
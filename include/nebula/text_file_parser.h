@@ -30,15 +30,108 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include "nebula/attributes.h"
 #include "nebula/standard.h"
+#include "nebula/stream_reader.h"
+#include "nebula/string.h"
 
 namespace nebula
 {
+  /*
+   * Description:
+   *   A 256-bit bitmap of delimiter characters, build it once and reuse it for
+   *   every line instead of letting strtok_r() rebuild its table on each call.
+   */
+  class DelimiterTable
+  {
+  private:
+    uint64_t bits_[4];
+
+  public:
+    DelimiterTable(const char * delim = " \f\n\r\t\v")
+    {
+      assign(delim);
+    }
+
+    void assign(const char * delim)
+    {
+      memset(bits_, 0, sizeof(bits_));
+      if (delim) {
+        for (const unsigned char * p = (const unsigned char *) delim; *p; ++p) {
+          bits_[*p >> 6] |= ((uint64_t) 1) << (*p & 0x3f);
+        }
+      }
+    }
+
+    bool isDelimiter(unsigned char c) const
+    {
+      return (bits_[c >> 6] >> (c & 0x3f)) & 0x1;
+    }
+
+    bool isEmpty() const
+    {
+      return !(bits_[0] | bits_[1] | bits_[2] | bits_[3]);
+    }
+  }; /* class DelimiterTable */
+
+  /*
+   * Description:
+   *   A token which refers to (but does not own) `length' bytes starting at
+   *   `data'.  It is NOT necessarily NUL terminated.
+   */
+  struct TokenView
+  {
+    const char * data;
+    size_t length;
+
+    bool equals(const char * s) const
+    {
+      return strlen(s) == length && memcmp(data, s, length) == 0;
+    }
+
+    bool equalsIgnoreCase(const char * s) const
+    {
+      return strlen(s) == length && strncasecmp(data, s, length) == 0;
+    }
+
+    String::ParseResult::Constants toI64(int64_t * out, bool parse_suffix = false) const
+    {
+      return String::parseI64(data, length, out, parse_suffix);
+    }
+
+    String::ParseResult::Constants toU64(uint64_t * out, bool parse_suffix = false) const
+    {
+      return String::parseU64(data, length, out, parse_suffix);
+    }
+
+    String::ParseResult::Constants toDouble(double * out) const
+    {
+      return String::parseDouble(data, length, out);
+    }
+
+    /*
+     * Description:
+     *   Copy the token into `buf' of size `buflen', the result is always NUL
+     *   terminated unless `buflen' is 0.
+     * Return value:
+     *   Length of the token, truncation occurred if it is >= `buflen'.
+     */
+    size_t copyTo(char * buf, size_t buflen) const
+    {
+      if (buflen) {
+        size_t n = length < buflen ? length : buflen - 1;
+        memcpy(buf, data, n);
+        buf[n] = '\0';
+      }
+      return length;
+    }
+  }; /* struct TokenView */
+
   class Tokens: public Standard::NoCopy
   {
   private:
-    const char ** tokens_;
-    char * input_string_;
+    TokenView * tokens_;
     uint32_t num_of_tokens_;
     uint32_t max_tokens_;
     uint32_t hint_size_;
@@ -50,8 +143,7 @@ namespace nebula
     };
 
     Tokens(uint32_t hint_size = DEFAULT_HINT_SIZE) :
-      tokens_(NULL), input_string_(NULL), num_of_tokens_(0), max_tokens_(0),
-          hint_size_(hint_size ? hint_size : DEFAULT_HINT_SIZE)
+      tokens_(NULL), num_of_tokens_(0), max_tokens_(0), hint_size_(hint_size ? hint_size : DEFAULT_HINT_SIZE)
     {
 
     }
@@ -65,21 +157,75 @@ namespace nebula
 
     void clear()
     {
-      input_string_ = NULL;
       num_of_tokens_ = 0;
     }
 
+    /*
+     * Description:
+     *   Split the NUL terminated string `input' in place, every delimiter that
+     *   follows a token is overwritten by '\0', so that token(idx) can be used
+     *   as a C string.
+     * Return value:
+     *   false if failed to allocate memory, true otherwise.
+     */
     bool splitString(char * input, const char * delim = " \f\n\r\t\v")
+    {
+      DelimiterTable table(delim);
+      return splitString(input, table);
+    }
+
+    bool splitString(char * input, const DelimiterTable & table)
     {
       clear();
-      char * token = NULL;
-      char * saved = NULL;
-      char * str = input;
-      while ((token = strtok_r(str, delim, &saved))) {
-        if (!saveTokenAddr(token)) {
+      unsigned char * p = (unsigned char *) input;
+      while (*p) {
+        while (*p && table.isDelimiter(*p)) {
+          ++p;
+        }
+        if (!*p) {
+          break;
+        }
+        unsigned char * start = p;
+        while (*p && !table.isDelimiter(*p)) {
+          ++p;
+        }
+        if (!saveToken((const char *) start, (size_t) (p - start))) {
+          return false;
+        }
+        if (*p) {
+          *p++ = '\0';
+        }
+      }
+      return true;
+    }
+
+    /*
+     * Description:
+     *   Split the first `length' bytes of `input' without modifying it, tokens
+     *   are only available through view(idx), token(idx) is NOT NUL terminated
+     *   after calling this method.
+     * Return value:
+     *   false if failed to allocate memory, true otherwise.
+     */
+    bool splitView(const char * input, size_t length, const DelimiterTable & table)
+    {
+      clear();
+      const unsigned char * p = (const unsigned char *) input;
+      const unsigned char * end = p + length;
+      while (p < end) {
+        while (p < end && table.isDelimiter(*p)) {
+          ++p;
+        }
+        if (p == end) {
+          break;
+        }
+        const unsigned char * start = p;
+        while (p < end && !table.isDelimiter(*p)) {
+          ++p;
+        }
+        if (!saveToken((const char *) start, (size_t) (p - start))) {
           return false;
         }
-        str = NULL;
       }
       return true;
     }
@@ -91,34 +237,35 @@ namespace nebula
 
     const char * token(uint32_t idx) const
     {
-      return (idx < num_of_tokens_) ? (*(tokens_ + idx)) : NULL;
+      return (idx < num_of_tokens_) ? tokens_[idx].data : NULL;
+    }
+
+    size_t tokenLength(uint32_t idx) const
+    {
+      return (idx < num_of_tokens_) ? tokens_[idx].length : 0;
+    }
+
+    const TokenView * view(uint32_t idx) const
+    {
+      return (idx < num_of_tokens_) ? (tokens_ + idx) : NULL;
     }
 
   private:
-    bool saveTokenAddr(char * ptr)
+    bool saveToken(const char * ptr, size_t length)
     {
-      if (num_of_tokens_ == max_tokens_) {
-        if (!max_tokens_) {
-          max_tokens_ = hint_size_;
-        }
-        else {
-          max_tokens_ += hint_size_;
-        }
-        const char ** all;
-        if (!tokens_) {
-          if (!(all = (const char **) malloc(max_tokens_ * sizeof(tokens_[0])))) {
-            return false;
-          }
-        }
-        else {
-          if (!(all = (const char **) realloc(tokens_, max_tokens_ * sizeof(tokens_[0])))) {
-            max_tokens_ -= hint_size_;
-            return false;
-          }
+      if (unlikely(num_of_tokens_ == max_tokens_)) {
+        // grow geometrically, `hint_size_' is only the initial capacity
+        uint32_t new_max = max_tokens_ ? max_tokens_ * 2 : hint_size_;
+        TokenView * all = (TokenView *) realloc(tokens_, new_max * sizeof(tokens_[0]));
+        if (!all) {
+          return false;
         }
         tokens_ = all;
+        max_tokens_ = new_max;
       }
-      *(tokens_ + num_of_tokens_++) = ptr;
+      tokens_[num_of_tokens_].data = ptr;
+      tokens_[num_of_tokens_].length = length;
+      ++num_of_tokens_;
       return true;
     }
   }; /* class Tokens */
@@ -183,6 +330,7 @@ namespace nebula
       uint64_t line_num = 0;
       ssize_t length;
       Tokens tokens(hint_size);
+      DelimiterTable table(delim);
       while ((length = getline(&line_buffer_, &line_size_, file_handle_)) != -1) {
         ++line_num;
         // remove trailing "\r", "\n" or "\r\n"
@@ -192,7 +340,7 @@ namespace nebula
             line_buffer_[--length] = '\0';
           }
         }
-        tokens.splitString(line_buffer_, delim);
+        tokens.splitString(line_buffer_, table);
         if (!tokens.numOfTokens() && skip_empty) {
           continue;
         }
@@ -204,6 +352,42 @@ namespace nebula
       file_handle_ = NULL;
       return rc;
     }
+
+    /*
+     * Description:
+     *   Same as above, but lines are fetched from `input', which may be a
+     *   pipe, the standard input or a gzip compressed file, see StreamReader.
+     *   input->name() is passed to `fn' as the file name.
+     * Return value:
+     *   Return value of `fn' if it is non-zero, -1 if failed reading
+     *   `input', or 0.
+     */
+    int parseLineByLine(StreamReader * input,
+      int(*fn)(const char * filename, uint64_t line_num, const Tokens * tokens, void * arg), void * fn_arg = NULL,
+      const char * delim = " \f\n\r\t\v", bool skip_empty = true, uint32_t hint_size = Tokens::DEFAULT_HINT_SIZE)
+    {
+      int rc = 0;
+      uint64_t line_num = 0;
+      ssize_t length;
+      char * line;
+      Tokens tokens(hint_size);
+      DelimiterTable table(delim);
+      while ((length = input->readLine(&line)) != -1) {
+        ++line_num;
+        // remove trailing "\r", the "\n" is already stripped
+        if (length && line[length - 1] == '\r') {
+          line[--length] = '\0';
+        }
+        tokens.splitString(line, table);
+        if (!tokens.numOfTokens() && skip_empty) {
+          continue;
+        }
+        if ((rc = (*fn)(input->name(), line_num, &tokens, fn_arg))) {
+          return rc;
+        }
+      }
+      return input->error() ? -1 : 0;
+    }
   }; /* class TextFileParser */
 
 } /* namespace nebula */
@@ -27,7 +27,11 @@
 #ifndef _BrianZ_NEBULA_THREAD_H_
 #define _BrianZ_NEBULA_THREAD_H_
 
+#include <errno.h>
+#include <limits.h>
 #include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
 #include <string.h>
 #include <signal.h>
 
@@ -40,6 +44,19 @@ namespace nebula
     pthread_t thread_id_;
     pthread_attr_t thread_attr_;
 
+    // settings applied by the new thread itself, before startHandler()
+    enum
+    {
+      NO_NICE = INT_MIN, MAX_NAME_LENGTH = 15
+    };
+    char name_[MAX_NAME_LENGTH + 1];
+    int nice_;
+    int numa_node_;
+    bool numa_strict_;
+    bool has_affinity_;
+    int setup_error_;
+    sem_t setup_done_;
+
   public:
     Thread()
     {
@@ -48,6 +65,13 @@ namespace nebula
       if (pthread_attr_init(&thread_attr_)) {
         // FIXME
       }
+      name_[0] = '\0';
+      nice_ = NO_NICE;
+      numa_node_ = -1;
+      numa_strict_ = false;
+      has_affinity_ = false;
+      setup_error_ = 0;
+      sem_init(&setup_done_, 0, 0);
     }
 
     virtual ~Thread()
@@ -55,6 +79,110 @@ namespace nebula
       if (pthread_attr_destroy(&thread_attr_)) {
         // FIXME
       }
+      sem_destroy(&setup_done_);
+    }
+
+    /*
+     * The following settings must be made before create(), and return 0 on
+     * success or an error number, like create().
+     */
+
+    int setStackSize(size_t size)
+    {
+      return pthread_attr_setstacksize(&thread_attr_, size);
+    }
+
+    int setGuardSize(size_t size)
+    {
+      return pthread_attr_setguardsize(&thread_attr_, size);
+    }
+
+    /*
+     * Description:
+     *   Only let `this' thread run on the processors in `cpus', or on `cpu'.
+     */
+    int setAffinity(const cpu_set_t * cpus)
+    {
+      int ec = pthread_attr_setaffinity_np(&thread_attr_, sizeof(*cpus), cpus);
+      if (!ec) {
+        has_affinity_ = true;
+      }
+      return ec;
+    }
+
+    int setAffinity(int cpu)
+    {
+      if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return EINVAL;
+      }
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(cpu, &cpus);
+      return setAffinity(&cpus);
+    }
+
+    /*
+     * Description:
+     *   Scheduling policy (SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO
+     *   or SCHED_RR) and static priority (for the real time policies) of
+     *   `this' thread, instead of inheriting those of the creator.  Real
+     *   time policies usually need CAP_SYS_NICE, create() fails otherwise.
+     */
+    int setSchedPolicy(int policy, int priority = 0)
+    {
+      struct sched_param param;
+      memset(&param, 0, sizeof(param));
+      param.sched_priority = priority;
+      int ec;
+      if ((ec = pthread_attr_setinheritsched(&thread_attr_, PTHREAD_EXPLICIT_SCHED))
+          || (ec = pthread_attr_setschedpolicy(&thread_attr_, policy))
+          || (ec = pthread_attr_setschedparam(&thread_attr_, &param))) {
+        return ec;
+      }
+      return 0;
+    }
+
+    /*
+     * Description:
+     *   Nice value of `this' thread (only for SCHED_OTHER and SCHED_BATCH),
+     *   lowering it usually needs CAP_SYS_NICE.
+     */
+    int setNice(int nice)
+    {
+      if (nice < -20 || nice > 19) {
+        return EINVAL;
+      }
+      nice_ = nice;
+      return 0;
+    }
+
+    /*
+     * Description:
+     *   Run `this' thread on the processors of NUMA node `node' (unless
+     *   setAffinity() was called), and allocate the memory it touches first,
+     *   stack included, from that node: preferably, or strictly if `strict'
+     *   is true.
+     */
+    int setNumaNode(int node, bool strict = false)
+    {
+      if (node < 0) {
+        return EINVAL;
+      }
+      numa_node_ = node;
+      numa_strict_ = strict;
+      return 0;
+    }
+
+    /*
+     * Description:
+     *   Name of `this' thread as shown by ps and top, truncated to 15
+     *   characters.
+     */
+    int setName(const char * name)
+    {
+      strncpy(name_, name, MAX_NAME_LENGTH);
+      name_[MAX_NAME_LENGTH] = '\0';
+      return 0;
     }
 
     /*
@@ -85,11 +213,24 @@ namespace nebula
 
     /*
      * Description:
-     *   Start a new thread.
+     *   Start a new thread.  If settings have to be applied by the new thread
+     *   itself, waits until it is done; if that failed, the new thread
+     *   terminates without calling routine() and the error is returned.
      */
     int create()
     {
-      return pthread_create(&thread_id_, &thread_attr_, privateStartRoutine, this);
+      int ec = pthread_create(&thread_id_, &thread_attr_, privateStartRoutine, this);
+      if (ec || !hasSetup()) {
+        return ec;
+      }
+      while (sem_wait(&setup_done_) && errno == EINTR) {
+        ;
+      }
+      if (setup_error_) {
+        pthread_join(thread_id_, NULL);
+        return setup_error_;
+      }
+      return 0;
     }
 
     /*
@@ -153,6 +294,13 @@ namespace nebula
      */
     void * startRoutine()
     {
+      if (hasSetup()) {
+        setup_error_ = applySetup();
+        sem_post(&setup_done_);
+        if (setup_error_) {
+          return NULL;
+        }
+      }
       startHandler();
       void * result = routine();
       exitHandler();
@@ -160,6 +308,17 @@ namespace nebula
     }
 
   private:
+    bool hasSetup() const
+    {
+      return name_[0] || nice_ != NO_NICE || numa_node_ >= 0;
+    }
+
+    /*
+     * Applies the settings which only the new thread can make for itself,
+     * returns 0 or an error number.
+     */
+    int applySetup();
+
     static void * privateStartRoutine(void * self)
     {
 #if 0
@@ -0,0 +1,202 @@
+/*
+ * arena_parse.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "nebula/arena.h"
+#include "nebula/random.h"
+#include "nebula/text_file_parser.h"
+#include "nebula/time.h"
+
+/*
+ * Tokenizing lines into per-line records (a copy of the line, an array of
+ * its fields), in requests of a few hundred lines freed together: records
+ * built with malloc() and freed one by one, against records built in an
+ * Arena rewound after every request, and in the thread's Arena under an
+ * ArenaScope.
+ */
+
+struct Record
+{
+  char * text;
+  nebula::TokenView * fields;
+  size_t num_fields;
+};
+
+static std::vector<char *> generateLines(int num_lines)
+{
+  static const char * words[] =
+  { "GET", "/index.html", "200", "1024", "127.0.0.1", "Mozilla/5.0", "-", "3.1415926", "nebula", "x" };
+  nebula::Prng prng(12345);
+  std::vector<char *> lines;
+  char buf[512];
+  for (int i = 0; i < num_lines; ++i) {
+    size_t used = 0;
+    int num_fields = 8 + (int) prng.nextBelow(8);
+    for (int j = 0; j < num_fields; ++j) {
+      used += snprintf(buf + used, sizeof(buf) - used, "%s ", words[prng.nextBelow(10)]);
+    }
+    buf[used - 1] = '\0';
+    lines.push_back(strdup(buf));
+  }
+  return lines;
+}
+
+// fill `r' from `line', the memory coming from `Alloc'
+template<typename Alloc>
+static bool parseLine(Alloc & alloc, nebula::Tokens & tokens, const nebula::DelimiterTable & table, const char * line,
+  Record * r)
+{
+  size_t len = strlen(line);
+  if (!(r->text = alloc.strdup(line, len))) {
+    return false;
+  }
+  tokens.splitView(r->text, len, table);
+  r->num_fields = tokens.numOfTokens();
+  if (!(r->fields = alloc.template allocateArray<nebula::TokenView>(r->num_fields))) {
+    return false;
+  }
+  for (size_t i = 0; i < r->num_fields; ++i) {
+    r->fields[i] = *tokens.view(i);
+  }
+  return true;
+}
+
+struct MallocAlloc
+{
+  char * strdup(const char * s, size_t len)
+  {
+    char * p = (char *) malloc(len + 1);
+    memcpy(p, s, len + 1);
+    return p;
+  }
+
+  template<typename T>
+  T * allocateArray(size_t n)
+  {
+    return (T *) malloc(n * sizeof(T));
+  }
+};
+
+static void report(const char * name, long num_lines, const nebula::StopWatch & sw, size_t sum)
+{
+  printf("  %-22s %8.1f ns/line %8.2f M lines/s   (%zu)\n", name, sw.timeCostUs() * 1e3 / num_lines,
+    num_lines / (double) sw.timeCostUs(), sum);
+}
+
+int main(int argc, char ** argv)
+{
+  long num_lines = 10000000L;
+  int request_size = 500;
+  if (argc >= 2) {
+    num_lines = atol(argv[1]);
+  }
+  if (argc >= 3) {
+    request_size = atoi(argv[2]);
+  }
+
+  std::vector<char *> lines = generateLines(100000);
+  nebula::Tokens tokens;
+  nebula::DelimiterTable table(" ");
+  std::vector<Record *> records(request_size);
+  long num_requests = num_lines / request_size;
+  nebula::StopWatch sw;
+  size_t sum = 0;
+
+  printf("%ld lines, %d per request\n", num_requests * request_size, request_size);
+
+  // the same parsing into reused buffers, what is left is the allocators
+  nebula::Arena reused;
+  sw.start();
+  for (long q = 0, next = 0; q < num_requests; ++q) {
+    for (int i = 0; i < request_size; ++i, next = (next + 1) % lines.size()) {
+      Record r;
+      nebula::Arena::Mark mark = reused.mark();
+      parseLine(reused, tokens, table, lines[next], &r);
+      reused.rewind(mark);
+      sum += r.num_fields;
+    }
+  }
+  sw.stop();
+  report("no allocation", num_requests * request_size, sw, sum);
+
+  sum = 0;
+  sw.reset();
+
+  MallocAlloc m;
+  sw.start();
+  for (long q = 0, next = 0; q < num_requests; ++q) {
+    for (int i = 0; i < request_size; ++i, next = (next + 1) % lines.size()) {
+      Record * r = records[i] = (Record *) malloc(sizeof(Record));
+      parseLine(m, tokens, table, lines[next], r);
+      sum += r->num_fields;
+    }
+    for (int i = 0; i < request_size; ++i) {
+      free(records[i]->fields);
+      free(records[i]->text);
+      free(records[i]);
+    }
+  }
+  sw.stop();
+  report("malloc/free", num_requests * request_size, sw, sum);
+
+  sum = 0;
+  nebula::Arena arena;
+  sw.reset();
+  sw.start();
+  for (long q = 0, next = 0; q < num_requests; ++q) {
+    nebula::Arena::Mark mark = arena.mark();
+    for (int i = 0; i < request_size; ++i, next = (next + 1) % lines.size()) {
+      Record * r = records[i] = arena.allocateArray<Record>(1);
+      parseLine(arena, tokens, table, lines[next], r);
+      sum += r->num_fields;
+    }
+    arena.rewind(mark);
+  }
+  sw.stop();
+  report("Arena, rewind", num_requests * request_size, sw, sum);
+
+  sum = 0;
+  sw.reset();
+  sw.start();
+  for (long q = 0, next = 0; q < num_requests; ++q) {
+    nebula::ArenaScope scope(nebula::Arena::threadLocal());
+    for (int i = 0; i < request_size; ++i, next = (next + 1) % lines.size()) {
+      Record * r = records[i] = scope.arena().allocateArray<Record>(1);
+      parseLine(scope.arena(), tokens, table, lines[next], r);
+      sum += r->num_fields;
+    }
+  }
+  sw.stop();
+  report("thread Arena, scope", num_requests * request_size, sw, sum);
+
+  for (size_t i = 0; i < lines.size(); ++i) {
+    free(lines[i]);
+  }
+  exit(0);
+}
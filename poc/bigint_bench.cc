@@ -0,0 +1,149 @@
+/*
+ * bigint_bench.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "nebula/big_int.h"
+#include "nebula/random.h"
+#include "nebula/time.h"
+
+/*
+ * BigInt costs: first the Karatsuba crossover, one level of Karatsuba over
+ * schoolbook halves against plain schoolbook, which is what
+ * BigInt::KARATSUBA_THRESHOLD is picked from; then microseconds per
+ * multiply, per decimal and hexadecimal conversion and per decimal parse
+ * from 1k to 100k bits.
+ */
+
+nebula::BigInt randomBigInt(nebula::Prng & prng, size_t limbs)
+{
+  std::string s = "0x";
+  for (size_t i = 0; i < limbs * 16; ++i) {
+    s += "0123456789abcdef"[prng.nextBelow(16)];
+  }
+  nebula::BigInt r;
+  nebula::BigInt::parse(s.data(), s.size(), &r);
+  return r;
+}
+
+double usPerMultiply(const nebula::BigInt & a, const nebula::BigInt & b, long rounds)
+{
+  nebula::BigInt r;
+  nebula::StopWatch sw;
+  sw.start();
+  for (long i = 0; i < rounds; ++i) {
+    r = a * b;
+  }
+  sw.stop();
+  return (double) sw.timeCostUs() / rounds;
+}
+
+void crossover(nebula::Prng & prng, long budget)
+{
+  const size_t saved = nebula::BigInt::karatsubaThreshold();
+  const size_t sizes[] = { 8, 12, 16, 24, 32, 48, 64, 96, 128 };
+  printf("karatsuba crossover, us per multiply\n");
+  printf("  %6s %12s %12s\n", "limbs", "schoolbook", "karatsuba");
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    size_t n = sizes[i];
+    nebula::BigInt a = randomBigInt(prng, n);
+    nebula::BigInt b = randomBigInt(prng, n);
+    long rounds = budget / (n * n) + 1;
+    nebula::BigInt::setKaratsubaThreshold(1 << 30);
+    double school = usPerMultiply(a, b, rounds);
+    // the top level splits, the halves fall back to schoolbook
+    nebula::BigInt::setKaratsubaThreshold(n);
+    double karatsuba = usPerMultiply(a, b, rounds);
+    printf("  %6zu %12.3f %12.3f\n", n, school, karatsuba);
+  }
+  nebula::BigInt::setKaratsubaThreshold(saved);
+}
+
+void conversions(nebula::Prng & prng, long budget)
+{
+  const size_t bits[] = { 1000, 2000, 5000, 10000, 20000, 50000, 100000 };
+  const size_t saved = nebula::BigInt::karatsubaThreshold();
+  printf("us per operation (karatsuba threshold %zu limbs)\n", saved);
+  printf("  %8s %12s %12s %12s %12s %12s\n", "bits", "schoolbook", "multiply", "toString", "toString(16)", "parse");
+  for (size_t i = 0; i < sizeof(bits) / sizeof(bits[0]); ++i) {
+    size_t limbs = (bits[i] + 63) / 64;
+    nebula::BigInt a = randomBigInt(prng, limbs);
+    nebula::BigInt b = randomBigInt(prng, limbs);
+    long rounds = budget / (limbs * limbs) + 1;
+
+    nebula::BigInt::setKaratsubaThreshold(1 << 30);
+    double school = usPerMultiply(a, b, rounds);
+    nebula::BigInt::setKaratsubaThreshold(saved);
+    double multiply = usPerMultiply(a, b, rounds);
+
+    size_t len = 0;
+    nebula::StopWatch sw;
+    sw.start();
+    for (long r = 0; r < rounds; ++r) {
+      len += a.toString().size();
+    }
+    sw.stop();
+    double dec = (double) sw.timeCostUs() / rounds;
+
+    sw.reset();
+    sw.start();
+    for (long r = 0; r < rounds; ++r) {
+      len += a.toString(16).size();
+    }
+    sw.stop();
+    double hex = (double) sw.timeCostUs() / rounds;
+
+    std::string s = a.toString();
+    nebula::BigInt parsed;
+    sw.reset();
+    sw.start();
+    for (long r = 0; r < rounds; ++r) {
+      nebula::BigInt::parse(s.data(), s.size(), &parsed);
+    }
+    sw.stop();
+    double parse = (double) sw.timeCostUs() / rounds;
+    if (parsed != a) {
+      fprintf(stderr, "parse mismatch at %zu bits\n", bits[i]);
+      exit(1);
+    }
+
+    printf("  %8zu %12.2f %12.2f %12.2f %12.2f %12.2f   (%zu)\n", bits[i], school, multiply, dec, hex, parse, len);
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  // roughly the number of limb products per measurement
+  long budget = 200000000L;
+  if (argc >= 2) {
+    budget = atol(argv[1]);
+  }
+  nebula::Prng prng(2026);
+  crossover(prng, budget);
+  conversions(prng, budget / 20);
+  exit(0);
+}
@@ -0,0 +1,230 @@
+/*
+ * connection_echo.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "nebula/async_io.h"
+#include "nebula/connection.h"
+#include "nebula/time.h"
+
+/*
+ * Echo over loopback: a server process echoes on every connection, the
+ * client keeps one message of the given size in flight on each of many
+ * connections and counts round trips for a while, both sides built on
+ * Connection.
+ */
+
+using nebula::AsyncEvent;
+using nebula::AsyncIo;
+using nebula::Connection;
+using nebula::IoBuffer;
+
+// Server ------------------------------------------------------------------------------------------------------------
+
+void echo(Connection * conn, IoBuffer * input, void * data)
+{
+  if (conn->send(*input) < 0) {
+    conn->close();
+  }
+}
+
+void stopReading(Connection * conn, bool above, void * data)
+{
+  if (above) {
+    conn->pauseReading();
+  }
+  else {
+    conn->resumeReading();
+  }
+}
+
+void release(Connection * conn, int error, void * data)
+{
+  delete conn;
+}
+
+uint32_t acceptAll(int fd, uint32_t mask, void * data, AsyncEvent * ae)
+{
+  int client;
+  while ((client = AsyncIo::accept4(fd, NULL, NULL, AsyncIo::AIO_NONBLOCK)) >= 0) {
+    AsyncIo::setTcpNoDelay(client);
+    Connection * conn = new Connection(ae, client);
+    conn->setCallbacks(echo, release, NULL);
+    conn->setWatermarks(1 << 20, 256 << 10, stopReading);
+    if (conn->init() < 0) {
+      delete conn;
+    }
+  }
+  return AsyncEvent::NONE;
+}
+
+void serve(int listen_fd)
+{
+  AsyncEvent ae;
+  if (ae.initialize(1024) < 0 || ae.addFdEvent(listen_fd, AsyncEvent::READABLE, acceptAll) < 0) {
+    perror("server");
+    exit(1);
+  }
+  ae.eventLoop();
+  exit(0);
+}
+
+// Client ------------------------------------------------------------------------------------------------------------
+
+struct Client
+{
+  const char * message;
+  size_t message_size;
+  uint64_t round_trips;
+  int closed;
+  bool stopping;
+};
+
+void onEcho(Connection * conn, IoBuffer * input, void * data)
+{
+  Client * client = (Client *) data;
+  while (input->size() >= client->message_size) {
+    input->consume(client->message_size);
+    ++client->round_trips;
+    if (!client->stopping && conn->send(client->message, client->message_size) < 0) {
+      return;
+    }
+  }
+}
+
+void onClosed(Connection * conn, int error, void * data)
+{
+  ++((Client *) data)->closed;
+}
+
+uint32_t timeUp(uint64_t time_event_id, void * data, AsyncEvent * ae)
+{
+  ((Client *) data)->stopping = true;
+  ae->stop();
+  return 0;
+}
+
+int main(int argc, char ** argv)
+{
+  int num_conns = 10000;
+  size_t message_size = 4096;
+  int seconds = 5;
+  if (argc >= 2) {
+    num_conns = atoi(argv[1]);
+  }
+  if (argc >= 3) {
+    message_size = strtoul(argv[2], NULL, 10);
+  }
+  if (argc >= 4) {
+    seconds = atoi(argv[3]);
+  }
+
+  struct rlimit rl;
+  getrlimit(RLIMIT_NOFILE, &rl);
+  rl.rlim_cur = rl.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &rl);
+  if ((rlim_t) num_conns + 64 > rl.rlim_cur) {
+    num_conns = rl.rlim_cur - 64;
+    printf("descriptors limited to %lu, using %d connections\n", (unsigned long) rl.rlim_cur, num_conns);
+  }
+
+  int listen_fd = AsyncIo::tcpServer("127.0.0.1", 0);
+  struct sockaddr_in addr;
+  socklen_t addr_len = sizeof(addr);
+  if (listen_fd < 0 || getsockname(listen_fd, (struct sockaddr *) &addr, &addr_len) < 0) {
+    perror("listen");
+    exit(1);
+  }
+  pid_t server = fork();
+  if (server < 0) {
+    perror("fork");
+    exit(1);
+  }
+  if (!server) {
+    serve(listen_fd);
+  }
+  close(listen_fd);
+
+  AsyncEvent ae;
+  if (ae.initialize(1024) < 0) {
+    perror("initialize");
+    exit(1);
+  }
+  char * message = (char *) malloc(message_size);
+  memset(message, 'x', message_size);
+  Client client = { message, message_size, 0, 0, false };
+  Connection ** conns = new Connection *[num_conns];
+  for (int i = 0; i < num_conns; ++i) {
+    int fd = AsyncIo::tcpClient(&addr);
+    if (fd < 0) {
+      perror("connect");
+      exit(1);
+    }
+    AsyncIo::setTcpNoDelay(fd);
+    conns[i] = new Connection(&ae, fd);
+    conns[i]->setCallbacks(onEcho, onClosed, &client);
+    if (conns[i]->init() < 0) {
+      perror("init");
+      exit(1);
+    }
+  }
+
+  printf("%d connections, %zu byte messages, %d seconds\n", num_conns, message_size, seconds);
+  nebula::StopWatch sw;
+  sw.start();
+  for (int i = 0; i < num_conns; ++i) {
+    conns[i]->send(message, message_size);
+  }
+  if (ae.addTimeEvent(seconds * 1000, timeUp, &client) < 0) {
+    perror("addTimeEvent");
+    exit(1);
+  }
+  ae.eventLoop();
+  sw.stop();
+
+  double us = sw.timeCostUs();
+  printf("  %12.0f round trips/s\n", client.round_trips / us * 1e6);
+  printf("  %12.1f MB/s echoed\n", client.round_trips * message_size / us);
+  printf("  %12d connections lost\n", client.closed);
+
+  for (int i = 0; i < num_conns; ++i) {
+    delete conns[i];
+  }
+  delete[] conns;
+  free(message);
+  kill(server, SIGTERM);
+  waitpid(server, NULL, 0);
+  exit(0);
+}
@@ -0,0 +1,133 @@
+/*
+ * endian_bulk.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "nebula/endian.h"
+#include "nebula/multiversion.h"
+#include "nebula/time.h"
+
+/*
+ * Big endian to host conversion of arrays of 32 and 64 bit integers: one
+ * element at a time with the former byte-at-a-time swap, one element at a
+ * time with Endian::fromBe32() / fromBe64(), and with the bulk functions at
+ * every SIMD level this machine supports.
+ */
+
+uint32_t oldSwap32(uint32_t in)
+{
+  uint32_t out = 0;
+  for (int i = 0; i < 4; ++i) {
+    out = (out << 8) | (in & 0xff);
+    in >>= 8;
+  }
+  return out;
+}
+
+uint64_t oldSwap64(uint64_t in)
+{
+  uint64_t out = 0;
+  for (int i = 0; i < 8; ++i) {
+    out = (out << 8) | (in & 0xff);
+    in >>= 8;
+  }
+  return out;
+}
+
+// the function is a template argument so that it gets inlined into the loop
+template<typename T, T (*F)(T)>
+void perElement(T * dst, const T * src, size_t n, int rounds)
+{
+  for (int r = 0; r < rounds; ++r) {
+    for (size_t i = 0; i < n; ++i) {
+      dst[i] = F(src[i]);
+    }
+    __asm__ __volatile__ ("" : : "r" (dst) : "memory");
+  }
+}
+
+void report(const char * name, size_t bytes, int rounds, const nebula::StopWatch & sw)
+{
+  double us = sw.timeCostUs() > 0 ? sw.timeCostUs() : 1;
+  printf("  %-28s %8.2f GB/s\n", name, 1.0 * bytes * rounds / us / 1e3);
+}
+
+template<typename T, T (*OLD_SWAP)(T), T (*SINGLE)(T)>
+void evaluate(const char * width, void (*bulk)(T *, const T *, size_t), size_t bytes, int rounds)
+{
+  size_t n = bytes / sizeof(T);
+  T * src = (T *) malloc(n * sizeof(T));
+  T * dst = (T *) malloc(n * sizeof(T));
+  for (size_t i = 0; i < n; ++i) {
+    src[i] = (T) (((uint64_t) random() << 32) | random());
+  }
+  char name[64];
+  nebula::StopWatch sw;
+
+  printf("%s bit, %zu bytes x %d rounds\n", width, n * sizeof(T), rounds);
+  sw.start();
+  perElement<T, OLD_SWAP>(dst, src, n, rounds);
+  sw.stop();
+  report("per element, byte loop", n * sizeof(T), rounds, sw);
+
+  sw.reset();
+  sw.start();
+  perElement<T, SINGLE>(dst, src, n, rounds);
+  sw.stop();
+  report("per element, bswap", n * sizeof(T), rounds, sw);
+
+  nebula::SimdLevel::Constants saved = nebula::MultiversionBase::levelLimit();
+  for (int level = nebula::HardwareInfo::simdLevel(); level >= nebula::SimdLevel::SCALAR; --level) {
+    nebula::MultiversionBase::limitLevel((nebula::SimdLevel::Constants) level);
+    snprintf(name, sizeof(name), "bulk, %s", nebula::SimdLevel::toString((nebula::SimdLevel::Constants) level));
+    sw.reset();
+    sw.start();
+    for (int r = 0; r < rounds; ++r) {
+      bulk(dst, src, n);
+    }
+    sw.stop();
+    report(name, n * sizeof(T), rounds, sw);
+  }
+  nebula::MultiversionBase::limitLevel(saved);
+
+  free(src);
+  free(dst);
+}
+
+int main(int argc, char ** argv)
+{
+  size_t bytes = 64 << 10; // fits in L2, use a larger size to measure memory bandwidth instead
+  int rounds = 20000;
+  if (argc >= 2) {
+    bytes = strtoul(argv[1], NULL, 10);
+  }
+  if (argc >= 3) {
+    rounds = atoi(argv[2]);
+  }
+  evaluate<uint32_t, oldSwap32, nebula::Endian::fromBe32>("32", nebula::Endian::fromBe32, bytes, rounds);
+  evaluate<uint64_t, oldSwap64, nebula::Endian::fromBe64>("64", nebula::Endian::fromBe64, bytes, rounds);
+  exit(0);
+}
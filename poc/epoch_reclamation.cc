@@ -0,0 +1,187 @@
+/*
+ * epoch_reclamation.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "nebula/epoch.h"
+#include "nebula/mutex.h"
+#include "nebula/time.h"
+
+/*
+ * Read-side cost of protecting a shared, periodically replaced object:
+ * no protection at all (unsafe, the baseline), an EpochGuard, a shared
+ * DistributedRWLock, and pthread_rwlock_t, with 1..N reader threads.
+ */
+
+struct Config
+{
+  long values[4];
+};
+
+enum Method
+{
+  UNPROTECTED, EPOCH, DISTRIBUTED_RWLOCK, PTHREAD_RWLOCK
+};
+
+static const char * method_names[] =
+{ "unprotected", "EpochGuard", "DistributedRWLock", "pthread_rwlock_t" };
+
+struct Shared
+{
+  Config * config;
+  nebula::EpochDomain domain;
+  nebula::DistributedRWLock rwlock;
+  pthread_rwlock_t pthread_rwlock;
+  volatile int stop;
+};
+
+class Reader: public nebula::EpochThread
+{
+public:
+  Shared * shared_;
+  Method method_;
+  long reads_;
+  long checksum_;
+
+  Reader() :
+    shared_(NULL), method_(UNPROTECTED), reads_(0), checksum_(0)
+  {
+  }
+
+  void * routine()
+  {
+    while (!__atomic_load_n(&shared_->stop, __ATOMIC_RELAXED)) {
+      for (int i = 0; i < 256; ++i) {
+        switch (method_) {
+          case UNPROTECTED:
+            checksum_ += __atomic_load_n(&shared_->config, __ATOMIC_ACQUIRE)->values[i & 3];
+            break;
+          case EPOCH: {
+            nebula::EpochGuard guard(shared_->domain);
+            checksum_ += __atomic_load_n(&shared_->config, __ATOMIC_ACQUIRE)->values[i & 3];
+            break;
+          }
+          case DISTRIBUTED_RWLOCK: {
+            nebula::ScopedSharedLock guard(shared_->rwlock);
+            checksum_ += shared_->config->values[i & 3];
+            break;
+          }
+          case PTHREAD_RWLOCK:
+            pthread_rwlock_rdlock(&shared_->pthread_rwlock);
+            checksum_ += shared_->config->values[i & 3];
+            pthread_rwlock_unlock(&shared_->pthread_rwlock);
+            break;
+        }
+      }
+      reads_ += 256;
+    }
+    return NULL;
+  }
+};
+
+static void evaluate(Method method, int num_readers, int duration_ms)
+{
+  Shared shared;
+  if (shared.domain.init() < 0) {
+    perror("EpochDomain::init");
+    exit(1);
+  }
+  shared.config = new Config();
+  shared.stop = 0;
+  pthread_rwlock_init(&shared.pthread_rwlock, NULL);
+  Reader * readers = new Reader[num_readers];
+  nebula::StopWatch sw;
+  sw.start();
+  for (int i = 0; i < num_readers; ++i) {
+    readers[i].shared_ = &shared;
+    readers[i].method_ = method;
+    readers[i].create();
+  }
+
+  // replace the configuration every millisecond
+  std::vector<Config *> leaked; // nothing else is safe without protection
+  for (int elapsed = 0; elapsed < duration_ms; ++elapsed) {
+    usleep(1000);
+    Config * config = new Config();
+    config->values[0] = elapsed;
+    switch (method) {
+      case UNPROTECTED:
+        leaked.push_back(__atomic_exchange_n(&shared.config, config, __ATOMIC_ACQ_REL));
+        break;
+      case EPOCH:
+        shared.domain.retire(__atomic_exchange_n(&shared.config, config, __ATOMIC_ACQ_REL));
+        break;
+      case DISTRIBUTED_RWLOCK:
+        shared.rwlock.lock();
+        std::swap(shared.config, config);
+        shared.rwlock.unlock();
+        delete config;
+        break;
+      case PTHREAD_RWLOCK:
+        pthread_rwlock_wrlock(&shared.pthread_rwlock);
+        std::swap(shared.config, config);
+        pthread_rwlock_unlock(&shared.pthread_rwlock);
+        delete config;
+        break;
+    }
+  }
+  __atomic_store_n(&shared.stop, 1, __ATOMIC_RELAXED);
+  long reads = 0;
+  for (int i = 0; i < num_readers; ++i) {
+    readers[i].join();
+    reads += readers[i].reads_;
+  }
+  sw.stop();
+  printf("  %-20s %3d readers %12.0f reads/s\n", method_names[method], num_readers, reads * 1e6 / sw.timeCostUs());
+  delete[] readers;
+  for (size_t i = 0; i < leaked.size(); ++i) {
+    delete leaked[i];
+  }
+  delete shared.config;
+  pthread_rwlock_destroy(&shared.pthread_rwlock);
+}
+
+int main(int argc, char ** argv)
+{
+  int max_readers = 16;
+  int duration_ms = 200;
+  if (argc >= 2) {
+    max_readers = atoi(argv[1]);
+  }
+  if (argc >= 3) {
+    duration_ms = atoi(argv[2]);
+  }
+  for (int n = 1; n <= max_readers; n *= 2) {
+    for (int m = UNPROTECTED; m <= PTHREAD_RWLOCK; ++m) {
+      evaluate((Method) m, n, duration_ms);
+    }
+  }
+  exit(0);
+}
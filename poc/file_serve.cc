@@ -0,0 +1,226 @@
+/*
+ * file_serve.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "nebula/async_io.h"
+#include "nebula/connection.h"
+#include "nebula/time.h"
+
+/*
+ * Serving a file over loopback TCP to a client process which discards it:
+ * throughput, and processor time of the server and of the client, with
+ * pread()/write() through a user space buffer, sendfile(), splice()
+ * through a pooled pipe, and Connection::sendFile() on an event loop.
+ * The file is written first, so it is in the page cache.
+ */
+
+using nebula::AsyncEvent;
+using nebula::AsyncIo;
+using nebula::Connection;
+using nebula::SplicePipe;
+
+enum
+{
+  CHUNK = 64 << 10
+};
+
+void die(const char * what)
+{
+  perror(what);
+  exit(1);
+}
+
+void readWrite(int sock, int file, size_t size)
+{
+  char * buf = (char *) malloc(CHUNK);
+  for (off_t off = 0; off < (off_t) size;) {
+    ssize_t n = pread(file, buf, CHUNK, off);
+    if (n <= 0) {
+      die("pread");
+    }
+    off += n;
+    for (ssize_t done = 0; done < n;) {
+      ssize_t w = write(sock, buf + done, n - done);
+      if (w <= 0) {
+        die("write");
+      }
+      done += w;
+    }
+  }
+  free(buf);
+}
+
+void sendFile(int sock, int file, size_t size)
+{
+  off_t off = 0;
+  while (off < (off_t) size) {
+    if (AsyncIo::sendFile(sock, file, &off, size - off) <= 0) {
+      die("sendfile");
+    }
+  }
+}
+
+void splice(int sock, int file, size_t size)
+{
+  SplicePipe pipe;
+  off_t off = 0;
+  while (off < (off_t) size || pipe.buffered()) {
+    if (off < (off_t) size && pipe.fill(file, size - off, &off) < 0) {
+      die("splice");
+    }
+    // the socket is blocking, SPLICE_F_NONBLOCK only concerns the pipe
+    if (pipe.drain(sock, pipe.buffered()) < 0) {
+      die("splice");
+    }
+  }
+}
+
+void stopLoop(Connection * conn, int error, void * data)
+{
+  if (error) {
+    fprintf(stderr, "connection closed: %s\n", strerror(error));
+  }
+  ((AsyncEvent *) data)->stop();
+}
+
+void eventLoop(int sock, int file, size_t size)
+{
+  AsyncEvent ae;
+  if (ae.initialize() < 0) {
+    die("initialize");
+  }
+  Connection conn(&ae, dup(sock));
+  conn.setCallbacks(NULL, stopLoop, &ae);
+  if (conn.init() < 0 || conn.sendFile(file, 0, size) < 0) {
+    die("sendFile");
+  }
+  conn.shutdown();
+  ae.eventLoop();
+}
+
+void drain(int listen_fd)
+{
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  getsockname(listen_fd, (struct sockaddr *) &addr, &len);
+  close(listen_fd);
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (sock < 0 || connect(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+    die("connect");
+  }
+  char * buf = (char *) malloc(1 << 20);
+  while (read(sock, buf, 1 << 20) > 0) {
+  }
+  exit(0);
+}
+
+double cpuSeconds(int who)
+{
+  struct rusage ru;
+  getrusage(who, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+void run(const char * name, void (*serve)(int, int, size_t), int listen_fd, int file, size_t size)
+{
+  fflush(stdout);
+  pid_t client = fork();
+  if (client < 0) {
+    die("fork");
+  }
+  if (!client) {
+    drain(listen_fd);
+  }
+  int sock = accept(listen_fd, NULL, NULL);
+  if (sock < 0) {
+    die("accept");
+  }
+
+  double server_cpu = cpuSeconds(RUSAGE_SELF);
+  double client_cpu = cpuSeconds(RUSAGE_CHILDREN);
+  nebula::StopWatch sw;
+  sw.start();
+  serve(sock, file, size);
+  close(sock);
+  waitpid(client, NULL, 0);
+  sw.stop();
+  double secs = sw.timeCostUs() / 1e6;
+  server_cpu = cpuSeconds(RUSAGE_SELF) - server_cpu;
+  client_cpu = cpuSeconds(RUSAGE_CHILDREN) - client_cpu;
+  printf("  %-12s %8.2f GB/s %10.0f%% %10.0f%%\n", name, size / secs / 1e9, server_cpu / secs * 100,
+    client_cpu / secs * 100);
+}
+
+int main(int argc, char ** argv)
+{
+  size_t size = (size_t) 1 << 30;
+  if (argc >= 2) {
+    size = strtoul(argv[1], NULL, 10) << 20;
+  }
+
+  const char * dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+  char path[256];
+  snprintf(path, sizeof(path), "%s/file_serve_XXXXXX", dir);
+  int file = mkstemp(path);
+  if (file < 0) {
+    die("mkstemp");
+  }
+  unlink(path);
+  char * buf = (char *) malloc(CHUNK);
+  for (size_t i = 0; i < CHUNK; ++i) {
+    buf[i] = (char) ('a' + i % 26);
+  }
+  for (size_t done = 0; done < size; done += CHUNK) {
+    if (write(file, buf, CHUNK) != CHUNK) {
+      die("write");
+    }
+  }
+  free(buf);
+
+  int listen_fd = AsyncIo::tcpServer("127.0.0.1", 0);
+  if (listen_fd < 0) {
+    die("listen");
+  }
+  // blocking accept
+  fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) & ~O_NONBLOCK);
+
+  printf("serving %zu MB over loopback\n", size >> 20);
+  printf("  %-12s %13s %11s %11s\n", "", "throughput", "server cpu", "client cpu");
+  run("read/write", readWrite, listen_fd, file, size);
+  run("sendfile", sendFile, listen_fd, file, size);
+  run("splice", splice, listen_fd, file, size);
+  run("Connection", eventLoop, listen_fd, file, size);
+  close(file);
+  exit(0);
+}
@@ -0,0 +1,133 @@
+/*
+ * file_status.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "nebula/file_status_cache.h"
+#include "nebula/file_system.h"
+#include "nebula/time.h"
+
+/*
+ * Repeated modification time queries on many paths: stat() through
+ * FileSystem::mtime(), statx() asking for the modification time only, and
+ * FileStatusCache, which answers from memory once every path was seen.
+ */
+
+static int removeItem(const char * fpath, const struct stat * sb, int typeflag, struct FTW * ftwbuf)
+{
+  return remove(fpath);
+}
+
+static void report(const char * name, nebula::StopWatch * sw, long queries, long checksum)
+{
+  printf("%-40s %8ld usec, %8.1f ns/query (checksum %ld)\n", name, sw->timeCostUs(),
+    sw->timeCostUs() * 1000.0 / queries, checksum);
+}
+
+int main(int argc, char ** argv)
+{
+  int num_paths = 10000;
+  int rounds = 10;
+  if (argc >= 2) {
+    num_paths = atoi(argv[1]);
+  }
+  if (argc >= 3) {
+    rounds = atoi(argv[2]);
+  }
+
+  char root[] = "file_status_XXXXXX";
+  if (!mkdtemp(root)) {
+    perror("mkdtemp");
+    exit(1);
+  }
+  // 100 files per directory
+  std::vector<std::string> paths;
+  char path[256];
+  for (int i = 0; i < num_paths; ++i) {
+    if (i % 100 == 0) {
+      snprintf(path, sizeof(path), "%s/d%d", root, i / 100);
+      mkdir(path, 0755);
+    }
+    snprintf(path, sizeof(path), "%s/d%d/f%d", root, i / 100, i);
+    int fd = open(path, O_CREAT | O_WRONLY, 0644);
+    if (fd < 0) {
+      perror(path);
+      exit(1);
+    }
+    close(fd);
+    paths.push_back(path);
+  }
+  long queries = (long) num_paths * rounds;
+  printf("%d paths, %d rounds\n", num_paths, rounds);
+
+  nebula::StopWatch sw;
+  long checksum = 0;
+  sw.start();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < num_paths; ++i) {
+      checksum += nebula::FileSystem::mtime(paths[i].c_str()) & 0xff;
+    }
+  }
+  sw.stop();
+  report("FileSystem::mtime()", &sw, queries, checksum);
+
+  struct statx sx;
+  checksum = 0;
+  sw.start();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < num_paths; ++i) {
+      if (nebula::FileSystem::getFileStatusX(paths[i].c_str(), STATX_MTIME, &sx) == 0) {
+        checksum += sx.stx_mtime.tv_sec & 0xff;
+      }
+    }
+  }
+  sw.stop();
+  report("FileSystem::getFileStatusX(STATX_MTIME)", &sw, queries, checksum);
+
+  nebula::FileStatusCache cache(STATX_MTIME);
+  if (cache.init() < 0) {
+    perror("FileStatusCache::init");
+  }
+  checksum = 0;
+  sw.start();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < num_paths; ++i) {
+      checksum += cache.mtime(paths[i].c_str()) & 0xff;
+    }
+  }
+  sw.stop();
+  report("FileStatusCache::mtime()", &sw, queries, checksum);
+  printf("%lu hits, %lu misses\n", cache.hits(), cache.misses());
+
+  nftw(root, removeItem, 16, FTW_DEPTH | FTW_PHYS);
+  exit(0);
+}
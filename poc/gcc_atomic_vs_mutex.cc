@@ -26,7 +26,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
+#include "nebula/mutex.h"
+#include "nebula/thread.h"
 #include "nebula/time.h"
 
 void evaluate(unsigned int * v, int num_iterations = 1000000)
@@ -83,12 +86,105 @@ void evaluatePthreadMutex(pthread_mutex_t * lock, int num_iterations = 1000000)
   printf("%s\n", sw.message("pthread_mutex_{lock,unlock}", num_iterations));
 }
 
+/*
+ * Contended case: every thread repeatedly takes the lock and runs a short
+ * (one increment) or long (a few dozen cache lines written) critical section,
+ * with a little private work in between.
+ */
+
+struct SharedState
+{
+  long counter;
+  long table[512];
+};
+
+template<typename LockType>
+class ContendedWorker: public nebula::Thread
+{
+private:
+  LockType * lock_;
+  SharedState * shared_;
+  int num_iterations_;
+  int cs_length_;
+
+public:
+  ContendedWorker() :
+    lock_(NULL), shared_(NULL), num_iterations_(0), cs_length_(0)
+  {
+  }
+
+  void setup(LockType * lock, SharedState * shared, int num_iterations, int cs_length)
+  {
+    lock_ = lock;
+    shared_ = shared;
+    num_iterations_ = num_iterations;
+    cs_length_ = cs_length;
+  }
+
+  void * routine()
+  {
+    volatile long local = 0;
+    for (int i = 0; i < num_iterations_; ++i) {
+      lock_->lock();
+      ++shared_->counter;
+      for (int j = 0; j < cs_length_; ++j) {
+        shared_->table[(j * 8) & 511] += j;
+      }
+      lock_->unlock();
+      for (int j = 0; j < 16; ++j) {
+        local = local + j;
+      }
+    }
+    return NULL;
+  }
+};
+
+template<typename LockType>
+void evaluateContended(const char * name, int num_threads, int num_iterations, int cs_length)
+{
+  LockType lock;
+  SharedState shared;
+  memset(&shared, 0, sizeof(shared));
+  ContendedWorker<LockType> * workers = new ContendedWorker<LockType> [num_threads];
+  int per_thread = num_iterations / num_threads;
+  nebula::StopWatch sw;
+  sw.start();
+  for (int i = 0; i < num_threads; ++i) {
+    workers[i].setup(&lock, &shared, per_thread, cs_length);
+    workers[i].create();
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    workers[i].join();
+  }
+  sw.stop();
+  delete[] workers;
+  if (shared.counter != (long) per_thread * num_threads) {
+    printf("%s: mutual exclusion broken\n", name);
+  }
+  printf("  %-16s %3d threads %10.0f ops/s\n", name, num_threads, per_thread * num_threads * 1e6 / sw.timeCostUs());
+}
+
+void evaluateAllLocks(int max_threads, int num_iterations, int cs_length)
+{
+  printf("%s critical section (%d cache lines written)\n", cs_length ? "long" : "short", cs_length);
+  for (int n = 1; n <= max_threads; n *= 2) {
+    evaluateContended<nebula::Mutex>("Mutex", n, num_iterations, cs_length);
+    evaluateContended<nebula::AdaptiveMutex>("AdaptiveMutex", n, num_iterations, cs_length);
+    evaluateContended<nebula::SpinLock>("SpinLock", n, num_iterations, cs_length);
+    evaluateContended<nebula::TicketLock>("TicketLock", n, num_iterations, cs_length);
+  }
+}
+
 int main(int argc, char ** argv)
 {
   int num_iterations = 1000000;
+  int max_threads = 64;
   if (argc >= 2) {
     num_iterations = atoi(argv[1]);
   }
+  if (argc >= 3) {
+    max_threads = atoi(argv[2]);
+  }
 
   unsigned int ui = 0;
   volatile unsigned int vui = 0;
@@ -99,5 +195,8 @@ int main(int argc, char ** argv)
   evaluatePthreadMutex(&lock, num_iterations);
   pthread_mutex_destroy(&lock);
 
+  evaluateAllLocks(max_threads, num_iterations / 10, 0);
+  evaluateAllLocks(max_threads, num_iterations / 10, 32);
+
   exit(0);
 }
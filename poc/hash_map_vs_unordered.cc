@@ -0,0 +1,142 @@
+/*
+ * hash_map_vs_unordered.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <unordered_map>
+#include "nebula/hash_map.h"
+#include "nebula/random.h"
+#include "nebula/time.h"
+
+/*
+ * FlatHashMap against std::unordered_map with uint64_t keys and values:
+ * nanoseconds per insertion, successful lookup, failed lookup and erase,
+ * and heap bytes per entry (from mallinfo2(), so including the allocator
+ * overhead of every unordered_map node), from 1K to 10M entries.
+ */
+
+size_t heapInUse()
+{
+  // large blocks, e.g. the slots of big tables, are mmap()ed
+  struct mallinfo2 mi = mallinfo2();
+  return mi.uordblks + mi.hblkhd;
+}
+
+struct Result
+{
+  double insert, hit, miss, erase, bytes;
+};
+
+template<typename Map>
+void run(const std::vector<uint64_t> & keys, const std::vector<uint64_t> & absent, int rounds, Result * res)
+{
+  size_t n = keys.size();
+  uint64_t sum = 0;
+  double insert = 0, hit = 0, miss = 0, erase = 0;
+  nebula::StopWatch sw;
+
+  for (int r = 0; r < rounds; ++r) {
+    size_t heap = heapInUse();
+    Map * map = new Map;
+
+    sw.reset();
+    sw.start();
+    for (size_t i = 0; i < n; ++i) {
+      (*map)[keys[i]] = i;
+    }
+    sw.stop();
+    insert += sw.timeCostUs();
+    res->bytes = (double) (heapInUse() - heap) / n;
+
+    sw.reset();
+    sw.start();
+    for (size_t i = 0; i < n; ++i) {
+      sum += map->find(keys[i])->second;
+    }
+    sw.stop();
+    hit += sw.timeCostUs();
+
+    sw.reset();
+    sw.start();
+    for (size_t i = 0; i < n; ++i) {
+      sum += map->find(absent[i]) == map->end();
+    }
+    sw.stop();
+    miss += sw.timeCostUs();
+
+    sw.reset();
+    sw.start();
+    for (size_t i = 0; i < n; ++i) {
+      sum += map->erase(keys[i]);
+    }
+    sw.stop();
+    erase += sw.timeCostUs();
+    delete map;
+  }
+  if (sum == 42) {
+    printf("\n");
+  }
+
+  double ops = (double) n * rounds / 1e3;
+  res->insert = insert / ops;
+  res->hit = hit / ops;
+  res->miss = miss / ops;
+  res->erase = erase / ops;
+}
+
+void report(const char * name, const Result & r)
+{
+  printf("  %-16s %8.1f %8.1f %8.1f %8.1f %10.1f\n", name, r.insert, r.hit, r.miss, r.erase, r.bytes);
+}
+
+int main(int argc, char ** argv)
+{
+  size_t max_entries = 10000000;
+  if (argc >= 2) {
+    max_entries = strtoul(argv[1], NULL, 10);
+  }
+
+  nebula::Prng prng(2026);
+  for (size_t n = 1000; n <= max_entries; n *= 10) {
+    std::vector<uint64_t> keys(n), absent(n);
+    for (size_t i = 0; i < n; ++i) {
+      keys[i] = prng.randomU64() | 1;
+      absent[i] = prng.randomU64() & ~(uint64_t) 1;
+    }
+    int rounds = n >= 10000000 ? 1 : (int) (10000000 / n);
+
+    Result flat, unordered;
+    run<nebula::FlatHashMap<uint64_t, uint64_t> >(keys, absent, rounds, &flat);
+    run<std::unordered_map<uint64_t, uint64_t> >(keys, absent, rounds, &unordered);
+    printf("%zu entries, ns per operation\n", n);
+    printf("  %-16s %8s %8s %8s %8s %10s\n", "", "insert", "hit", "miss", "erase", "bytes/ent");
+    report("FlatHashMap", flat);
+    report("unordered_map", unordered);
+  }
+  exit(0);
+}
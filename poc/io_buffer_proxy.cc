@@ -0,0 +1,165 @@
+/*
+ * io_buffer_proxy.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "nebula/io_buffer.h"
+#include "nebula/time.h"
+
+/*
+ * Proxy-style forwarding: a source thread writes into one socket pair, a
+ * sink thread drains another, and the proxy in between moves the bytes
+ * from the first to the second, either
+ *   - flat: read() into an input array, memcpy() into an output array,
+ *     write() from it, as our servers do today, or
+ *   - chain: IoBuffer::readFrom() then IoBuffer::writeTo(), the slices
+ *     read being written out in place.
+ */
+
+enum
+{
+  CHUNK = 64 << 10
+};
+
+struct Endpoint
+{
+  int fd;
+  uint64_t bytes;
+};
+
+void * source(void * arg)
+{
+  Endpoint * e = (Endpoint *) arg;
+  char * buf = (char *) malloc(CHUNK);
+  memset(buf, 'x', CHUNK);
+  for (uint64_t sent = 0; sent < e->bytes;) {
+    ssize_t n = write(e->fd, buf, e->bytes - sent < CHUNK ? e->bytes - sent : CHUNK);
+    if (n <= 0) {
+      perror("write");
+      exit(1);
+    }
+    sent += n;
+  }
+  shutdown(e->fd, SHUT_WR);
+  free(buf);
+  return NULL;
+}
+
+void * sink(void * arg)
+{
+  Endpoint * e = (Endpoint *) arg;
+  char * buf = (char *) malloc(CHUNK);
+  ssize_t n;
+  e->bytes = 0;
+  while ((n = read(e->fd, buf, CHUNK)) > 0) {
+    e->bytes += n;
+  }
+  free(buf);
+  return NULL;
+}
+
+void forwardFlat(int in, int out)
+{
+  char * input = (char *) malloc(CHUNK);
+  char * output = (char *) malloc(CHUNK);
+  ssize_t n;
+  while ((n = read(in, input, CHUNK)) > 0) {
+    memcpy(output, input, n);
+    for (ssize_t done = 0; done < n;) {
+      ssize_t w = write(out, output + done, n - done);
+      if (w <= 0) {
+        perror("write");
+        exit(1);
+      }
+      done += w;
+    }
+  }
+  free(input);
+  free(output);
+}
+
+void forwardChain(int in, int out)
+{
+  nebula::IoBuffer buf;
+  while (buf.readFrom(in) > 0) {
+    while (!buf.empty()) {
+      if (buf.writeTo(out) < 0) {
+        perror("writev");
+        exit(1);
+      }
+    }
+  }
+}
+
+void run(const char * name, void (*forward)(int, int), uint64_t bytes)
+{
+  int a[2], b[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, a) < 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, b) < 0) {
+    perror("socketpair");
+    exit(1);
+  }
+  Endpoint src = { a[0], bytes };
+  Endpoint dst = { b[1], 0 };
+  pthread_t t1, t2;
+
+  nebula::StopWatch sw;
+  sw.start();
+  pthread_create(&t1, NULL, source, &src);
+  pthread_create(&t2, NULL, sink, &dst);
+  forward(a[1], b[0]);
+  shutdown(b[0], SHUT_WR);
+  pthread_join(t1, NULL);
+  pthread_join(t2, NULL);
+  sw.stop();
+
+  if (dst.bytes != bytes) {
+    fprintf(stderr, "%s: forwarded %llu bytes out of %llu\n", name, (unsigned long long) dst.bytes,
+      (unsigned long long) bytes);
+    exit(1);
+  }
+  printf("  %-6s %8.2f GB/s\n", name, bytes / (double) sw.timeCostUs() / 1e3);
+  close(a[0]);
+  close(a[1]);
+  close(b[0]);
+  close(b[1]);
+}
+
+int main(int argc, char ** argv)
+{
+  double gb = 10;
+  if (argc >= 2) {
+    gb = atof(argv[1]);
+  }
+  uint64_t bytes = (uint64_t) (gb * 1e9);
+  printf("forwarding %.1f GB\n", gb);
+  run("flat", forwardFlat, bytes);
+  run("chain", forwardChain, bytes);
+  exit(0);
+}
@@ -0,0 +1,140 @@
+/*
+ * number_parsing.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nebula/random.h"
+#include "nebula/string.h"
+#include "nebula/time.h"
+
+/*
+ * String::parseI64()/parseDouble() versus strtol()/strtod(), the same set of
+ * numbers is parsed `rounds' times, total = num_values * rounds.
+ */
+
+struct Field
+{
+  const char * data;
+  size_t length;
+};
+
+static char * generate(int num_values, bool floating, Field * fields)
+{
+  nebula::Prng prng(54321);
+  char * text = (char *) malloc(num_values * 32);
+  char * pos = text;
+  for (int i = 0; i < num_values; ++i) {
+    int len;
+    if (floating) {
+      len = sprintf(pos, "%.*f", (int) (prng.randomU32() % 7), (double) (prng.randomI64() % 100000000) / 1000);
+    }
+    else {
+      // mixture of short and long integers
+      uint64_t v = prng.randomU64() >> (prng.randomU32() % 64);
+      len = sprintf(pos, "%ld", (int64_t) (prng.randomU32() & 0x1 ? v >> 1 : -(v >> 1)));
+    }
+    fields[i].data = pos;
+    fields[i].length = (size_t) len;
+    pos += len + 1;
+  }
+  return text;
+}
+
+static void report(nebula::StopWatch & sw, const char * name, int64_t total, double checksum)
+{
+  printf("%s, %.2f M numbers/sec (checksum %g)\n", sw.message(name, total), total / (double) sw.timeCostUs(),
+    checksum);
+}
+
+int main(int argc, char ** argv)
+{
+  int num_values = 1000000;
+  int rounds = 100;
+  if (argc >= 2) {
+    num_values = atoi(argv[1]);
+  }
+  if (argc >= 3) {
+    rounds = atoi(argv[2]);
+  }
+  int64_t total = (int64_t) num_values * rounds;
+
+  Field * fields = (Field *) malloc(num_values * sizeof(Field));
+  char * text = generate(num_values, false, fields);
+  nebula::StopWatch sw;
+  int64_t isum;
+  double dsum;
+
+  isum = 0;
+  sw.start();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < num_values; ++i) {
+      isum += strtol(fields[i].data, NULL, 10);
+    }
+  }
+  sw.stop();
+  report(sw, "strtol()", total, (double) isum);
+
+  isum = 0;
+  sw.start();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < num_values; ++i) {
+      int64_t v = 0;
+      nebula::String::parseI64(fields[i].data, fields[i].length, &v);
+      isum += v;
+    }
+  }
+  sw.stop();
+  report(sw, "String::parseI64()", total, (double) isum);
+  free(text);
+
+  text = generate(num_values, true, fields);
+  dsum = 0;
+  sw.start();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < num_values; ++i) {
+      dsum += strtod(fields[i].data, NULL);
+    }
+  }
+  sw.stop();
+  report(sw, "strtod()", total, dsum);
+
+  dsum = 0;
+  sw.start();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < num_values; ++i) {
+      double v = 0;
+      nebula::String::parseDouble(fields[i].data, fields[i].length, &v);
+      dsum += v;
+    }
+  }
+  sw.stop();
+  report(sw, "String::parseDouble()", total, dsum);
+
+  free(text);
+  free(fields);
+  exit(0);
+}
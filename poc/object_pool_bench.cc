@@ -0,0 +1,172 @@
+/*
+ * object_pool_bench.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "nebula/object_pool.h"
+#include "nebula/ring_buffer.h"
+#include "nebula/time.h"
+
+/*
+ * Million allocate/free pairs per second of 128-byte blocks, SlabPool
+ * against glibc malloc() (whose per-thread tcache and arenas behave much
+ * like jemalloc's thread caches), by 1 to N threads:
+ *   - local: every thread allocates a batch then frees it;
+ *   - handoff: threads in pairs, one allocating, the other freeing what it
+ *     receives through an SpscRing, the pattern of connection objects
+ *     built by an acceptor and released by a worker.
+ */
+
+enum
+{
+  OBJECT_SIZE = 128, BATCH = 100
+};
+
+struct Job
+{
+  nebula::SlabPool * pool;      // NULL for malloc()
+  long ops;
+  nebula::SpscRing<void *> * ring;
+};
+
+void * localWorker(void * arg)
+{
+  Job * job = (Job *) arg;
+  void * blocks[BATCH];
+  for (long done = 0; done < job->ops; done += BATCH) {
+    for (int i = 0; i < BATCH; ++i) {
+      blocks[i] = job->pool ? job->pool->allocate() : malloc(OBJECT_SIZE);
+      *(long *) blocks[i] = i;
+    }
+    for (int i = 0; i < BATCH; ++i) {
+      if (job->pool) {
+        job->pool->free(blocks[i]);
+      }
+      else {
+        free(blocks[i]);
+      }
+    }
+  }
+  return NULL;
+}
+
+void * producer(void * arg)
+{
+  Job * job = (Job *) arg;
+  for (long i = 0; i < job->ops; ++i) {
+    void * p = job->pool ? job->pool->allocate() : malloc(OBJECT_SIZE);
+    *(long *) p = i;
+    while (!job->ring->push(p)) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+void * consumer(void * arg)
+{
+  Job * job = (Job *) arg;
+  for (long i = 0; i < job->ops; ++i) {
+    void * p;
+    while (!job->ring->pop(&p)) {
+      sched_yield();
+    }
+    if (job->pool) {
+      job->pool->free(p);
+    }
+    else {
+      free(p);
+    }
+  }
+  return NULL;
+}
+
+double run(bool use_pool, bool handoff, int num_threads, long ops)
+{
+  nebula::SlabPool pool(OBJECT_SIZE, 16);
+  if (use_pool && pool.init() < 0) {
+    perror("SlabPool::init");
+    exit(1);
+  }
+  std::vector<Job> jobs(num_threads);
+  std::vector<pthread_t> tids(num_threads);
+  std::vector<nebula::SpscRing<void *> *> rings;
+  for (int i = 0; i < num_threads; ++i) {
+    jobs[i].pool = use_pool ? &pool : NULL;
+    jobs[i].ops = ops;
+    jobs[i].ring = NULL;
+    if (handoff && i % 2 == 0) {
+      rings.push_back(new nebula::SpscRing<void *>);
+      rings.back()->init(4096);
+    }
+    if (handoff) {
+      jobs[i].ring = rings.back();
+    }
+  }
+
+  nebula::StopWatch sw;
+  sw.start();
+  for (int i = 0; i < num_threads; ++i) {
+    pthread_create(&tids[i], NULL, handoff ? (i % 2 ? consumer : producer) : localWorker, &jobs[i]);
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    pthread_join(tids[i], NULL);
+  }
+  sw.stop();
+  for (size_t i = 0; i < rings.size(); ++i) {
+    delete rings[i];
+  }
+  // pairs count once in the handoff case
+  long pairs = handoff ? ops * (num_threads / 2) : ops * num_threads;
+  return pairs / (double) sw.timeCostUs();
+}
+
+int main(int argc, char ** argv)
+{
+  long ops = 10000000L;
+  int max_threads = 4;
+  if (argc >= 2) {
+    ops = atol(argv[1]);
+  }
+  if (argc >= 3) {
+    max_threads = atoi(argv[2]);
+  }
+  printf("M allocate/free pairs per second, %ld per thread\n", ops);
+  printf("  %8s %12s %12s %12s %12s\n", "threads", "local pool", "local malloc", "handoff pool", "handoff malloc");
+  for (int t = 1; t <= max_threads; t *= 2) {
+    printf("  %8d %12.1f %12.1f", t, run(true, false, t, ops), run(false, false, t, ops));
+    if (t >= 2) {
+      printf(" %12.1f %12.1f\n", run(true, true, t, ops), run(false, true, t, ops));
+    }
+    else {
+      printf(" %12s %12s\n", "-", "-");
+    }
+  }
+  exit(0);
+}
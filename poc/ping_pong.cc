@@ -0,0 +1,169 @@
+/*
+ * ping_pong.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nebula/hardwareinfo.h"
+#include "nebula/mutex.h"
+#include "nebula/thread.h"
+#include "nebula/time.h"
+
+/*
+ * Round trip latency of a cache line bounced between two threads pinned to
+ * SMT siblings of one core, to two cores of one socket, and to two sockets,
+ * as found in /sys/devices/system/cpu/cpuN/topology.
+ */
+
+struct PingPong
+{
+  volatile int turn __attribute__((aligned(64)));
+  int num_round_trips;
+};
+
+static void waitFor(volatile int * turn, int value)
+{
+  for (int spins = 0; __atomic_load_n(turn, __ATOMIC_ACQUIRE) != value; ++spins) {
+    if (spins < 1000) {
+      nebula::cpuRelax();
+    }
+    else {
+      sched_yield(); // both threads share a processor
+    }
+  }
+}
+
+class Player: public nebula::Thread
+{
+private:
+  PingPong * game_;
+  int me_;
+
+public:
+  Player(PingPong * game, int me) :
+    game_(game), me_(me)
+  {
+  }
+
+  void * routine()
+  {
+    for (int i = 0; i < game_->num_round_trips; ++i) {
+      waitFor(&game_->turn, me_);
+      __atomic_store_n(&game_->turn, 1 - me_, __ATOMIC_RELEASE);
+    }
+    return NULL;
+  }
+};
+
+static int readTopology(int cpu, const char * item, char * buf, size_t buflen)
+{
+  char path[128];
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, item);
+  FILE * fin = fopen(path, "r");
+  if (!fin) {
+    return -1;
+  }
+  int rc = fgets(buf, buflen, fin) ? 0 : -1;
+  fclose(fin);
+  return rc;
+}
+
+static int readTopologyId(int cpu, const char * item)
+{
+  char buf[64];
+  return readTopology(cpu, item, buf, sizeof(buf)) < 0 ? -1 : atoi(buf);
+}
+
+static void evaluate(const char * name, int cpu_a, int cpu_b, int num_round_trips)
+{
+  if (cpu_a < 0 || cpu_b < 0) {
+    printf("%-28s n/a on this machine\n", name);
+    return;
+  }
+  PingPong game;
+  game.turn = 0;
+  game.num_round_trips = num_round_trips;
+  Player a(&game, 0), b(&game, 1);
+  if (a.setAffinity(cpu_a) || b.setAffinity(cpu_b)) {
+    printf("%-28s can not pin\n", name);
+    return;
+  }
+  nebula::StopWatch sw;
+  sw.start();
+  if (a.create() || b.create()) {
+    perror("create");
+    exit(1);
+  }
+  a.join();
+  b.join();
+  sw.stop();
+  printf("%-28s cpu %3d <-> cpu %3d %10.1f ns/round trip\n", name, cpu_a, cpu_b,
+    sw.timeCostUs() * 1000.0 / num_round_trips);
+}
+
+int main(int argc, char ** argv)
+{
+  int num_round_trips = 1000000;
+  if (argc >= 2) {
+    num_round_trips = atoi(argv[1]);
+  }
+
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  sched_getaffinity(0, sizeof(allowed), &allowed);
+  int first = -1;
+  for (int cpu = 0; cpu < CPU_SETSIZE && first < 0; ++cpu) {
+    if (CPU_ISSET(cpu, &allowed)) {
+      first = cpu;
+    }
+  }
+  int package = readTopologyId(first, "physical_package_id");
+  int core = readTopologyId(first, "core_id");
+  int sibling = -1, same_socket = -1, other_socket = -1;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (cpu == first || !CPU_ISSET(cpu, &allowed)) {
+      continue;
+    }
+    int p = readTopologyId(cpu, "physical_package_id");
+    int c = readTopologyId(cpu, "core_id");
+    if (p == package && c == core && sibling < 0) {
+      sibling = cpu;
+    }
+    else if (p == package && c != core && same_socket < 0) {
+      same_socket = cpu;
+    }
+    else if (p != package && other_socket < 0) {
+      other_socket = cpu;
+    }
+  }
+
+  printf("%lu processors, %d round trips\n", nebula::HardwareInfo::numOfProcessors(), num_round_trips);
+  evaluate("same processor", first, first, num_round_trips / 10);
+  evaluate("SMT siblings", first, sibling, num_round_trips);
+  evaluate("same socket", first, same_socket, num_round_trips);
+  evaluate("cross socket", first, other_socket, num_round_trips);
+  exit(0);
+}
@@ -0,0 +1,158 @@
+/*
+ * prng.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "nebula/multiversion.h"
+#include "nebula/random.h"
+#include "nebula/time.h"
+
+/*
+ * Nanoseconds per draw of the generators in random.h, compared with the
+ * former Prng built on glibc random_r() (LibcPrng) and with `random() % n';
+ * then GB/s of filling a buffer with a randomU64() loop and with
+ * Xoshiro256x8 at every SIMD level.
+ */
+
+template<typename G>
+void evaluate(const char * name, long n)
+{
+  G g(2026);
+  uint64_t sum = 0;
+  nebula::StopWatch sw;
+
+  sw.start();
+  for (long i = 0; i < n; ++i) {
+    sum += g.randomU64();
+  }
+  sw.stop();
+  double u64 = sw.timeCostUs() * 1e3 / n;
+
+  sw.reset();
+  sw.start();
+  for (long i = 0; i < n; ++i) {
+    sum += g.randomU32();
+  }
+  sw.stop();
+  double u32 = sw.timeCostUs() * 1e3 / n;
+
+  sw.reset();
+  sw.start();
+  for (long i = 0; i < n; ++i) {
+    sum += g.nextBelow(1000);
+  }
+  sw.stop();
+  double below = sw.timeCostUs() * 1e3 / n;
+
+  double dsum = 0;
+  sw.reset();
+  sw.start();
+  for (long i = 0; i < n; ++i) {
+    dsum += g.nextDouble();
+  }
+  sw.stop();
+  double dbl = sw.timeCostUs() * 1e3 / n;
+
+  printf("  %-14s %8.2f %8.2f %12.2f %12.2f   (%llu, %.0f)\n", name, u64, u32, below, dbl, (unsigned long long) sum,
+    dsum);
+}
+
+void reportFill(const char * name, size_t len, int rounds, const nebula::StopWatch & sw)
+{
+  double us = sw.timeCostUs() > 0 ? sw.timeCostUs() : 1;
+  printf("  %-24s %8.2f GB/s\n", name, 1.0 * len * rounds / us / 1e3);
+}
+
+void evaluateFill(size_t len, int rounds)
+{
+  uint64_t * buf = (uint64_t *) malloc(len);
+  size_t n = len / sizeof(uint64_t);
+  nebula::StopWatch sw;
+
+  printf("fill, %zu bytes x %d rounds\n", len, rounds);
+  nebula::Prng prng(2026);
+  sw.start();
+  for (int r = 0; r < rounds; ++r) {
+    for (size_t i = 0; i < n; ++i) {
+      buf[i] = prng.randomU64();
+    }
+    __asm__ __volatile__ ("" : : "r" (buf) : "memory");
+  }
+  sw.stop();
+  reportFill("randomU64() loop", len, rounds, sw);
+
+  nebula::SimdLevel::Constants saved = nebula::MultiversionBase::levelLimit();
+  for (int level = nebula::HardwareInfo::simdLevel(); level >= nebula::SimdLevel::SCALAR; --level) {
+    nebula::MultiversionBase::limitLevel((nebula::SimdLevel::Constants) level);
+    nebula::Xoshiro256x8 bulk(2026);
+    char name[64];
+    snprintf(name, sizeof(name), "Xoshiro256x8, %s", nebula::SimdLevel::toString((nebula::SimdLevel::Constants) level));
+    sw.reset();
+    sw.start();
+    for (int r = 0; r < rounds; ++r) {
+      bulk.fill(buf, len);
+    }
+    sw.stop();
+    reportFill(name, len, rounds, sw);
+  }
+  nebula::MultiversionBase::limitLevel(saved);
+  free(buf);
+}
+
+int main(int argc, char ** argv)
+{
+  long n = 100000000L;
+  size_t fill_len = 256 << 10;
+  int fill_rounds = 2000;
+  if (argc >= 2) {
+    n = atol(argv[1]);
+  }
+  if (argc >= 3) {
+    fill_len = strtoul(argv[2], NULL, 10);
+  }
+  if (argc >= 4) {
+    fill_rounds = atoi(argv[3]);
+  }
+  printf("ns per draw, %ld draws\n", n);
+  printf("  %-14s %8s %8s %12s %12s\n", "", "u64", "u32", "below(1000)", "double");
+  evaluate<nebula::LibcPrng>("random_r", n / 10);
+  evaluate<nebula::Xoshiro256ss>("xoshiro256**", n);
+  evaluate<nebula::SplitMix64>("splitmix64", n);
+  evaluate<nebula::Pcg32>("pcg32", n);
+
+  uint64_t sum = 0;
+  nebula::StopWatch sw;
+  sw.start();
+  for (long i = 0; i < n / 10; ++i) {
+    sum += random() % 1000;
+  }
+  sw.stop();
+  printf("  %-14s %8s %8s %12.2f   (%llu)\n", "random() % n", "", "", sw.timeCostUs() * 1e3 / (n / 10),
+    (unsigned long long) sum);
+
+  evaluateFill(fill_len, fill_rounds);
+  exit(0);
+}
@@ -0,0 +1,200 @@
+/*
+ * rbtree_vs_map.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <map>
+#include <vector>
+#include "nebula/random.h"
+#include "nebula/rbtree.h"
+#include "nebula/time.h"
+
+/*
+ * 1M random inserts, lookups and erases with std::map (one allocation per
+ * node) and with RbTree (nodes embedded in objects allocated in one
+ * array), with the time and, where perf events are available, the cache
+ * misses of every phase.
+ */
+
+class CacheMisses
+{
+private:
+  int fd_;
+
+public:
+  CacheMisses()
+  {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+
+  ~CacheMisses()
+  {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  void start()
+  {
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  // -1 if not available
+  long long stop()
+  {
+    long long count = -1;
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+        count = -1;
+      }
+    }
+    return count;
+  }
+};
+
+class Phase
+{
+private:
+  const char * container_;
+  const char * name_;
+  long n_;
+  CacheMisses misses_;
+  nebula::StopWatch sw_;
+
+public:
+  Phase(const char * container, const char * name, long n) :
+    container_(container), name_(name), n_(n)
+  {
+    misses_.start();
+    sw_.start();
+  }
+
+  ~Phase()
+  {
+    sw_.stop();
+    long long misses = misses_.stop();
+    if (misses >= 0) {
+      printf("  %-10s %-8s %8.1f ns/op %8.2f misses/op\n", container_, name_, sw_.timeCostUs() * 1e3 / n_,
+        misses * 1.0 / n_);
+    }
+    else {
+      printf("  %-10s %-8s %8.1f ns/op      n/a misses/op\n", container_, name_, sw_.timeCostUs() * 1e3 / n_);
+    }
+  }
+};
+
+struct Entry
+{
+  uint64_t key;
+  nebula::RbNode link;
+  uint64_t payload;
+};
+
+typedef nebula::RbTree<Entry, uint64_t, &Entry::key, &Entry::link> EntryTree;
+
+int main(int argc, char ** argv)
+{
+  long n = 1000000;
+  if (argc >= 2) {
+    n = atol(argv[1]);
+  }
+  std::vector<uint64_t> keys(n);
+  std::vector<uint64_t> probes(n);
+  nebula::Prng prng(43);
+  for (long i = 0; i < n; ++i) {
+    keys[i] = prng.randomU64();
+  }
+  for (long i = 0; i < n; ++i) {
+    probes[i] = keys[prng.nextBelow64(n)];
+  }
+  uint64_t sum = 0;
+
+  {
+    std::map<uint64_t, uint64_t> map;
+    {
+      Phase p("std::map", "insert", n);
+      for (long i = 0; i < n; ++i) {
+        map.insert(std::make_pair(keys[i], i));
+      }
+    }
+    {
+      Phase p("std::map", "find", n);
+      for (long i = 0; i < n; ++i) {
+        sum += map.find(probes[i])->second;
+      }
+    }
+    {
+      Phase p("std::map", "erase", n);
+      for (long i = 0; i < n; ++i) {
+        map.erase(keys[i]);
+      }
+    }
+  }
+
+  {
+    std::vector<Entry> entries(n);
+    EntryTree tree;
+    {
+      Phase p("RbTree", "insert", n);
+      for (long i = 0; i < n; ++i) {
+        entries[i].key = keys[i];
+        entries[i].payload = i;
+        tree.insert(&entries[i]);
+      }
+    }
+    {
+      Phase p("RbTree", "find", n);
+      for (long i = 0; i < n; ++i) {
+        sum += tree.find(probes[i])->payload;
+      }
+    }
+    {
+      Phase p("RbTree", "erase", n);
+      for (long i = 0; i < n; ++i) {
+        tree.erase(&entries[i]);
+      }
+    }
+  }
+  printf("(%llu)\n", (unsigned long long) sum);
+  exit(0);
+}
@@ -0,0 +1,123 @@
+/*
+ * remove_tree.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "nebula/file_system.h"
+#include "nebula/hardwareinfo.h"
+#include "nebula/time.h"
+
+/*
+ * Creation and deletion rate of a synthetic tree root/x/y/aNN/bNN/fNN:
+ * FileSystem::mkdir(recursive) for every leaf directory versus a shared
+ * DirectoryCreator, called once per file, then nftw() with remove() versus FileSystem::removeTree()
+ * with one and several threads.
+ */
+
+static int removeItem(const char * fpath, const struct stat * sb, int typeflag, struct FTW * ftwbuf)
+{
+  return remove(fpath);
+}
+
+static int num_files = 200000;
+static int files_per_dir = 100;
+
+static void buildTree(const char * root, bool use_creator)
+{
+  nebula::DirectoryCreator creator;
+  nebula::StopWatch sw;
+  char path[256];
+  int num_dirs = (num_files + files_per_dir - 1) / files_per_dir;
+  // makes sure the directory of every file exists, as a writer would do
+  sw.start();
+  for (int i = 0; i < num_files; ++i) {
+    int d = i / files_per_dir;
+    snprintf(path, sizeof(path), "%s/x/y/a%d/b%d", root, d / 100, d % 100);
+    if ((use_creator ? creator.create(path) : nebula::FileSystem::mkdir(path, true)) < 0) {
+      perror(path);
+      exit(1);
+    }
+  }
+  sw.stop();
+  printf("%-40s %8ld usec, %d calls, %d leaf directories\n",
+    use_creator ? "mkdir, DirectoryCreator" : "mkdir, FileSystem::mkdir(recursive)", sw.timeCostUs(), num_files,
+    num_dirs);
+
+  for (int i = 0; i < num_files; ++i) {
+    int d = i / files_per_dir;
+    snprintf(path, sizeof(path), "%s/x/y/a%d/b%d/f%d", root, d / 100, d % 100, i);
+    int fd = open(path, O_CREAT | O_WRONLY, 0644);
+    if (fd < 0) {
+      perror(path);
+      exit(1);
+    }
+    close(fd);
+  }
+}
+
+static void report(const char * name, nebula::StopWatch * sw)
+{
+  printf("%-40s %8ld usec, %10.0f files/s\n", name, sw->timeCostUs(), num_files * 1e6 / sw->timeCostUs());
+}
+
+int main(int argc, char ** argv)
+{
+  if (argc >= 2) {
+    num_files = atoi(argv[1]);
+  }
+  if (argc >= 3) {
+    files_per_dir = atoi(argv[2]);
+  }
+  const char * root = "remove_tree_root";
+  nebula::StopWatch sw;
+
+  buildTree(root, false);
+  sw.start();
+  nftw(root, removeItem, 64, FTW_DEPTH | FTW_PHYS);
+  sw.stop();
+  report("remove, nftw() and remove()", &sw);
+
+  int num_threads = nebula::HardwareInfo::numOfProcessors();
+  int threads[] =
+  { 1, num_threads, num_threads * 4 };
+  for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); ++i) {
+    buildTree(root, true);
+    nebula::FileSystem::RemoveProgress progress = nebula::FileSystem::RemoveProgress();
+    char name[64];
+    snprintf(name, sizeof(name), "remove, removeTree(), %d threads", threads[i]);
+    sw.start();
+    if (nebula::FileSystem::removeTree(root, &progress, threads[i]) < 0) {
+      perror(root);
+    }
+    sw.stop();
+    report(name, &sw);
+  }
+  exit(0);
+}
@@ -0,0 +1,218 @@
+/*
+ * rwlock.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "nebula/mutex.h"
+#include "nebula/thread.h"
+#include "nebula/time.h"
+
+/*
+ * Read throughput of a small shared table, with 1..64 reader threads and a
+ * writer updating it every millisecond in the background: pthread_rwlock_t,
+ * DistributedRWLock and SeqLock.
+ */
+
+struct Table
+{
+  long entries[8];
+};
+
+struct PthreadRWLock
+{
+  pthread_rwlock_t lock;
+  Table table;
+
+  PthreadRWLock()
+  {
+    pthread_rwlock_init(&lock, NULL);
+    memset(&table, 0, sizeof(table));
+  }
+
+  ~PthreadRWLock()
+  {
+    pthread_rwlock_destroy(&lock);
+  }
+
+  long read()
+  {
+    pthread_rwlock_rdlock(&lock);
+    long sum = table.entries[0] + table.entries[7];
+    pthread_rwlock_unlock(&lock);
+    return sum;
+  }
+
+  void write(long v)
+  {
+    pthread_rwlock_wrlock(&lock);
+    for (int i = 0; i < 8; ++i) {
+      table.entries[i] = v;
+    }
+    pthread_rwlock_unlock(&lock);
+  }
+};
+
+struct DistributedLock
+{
+  nebula::DistributedRWLock lock;
+  Table table;
+
+  DistributedLock()
+  {
+    memset(&table, 0, sizeof(table));
+  }
+
+  long read()
+  {
+    int slot = lock.lockShared();
+    long sum = table.entries[0] + table.entries[7];
+    lock.unlockShared(slot);
+    return sum;
+  }
+
+  void write(long v)
+  {
+    lock.lock();
+    for (int i = 0; i < 8; ++i) {
+      table.entries[i] = v;
+    }
+    lock.unlock();
+  }
+};
+
+struct SequenceLock
+{
+  nebula::SeqLock<Table> lock;
+
+  long read()
+  {
+    Table t;
+    lock.read(&t);
+    return t.entries[0] + t.entries[7];
+  }
+
+  void write(long v)
+  {
+    Table t;
+    for (int i = 0; i < 8; ++i) {
+      t.entries[i] = v;
+    }
+    lock.write(t);
+  }
+};
+
+template<typename LockType>
+class Reader: public nebula::Thread
+{
+public:
+  LockType * lock_;
+  volatile int * stop_;
+  long reads_;
+  long checksum_;
+
+  void * routine()
+  {
+    while (!__atomic_load_n(stop_, __ATOMIC_RELAXED)) {
+      for (int i = 0; i < 64; ++i) {
+        checksum_ += lock_->read();
+      }
+      reads_ += 64;
+    }
+    return NULL;
+  }
+};
+
+template<typename LockType>
+class Writer: public nebula::Thread
+{
+public:
+  LockType * lock_;
+  volatile int * stop_;
+  long writes_;
+
+  void * routine()
+  {
+    while (!__atomic_load_n(stop_, __ATOMIC_RELAXED)) {
+      lock_->write(++writes_);
+      usleep(1000);
+    }
+    return NULL;
+  }
+};
+
+template<typename LockType>
+void evaluate(const char * name, int num_readers, int duration_ms)
+{
+  LockType lock;
+  volatile int stop = 0;
+  Reader<LockType> * readers = new Reader<LockType> [num_readers];
+  Writer<LockType> writer;
+  writer.lock_ = &lock;
+  writer.stop_ = &stop;
+  writer.writes_ = 0;
+  nebula::StopWatch sw;
+  sw.start();
+  writer.create();
+  for (int i = 0; i < num_readers; ++i) {
+    readers[i].lock_ = &lock;
+    readers[i].stop_ = &stop;
+    readers[i].reads_ = readers[i].checksum_ = 0;
+    readers[i].create();
+  }
+  usleep(duration_ms * 1000);
+  __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+  long reads = 0;
+  for (int i = 0; i < num_readers; ++i) {
+    readers[i].join();
+    reads += readers[i].reads_;
+  }
+  writer.join();
+  sw.stop();
+  delete[] readers;
+  printf("  %-20s %3d readers %12.0f reads/s, %ld writes\n", name, num_readers, reads * 1e6 / sw.timeCostUs(),
+    writer.writes_);
+}
+
+int main(int argc, char ** argv)
+{
+  int max_readers = 64;
+  int duration_ms = 200;
+  if (argc >= 2) {
+    max_readers = atoi(argv[1]);
+  }
+  if (argc >= 3) {
+    duration_ms = atoi(argv[2]);
+  }
+  for (int n = 1; n <= max_readers; n *= 2) {
+    evaluate<PthreadRWLock>("pthread_rwlock_t", n, duration_ms);
+    evaluate<DistributedLock>("DistributedRWLock", n, duration_ms);
+    evaluate<SequenceLock>("SeqLock", n, duration_ms);
+  }
+  exit(0);
+}
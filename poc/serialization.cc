@@ -0,0 +1,174 @@
+/*
+ * serialization.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "nebula/byte_buffer.h"
+#include "nebula/time.h"
+
+/*
+ * Encoding and decoding of records of 10 mixed fields (fixed width integers
+ * in both byte orders, short and long varints, zig-zag varints) with a
+ * reused ByteWriter and a ByteReader, 100M fields by default.  Unsigned
+ * varints are also decoded with the byte-at-a-time loop only, to show what
+ * the 8 byte fast path saves.
+ */
+
+struct Record
+{
+  uint8_t type;
+  uint16_t flags;
+  uint32_t id;
+  uint32_t length;
+  uint64_t timestamp;
+  uint64_t small; // < 2^14
+  uint64_t large; // < 2^56
+  int32_t delta;
+  int64_t offset;
+  uint32_t count;
+};
+
+enum
+{
+  FIELDS_PER_RECORD = 10, BATCH = 10000
+};
+
+void encode(nebula::ByteWriter * w, const Record & r)
+{
+  w->putU8(r.type);
+  w->putBe16(r.flags);
+  w->putBe32(r.id);
+  w->putLe32(r.length);
+  w->putLe64(r.timestamp);
+  w->putVarU64(r.small);
+  w->putVarU64(r.large);
+  w->putVarI32(r.delta);
+  w->putVarI64(r.offset);
+  w->putVarU32(r.count);
+}
+
+int decode(nebula::ByteReader * rd, Record * r)
+{
+  return rd->getU8(&r->type) | rd->getBe16(&r->flags) | rd->getBe32(&r->id) | rd->getLe32(&r->length)
+      | rd->getLe64(&r->timestamp) | rd->getVarU64(&r->small) | rd->getVarU64(&r->large) | rd->getVarI32(&r->delta)
+      | rd->getVarI64(&r->offset) | rd->getVarU32(&r->count);
+}
+
+typedef size_t (*VarintDecoder)(const uint8_t * p, size_t len, uint64_t * out);
+
+template<VarintDecoder DECODE>
+uint64_t decodeVarints(const nebula::ByteWriter & w)
+{
+  // skips the fixed width fields, decodes the 5 varints of every record
+  nebula::ByteReader rd(w);
+  uint64_t sum = 0;
+  while (rd.remaining()) {
+    uint64_t v;
+    rd.skip(1 + 2 + 4 + 4 + 8);
+    for (int i = 0; i < 5; ++i) {
+      size_t n = DECODE(rd.current(), rd.remaining(), &v);
+      rd.skip(n);
+      sum += v;
+    }
+  }
+  return sum;
+}
+
+int main(int argc, char ** argv)
+{
+  long num_fields = 100000000L;
+  if (argc >= 2) {
+    num_fields = atol(argv[1]);
+  }
+  long num_batches = (num_fields / FIELDS_PER_RECORD + BATCH - 1) / BATCH;
+
+  std::vector<Record> input(BATCH);
+  for (size_t i = 0; i < input.size(); ++i) {
+    Record & r = input[i];
+    r.type = random();
+    r.flags = random();
+    r.id = random();
+    r.length = random() % 4096;
+    r.timestamp = 1700000000000000ULL + random();
+    r.small = random() % (1 << 14);
+    r.large = ((uint64_t) random() << 25) ^ random();
+    r.delta = (int32_t) (random() % 2001) - 1000;
+    r.offset = ((int64_t) random() << 20) * (random() % 2 ? 1 : -1);
+    r.count = random() % 100;
+  }
+
+  nebula::ByteWriter w;
+  Record out;
+  uint64_t checksum = 0;
+  size_t bytes = 0;
+  int64_t encode_us = 0, decode_us = 0, fast_us = 0, slow_us = 0;
+
+  for (long b = 0; b < num_batches; ++b) {
+    nebula::StopWatch sw;
+    sw.start();
+    w.clear();
+    for (size_t i = 0; i < input.size(); ++i) {
+      encode(&w, input[i]);
+    }
+    sw.stop();
+    encode_us += sw.timeCostUs();
+    bytes += w.size();
+
+    sw.reset();
+    sw.start();
+    nebula::ByteReader rd(w);
+    while (rd.remaining()) {
+      if (decode(&rd, &out) < 0) {
+        fprintf(stderr, "decode() failed at %zu\n", rd.position());
+        exit(1);
+      }
+      checksum += out.large + out.count;
+    }
+    sw.stop();
+    decode_us += sw.timeCostUs();
+
+    sw.reset();
+    sw.start();
+    checksum += decodeVarints<nebula::Varint::decode>(w);
+    sw.stop();
+    fast_us += sw.timeCostUs();
+
+    sw.reset();
+    sw.start();
+    checksum += decodeVarints<nebula::Varint::decodeSlow>(w);
+    sw.stop();
+    slow_us += sw.timeCostUs();
+  }
+
+  double fields = 1.0 * num_batches * BATCH * FIELDS_PER_RECORD;
+  printf("%.0f fields, %zu bytes (checksum %llu)\n", fields, bytes, (unsigned long long) checksum);
+  printf("  encode                  %8.2f ns/field %8.1f MB/s\n", encode_us * 1e3 / fields, bytes * 1.0 / encode_us);
+  printf("  decode                  %8.2f ns/field %8.1f MB/s\n", decode_us * 1e3 / fields, bytes * 1.0 / decode_us);
+  printf("  varints, 8 byte loads   %8.2f ns/record\n", fast_us * 1e3 / (fields / FIELDS_PER_RECORD));
+  printf("  varints, byte loop      %8.2f ns/record\n", slow_us * 1e3 / (fields / FIELDS_PER_RECORD));
+  exit(0);
+}
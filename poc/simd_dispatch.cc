@@ -0,0 +1,113 @@
+/*
+ * simd_dispatch.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nebula/multiversion.h"
+#include "nebula/string.h"
+#include "nebula/time.h"
+
+/*
+ * Throughput of every implementation of a multiversioned function, selected
+ * by lowering the level limit from the highest level this machine supports
+ * down to the scalar one.
+ */
+
+typedef size_t (*Kernel)(const char * buf, size_t len, int rounds);
+
+size_t countLines(const char * buf, size_t len, int rounds)
+{
+  size_t n = 0;
+  for (int i = 0; i < rounds; ++i) {
+    n += nebula::String::countChar(buf, len, '\n');
+  }
+  return n;
+}
+
+size_t countLinesMemchr(const char * buf, size_t len, int rounds)
+{
+  size_t n = 0;
+  for (int i = 0; i < rounds; ++i) {
+    const char * p = buf;
+    const char * end = buf + len;
+    while ((p = (const char *) memchr(p, '\n', end - p)) != NULL) {
+      ++n;
+      ++p;
+    }
+  }
+  return n;
+}
+
+void report(const char * name, const char * variant, size_t bytes, int rounds, const nebula::StopWatch & sw,
+  size_t result)
+{
+  double us = sw.timeCostUs() > 0 ? sw.timeCostUs() : 1;
+  printf("  %-24s %-8s %8.2f GB/s  (%zu)\n", name, variant, 1.0 * bytes * rounds / us / 1e3, result);
+}
+
+void evaluate(const char * name, Kernel kernel, const char * buf, size_t len, int rounds)
+{
+  nebula::SimdLevel::Constants saved = nebula::MultiversionBase::levelLimit();
+  for (int level = nebula::HardwareInfo::simdLevel(); level >= nebula::SimdLevel::SCALAR; --level) {
+    nebula::MultiversionBase::limitLevel((nebula::SimdLevel::Constants) level);
+    nebula::StopWatch sw;
+    sw.start();
+    size_t result = kernel(buf, len, rounds);
+    sw.stop();
+    report(name, nebula::SimdLevel::toString((nebula::SimdLevel::Constants) level), len, rounds, sw, result);
+  }
+  nebula::MultiversionBase::limitLevel(saved);
+}
+
+int main(int argc, char ** argv)
+{
+  size_t len = 1 << 20;
+  int rounds = 1000;
+  if (argc >= 2) {
+    len = strtoul(argv[1], NULL, 10);
+  }
+  if (argc >= 3) {
+    rounds = atoi(argv[2]);
+  }
+  char * buf = (char *) malloc(len);
+  for (size_t i = 0; i < len; ++i) {
+    buf[i] = random() % 64 ? 'a' + random() % 26 : '\n';
+  }
+
+  printf("machine level %s, %zu bytes x %d rounds\n", nebula::SimdLevel::toString(nebula::HardwareInfo::simdLevel()),
+    len, rounds);
+  evaluate("String::countChar", countLines, buf, len, rounds);
+
+  nebula::StopWatch sw;
+  sw.start();
+  size_t result = countLinesMemchr(buf, len, rounds);
+  sw.stop();
+  report("memchr() loop", "libc", len, rounds, sw, result);
+
+  free(buf);
+  exit(0);
+}
@@ -0,0 +1,267 @@
+/*
+ * spsc_ring.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "nebula/hardwareinfo.h"
+#include "nebula/mutex.h"
+#include "nebula/ring_buffer.h"
+#include "nebula/thread.h"
+#include "nebula/time.h"
+
+/*
+ * SpscRing and SpscByteRing between two threads pinned to the first two
+ * allowed processors (the same one on a single processor machine):
+ * throughput of single and batched transfers, one way latency measured by
+ * bouncing a message through two rings, and byte stream throughput with
+ * reserve()/commit() of 4 KB chunks.
+ */
+
+static int cpu_a = 0;
+static int cpu_b = 0;
+
+static void backoff(int * spins)
+{
+  if (++*spins < 1000) {
+    nebula::cpuRelax();
+  }
+  else {
+    sched_yield(); // both threads may share a processor
+  }
+}
+
+static void pinSelf(int cpu)
+{
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+
+class Producer: public nebula::Thread
+{
+public:
+  nebula::SpscRing<uint64_t> * ring_;
+  long count_;
+  size_t batch_;
+
+  void * routine()
+  {
+    std::vector<uint64_t> items(batch_, 1);
+    int spins = 0;
+    for (long sent = 0; sent < count_;) {
+      size_t n = batch_ < (size_t) (count_ - sent) ? batch_ : count_ - sent;
+      size_t pushed = batch_ == 1 ? ring_->push(1) : ring_->pushBatch(&items[0], n);
+      if (pushed) {
+        sent += pushed;
+        spins = 0;
+      }
+      else {
+        backoff(&spins);
+      }
+    }
+    return NULL;
+  }
+};
+
+void throughput(long count, size_t batch)
+{
+  nebula::SpscRing<uint64_t> ring;
+  ring.init(4096);
+  Producer producer;
+  producer.ring_ = &ring;
+  producer.count_ = count;
+  producer.batch_ = batch;
+  producer.setAffinity(cpu_a);
+  pinSelf(cpu_b);
+
+  nebula::StopWatch sw;
+  sw.start();
+  producer.create();
+  std::vector<uint64_t> out(batch);
+  uint64_t sum = 0;
+  int spins = 0;
+  for (long received = 0; received < count;) {
+    size_t n = batch == 1 ? ring.pop(&out[0]) : ring.popBatch(&out[0], batch);
+    for (size_t i = 0; i < n; ++i) {
+      sum += out[i];
+    }
+    if (n) {
+      received += n;
+      spins = 0;
+    }
+    else {
+      backoff(&spins);
+    }
+  }
+  producer.join();
+  sw.stop();
+  printf("  SpscRing<uint64_t>, batch %3zu %10.1f M items/s (%llu)\n", batch, count * 1.0 / sw.timeCostUs(),
+    (unsigned long long) sum);
+}
+
+class Echo: public nebula::Thread
+{
+public:
+  nebula::SpscRing<uint64_t> * in_;
+  nebula::SpscRing<uint64_t> * out_;
+  long count_;
+
+  void * routine()
+  {
+    uint64_t v;
+    int spins = 0;
+    for (long i = 0; i < count_; ++i) {
+      while (!in_->pop(&v)) {
+        backoff(&spins);
+      }
+      spins = 0;
+      out_->push(v);
+    }
+    return NULL;
+  }
+};
+
+void latency(long count)
+{
+  nebula::SpscRing<uint64_t> ping, pong;
+  ping.init(16);
+  pong.init(16);
+  Echo echo;
+  echo.in_ = &ping;
+  echo.out_ = &pong;
+  echo.count_ = count;
+  echo.setAffinity(cpu_a);
+  pinSelf(cpu_b);
+  echo.create();
+
+  nebula::StopWatch sw;
+  sw.start();
+  uint64_t v;
+  int spins = 0;
+  for (long i = 0; i < count; ++i) {
+    ping.push(i);
+    while (!pong.pop(&v)) {
+      backoff(&spins);
+    }
+    spins = 0;
+  }
+  sw.stop();
+  echo.join();
+  printf("  one way latency             %10.1f ns\n", sw.timeCostUs() * 1e3 / count / 2);
+}
+
+class ByteWriterThread: public nebula::Thread
+{
+public:
+  nebula::SpscByteRing * ring_;
+  size_t total_;
+  size_t chunk_;
+
+  void * routine()
+  {
+    int spins = 0;
+    for (size_t sent = 0; sent < total_;) {
+      size_t len;
+      char * p = ring_->reserve(chunk_, &len);
+      if (!p) {
+        backoff(&spins);
+        continue;
+      }
+      spins = 0;
+      p[0] = p[chunk_ - 1] = 1; // stands for filling the chunk, e.g. with recv()
+      ring_->commit(chunk_);
+      sent += chunk_;
+    }
+    return NULL;
+  }
+};
+
+void byteThroughput(size_t total, size_t chunk)
+{
+  nebula::SpscByteRing ring;
+  ring.init(1 << 20);
+  ByteWriterThread writer;
+  writer.ring_ = &ring;
+  writer.total_ = total / chunk * chunk;
+  writer.chunk_ = chunk;
+  writer.setAffinity(cpu_a);
+  pinSelf(cpu_b);
+
+  nebula::StopWatch sw;
+  sw.start();
+  writer.create();
+  uint64_t sum = 0;
+  int spins = 0;
+  for (size_t received = 0; received < writer.total_;) {
+    size_t len;
+    const char * p = ring.peek(1, &len);
+    if (!p) {
+      backoff(&spins);
+      continue;
+    }
+    spins = 0;
+    sum += p[0] + p[len - 1];
+    ring.consume(len);
+    received += len;
+  }
+  writer.join();
+  sw.stop();
+  printf("  SpscByteRing, %zu byte chunks %6.1f GB/s (%llu)\n", chunk, writer.total_ * 1.0 / sw.timeCostUs() / 1e3,
+    (unsigned long long) sum);
+}
+
+int main(int argc, char ** argv)
+{
+  long count = 20000000;
+  long round_trips = 1000000;
+  if (argc >= 2) {
+    count = atol(argv[1]);
+  }
+  if (argc >= 3) {
+    round_trips = atol(argv[2]);
+  }
+  const nebula::CpuTopology & topology = nebula::HardwareInfo::topology();
+  std::vector<int> cpus;
+  for (size_t i = 0; i < topology.cpus().size(); ++i) {
+    if (topology.cpus()[i].allowed) {
+      cpus.push_back(topology.cpus()[i].id);
+    }
+  }
+  if (!cpus.empty()) {
+    cpu_a = cpus[0];
+    cpu_b = cpus.size() > 1 ? cpus[1] : cpus[0];
+  }
+  printf("producer on cpu %d, consumer on cpu %d\n", cpu_a, cpu_b);
+
+  throughput(count, 1);
+  throughput(count, 32);
+  latency(round_trips);
+  byteThroughput((size_t) count * 64, 4096);
+  exit(0);
+}
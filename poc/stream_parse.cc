@@ -0,0 +1,124 @@
+/*
+ * stream_parse.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+#include "nebula/random.h"
+#include "nebula/stream_reader.h"
+#include "nebula/text_file_parser.h"
+#include "nebula/time.h"
+
+/*
+ * Throughput of TextFileParser::parseLineByLine() over a StreamReader, with
+ * decompression done by the parsing thread (SR_NONE) versus overlapped with
+ * parsing in the read-ahead thread (SR_READ_AHEAD).
+ */
+
+static int sumFields(const char * filename, uint64_t line_num, const nebula::Tokens * tokens, void * arg)
+{
+  int64_t v;
+  for (uint32_t i = 1; i < tokens->numOfTokens(); ++i) {
+    if (tokens->view(i)->toI64(&v) == nebula::String::ParseResult::SUCCESS) {
+      *(uint64_t *) arg += (uint64_t) v;
+    }
+  }
+  return 0;
+}
+
+static void evaluate(const char * path, int flags, size_t raw_bytes, const char * name)
+{
+  nebula::StreamReader reader;
+  nebula::TextFileParser parser;
+  nebula::StopWatch sw;
+  uint64_t sum = 0;
+  sw.start();
+  if (reader.open(path, flags) < 0 || parser.parseLineByLine(&reader, sumFields, &sum) < 0) {
+    perror(name);
+    return;
+  }
+  sw.stop();
+  printf("%-40s %8ld usec, %8.2f MB/s (checksum %lu)\n", name, sw.timeCostUs(), raw_bytes / (double) sw.timeCostUs(),
+    sum);
+}
+
+int main(int argc, char ** argv)
+{
+  int num_lines = 2000000;
+  if (argc >= 2) {
+    num_lines = atoi(argv[1]);
+  }
+
+  char plain[] = "stream_parse_plain_XXXXXX";
+  char gz[] = "stream_parse_gz_XXXXXX";
+  int fd = mkstemp(plain);
+  int gz_fd = mkstemp(gz);
+  if (fd < 0 || gz_fd < 0) {
+    perror("mkstemp");
+    exit(1);
+  }
+  FILE * fout = fdopen(fd, "w");
+#ifdef USE_ZLIB
+  gzFile gzout = gzdopen(gz_fd, "wb6");
+#else
+  close(gz_fd);
+#endif
+  nebula::Prng prng(2026);
+  size_t raw_bytes = 0;
+  char line[256];
+  for (int i = 0; i < num_lines; ++i) {
+    int len = snprintf(line, sizeof(line), "key%u %u %u %u %lu\n", prng.randomU32() % 1000, prng.randomU32() % 100000,
+      prng.randomU32() % 100, prng.randomU32(), prng.randomU64() >> 20);
+    raw_bytes += len;
+    fwrite(line, 1, len, fout);
+#ifdef USE_ZLIB
+    gzwrite(gzout, line, len);
+#endif
+  }
+  fclose(fout);
+#ifdef USE_ZLIB
+  gzclose(gzout);
+#endif
+  printf("%d lines, %zu bytes uncompressed\n", num_lines, raw_bytes);
+
+  evaluate(plain, nebula::StreamReader::SR_NONE, raw_bytes, "plain, single-threaded");
+  evaluate(plain, nebula::StreamReader::SR_READ_AHEAD, raw_bytes, "plain, read-ahead");
+#ifdef USE_ZLIB
+  evaluate(gz, nebula::StreamReader::SR_DECOMPRESS, raw_bytes, "gzip, single-threaded");
+  evaluate(gz, nebula::StreamReader::SR_DECOMPRESS | nebula::StreamReader::SR_READ_AHEAD, raw_bytes,
+    "gzip, decompression overlapped");
+#else
+  printf("built without zlib (NO_ZLIB), gzip input skipped\n");
+#endif
+
+  unlink(plain);
+  unlink(gz);
+  exit(0);
+}
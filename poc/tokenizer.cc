@@ -0,0 +1,139 @@
+/*
+ * tokenizer.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nebula/text_file_parser.h"
+#include "nebula/random.h"
+#include "nebula/time.h"
+
+/*
+ * Tokens/sec of strtok_r(), Tokens::splitString() and Tokens::splitView() on
+ * whitespace separated and tab separated lines.
+ */
+
+static char ** generateLines(int num_lines, char sep)
+{
+  static const char * words[] =
+  { "GET", "/index.html", "200", "1024", "127.0.0.1", "Mozilla/5.0", "-", "3.1415926", "nebula", "x" };
+  nebula::Prng prng(12345);
+  char ** lines = (char **) malloc(num_lines * sizeof(char *));
+  char buf[512];
+  for (int i = 0; i < num_lines; ++i) {
+    size_t used = 0;
+    int num_fields = 8 + (int) (prng.randomU32() % 8);
+    for (int j = 0; j < num_fields; ++j) {
+      used += snprintf(buf + used, sizeof(buf) - used, "%s%c", words[prng.randomU32() % 10], sep);
+    }
+    buf[used - 1] = '\0';
+    lines[i] = strdup(buf);
+  }
+  return lines;
+}
+
+static void evaluate(char ** lines, int num_lines, int rounds, const char * delim, const char * name)
+{
+  char copy[512];
+  char * saved;
+  nebula::Tokens tokens;
+  nebula::DelimiterTable table(delim);
+  nebula::StopWatch sw;
+  uint64_t total;
+  char msg[128];
+  volatile int sink = 0;
+
+  // 1. strtok_r(), pointers only
+  const char * ptrs[64];
+  total = 0;
+  sw.start();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < num_lines; ++i) {
+      strcpy(copy, lines[i]);
+      size_t n = 0;
+      for (char * tok = strtok_r(copy, delim, &saved); tok; tok = strtok_r(NULL, delim, &saved)) {
+        ptrs[n++] = tok;
+      }
+      total += n;
+      sink += n ? ptrs[n - 1][0] : 0;
+    }
+  }
+  sw.stop();
+  snprintf(msg, sizeof(msg), "%s strtok_r()", name);
+  printf("%s, %.2f M tokens/sec\n", sw.message(msg, total), total / (double) sw.timeCostUs());
+
+  // 2. destructive split with a prebuilt delimiter table
+  total = 0;
+  sw.start();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < num_lines; ++i) {
+      strcpy(copy, lines[i]);
+      tokens.splitString(copy, table);
+      total += tokens.numOfTokens();
+    }
+  }
+  sw.stop();
+  snprintf(msg, sizeof(msg), "%s Tokens::splitString()", name);
+  printf("%s, %.2f M tokens/sec\n", sw.message(msg, total), total / (double) sw.timeCostUs());
+
+  // 3. non-destructive split, no copy of the input needed
+  total = 0;
+  sw.start();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < num_lines; ++i) {
+      tokens.splitView(lines[i], strlen(lines[i]), table);
+      total += tokens.numOfTokens();
+    }
+  }
+  sw.stop();
+  snprintf(msg, sizeof(msg), "%s Tokens::splitView()", name);
+  printf("%s, %.2f M tokens/sec\n", sw.message(msg, total), total / (double) sw.timeCostUs());
+}
+
+int main(int argc, char ** argv)
+{
+  int num_lines = 100000;
+  int rounds = 20;
+  if (argc >= 2) {
+    num_lines = atoi(argv[1]);
+  }
+  if (argc >= 3) {
+    rounds = atoi(argv[2]);
+  }
+
+  char ** ws_lines = generateLines(num_lines, ' ');
+  char ** tab_lines = generateLines(num_lines, '\t');
+  evaluate(ws_lines, num_lines, rounds, " \f\n\r\t\v", "whitespace");
+  evaluate(tab_lines, num_lines, rounds, "\t", "tab");
+
+  for (int i = 0; i < num_lines; ++i) {
+    free(ws_lines[i]);
+    free(tab_lines[i]);
+  }
+  free(ws_lines);
+  free(tab_lines);
+  exit(0);
+}
@@ -0,0 +1,135 @@
+/*
+ * tree_traversal.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ftw.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "nebula/file_system.h"
+#include "nebula/hardwareinfo.h"
+#include "nebula/time.h"
+
+/*
+ * Recursive traversal of a synthetic tree: lstat() on full paths through
+ * FileSystem::fileTreeTraversal(), versus FileSystem::treeWalk() with one
+ * and several threads.  Run it twice to compare a cold and a warm cache.
+ */
+
+static int countRecursively(const char * fpath, const struct stat * sb, void * arg)
+{
+  ++*(long *) arg;
+  if (S_ISDIR(sb->st_mode)) {
+    return nebula::FileSystem::fileTreeTraversal(fpath, countRecursively, arg);
+  }
+  return 0;
+}
+
+static int countEntry(const nebula::FileSystem::TreeEntry * entry, void * arg)
+{
+  __sync_fetch_and_add((long *) arg, 1);
+  return nebula::FileSystem::TW_CONTINUE;
+}
+
+static int removeItem(const char * fpath, const struct stat * sb, int typeflag, struct FTW * ftwbuf)
+{
+  return remove(fpath);
+}
+
+static void evaluateTreeWalk(const char * root, int num_threads, int flags, const char * name)
+{
+  nebula::StopWatch sw;
+  long count = 0;
+  sw.start();
+  nebula::FileSystem::treeWalk(root, countEntry, &count, num_threads, flags);
+  sw.stop();
+  printf("%-40s %8ld usec, %ld entries\n", name, sw.timeCostUs(), count);
+}
+
+int main(int argc, char ** argv)
+{
+  int num_files = 100000;
+  int files_per_dir = 100;
+  if (argc >= 2) {
+    num_files = atoi(argv[1]);
+  }
+  if (argc >= 3) {
+    files_per_dir = atoi(argv[2]);
+  }
+
+  char root[] = "tree_traversal_XXXXXX";
+  if (!mkdtemp(root)) {
+    perror("mkdtemp");
+    exit(1);
+  }
+
+  // root/aNN/bNN/fNN, fan out of the two directory levels is about equal
+  int num_dirs = (num_files + files_per_dir - 1) / files_per_dir;
+  int fan_out = 1;
+  while (fan_out * fan_out < num_dirs) {
+    ++fan_out;
+  }
+  char path[256];
+  int created = 0;
+  for (int a = 0; a < fan_out && created < num_files; ++a) {
+    snprintf(path, sizeof(path), "%s/a%d", root, a);
+    mkdir(path, 0755);
+    for (int b = 0; b < fan_out && created < num_files; ++b) {
+      snprintf(path, sizeof(path), "%s/a%d/b%d", root, a, b);
+      mkdir(path, 0755);
+      for (int f = 0; f < files_per_dir && created < num_files; ++f, ++created) {
+        snprintf(path, sizeof(path), "%s/a%d/b%d/f%d", root, a, b, f);
+        int fd = open(path, O_CREAT | O_WRONLY, 0644);
+        if (fd < 0) {
+          perror(path);
+          exit(1);
+        }
+        close(fd);
+      }
+    }
+  }
+  printf("%d files, %d per directory\n", created, files_per_dir);
+
+  nebula::StopWatch sw;
+  long count = 0;
+  sw.start();
+  nebula::FileSystem::fileTreeTraversal(root, countRecursively, &count);
+  sw.stop();
+  printf("%-40s %8ld usec, %ld entries\n", "fileTreeTraversal, recursive", sw.timeCostUs(), count);
+
+  int num_threads = nebula::HardwareInfo::numOfProcessors();
+  evaluateTreeWalk(root, 1, nebula::FileSystem::TW_STAT, "treeWalk, 1 thread, TW_STAT");
+  evaluateTreeWalk(root, 1, nebula::FileSystem::TW_NONE, "treeWalk, 1 thread");
+  snprintf(path, sizeof(path), "treeWalk, %d threads", num_threads);
+  evaluateTreeWalk(root, num_threads, nebula::FileSystem::TW_NONE, path);
+  snprintf(path, sizeof(path), "treeWalk, %d threads", num_threads * 4);
+  evaluateTreeWalk(root, num_threads * 4, nebula::FileSystem::TW_NONE, path);
+
+  nftw(root, removeItem, 16, FTW_DEPTH | FTW_PHYS);
+  exit(0);
+}
@@ -0,0 +1,166 @@
+/*
+ * arena.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include "nebula/arena.h"
+
+namespace nebula
+{
+  pthread_once_t Arena::key_created_ = PTHREAD_ONCE_INIT;
+  pthread_key_t Arena::key_;
+
+  Arena::Arena(size_t chunk_size) :
+    chunk_(NULL), ptr_(NULL), end_(NULL), large_(NULL), spare_(NULL), cleanups_(NULL),
+        chunk_size_(chunk_size < 4 * sizeof(Chunk) ? 4 * sizeof(Chunk) : chunk_size), bytes_allocated_(0)
+  {
+  }
+
+  Arena::~Arena()
+  {
+    reset();
+    if (spare_) {
+      ::free(spare_);
+    }
+  }
+
+  void * Arena::allocateSlow(size_t size, size_t align)
+  {
+    // worst case, the header is followed by align - 1 bytes of padding
+    size_t need = sizeof(Chunk) + align - 1 + size;
+    if (need < size) {
+      errno = ENOMEM;
+      return NULL;
+    }
+
+    Chunk * chunk;
+    if (need > chunk_size_ / 4) {
+      if (!(chunk = (Chunk *) ::malloc(need))) {
+        errno = ENOMEM;
+        return NULL;
+      }
+      chunk->size = need;
+      chunk->prev = large_;
+      large_ = chunk;
+      bytes_allocated_ += need;
+      return (void *) (((uintptr_t) (chunk + 1) + align - 1) & ~(uintptr_t) (align - 1));
+    }
+
+    if (spare_) {
+      chunk = spare_;
+      spare_ = NULL;
+    }
+    else {
+      if (!(chunk = (Chunk *) ::malloc(chunk_size_))) {
+        errno = ENOMEM;
+        return NULL;
+      }
+      chunk->size = chunk_size_;
+      bytes_allocated_ += chunk_size_;
+    }
+    chunk->prev = chunk_;
+    chunk_ = chunk;
+
+    char * p = (char *) (((uintptr_t) (chunk + 1) + align - 1) & ~(uintptr_t) (align - 1));
+    ptr_ = p + size;
+    end_ = (char *) chunk + chunk->size;
+    return p;
+  }
+
+  void Arena::releaseChunk(Chunk * chunk)
+  {
+    if (!spare_) {
+      spare_ = chunk;
+      return;
+    }
+    bytes_allocated_ -= chunk->size;
+    ::free(chunk);
+  }
+
+  int Arena::addCleanup(Destructor destructor, void * object)
+  {
+    Cleanup * c = (Cleanup *) allocate(sizeof(Cleanup), __alignof__(Cleanup));
+    if (!c) {
+      return -1;
+    }
+    c->prev = cleanups_;
+    c->destructor = destructor;
+    c->object = object;
+    cleanups_ = c;
+    return 0;
+  }
+
+  void Arena::rewind(const Mark & m)
+  {
+    // destructors first, the objects may still use each other
+    while (cleanups_ != m.cleanups) {
+      Cleanup * c = cleanups_;
+      cleanups_ = c->prev;
+      c->destructor(c->object);
+    }
+    while (large_ != m.large) {
+      Chunk * c = large_;
+      large_ = c->prev;
+      bytes_allocated_ -= c->size;
+      ::free(c);
+    }
+    while (chunk_ != m.chunk) {
+      Chunk * c = chunk_;
+      chunk_ = c->prev;
+      releaseChunk(c);
+    }
+    ptr_ = m.ptr;
+    end_ = chunk_ ? (char *) chunk_ + chunk_->size : NULL;
+  }
+
+  void Arena::createKey()
+  {
+    (void) pthread_key_create(&key_, destroyThreadArena);
+  }
+
+  void Arena::destroyThreadArena(void * arena)
+  {
+    delete (Arena *) arena;
+  }
+
+  Arena * Arena::threadLocal()
+  {
+    (void) pthread_once(&key_created_, createKey);
+    Arena * arena = (Arena *) pthread_getspecific(key_);
+    if (!arena) {
+      if (!(arena = new (std::nothrow) Arena())) {
+        errno = ENOMEM;
+        return NULL;
+      }
+      if (pthread_setspecific(key_, arena)) {
+        delete arena;
+        errno = ENOMEM;
+        return NULL;
+      }
+    }
+    return arena;
+  }
+}
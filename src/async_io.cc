@@ -25,11 +25,52 @@
  */
 
 #include <string.h>
+#include <sys/sendfile.h>
+#include <algorithm>
 #include "nebula/async_io.h"
+#include "nebula/mutex.h"
 #include "nebula/string.h"
 
 namespace nebula
 {
+  namespace
+  {
+    // empty pipes for splice()
+    AdaptiveMutex pipe_pool_lock;
+    int pipe_pool[AsyncIo::MAX_POOLED_PIPES][2];
+    int num_pooled_pipes = 0;
+
+    bool isUnsupported(int error)
+    {
+      return error == ENOSYS || error == EXDEV || error == EOPNOTSUPP || error == EINVAL;
+    }
+
+    // copyFileRange() without copy_file_range()
+    ssize_t spliceFileRange(int in_fd, off_t * in_off, int out_fd, off_t * out_off, size_t len)
+    {
+      SplicePipe pipe;
+      size_t done = 0;
+      while (done < len) {
+        ssize_t n = pipe.fill(in_fd, std::min(len - done, (size_t) AsyncIo::PIPE_SIZE), in_off);
+        if (n <= 0) {
+          if (n < 0 && !done) {
+            return -1;
+          }
+          break;
+        }
+        while (pipe.buffered()) {
+          ssize_t m = pipe.drain(out_fd, pipe.buffered(), out_off);
+          if (m <= 0) {
+            // what was read is lost with the pipe, report what was written
+            return done ? (ssize_t) done : -1;
+          }
+          done += m;
+        }
+      }
+      return done;
+    }
+  }
+
   int AsyncIo::pipe2(int pipefd[2], int flags)
   {
     if (flags & (~(AIO_CLOEXEC | AIO_NONBLOCK))) {
@@ -198,4 +239,145 @@ namespace nebula
     }
     return fd;
   }
+
+  ssize_t AsyncIo::sendFile(int out_sockfd, int in_fd, off_t * offset, size_t count)
+  {
+    size_t done = 0;
+    while (done < count) {
+      ssize_t n = ::sendfile(out_sockfd, in_fd, offset, count - done);
+      if (n > 0) {
+        done += n;
+      }
+      else if (n == 0) {
+        break;
+      }
+      else if (errno != EINTR) {
+        return done ? (ssize_t) done : ERROR;
+      }
+    }
+    return done;
+  }
+
+  ssize_t AsyncIo::splice(int in_fd, off_t * in_off, int out_fd, off_t * out_off, size_t len)
+  {
+    ssize_t n;
+    while ((n = ::splice(in_fd, in_off, out_fd, out_off, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK)) < 0
+        && errno == EINTR) {
+    }
+    return n;
+  }
+
+  ssize_t AsyncIo::tee(int in_pipe, int out_pipe, size_t len)
+  {
+    ssize_t n;
+    while ((n = ::tee(in_pipe, out_pipe, len, SPLICE_F_NONBLOCK)) < 0 && errno == EINTR) {
+    }
+    return n;
+  }
+
+  ssize_t AsyncIo::copyFileRange(int in_fd, off_t * in_off, int out_fd, off_t * out_off, size_t len)
+  {
+    size_t done = 0;
+    while (done < len) {
+      ssize_t n = ::copy_file_range(in_fd, in_off, out_fd, out_off, len - done, 0);
+      if (n > 0) {
+        done += n;
+      }
+      else if (n == 0) {
+        break;
+      }
+      else if (errno == EINTR) {
+        continue;
+      }
+      else if (!done && isUnsupported(errno)) {
+        return spliceFileRange(in_fd, in_off, out_fd, out_off, len);
+      }
+      else {
+        return done ? (ssize_t) done : ERROR;
+      }
+    }
+    return done;
+  }
+
+  int AsyncIo::acquirePipe(int pipefd[2])
+  {
+    {
+      ScopedLock<AdaptiveMutex> guard(pipe_pool_lock);
+      if (num_pooled_pipes) {
+        --num_pooled_pipes;
+        pipefd[0] = pipe_pool[num_pooled_pipes][0];
+        pipefd[1] = pipe_pool[num_pooled_pipes][1];
+        return OK;
+      }
+    }
+    if (pipe2(pipefd, AIO_CLOEXEC | AIO_NONBLOCK) < 0) {
+      return ERROR;
+    }
+    // the default of 64K means a syscall per 16 pages, unprivileged users may be refused more
+    (void) fcntl(pipefd[1], F_SETPIPE_SZ, (int) PIPE_SIZE);
+    return OK;
+  }
+
+  void AsyncIo::releasePipe(int pipefd[2], bool empty)
+  {
+    if (empty) {
+      ScopedLock<AdaptiveMutex> guard(pipe_pool_lock);
+      if (num_pooled_pipes < MAX_POOLED_PIPES) {
+        pipe_pool[num_pooled_pipes][0] = pipefd[0];
+        pipe_pool[num_pooled_pipes][1] = pipefd[1];
+        ++num_pooled_pipes;
+        return;
+      }
+    }
+    close(pipefd[0]);
+    close(pipefd[1]);
+  }
+
+  ssize_t SplicePipe::fill(int in_fd, size_t len, off_t * in_off)
+  {
+    if (fds_[0] < 0 && AsyncIo::acquirePipe(fds_) < 0) {
+      return -1;
+    }
+    ssize_t n = AsyncIo::splice(in_fd, in_off, fds_[1], NULL, len);
+    if (n > 0) {
+      buffered_ += n;
+    }
+    return n;
+  }
+
+  ssize_t SplicePipe::drain(int out_fd, size_t len, off_t * out_off)
+  {
+    if (!buffered_) {
+      return 0;
+    }
+    ssize_t n = AsyncIo::splice(fds_[0], NULL, out_fd, out_off, std::min(len, buffered_));
+    if (n > 0) {
+      buffered_ -= n;
+    }
+    return n;
+  }
+
+  ssize_t SplicePipe::tee(SplicePipe & other, size_t len)
+  {
+    if (!buffered_) {
+      return 0;
+    }
+    if (other.fds_[0] < 0 && AsyncIo::acquirePipe(other.fds_) < 0) {
+      return -1;
+    }
+    ssize_t n = AsyncIo::tee(fds_[0], other.fds_[1], std::min(len, buffered_));
+    if (n > 0) {
+      other.buffered_ += n;
+    }
+    return n;
+  }
+
+  void SplicePipe::release()
+  {
+    if (fds_[0] >= 0) {
+      AsyncIo::releasePipe(fds_, !buffered_);
+      fds_[0] = fds_[1] = -1;
+      buffered_ = 0;
+    }
+  }
 }
@@ -0,0 +1,860 @@
+/*
+ * big_int.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <algorithm>
+#include <vector>
+#include "nebula/attributes.h"
+#include "nebula/big_int.h"
+
+namespace nebula
+{
+  namespace
+  {
+    typedef unsigned __int128 u128;
+
+    const uint64_t TEN_POW_19 = 10000000000000000000ULL;
+
+    size_t karatsuba_threshold = BigInt::KARATSUBA_THRESHOLD;
+
+    size_t normalized(const uint64_t * a, size_t n)
+    {
+      while (n && !a[n - 1]) {
+        --n;
+      }
+      return n;
+    }
+
+    int compareN(const uint64_t * a, const uint64_t * b, size_t n)
+    {
+      while (n--) {
+        if (a[n] != b[n]) {
+          return a[n] < b[n] ? -1 : 1;
+        }
+      }
+      return 0;
+    }
+
+    // r = a + b + carry, `r' may be `a' or `b'
+    uint64_t addN(uint64_t * r, const uint64_t * a, const uint64_t * b, size_t n, uint64_t carry = 0)
+    {
+      for (size_t i = 0; i < n; ++i) {
+        u128 s = (u128) a[i] + b[i] + carry;
+        r[i] = (uint64_t) s;
+        carry = (uint64_t) (s >> 64);
+      }
+      return carry;
+    }
+
+    uint64_t add1(uint64_t * r, const uint64_t * a, size_t n, uint64_t carry)
+    {
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t t = a[i] + carry;
+        carry = t < carry;
+        r[i] = t;
+      }
+      return carry;
+    }
+
+    // r = a - b - borrow, `r' may be `a' or `b'
+    uint64_t subN(uint64_t * r, const uint64_t * a, const uint64_t * b, size_t n, uint64_t borrow = 0)
+    {
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t t = a[i] - b[i];
+        uint64_t b1 = a[i] < b[i];
+        r[i] = t - borrow;
+        borrow = b1 | (t < borrow);
+      }
+      return borrow;
+    }
+
+    uint64_t sub1(uint64_t * r, const uint64_t * a, size_t n, uint64_t borrow)
+    {
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t t = a[i];
+        r[i] = t - borrow;
+        borrow = t < borrow;
+      }
+      return borrow;
+    }
+
+    // r[0, rn) += a[0, an), an <= rn
+    uint64_t addInto(uint64_t * r, size_t rn, const uint64_t * a, size_t an)
+    {
+      uint64_t carry = addN(r, r, a, an);
+      return add1(r + an, r + an, rn - an, carry);
+    }
+
+    // r[0, rn) -= a[0, an), an <= rn
+    uint64_t subFrom(uint64_t * r, size_t rn, const uint64_t * a, size_t an)
+    {
+      uint64_t borrow = subN(r, r, a, an);
+      return sub1(r + an, r + an, rn - an, borrow);
+    }
+
+    // r = a * m, returns the high limb
+    uint64_t mul1(uint64_t * r, const uint64_t * a, size_t n, uint64_t m)
+    {
+      uint64_t carry = 0;
+      for (size_t i = 0; i < n; ++i) {
+        u128 p = (u128) a[i] * m + carry;
+        r[i] = (uint64_t) p;
+        carry = (uint64_t) (p >> 64);
+      }
+      return carry;
+    }
+
+    // r += a * m, returns the high limb
+    uint64_t addMul1(uint64_t * r, const uint64_t * a, size_t n, uint64_t m)
+    {
+      uint64_t carry = 0;
+      for (size_t i = 0; i < n; ++i) {
+        u128 p = (u128) a[i] * m + r[i] + carry;
+        r[i] = (uint64_t) p;
+        carry = (uint64_t) (p >> 64);
+      }
+      return carry;
+    }
+
+    // r -= a * m, returns what is to be subtracted from r[n]
+    uint64_t subMul1(uint64_t * r, const uint64_t * a, size_t n, uint64_t m)
+    {
+      uint64_t carry = 0;
+      for (size_t i = 0; i < n; ++i) {
+        u128 p = (u128) a[i] * m + carry;
+        uint64_t lo = (uint64_t) p;
+        uint64_t t = r[i];
+        r[i] = t - lo;
+        carry = (uint64_t) (p >> 64) + (t < lo);
+      }
+      return carry;
+    }
+
+    // r = a << s, 0 <= s < 64, returns the bits shifted out
+    uint64_t shiftLeft(uint64_t * r, const uint64_t * a, size_t n, int s)
+    {
+      if (!s) {
+        std::copy(a, a + n, r);
+        return 0;
+      }
+      uint64_t out = a[n - 1] >> (64 - s);
+      for (size_t i = n - 1; i > 0; --i) {
+        r[i] = (a[i] << s) | (a[i - 1] >> (64 - s));
+      }
+      r[0] = a[0] << s;
+      return out;
+    }
+
+    // r = a >> s, 0 <= s < 64
+    void shiftRight(uint64_t * r, const uint64_t * a, size_t n, int s)
+    {
+      if (!s) {
+        std::copy(a, a + n, r);
+        return;
+      }
+      for (size_t i = 0; i + 1 < n; ++i) {
+        r[i] = (a[i] >> s) | (a[i + 1] << (64 - s));
+      }
+      r[n - 1] = a[n - 1] >> s;
+    }
+
+    void mulAny(uint64_t * r, const uint64_t * a, size_t an, const uint64_t * b, size_t bn);
+
+    void mulSchoolbook(uint64_t * r, const uint64_t * a, size_t an, const uint64_t * b, size_t bn)
+    {
+      r[an] = mul1(r, a, an, b[0]);
+      for (size_t j = 1; j < bn; ++j) {
+        r[an + j] = addMul1(r + j, a, an, b[j]);
+      }
+    }
+
+    /*
+     * a = a1 * B^m + a0, b = b1 * B^m + b0:
+     *   a * b = a1 b1 B^2m + ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) B^m + a0 b0
+     * three half size products instead of four.  Requires bn > an / 2.
+     */
+    void mulKaratsuba(uint64_t * r, const uint64_t * a, size_t an, const uint64_t * b, size_t bn)
+    {
+      size_t m = an / 2;
+      size_t a1n = an - m, b1n = bn - m;
+
+      mulAny(r, a, m, b, m);
+      mulAny(r + 2 * m, a + m, a1n, b + m, b1n);
+
+      // a1n >= m, b1n may be shorter than m
+      size_t san = a1n + 1, sbn = std::max(m, b1n) + 1;
+      std::vector<uint64_t> tmp(san + sbn + san + sbn);
+      uint64_t * sa = &tmp[0];
+      uint64_t * sb = sa + san;
+      uint64_t * z1 = sb + sbn;
+
+      std::copy(a + m, a + an, sa);
+      sa[a1n] = addInto(sa, a1n, a, m);
+      if (b1n >= m) {
+        std::copy(b + m, b + bn, sb);
+        sb[b1n] = addInto(sb, b1n, b, m);
+      }
+      else {
+        std::copy(b, b + m, sb);
+        sb[m] = addInto(sb, m, b + m, b1n);
+      }
+
+      mulAny(z1, sa, san, sb, sbn);
+      size_t z1n = san + sbn;
+      subFrom(z1, z1n, r, 2 * m);
+      subFrom(z1, z1n, r + 2 * m, a1n + b1n);
+      addInto(r + m, an + bn - m, z1, normalized(z1, z1n));
+    }
+
+    // r[0, an + bn) = a * b, `r' must not overlap the operands
+    void mulAny(uint64_t * r, const uint64_t * a, size_t an, const uint64_t * b, size_t bn)
+    {
+      size_t rn = an + bn;
+      an = normalized(a, an);
+      bn = normalized(b, bn);
+      if (!an || !bn) {
+        std::fill(r, r + rn, 0);
+        return;
+      }
+      std::fill(r + an + bn, r + rn, 0);
+      if (an < bn) {
+        std::swap(a, b);
+        std::swap(an, bn);
+      }
+
+      size_t threshold = __atomic_load_n(&karatsuba_threshold, __ATOMIC_RELAXED);
+      if (bn < threshold) {
+        mulSchoolbook(r, a, an, b, bn);
+      }
+      else if (an >= 2 * bn) {
+        // unbalanced, multiply `b' by bn limb slices of `a'
+        std::vector<uint64_t> tmp(2 * bn);
+        std::fill(r, r + an + bn, 0);
+        for (size_t off = 0; off < an; off += bn) {
+          size_t len = std::min(bn, an - off);
+          mulAny(&tmp[0], b, bn, a + off, len);
+          addInto(r + off, an + bn - off, &tmp[0], bn + len);
+        }
+      }
+      else {
+        mulKaratsuba(r, a, an, b, bn);
+      }
+    }
+
+    /*
+     * Division by an invariant single limb divisor: with d normalized (top
+     * bit set) and v = floor((B^2 - 1) / d) - B, every 2-by-1 step is two
+     * multiplications and a few corrections instead of a hardware divide
+     * (Moller and Granlund, "Improved division by invariant integers").
+     */
+    struct Divisor
+    {
+      uint64_t d;
+      int shift;
+      uint64_t v;
+
+      explicit Divisor(uint64_t divisor)
+      {
+        shift = __builtin_clzll(divisor);
+        d = divisor << shift;
+        v = (uint64_t) ((((u128) ~d) << 64 | ~(uint64_t) 0) / d);
+      }
+
+      // (u1 B + u0) / d, requires u1 < d
+      uint64_t divide(uint64_t u1, uint64_t u0, uint64_t * r) const
+      {
+        u128 q = (u128) v * u1 + (((u128) u1 << 64) | u0);
+        uint64_t q1 = (uint64_t) (q >> 64) + 1;
+        uint64_t q0 = (uint64_t) q;
+        uint64_t rem = u0 - q1 * d;
+        if (rem > q0) {
+          --q1;
+          rem += d;
+        }
+        if (unlikely(rem >= d)) {
+          ++q1;
+          rem -= d;
+        }
+        *r = rem;
+        return q1;
+      }
+    };
+
+    // q = a / d, returns the remainder, `q' may be `a'
+    uint64_t divRem1(uint64_t * q, const uint64_t * a, size_t n, const Divisor & d)
+    {
+      int s = d.shift;
+      uint64_t r = s ? a[n - 1] >> (64 - s) : 0;
+      for (size_t i = n; i-- > 0;) {
+        uint64_t u0 = a[i] << s;
+        if (s && i) {
+          u0 |= a[i - 1] >> (64 - s);
+        }
+        q[i] = d.divide(r, u0, &r);
+      }
+      return r >> s;
+    }
+
+    /*
+     * Knuth, TAOCP vol. 2, 4.3.1, algorithm D.  q[0, un - vn] = u / v,
+     * r[0, vn) = u % v; requires vn >= 2, un >= vn and v normalized in
+     * length (v[vn - 1] != 0).
+     */
+    void divRemN(uint64_t * q, uint64_t * r, const uint64_t * u, size_t un, const uint64_t * v, size_t vn)
+    {
+      int s = __builtin_clzll(v[vn - 1]);
+      std::vector<uint64_t> tmp(vn + un + 1);
+      uint64_t * vv = &tmp[0];
+      uint64_t * uu = vv + vn;
+      shiftLeft(vv, v, vn, s);
+      uu[un] = shiftLeft(uu, u, un, s);
+
+      uint64_t vtop = vv[vn - 1], vsec = vv[vn - 2];
+      for (size_t j = un - vn + 1; j-- > 0;) {
+        u128 num = ((u128) uu[j + vn] << 64) | uu[j + vn - 1];
+        u128 qhat = num / vtop;
+        u128 rhat = num - qhat * vtop;
+        while ((qhat >> 64) || qhat * vsec > ((rhat << 64) | uu[j + vn - 2])) {
+          --qhat;
+          rhat += vtop;
+          if (rhat >> 64) {
+            break;
+          }
+        }
+
+        uint64_t borrow = subMul1(uu + j, vv, vn, (uint64_t) qhat);
+        uint64_t top = uu[j + vn];
+        uu[j + vn] = top - borrow;
+        if (unlikely(top < borrow)) {
+          // qhat was one too large, which happens with probability ~2/B
+          --qhat;
+          uu[j + vn] += addN(uu + j, uu + j, vv, vn);
+        }
+        q[j] = (uint64_t) qhat;
+      }
+      shiftRight(r, uu, vn, s);
+    }
+
+    // 10^(19 * 2^k) for k = 0, 1, ..., built on demand by squaring
+    class DecimalPowers
+    {
+    private:
+      std::vector<BigInt> powers_;
+
+    public:
+      const BigInt & get(size_t k)
+      {
+        while (powers_.size() <= k) {
+          if (powers_.empty()) {
+            powers_.push_back(BigInt::fromU64(TEN_POW_19));
+          }
+          else {
+            powers_.push_back(powers_.back() * powers_.back());
+          }
+        }
+        return powers_[k];
+      }
+    };
+
+    uint64_t parseDigits(const char * s, size_t len)
+    {
+      uint64_t v = 0;
+      for (size_t i = 0; i < len; ++i) {
+        v = v * 10 + (s[i] - '0');
+      }
+      return v;
+    }
+
+    void parseDecimal(const char * s, size_t len, DecimalPowers & powers, BigInt * out)
+    {
+      if (len <= 19 * (size_t) BigInt::CONVERSION_THRESHOLD) {
+        BigInt r;
+        size_t first = len % 19 ? len % 19 : 19;
+        r.mulAddSmall(0, parseDigits(s, first));
+        for (size_t i = first; i < len; i += 19) {
+          r.mulAddSmall(TEN_POW_19, parseDigits(s + i, 19));
+        }
+        out->swap(r);
+        return;
+      }
+
+      // the low part takes the largest 19 * 2^k digits below len
+      size_t k = 0;
+      while ((size_t) 19 << (k + 1) < len) {
+        ++k;
+      }
+      size_t low_len = (size_t) 19 << k;
+      BigInt high, low;
+      parseDecimal(s, len - low_len, powers, &high);
+      parseDecimal(s + len - low_len, low_len, powers, &low);
+      high *= powers.get(k);
+      high += low;
+      out->swap(high);
+    }
+
+    void formatDigits(uint64_t v, char * buf)
+    {
+      for (int i = 18; i >= 0; --i) {
+        buf[i] = '0' + v % 10;
+        v /= 10;
+      }
+    }
+
+    // append the non negative `x', left padded with zeros to `pad' digits
+    void formatDecimal(const BigInt & x, size_t pad, DecimalPowers & powers, std::string & out)
+    {
+      if (x.numLimbs() <= (size_t) BigInt::CONVERSION_THRESHOLD) {
+        BigInt t(x);
+        std::vector<uint64_t> groups;
+        groups.reserve(x.numLimbs() * 64 / 63 + 1);
+        while (!t.isZero()) {
+          groups.push_back(t.divModSmall(TEN_POW_19));
+        }
+
+        char buf[19];
+        std::string digits;
+        if (!groups.empty()) {
+          formatDigits(groups.back(), buf);
+          size_t skip = 0;
+          while (skip < 18 && buf[skip] == '0') {
+            ++skip;
+          }
+          digits.append(buf + skip, 19 - skip);
+          for (size_t i = groups.size() - 1; i-- > 0;) {
+            formatDigits(groups[i], buf);
+            digits.append(buf, 19);
+          }
+        }
+        if (pad > digits.size()) {
+          out.append(pad - digits.size(), '0');
+        }
+        out += digits;
+        return;
+      }
+
+      // split around a power of a quarter to half the length of `x'
+      size_t k = 0;
+      while (powers.get(k).numLimbs() * 4 <= x.numLimbs()) {
+        ++k;
+      }
+      size_t low_len = (size_t) 19 << k;
+      BigInt q, r;
+      BigInt::divMod(x, powers.get(k), &q, &r);
+      formatDecimal(q, pad > low_len ? pad - low_len : 0, powers, out);
+      formatDecimal(r, low_len, powers, out);
+    }
+
+    int hexValue(char c)
+    {
+      if (c >= '0' && c <= '9') {
+        return c - '0';
+      }
+      c |= 0x20;
+      if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+      }
+      return -1;
+    }
+  }
+
+  BigInt::BigInt(const BigInt & other) :
+    limbs_(inline_), size_(0), capacity_(INLINE_LIMBS), negative_(other.negative_)
+  {
+    resize(other.size_);
+    std::copy(other.limbs_, other.limbs_ + other.size_, limbs_);
+  }
+
+  BigInt & BigInt::operator=(const BigInt & other)
+  {
+    if (this != &other) {
+      resize(other.size_);
+      std::copy(other.limbs_, other.limbs_ + other.size_, limbs_);
+      negative_ = other.negative_;
+    }
+    return *this;
+  }
+
+  void BigInt::swap(BigInt & other)
+  {
+    bool self_inline = limbs_ == inline_;
+    bool other_inline = other.limbs_ == other.inline_;
+    for (size_t i = 0; i < INLINE_LIMBS; ++i) {
+      std::swap(inline_[i], other.inline_[i]);
+    }
+    std::swap(limbs_, other.limbs_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(negative_, other.negative_);
+    if (other_inline) {
+      limbs_ = inline_;
+    }
+    if (self_inline) {
+      other.limbs_ = other.inline_;
+    }
+  }
+
+  void BigInt::reserve(size_t n)
+  {
+    if (n <= capacity_) {
+      return;
+    }
+    size_t cap = std::max(n, (size_t) capacity_ * 2);
+    uint64_t * p;
+    if (limbs_ == inline_) {
+      p = (uint64_t *) ::malloc(cap * sizeof(uint64_t));
+      if (p) {
+        std::copy(inline_, inline_ + size_, p);
+      }
+    }
+    else {
+      p = (uint64_t *) ::realloc(limbs_, cap * sizeof(uint64_t));
+    }
+    if (!p) {
+      ::abort();
+    }
+    limbs_ = p;
+    capacity_ = cap;
+  }
+
+  void BigInt::resize(size_t n)
+  {
+    reserve(n);
+    size_ = n;
+  }
+
+  void BigInt::trim()
+  {
+    size_ = normalized(limbs_, size_);
+    if (!size_) {
+      negative_ = false;
+    }
+  }
+
+  void BigInt::assignU64(uint64_t v)
+  {
+    limbs_[0] = v;
+    size_ = v ? 1 : 0;
+    negative_ = false;
+  }
+
+  size_t BigInt::karatsubaThreshold()
+  {
+    return __atomic_load_n(&karatsuba_threshold, __ATOMIC_RELAXED);
+  }
+
+  void BigInt::setKaratsubaThreshold(size_t limbs)
+  {
+    __atomic_store_n(&karatsuba_threshold, std::max(limbs, (size_t) 4), __ATOMIC_RELAXED);
+  }
+
+  int BigInt::compareAbs(const BigInt & other) const
+  {
+    if (size_ != other.size_) {
+      return size_ < other.size_ ? -1 : 1;
+    }
+    return compareN(limbs_, other.limbs_, size_);
+  }
+
+  int BigInt::compare(const BigInt & other) const
+  {
+    if (negative_ != other.negative_) {
+      return negative_ ? -1 : 1;
+    }
+    int c = compareAbs(other);
+    return negative_ ? -c : c;
+  }
+
+  void BigInt::addAbs(const BigInt & a, const BigInt & b, BigInt * r)
+  {
+    const BigInt * x = &a;
+    const BigInt * y = &b;
+    if (x->size_ < y->size_) {
+      std::swap(x, y);
+    }
+    size_t xn = x->size_, yn = y->size_;
+    // may reallocate `x' or `y' when `r' is one of them, fetch limbs after
+    r->resize(xn + 1);
+    uint64_t * rp = r->limbs_;
+    const uint64_t * xp = x->limbs_;
+    const uint64_t * yp = y->limbs_;
+    uint64_t carry = addN(rp, xp, yp, yn);
+    rp[xn] = add1(rp + yn, xp + yn, xn - yn, carry);
+    r->trim();
+  }
+
+  void BigInt::subAbs(const BigInt & a, const BigInt & b, BigInt * r)
+  {
+    size_t an = a.size_, bn = b.size_;
+    r->resize(an);
+    uint64_t * rp = r->limbs_;
+    const uint64_t * ap = a.limbs_;
+    const uint64_t * bp = b.limbs_;
+    uint64_t borrow = subN(rp, ap, bp, bn);
+    sub1(rp + bn, ap + bn, an - bn, borrow);
+    r->trim();
+  }
+
+  void BigInt::addSigned(const BigInt & a, const BigInt & b, bool negate_b, BigInt * r)
+  {
+    bool a_negative = a.negative_;
+    bool b_negative = b.negative_ != negate_b;
+    bool negative;
+    if (a_negative == b_negative) {
+      addAbs(a, b, r);
+      negative = a_negative;
+    }
+    else if (a.compareAbs(b) >= 0) {
+      subAbs(a, b, r);
+      negative = a_negative;
+    }
+    else {
+      subAbs(b, a, r);
+      negative = b_negative;
+    }
+    r->negative_ = negative && r->size_;
+  }
+
+  BigInt & BigInt::operator*=(const BigInt & other)
+  {
+    if (!size_ || !other.size_) {
+      assignU64(0);
+      return *this;
+    }
+    BigInt r;
+    r.resize(size_ + other.size_);
+    mulAny(r.limbs_, limbs_, size_, other.limbs_, other.size_);
+    r.trim();
+    r.negative_ = negative_ != other.negative_;
+    swap(r);
+    return *this;
+  }
+
+  int BigInt::divMod(const BigInt & a, const BigInt & b, BigInt * q, BigInt * r)
+  {
+    if (!b.size_) {
+      errno = EDOM;
+      return -1;
+    }
+
+    BigInt qq, rr;
+    if (a.compareAbs(b) < 0) {
+      rr = a;
+    }
+    else if (b.size_ == 1) {
+      qq.resize(a.size_);
+      rr.assignU64(divRem1(qq.limbs_, a.limbs_, a.size_, Divisor(b.limbs_[0])));
+    }
+    else {
+      qq.resize(a.size_ - b.size_ + 1);
+      rr.resize(b.size_);
+      divRemN(qq.limbs_, rr.limbs_, a.limbs_, a.size_, b.limbs_, b.size_);
+    }
+    qq.trim();
+    rr.trim();
+    qq.negative_ = (a.negative_ != b.negative_) && qq.size_;
+    rr.negative_ = a.negative_ && rr.size_;
+
+    if (q) {
+      q->swap(qq);
+    }
+    if (r) {
+      r->swap(rr);
+    }
+    return 0;
+  }
+
+  BigInt & BigInt::operator/=(const BigInt & other)
+  {
+    divMod(*this, other, this, NULL);
+    return *this;
+  }
+
+  BigInt & BigInt::operator%=(const BigInt & other)
+  {
+    divMod(*this, other, NULL, this);
+    return *this;
+  }
+
+  uint64_t BigInt::divModSmall(uint64_t d)
+  {
+    if (!size_) {
+      return 0;
+    }
+    uint64_t rem = divRem1(limbs_, limbs_, size_, Divisor(d));
+    trim();
+    return rem;
+  }
+
+  void BigInt::mulAddSmall(uint64_t m, uint64_t a)
+  {
+    size_t n = size_;
+    resize(n + 2);
+    limbs_[n] = mul1(limbs_, limbs_, n, m);
+    limbs_[n + 1] = add1(limbs_, limbs_, n + 1, a);
+    trim();
+  }
+
+  BigInt & BigInt::operator<<=(size_t bits)
+  {
+    if (!size_ || !bits) {
+      return *this;
+    }
+    size_t n = size_;
+    size_t shift = bits / 64;
+    int s = bits % 64;
+    resize(n + shift + 1);
+    uint64_t * p = limbs_;
+    if (s) {
+      p[n + shift] = p[n - 1] >> (64 - s);
+      for (size_t i = n - 1; i > 0; --i) {
+        p[i + shift] = (p[i] << s) | (p[i - 1] >> (64 - s));
+      }
+      p[shift] = p[0] << s;
+    }
+    else {
+      p[n + shift] = 0;
+      std::copy_backward(p, p + n, p + n + shift);
+    }
+    std::fill(p, p + shift, 0);
+    trim();
+    return *this;
+  }
+
+  BigInt & BigInt::operator>>=(size_t bits)
+  {
+    size_t shift = bits / 64;
+    if (shift >= size_) {
+      assignU64(0);
+      return *this;
+    }
+    size_t n = size_ - shift;
+    shiftRight(limbs_, limbs_ + shift, n, bits % 64);
+    size_ = n;
+    trim();
+    return *this;
+  }
+
+  BigInt BigInt::pow(const BigInt & base, uint32_t exponent)
+  {
+    BigInt result(1);
+    BigInt b(base);
+    while (exponent) {
+      if (exponent & 1) {
+        result *= b;
+      }
+      exponent >>= 1;
+      if (exponent) {
+        b *= b;
+      }
+    }
+    return result;
+  }
+
+  int BigInt::parse(const char * s, size_t len, BigInt * out)
+  {
+    size_t i = 0;
+    bool negative = false;
+    if (i < len && (s[i] == '+' || s[i] == '-')) {
+      negative = s[i] == '-';
+      ++i;
+    }
+    bool hex = len - i >= 2 && s[i] == '0' && (s[i + 1] | 0x20) == 'x';
+    if (hex) {
+      i += 2;
+    }
+    if (i == len) {
+      errno = EINVAL;
+      return -1;
+    }
+    for (size_t j = i; j < len; ++j) {
+      if (hex ? hexValue(s[j]) < 0 : (s[j] < '0' || s[j] > '9')) {
+        errno = EINVAL;
+        return -1;
+      }
+    }
+
+    BigInt r;
+    if (hex) {
+      size_t digits = len - i;
+      r.resize((digits + 15) / 16);
+      std::fill(r.limbs_, r.limbs_ + r.size_, 0);
+      for (size_t k = 0; k < digits; ++k) {
+        r.limbs_[k / 16] |= (uint64_t) hexValue(s[len - 1 - k]) << (k % 16 * 4);
+      }
+      r.trim();
+    }
+    else {
+      DecimalPowers powers;
+      parseDecimal(s + i, len - i, powers, &r);
+    }
+    r.negative_ = negative && r.size_;
+    out->swap(r);
+    return 0;
+  }
+
+  std::string BigInt::toString(int base) const
+  {
+    std::string out;
+    if (negative_) {
+      out += '-';
+    }
+
+    if (base == 16) {
+      out += "0x";
+      if (!size_) {
+        out += '0';
+        return out;
+      }
+      static const char digits[] = "0123456789abcdef";
+      out.reserve(out.size() + size_ * 16);
+      bool leading = true;
+      for (size_t i = size_; i-- > 0;) {
+        for (int shift = 60; shift >= 0; shift -= 4) {
+          int d = (limbs_[i] >> shift) & 0xf;
+          if (leading && !d) {
+            continue;
+          }
+          leading = false;
+          out += digits[d];
+        }
+      }
+      return out;
+    }
+
+    if (!size_) {
+      return "0";
+    }
+    out.reserve(out.size() + size_ * 20);
+    DecimalPowers powers;
+    if (negative_) {
+      formatDecimal(-*this, 0, powers, out);
+    }
+    else {
+      formatDecimal(*this, 0, powers, out);
+    }
+    return out;
+  }
+}
@@ -0,0 +1,102 @@
+/*
+ * byte_buffer.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include "nebula/byte_buffer.h"
+
+namespace nebula
+{
+  size_t Varint::decodeSlow(const uint8_t * p, size_t len, uint64_t * out)
+  {
+    uint64_t v = 0;
+    for (size_t i = 0; i < MAX_LENGTH_64; ++i) {
+      if (i == len) {
+        errno = ENODATA;
+        return 0;
+      }
+      uint64_t group = p[i] & 0x7f;
+      if (i == MAX_LENGTH_64 - 1 && group > 1) {
+        // the 10th byte holds only the highest bit
+        errno = EBADMSG;
+        return 0;
+      }
+      v |= group << (7 * i);
+      if (!(p[i] & 0x80)) {
+        *out = v;
+        return i + 1;
+      }
+    }
+    errno = EBADMSG;
+    return 0;
+  }
+
+  ByteWriter::ByteWriter(size_t capacity) :
+    data_(NULL), size_(0), capacity_(0)
+  {
+    if (capacity) {
+      (void) grow(capacity);
+    }
+  }
+
+  ByteWriter::~ByteWriter()
+  {
+    free(data_);
+  }
+
+  int ByteWriter::grow(size_t extra)
+  {
+    if (extra > SIZE_MAX - size_) {
+      errno = ENOMEM;
+      return -1;
+    }
+    size_t needed = size_ + extra;
+    size_t capacity = capacity_ ? capacity_ : 64;
+    while (capacity < needed) {
+      capacity = capacity > SIZE_MAX / 2 ? needed : capacity * 2;
+    }
+    uint8_t * data = (uint8_t *) realloc(data_, capacity);
+    if (!data) {
+      errno = ENOMEM;
+      return -1;
+    }
+    data_ = data;
+    capacity_ = capacity;
+    return 0;
+  }
+
+  void ByteWriter::swap(ByteWriter & other)
+  {
+    uint8_t * data = data_;
+    size_t size = size_;
+    size_t capacity = capacity_;
+    data_ = other.data_;
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+    other.data_ = data;
+    other.size_ = size;
+    other.capacity_ = capacity;
+  }
+}
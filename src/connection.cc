@@ -0,0 +1,465 @@
+/*
+ * connection.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "nebula/async_io.h"
+#include "nebula/connection.h"
+
+namespace nebula
+{
+  Connection::~Connection()
+  {
+    if (state_ != CLOSED && ae_->removeFd(fd_, true) < 0) {
+      ::close(fd_);
+    }
+    dropSegments();
+  }
+
+  int Connection::init()
+  {
+    if (AsyncIo::setNonblock(fd_) < 0) {
+      return -1;
+    }
+    return updateEvents();
+  }
+
+  int Connection::send(const void * data, size_t len)
+  {
+    if (state_ != CONNECTED) {
+      errno = EPIPE;
+      return -1;
+    }
+    const char * p = (const char *) data;
+    if (!hasOutput()) {
+      // nothing queued, try the socket first and only buffer the rest
+      while (len) {
+        ssize_t n = ::send(fd_, p, len, MSG_NOSIGNAL);
+        if (n > 0) {
+          p += n;
+          len -= n;
+          bytes_written_ += n;
+        }
+        else if (n < 0 && errno == EINTR) {
+          continue;
+        }
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+          break;
+        }
+        else {
+          int error = n < 0 ? errno : EPIPE;
+          closeWith(error);
+          errno = error;
+          return -1;
+        }
+      }
+      if (!len) {
+        return 0;
+      }
+    }
+    if (output_.append(p, len) < 0) {
+      return -1;
+    }
+    return afterQueued(false);
+  }
+
+  int Connection::send(IoBuffer & data)
+  {
+    if (state_ != CONNECTED) {
+      errno = EPIPE;
+      return -1;
+    }
+    bool idle = !hasOutput();
+    output_.append(data);
+    return afterQueued(idle);
+  }
+
+  int Connection::sendFile(int file_fd, off_t offset, size_t len, bool close_it)
+  {
+    if (state_ != CONNECTED) {
+      if (close_it) {
+        ::close(file_fd);
+      }
+      errno = EPIPE;
+      return -1;
+    }
+    bool idle = !hasOutput();
+    Segment * s = queueSegment();
+    s->file_fd = file_fd;
+    s->close_file = close_it;
+    s->offset = offset;
+    s->remaining = len;
+    return afterQueued(idle);
+  }
+
+  ssize_t Connection::spliceFrom(int fd, size_t len)
+  {
+    if (state_ != CONNECTED) {
+      errno = EPIPE;
+      return -1;
+    }
+    bool idle = !hasOutput();
+    Segment * s = NULL;
+    if (!segments_.empty() && segments_.back().pipe) {
+      // keep filling the last pipe unless bytes were queued after it
+      size_t gaps = 0;
+      for (size_t i = 0; i < segments_.size(); ++i) {
+        gaps += segments_[i].gap;
+      }
+      if (gaps == output_.size()) {
+        s = &segments_.back();
+      }
+    }
+    if (!s) {
+      SplicePipe * pipe = new SplicePipe;
+      s = queueSegment();
+      s->pipe = pipe;
+    }
+    ssize_t n = s->pipe->fill(fd, len);
+    if (n <= 0) {
+      int error = errno;
+      SplicePipe * pipe = s->pipe;
+      if (!pipe->buffered()) {
+        segments_.pop_back();
+        delete pipe;
+      }
+      errno = error;
+      return n;
+    }
+    spliced_ += n;
+    return afterQueued(idle) < 0 ? -1 : n;
+  }
+
+  void Connection::pauseReading()
+  {
+    reading_paused_ = true;
+    rearm();
+  }
+
+  void Connection::resumeReading()
+  {
+    reading_paused_ = false;
+    rearm();
+  }
+
+  void Connection::shutdown()
+  {
+    if (state_ != CONNECTED) {
+      return;
+    }
+    if (!hasOutput()) {
+      closeWith(0);
+      return;
+    }
+    state_ = DRAINING;
+    rearm();
+  }
+
+  void Connection::close()
+  {
+    closeWith(0);
+  }
+
+  uint32_t Connection::onEvent(int fd, uint32_t mask, void * data, AsyncEvent * ae)
+  {
+    Connection * c = (Connection *) data;
+    uint32_t guess = AsyncEvent::NONE;
+    ++c->in_callback_;
+    if ((mask & AsyncEvent::WRITABLE) && c->state_ != CLOSED) {
+      c->flush();
+    }
+    if ((mask & AsyncEvent::READABLE) && c->state_ == CONNECTED && (c->monitored_ & AsyncEvent::READABLE)) {
+      guess = c->handleRead();
+    }
+    --c->in_callback_;
+    if (c->close_pending_ && !c->in_callback_) {
+      c->finishClose();
+      return AsyncEvent::NONE;
+    }
+    return guess;
+  }
+
+  uint32_t Connection::onError(int fd, uint32_t mask_place_holder, void * data, AsyncEvent * ae)
+  {
+    Connection * c = (Connection *) data;
+    ++c->in_callback_;
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0) {
+      error = errno;
+    }
+    if (!error && c->state_ == CONNECTED && (c->monitored_ & AsyncEvent::READABLE)) {
+      // hung up, what the peer sent before is still there
+      c->handleRead();
+    }
+    if (c->state_ != CLOSED) {
+      c->closeWith(error ? error : (c->hasOutput() ? EPIPE : 0));
+    }
+    --c->in_callback_;
+    if (c->close_pending_ && !c->in_callback_) {
+      c->finishClose();
+    }
+    return AsyncEvent::NONE;
+  }
+
+  uint32_t Connection::handleRead()
+  {
+    size_t got = 0;
+    bool eof = false, more = false;
+    int error = 0;
+    for (;;) {
+      ssize_t n = input_.readFrom(fd_);
+      if (n > 0) {
+        got += n;
+        if (got >= READ_BUDGET) {
+          more = true;
+          break;
+        }
+      }
+      else if (n == 0) {
+        eof = true;
+        break;
+      }
+      else {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+          error = errno;
+        }
+        break;
+      }
+    }
+    bytes_read_ += got;
+    if (got && on_message_) {
+      on_message_(this, &input_, data_);
+    }
+    if (state_ == CLOSED) {
+      return AsyncEvent::NONE;
+    }
+    if (error) {
+      closeWith(error);
+      return AsyncEvent::NONE;
+    }
+    if (eof) {
+      if (!hasOutput()) {
+        closeWith(0);
+      }
+      else {
+        // answer what was asked before going away
+        state_ = DRAINING;
+        rearm();
+      }
+      return AsyncEvent::NONE;
+    }
+    return more && (monitored_ & AsyncEvent::READABLE) ? AsyncEvent::READABLE : AsyncEvent::NONE;
+  }
+
+  Connection::Segment * Connection::queueSegment()
+  {
+    size_t gaps = 0;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+      gaps += segments_[i].gap;
+    }
+    Segment s =
+    { output_.size() - gaps, NULL, -1, false, 0, 0 };
+    segments_.push_back(s);
+    return &segments_.back();
+  }
+
+  void Connection::popSegment()
+  {
+    Segment & s = segments_.front();
+    if (s.pipe) {
+      spliced_ -= s.pipe->buffered();
+      delete s.pipe;
+    }
+    if (s.close_file) {
+      ::close(s.file_fd);
+    }
+    segments_.pop_front();
+  }
+
+  void Connection::dropSegments()
+  {
+    while (!segments_.empty()) {
+      popSegment();
+    }
+  }
+
+  bool Connection::flush()
+  {
+    for (;;) {
+      size_t limit = segments_.empty() ? output_.size() : segments_.front().gap;
+      int error = EPIPE;
+      ssize_t n;
+      if (limit) {
+        if ((n = output_.sendTo(fd_, limit)) > 0 && !segments_.empty()) {
+          segments_.front().gap -= n;
+        }
+      }
+      else if (segments_.empty()) {
+        break;
+      }
+      else if (segments_.front().pipe) {
+        Segment & s = segments_.front();
+        if (!s.pipe->buffered()) {
+          popSegment();
+          continue;
+        }
+        if ((n = s.pipe->drain(fd_, s.pipe->buffered())) > 0) {
+          spliced_ -= n;
+          if (!s.pipe->buffered()) {
+            popSegment();
+          }
+        }
+      }
+      else {
+        Segment & s = segments_.front();
+        if (!s.remaining) {
+          popSegment();
+          continue;
+        }
+        if ((n = AsyncIo::sendFile(fd_, s.file_fd, &s.offset, s.remaining)) > 0 && !(s.remaining -= n)) {
+          popSegment();
+        }
+        error = EIO; // end of file before `remaining' bytes
+      }
+      if (n > 0) {
+        bytes_written_ += n;
+      }
+      else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        break;
+      }
+      else {
+        closeWith(n < 0 ? errno : error);
+        return false;
+      }
+    }
+    if (above_high_ && pendingOutput() <= low_watermark_) {
+      above_high_ = false;
+      if (on_watermark_) {
+        on_watermark_(this, false, data_);
+        if (state_ == CLOSED) {
+          return false;
+        }
+      }
+    }
+    if (!hasOutput() && state_ == DRAINING) {
+      closeWith(0);
+      return false;
+    }
+    rearm();
+    return state_ != CLOSED;
+  }
+
+  int Connection::afterQueued(bool write_now)
+  {
+    ++in_callback_;
+    if (!write_now || flush()) {
+      if (!above_high_ && pendingOutput() > high_watermark_) {
+        above_high_ = true;
+        if (on_watermark_) {
+          on_watermark_(this, true, data_);
+        }
+      }
+      if (state_ != CLOSED) {
+        rearm();
+      }
+    }
+    --in_callback_;
+    if (state_ != CLOSED) {
+      return 0;
+    }
+    int error = error_ ? error_ : EPIPE;
+    if (close_pending_ && !in_callback_) {
+      finishClose();
+    }
+    errno = error;
+    return -1;
+  }
+
+  int Connection::updateEvents()
+  {
+    uint32_t wanted = AsyncEvent::NONE;
+    if (state_ == CONNECTED && !reading_paused_) {
+      wanted |= AsyncEvent::READABLE;
+    }
+    if (state_ != CLOSED && hasOutput()) {
+      wanted |= AsyncEvent::WRITABLE;
+    }
+    uint32_t add = wanted & ~monitored_;
+    uint32_t del = monitored_ & ~wanted;
+    if (add && ae_->addFdEvent(fd_, add, onEvent, this, onError, this) < 0) {
+      return -1;
+    }
+    monitored_ |= add;
+    if (del && ae_->delFdEvent(fd_, del) < 0) {
+      return -1;
+    }
+    monitored_ &= ~del;
+    return 0;
+  }
+
+  void Connection::rearm()
+  {
+    ++in_callback_;
+    if (state_ != CLOSED && updateEvents() < 0) {
+      closeWith(errno);
+    }
+    --in_callback_;
+    if (close_pending_ && !in_callback_) {
+      finishClose();
+    }
+  }
+
+  void Connection::closeWith(int error)
+  {
+    if (state_ == CLOSED) {
+      return;
+    }
+    state_ = CLOSED;
+    error_ = error;
+    if (ae_->removeFd(fd_, true) < 0) {
+      ::close(fd_);
+    }
+    monitored_ = AsyncEvent::NONE;
+    close_pending_ = true;
+    if (!in_callback_) {
+      finishClose();
+    }
+  }
+
+  void Connection::finishClose()
+  {
+    close_pending_ = false;
+    input_.clear();
+    output_.clear();
+    dropSegments();
+    if (on_close_) {
+      // may delete this
+      on_close_(this, error_, data_);
+    }
+  }
+}
@@ -0,0 +1,172 @@
+/*
+ * endian.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "nebula/attributes.h"
+#include "nebula/endian.h"
+#include "nebula/multiversion.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace nebula
+{
+  namespace
+  {
+    INLINE uint16_t bswap(uint16_t v)
+    {
+      return __builtin_bswap16(v);
+    }
+
+    INLINE uint32_t bswap(uint32_t v)
+    {
+      return __builtin_bswap32(v);
+    }
+
+    INLINE uint64_t bswap(uint64_t v)
+    {
+      return __builtin_bswap64(v);
+    }
+
+    template<typename T>
+    void swapScalar(T * dst, const T * src, size_t n)
+    {
+      for (size_t i = 0; i < n; ++i) {
+        dst[i] = bswap(src[i]);
+      }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    /*
+     * pshufb controls reversing the bytes of every 2, 4 and 8 byte integer,
+     * for 64 bytes (pshufb shuffles within 16 byte lanes, so the pattern
+     * simply repeats).
+     */
+    const uint8_t shuffle_masks[3][64] __attribute__((aligned(64))) = {
+        { // 2 byte integers
+          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 },
+        { // 4 byte integers
+          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+        { // 8 byte integers
+          7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+          7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+          7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+          7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 }
+    };
+
+    template<typename T>
+    INLINE const uint8_t * shuffleMask()
+    {
+      return shuffle_masks[sizeof(T) == 2 ? 0 : sizeof(T) == 4 ? 1 : 2];
+    }
+
+    template<typename T>
+    TARGET("ssse3")
+    void swapSsse3(T * dst, const T * src, size_t n)
+    {
+      const __m128i mask = _mm_load_si128((const __m128i *) shuffleMask<T>());
+      const size_t step = 16 / sizeof(T);
+      size_t i = 0;
+      for (; i + step <= n; i += step) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_shuffle_epi8(v, mask));
+      }
+      swapScalar(dst + i, src + i, n - i);
+    }
+
+    template<typename T>
+    TARGET("avx2")
+    void swapAvx2(T * dst, const T * src, size_t n)
+    {
+      const __m256i mask = _mm256_load_si256((const __m256i *) shuffleMask<T>());
+      const size_t step = 32 / sizeof(T);
+      size_t i = 0;
+      for (; i + 2 * step <= n; i += 2 * step) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *) (src + i + step));
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_shuffle_epi8(v0, mask));
+        _mm256_storeu_si256((__m256i *) (dst + i + step), _mm256_shuffle_epi8(v1, mask));
+      }
+      if (i + step <= n) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_shuffle_epi8(v, mask));
+        i += step;
+      }
+      swapScalar(dst + i, src + i, n - i);
+    }
+
+    template<typename T>
+    TARGET("avx512f,avx512bw")
+    void swapAvx512(T * dst, const T * src, size_t n)
+    {
+      const __m512i mask = _mm512_load_si512((const void *) shuffleMask<T>());
+      const size_t step = 64 / sizeof(T);
+      size_t i = 0;
+      for (; i + step <= n; i += step) {
+        __m512i v = _mm512_loadu_si512((const void *) (src + i));
+        _mm512_storeu_si512((void *) (dst + i), _mm512_shuffle_epi8(v, mask));
+      }
+      if (i < n) {
+        // masked load and store of the tail, never touches bytes past the end
+        __mmask64 tail = ~0ULL >> (64 - (n - i) * sizeof(T));
+        __m512i v = _mm512_maskz_loadu_epi8(tail, (const void *) (src + i));
+        _mm512_mask_storeu_epi8((void *) (dst + i), tail, _mm512_shuffle_epi8(v, mask));
+      }
+    }
+
+    Multiversion<void (*)(uint16_t *, const uint16_t *, size_t)> swap16_impl(swapScalar<uint16_t>,
+        swapSsse3<uint16_t>, swapAvx2<uint16_t>, swapAvx512<uint16_t>);
+    Multiversion<void (*)(uint32_t *, const uint32_t *, size_t)> swap32_impl(swapScalar<uint32_t>,
+        swapSsse3<uint32_t>, swapAvx2<uint32_t>, swapAvx512<uint32_t>);
+    Multiversion<void (*)(uint64_t *, const uint64_t *, size_t)> swap64_impl(swapScalar<uint64_t>,
+        swapSsse3<uint64_t>, swapAvx2<uint64_t>, swapAvx512<uint64_t>);
+#else
+    Multiversion<void (*)(uint16_t *, const uint16_t *, size_t)> swap16_impl(swapScalar<uint16_t>, NULL, NULL, NULL);
+    Multiversion<void (*)(uint32_t *, const uint32_t *, size_t)> swap32_impl(swapScalar<uint32_t>, NULL, NULL, NULL);
+    Multiversion<void (*)(uint64_t *, const uint64_t *, size_t)> swap64_impl(swapScalar<uint64_t>, NULL, NULL, NULL);
+#endif
+  }
+
+  void Endian::swap16(uint16_t * dst, const uint16_t * src, size_t n)
+  {
+    swap16_impl.get()(dst, src, n);
+  }
+
+  void Endian::swap32(uint32_t * dst, const uint32_t * src, size_t n)
+  {
+    swap32_impl.get()(dst, src, n);
+  }
+
+  void Endian::swap64(uint64_t * dst, const uint64_t * src, size_t n)
+  {
+    swap64_impl.get()(dst, src, n);
+  }
+}
@@ -0,0 +1,280 @@
+/*
+ * epoch.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <new>
+#include "nebula/epoch.h"
+
+namespace nebula
+{
+  EpochDomain::EpochDomain() :
+    global_epoch_(0), records_(NULL), initialized_(false)
+  {
+    pthread_mutex_init(&orphans_lock_, NULL);
+  }
+
+  EpochDomain::~EpochDomain()
+  {
+    if (initialized_) {
+      pthread_key_delete(key_);
+    }
+    ThreadRecord * r = records_;
+    while (r) {
+      ThreadRecord * next = r->next;
+      for (int i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < r->limbo[i].size(); ++j) {
+          (*r->limbo[i][j].deleter)(r->limbo[i][j].ptr);
+        }
+      }
+      r->~ThreadRecord();
+      free(r);
+      r = next;
+    }
+    for (size_t i = 0; i < orphans_.size(); ++i) {
+      (*orphans_[i].retired.deleter)(orphans_[i].retired.ptr);
+    }
+    pthread_mutex_destroy(&orphans_lock_);
+  }
+
+  int EpochDomain::init()
+  {
+    if (initialized_) {
+      errno = EINVAL;
+      return -1;
+    }
+    int rc = pthread_key_create(&key_, threadExit);
+    if (rc) {
+      errno = rc;
+      return -1;
+    }
+    initialized_ = true;
+    return 0;
+  }
+
+  EpochDomain & EpochDomain::defaultDomain()
+  {
+    static EpochDomain domain;
+    static int rc = domain.init();
+    if (rc < 0) {
+      ::abort(); // out of pthread keys, nothing could be reclaimed safely
+    }
+    return domain;
+  }
+
+  EpochDomain::ThreadRecord * EpochDomain::attach()
+  {
+    ThreadRecord * r;
+    // reuse the record of an exited thread if possible
+    for (r = __atomic_load_n(&records_, __ATOMIC_ACQUIRE); r; r = r->next) {
+      int free = 0;
+      if (!__atomic_load_n(&r->in_use, __ATOMIC_RELAXED)
+          && __atomic_compare_exchange_n(&r->in_use, &free, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        break;
+      }
+    }
+    if (!r) {
+      // new does not honour the alignment of ThreadRecord before C++17
+      void * p = NULL;
+      if (posix_memalign(&p, __alignof__(ThreadRecord), sizeof(ThreadRecord))) {
+        throw std::bad_alloc();
+      }
+      r = new (p) ThreadRecord;
+      r->epoch = 0;
+      r->in_use = 1;
+      r->domain = this;
+      for (int i = 0; i < 3; ++i) {
+        r->limbo_epoch[i] = 0;
+      }
+      r->next = __atomic_load_n(&records_, __ATOMIC_RELAXED);
+      while (!__atomic_compare_exchange_n(&records_, &r->next, r, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        ;
+      }
+    }
+    r->nesting = 0;
+    r->num_retired = 0;
+    pthread_setspecific(key_, r);
+    return r;
+  }
+
+  void EpochDomain::retire(void * ptr, Deleter deleter)
+  {
+    ThreadRecord * r = (ThreadRecord *) pthread_getspecific(key_);
+    if (!r) {
+      r = attach();
+    }
+    // `ptr' was unlinked before the epoch is read
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    uint64_t epoch = __atomic_load_n(&global_epoch_, __ATOMIC_RELAXED);
+    int idx = epoch % 3;
+    if (r->limbo_epoch[idx] != epoch) {
+      // objects of epoch - 3 or earlier, nobody can see them any more
+      reclaimRecord(r, epoch);
+      r->limbo_epoch[idx] = epoch;
+    }
+    Retired retired =
+    { ptr, deleter };
+    r->limbo[idx].push_back(retired);
+    if (++r->num_retired >= RECLAIM_BATCH) {
+      reclaim();
+    }
+  }
+
+  size_t EpochDomain::reclaim()
+  {
+    ThreadRecord * r = (ThreadRecord *) pthread_getspecific(key_);
+    tryAdvance();
+    uint64_t epoch = __atomic_load_n(&global_epoch_, __ATOMIC_ACQUIRE);
+    size_t n = reclaimOrphans(epoch);
+    if (r) {
+      r->num_retired = 0;
+      n += reclaimRecord(r, epoch);
+    }
+    return n;
+  }
+
+  void EpochDomain::synchronize()
+  {
+    uint64_t target = __atomic_load_n(&global_epoch_, __ATOMIC_ACQUIRE) + 2;
+    while (__atomic_load_n(&global_epoch_, __ATOMIC_ACQUIRE) < target) {
+      if (!tryAdvance()) {
+        sched_yield();
+      }
+    }
+    reclaim();
+  }
+
+  void EpochDomain::unregisterThread()
+  {
+    ThreadRecord * r = (ThreadRecord *) pthread_getspecific(key_);
+    if (r) {
+      pthread_setspecific(key_, NULL);
+      releaseRecord(r);
+    }
+  }
+
+  size_t EpochDomain::pending()
+  {
+    size_t n = 0;
+    ThreadRecord * r = (ThreadRecord *) pthread_getspecific(key_);
+    if (r) {
+      n += r->limbo[0].size() + r->limbo[1].size() + r->limbo[2].size();
+    }
+    pthread_mutex_lock(&orphans_lock_);
+    n += orphans_.size();
+    pthread_mutex_unlock(&orphans_lock_);
+    return n;
+  }
+
+  /*
+   * The global epoch can move from e to e + 1 once every thread inside a
+   * critical section has observed e.
+   */
+  bool EpochDomain::tryAdvance()
+  {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    uint64_t epoch = __atomic_load_n(&global_epoch_, __ATOMIC_RELAXED);
+    for (ThreadRecord * r = __atomic_load_n(&records_, __ATOMIC_ACQUIRE); r; r = r->next) {
+      uint64_t e = __atomic_load_n(&r->epoch, __ATOMIC_ACQUIRE);
+      if ((e & 1) && (e >> 1) != epoch) {
+        return false;
+      }
+    }
+    return __atomic_compare_exchange_n(&global_epoch_, &epoch, epoch + 1, false, __ATOMIC_ACQ_REL,
+      __ATOMIC_RELAXED);
+  }
+
+  /*
+   * Deletes the objects of `r' retired two or more epochs before `epoch'.
+   */
+  size_t EpochDomain::reclaimRecord(ThreadRecord * r, uint64_t epoch)
+  {
+    size_t n = 0;
+    for (int i = 0; i < 3; ++i) {
+      if (!r->limbo[i].empty() && r->limbo_epoch[i] + 2 <= epoch) {
+        // the deleter may retire other objects, which must not go into this list
+        std::vector<Retired> list;
+        list.swap(r->limbo[i]);
+        for (size_t j = 0; j < list.size(); ++j) {
+          (*list[j].deleter)(list[j].ptr);
+        }
+        n += list.size();
+        if (r->limbo[i].empty()) {
+          list.clear();
+          list.swap(r->limbo[i]); // keep the capacity
+        }
+      }
+    }
+    return n;
+  }
+
+  size_t EpochDomain::reclaimOrphans(uint64_t epoch)
+  {
+    std::vector<Orphan> ready;
+    if (pthread_mutex_trylock(&orphans_lock_)) {
+      return 0; // somebody else is at it
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < orphans_.size(); ++i) {
+      if (orphans_[i].epoch + 2 <= epoch) {
+        ready.push_back(orphans_[i]);
+      }
+      else {
+        orphans_[kept++] = orphans_[i];
+      }
+    }
+    orphans_.resize(kept);
+    pthread_mutex_unlock(&orphans_lock_);
+    for (size_t i = 0; i < ready.size(); ++i) {
+      (*ready[i].retired.deleter)(ready[i].retired.ptr);
+    }
+    return ready.size();
+  }
+
+  void EpochDomain::releaseRecord(ThreadRecord * r)
+  {
+    pthread_mutex_lock(&orphans_lock_);
+    for (int i = 0; i < 3; ++i) {
+      for (size_t j = 0; j < r->limbo[i].size(); ++j) {
+        Orphan orphan =
+        { r->limbo_epoch[i], r->limbo[i][j] };
+        orphans_.push_back(orphan);
+      }
+      r->limbo[i].clear();
+    }
+    pthread_mutex_unlock(&orphans_lock_);
+    r->nesting = 0;
+    __atomic_store_n(&r->epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&r->in_use, 0, __ATOMIC_RELEASE);
+  }
+
+  void EpochDomain::threadExit(void * record)
+  {
+    ThreadRecord * r = (ThreadRecord *) record;
+    r->domain->releaseRecord(r);
+  }
+}
@@ -0,0 +1,359 @@
+/*
+ * file_status_cache.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include "nebula/file_status_cache.h"
+#include "nebula/file_system.h"
+#include "nebula/thread.h"
+
+namespace nebula
+{
+  namespace internal
+  {
+    class StatusWatcherThread: public Thread
+    {
+    private:
+      FileStatusCache * owner_;
+
+    public:
+      StatusWatcherThread(FileStatusCache * owner) :
+        owner_(owner)
+      {
+
+      }
+
+      virtual void * routine()
+      {
+        struct pollfd fds[2];
+        fds[0].fd = owner_->inotify_fd_;
+        fds[0].events = POLLIN;
+        fds[1].fd = owner_->wakeup_fd_;
+        fds[1].events = POLLIN;
+        for (;;) {
+          if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+              continue;
+            }
+            break;
+          }
+          if (fds[1].revents) {
+            break; // woken up by the destructor
+          }
+          if (fds[0].revents) {
+            owner_->processEvents();
+          }
+        }
+        return NULL;
+      }
+    }; /* class StatusWatcherThread */
+  } /* namespace internal */
+
+  namespace
+  {
+    const uint32_t WATCH_EVENTS = IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM
+        | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+  }
+
+  FileStatusCache::FileStatusCache(unsigned int mask, int flags) :
+    mask_(mask), flags_(flags), inotify_fd_(-1), wakeup_fd_(-1), watcher_(NULL), generation_(0), hits_(0), misses_(0)
+  {
+    mask_ |= STATX_TYPE; // needed to recognize symbolic links and directories
+    pthread_mutex_init(&lock_, NULL);
+  }
+
+  FileStatusCache::~FileStatusCache()
+  {
+    if (watcher_) {
+      uint64_t one = 1;
+      if (write(wakeup_fd_, &one, sizeof(one)) == (ssize_t) sizeof(one)) {
+        watcher_->join();
+      }
+      else {
+        watcher_->cancel();
+        watcher_->join();
+      }
+      delete watcher_;
+    }
+    if (wakeup_fd_ >= 0) {
+      close(wakeup_fd_);
+    }
+    if (inotify_fd_ >= 0) {
+      close(inotify_fd_); // removes all watches
+    }
+    pthread_mutex_destroy(&lock_);
+  }
+
+  int FileStatusCache::init()
+  {
+    if (inotify_fd_ >= 0) {
+      return 0;
+    }
+    if ((inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0) {
+      return -1;
+    }
+    if (flags_ & FSC_WATCHER_THREAD) {
+      int ec;
+      if ((wakeup_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0) {
+        ec = errno;
+      }
+      else {
+        watcher_ = new internal::StatusWatcherThread(this);
+        if ((ec = watcher_->create()) == 0) {
+          return 0;
+        }
+        delete watcher_;
+        watcher_ = NULL;
+        close(wakeup_fd_);
+        wakeup_fd_ = -1;
+      }
+      close(inotify_fd_);
+      inotify_fd_ = -1;
+      errno = ec;
+      return -1;
+    }
+    return 0;
+  }
+
+  int FileStatusCache::processEvents()
+  {
+    if (inotify_fd_ < 0) {
+      errno = EBADF;
+      return -1;
+    }
+    char buf[16 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int count = 0;
+    for (;;) {
+      ssize_t len = read(inotify_fd_, buf, sizeof(buf));
+      if (len < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          return count;
+        }
+        return -1;
+      }
+      pthread_mutex_lock(&lock_);
+      for (char * p = buf; p < buf + len;) {
+        struct inotify_event * ev = (struct inotify_event *) p;
+        handleEvent(ev->wd, ev->mask, ev->len ? ev->name : NULL);
+        p += sizeof(struct inotify_event) + ev->len;
+        ++count;
+      }
+      pthread_mutex_unlock(&lock_);
+    }
+  }
+
+  int FileStatusCache::getFileStatus(const char * path, struct statx * buf)
+  {
+    if (inotify_fd_ < 0) {
+      pthread_mutex_lock(&lock_);
+      ++misses_;
+      pthread_mutex_unlock(&lock_);
+      return FileSystem::getFileStatusX(path, mask_, buf, flags_ & FSC_FOLLOW_LINK);
+    }
+
+    std::string key(path);
+    pthread_mutex_lock(&lock_);
+    EntryMap::const_iterator it = entries_.find(key);
+    if (it != entries_.end()) {
+      ++hits_;
+      int error = it->second.error;
+      if (!error) {
+        memcpy(buf, &it->second.sb, sizeof(*buf));
+      }
+      pthread_mutex_unlock(&lock_);
+      if (error) {
+        errno = error;
+        return -1;
+      }
+      return 0;
+    }
+    ++misses_;
+    // watch before fetching the status, so that no change can slip in between
+    bool cacheable = watchDirectory(key.substr(0, key.rfind('/') + 1)) == 0;
+    uint64_t generation = generation_;
+    pthread_mutex_unlock(&lock_);
+
+    Entry entry;
+    int rc = FileSystem::getFileStatusX(path, mask_, &entry.sb, false);
+    if (rc == 0 && (flags_ & FSC_FOLLOW_LINK) && S_ISLNK(entry.sb.stx_mode)) {
+      cacheable = false;
+      rc = FileSystem::getFileStatusX(path, mask_, &entry.sb, true);
+    }
+    if (rc == 0 && cacheable && S_ISDIR(entry.sb.stx_mode)) {
+      // entries created or removed in a directory change its own status, but
+      // raise no event on the watch of its parent
+      std::string self(key);
+      if (self.empty() || self[self.size() - 1] != '/') {
+        self += '/';
+      }
+      pthread_mutex_lock(&lock_);
+      bool watched = directories_.find(self) != directories_.end();
+      if (!watched) {
+        cacheable = watchDirectory(self) == 0;
+      }
+      pthread_mutex_unlock(&lock_);
+      if (!watched && cacheable) {
+        // fetched again, a change made before the watch was added is missed otherwise
+        rc = FileSystem::getFileStatusX(path, mask_, &entry.sb, false);
+      }
+    }
+    entry.error = rc < 0 ? errno : 0;
+
+    if (cacheable) {
+      pthread_mutex_lock(&lock_);
+      if (generation == generation_) { // otherwise the status might already be stale
+        entries_[key] = entry;
+      }
+      pthread_mutex_unlock(&lock_);
+    }
+    if (rc < 0) {
+      errno = entry.error;
+      return -1;
+    }
+    memcpy(buf, &entry.sb, sizeof(*buf));
+    return 0;
+  }
+
+  time_t FileStatusCache::mtime(const char * path)
+  {
+    struct statx buf;
+    if (getFileStatus(path, &buf) < 0) {
+      return ((time_t) -1);
+    }
+    return buf.stx_mtime.tv_sec;
+  }
+
+  void FileStatusCache::invalidate(const char * path)
+  {
+    pthread_mutex_lock(&lock_);
+    entries_.erase(path);
+    ++generation_;
+    pthread_mutex_unlock(&lock_);
+  }
+
+  void FileStatusCache::clear()
+  {
+    pthread_mutex_lock(&lock_);
+    entries_.clear();
+    ++generation_;
+    pthread_mutex_unlock(&lock_);
+  }
+
+  size_t FileStatusCache::size()
+  {
+    pthread_mutex_lock(&lock_);
+    size_t n = entries_.size();
+    pthread_mutex_unlock(&lock_);
+    return n;
+  }
+
+  uint64_t FileStatusCache::hits()
+  {
+    pthread_mutex_lock(&lock_);
+    uint64_t n = hits_;
+    pthread_mutex_unlock(&lock_);
+    return n;
+  }
+
+  uint64_t FileStatusCache::misses()
+  {
+    pthread_mutex_lock(&lock_);
+    uint64_t n = misses_;
+    pthread_mutex_unlock(&lock_);
+    return n;
+  }
+
+  /*
+   * Called with `lock_' held.
+   */
+  int FileStatusCache::watchDirectory(const std::string & prefix)
+  {
+    if (directories_.find(prefix) != directories_.end()) {
+      return 0;
+    }
+    int wd = inotify_add_watch(inotify_fd_, prefix.empty() ? "." : prefix.c_str(), WATCH_EVENTS);
+    if (wd < 0) {
+      return -1;
+    }
+    watches_.insert(std::make_pair(wd, prefix));
+    directories_[prefix] = wd;
+    return 0;
+  }
+
+  /*
+   * Called with `lock_' held, drops all entries whose path starts with `prefix'.
+   */
+  void FileStatusCache::invalidatePrefix(const std::string & prefix)
+  {
+    EntryMap::iterator it = entries_.lower_bound(prefix);
+    while (it != entries_.end() && !it->first.compare(0, prefix.size(), prefix)) {
+      entries_.erase(it++);
+    }
+  }
+
+  /*
+   * Called with `lock_' held.
+   */
+  void FileStatusCache::handleEvent(int wd, uint32_t mask, const char * name)
+  {
+    ++generation_;
+    if (mask & IN_Q_OVERFLOW) {
+      entries_.clear();
+      return;
+    }
+    std::pair<WatchMap::iterator, WatchMap::iterator> range = watches_.equal_range(wd);
+    for (WatchMap::iterator it = range.first; it != range.second; ++it) {
+      const std::string & prefix = it->second;
+      if (name && !(mask & IN_IGNORED)) {
+        entries_.erase(prefix + name);
+        // the directory itself was modified as well, under whichever name it was cached
+        entries_.erase(prefix);
+        if (prefix.empty()) {
+          entries_.erase(".");
+        }
+        else if (prefix.size() > 1) {
+          entries_.erase(prefix.substr(0, prefix.size() - 1));
+        }
+      }
+      else {
+        invalidatePrefix(prefix); // the directory itself went away, or the watch is gone
+      }
+    }
+    if (mask & IN_IGNORED) {
+      for (WatchMap::iterator it = range.first; it != range.second; ++it) {
+        directories_.erase(it->second);
+      }
+      watches_.erase(range.first, range.second);
+    }
+  }
+}
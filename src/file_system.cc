@@ -24,18 +24,851 @@
  * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+#include "nebula/attributes.h"
 #include "nebula/file_system.h"
+#include "nebula/hardwareinfo.h"
+#include "nebula/thread.h"
 
 namespace nebula
 {
+  namespace
+  {
+    struct LinuxDirent64
+    {
+      uint64_t d_ino;
+      int64_t d_off;
+      unsigned short d_reclen;
+      unsigned char d_type;
+      char d_name[];
+    };
+
+    class TreeWalker
+    {
+    private:
+      enum
+      {
+        DENTS_BUFFER_SIZE = (256 << 10), //
+        MAX_LOCAL_DEPTH = 64 // bounds number of open descriptors per thread
+      };
+
+      struct Job
+      {
+        std::string path; // ends with '/'
+        int depth;
+      };
+
+      int (*fn_)(const FileSystem::TreeEntry * entry, void * arg);
+      void * arg_;
+      int flags_;
+      int num_threads_;
+
+      pthread_mutex_t lock_;
+      pthread_cond_t cond_;
+      std::vector<Job *> jobs_;
+      int active_; // threads processing a job
+      int waiting_; // threads waiting for a job
+      int stop_;
+      int result_;
+
+      class Worker: public Thread
+      {
+      private:
+        TreeWalker * walker_;
+      public:
+        Worker(TreeWalker * walker = NULL) :
+          walker_(walker)
+        {
+        }
+
+        void setWalker(TreeWalker * walker)
+        {
+          walker_ = walker;
+        }
+
+        void * routine()
+        {
+          walker_->work();
+          return NULL;
+        }
+      };
+
+    public:
+      TreeWalker(int(*fn)(const FileSystem::TreeEntry * entry, void * arg), void * arg, int flags, int num_threads) :
+        fn_(fn), arg_(arg), flags_(flags), num_threads_(num_threads), active_(0), waiting_(0), stop_(0), result_(0)
+      {
+        pthread_mutex_init(&lock_, NULL);
+        pthread_cond_init(&cond_, NULL);
+      }
+
+      ~TreeWalker()
+      {
+        for (size_t i = 0; i < jobs_.size(); ++i) {
+          delete jobs_[i];
+        }
+        pthread_cond_destroy(&cond_);
+        pthread_mutex_destroy(&lock_);
+      }
+
+      int run(int root_fd, const char * root_path)
+      {
+        std::string path(root_path);
+        if (path.empty() || path[path.size() - 1] != '/') {
+          path += '/';
+        }
+
+        // the calling thread walks the top directory, then helps the others
+        active_ = 1;
+        Worker * workers = new Worker[num_threads_ - 1];
+        int started = 0;
+        while (started < num_threads_ - 1) {
+          workers[started].setWalker(this);
+          if (workers[started].create()) {
+            break;
+          }
+          ++started;
+        }
+
+        char * dents = (char *) malloc(DENTS_BUFFER_SIZE);
+        if (dents) {
+          walkDirectory(root_fd, &path, 1, 0, dents);
+          free(dents);
+        }
+        else {
+          close(root_fd);
+          stopWith(-1);
+        }
+        finishJob();
+        work();
+
+        for (int i = 0; i < started; ++i) {
+          workers[i].join();
+        }
+        delete[] workers;
+        return result_;
+      }
+
+      void work()
+      {
+        char * dents = (char *) malloc(DENTS_BUFFER_SIZE);
+        if (!dents) {
+          return;
+        }
+        Job * job;
+        while ((job = nextJob())) {
+          int fd = open(job->path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+          if (fd >= 0) {
+            walkDirectory(fd, &job->path, job->depth, 0, dents);
+          }
+          delete job;
+          finishJob();
+        }
+        free(dents);
+      }
+
+    private:
+      // hints peeked at without holding the lock
+      bool hasIdleThreads() const
+      {
+        return __atomic_load_n(&waiting_, __ATOMIC_RELAXED) > 0;
+      }
+
+      bool stopped() const
+      {
+        return __atomic_load_n(&stop_, __ATOMIC_RELAXED) != 0;
+      }
+
+      Job * nextJob()
+      {
+        Job * job = NULL;
+        pthread_mutex_lock(&lock_);
+        __atomic_add_fetch(&waiting_, 1, __ATOMIC_RELAXED);
+        while (jobs_.empty() && active_ > 0 && !stop_) {
+          pthread_cond_wait(&cond_, &lock_);
+        }
+        __atomic_sub_fetch(&waiting_, 1, __ATOMIC_RELAXED);
+        if (!stop_ && !jobs_.empty()) {
+          job = jobs_.back();
+          jobs_.pop_back();
+          ++active_;
+        }
+        else {
+          pthread_cond_broadcast(&cond_);
+        }
+        pthread_mutex_unlock(&lock_);
+        return job;
+      }
+
+      void finishJob()
+      {
+        pthread_mutex_lock(&lock_);
+        if (--active_ == 0 && jobs_.empty()) {
+          pthread_cond_broadcast(&cond_);
+        }
+        pthread_mutex_unlock(&lock_);
+      }
+
+      void shareJob(const std::string & path, int depth)
+      {
+        Job * job = new Job;
+        job->path = path;
+        job->depth = depth;
+        pthread_mutex_lock(&lock_);
+        jobs_.push_back(job);
+        pthread_cond_signal(&cond_);
+        pthread_mutex_unlock(&lock_);
+      }
+
+      void stopWith(int rc)
+      {
+        pthread_mutex_lock(&lock_);
+        if (!stop_) {
+          __atomic_store_n(&stop_, 1, __ATOMIC_RELAXED);
+          result_ = rc;
+        }
+        pthread_cond_broadcast(&cond_);
+        pthread_mutex_unlock(&lock_);
+      }
+
+      /*
+       * Reports entries of directory `fd' (closed before returning), whose
+       * path is `*path'.  Subdirectories are handed over to idle threads, or
+       * walked by this thread after the whole directory has been read.
+       */
+      void walkDirectory(int fd, std::string * path, int depth, int local_depth, char * dents)
+      {
+        std::vector<std::string> subdirs;
+        FileSystem::TreeEntry entry;
+        struct stat sb;
+        entry.dir_fd = fd;
+        entry.depth = depth;
+        long nread;
+        while (!stopped() && (nread = syscall(SYS_getdents64, fd, dents, DENTS_BUFFER_SIZE)) > 0) {
+          for (long off = 0; off < nread && !stopped();) {
+            LinuxDirent64 * d = (LinuxDirent64 *) (dents + off);
+            off += d->d_reclen;
+            if (d->d_name[0] == '.' && (!d->d_name[1] || (d->d_name[1] == '.' && !d->d_name[2]))) {
+              continue;
+            }
+            entry.dir_path = path->c_str();
+            entry.dir_path_len = path->size();
+            entry.name = d->d_name;
+            entry.type = d->d_type;
+            entry.sb = NULL;
+            if ((flags_ & FileSystem::TW_STAT) || d->d_type == DT_UNKNOWN) {
+              if (fstatat(fd, d->d_name, &sb, AT_SYMLINK_NOFOLLOW) == 0) {
+                entry.sb = &sb;
+                entry.type = IFTODT(sb.st_mode);
+              }
+            }
+            int rc = (*fn_)(&entry, arg_);
+            if (rc == FileSystem::TW_CONTINUE && entry.type == DT_DIR) {
+              if (hasIdleThreads() || local_depth >= MAX_LOCAL_DEPTH) {
+                size_t saved = path->size();
+                path->append(d->d_name).append(1, '/');
+                shareJob(*path, depth + 1);
+                path->resize(saved);
+              }
+              else {
+                subdirs.push_back(d->d_name);
+              }
+            }
+            else if (rc != FileSystem::TW_CONTINUE && rc != FileSystem::TW_SKIP_SUBTREE) {
+              stopWith(rc);
+            }
+          }
+        }
+
+        for (size_t i = 0; i < subdirs.size() && !stopped(); ++i) {
+          size_t saved = path->size();
+          path->append(subdirs[i]).append(1, '/');
+          if (hasIdleThreads()) {
+            shareJob(*path, depth + 1); // some threads became idle meanwhile
+          }
+          else {
+            int sub_fd = openat(fd, subdirs[i].c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (sub_fd >= 0) {
+              walkDirectory(sub_fd, path, depth + 1, local_depth + 1, dents);
+            }
+          }
+          path->resize(saved);
+        }
+        close(fd);
+      }
+    }; /* class TreeWalker */
+  } /* anonymous namespace */
+
+  namespace
+  {
+    volatile int statx_unsupported = 0;
+
+    void toStatx(const struct stat * sb, struct statx * buf)
+    {
+      memset(buf, 0, sizeof(*buf));
+      buf->stx_mask = STATX_BASIC_STATS;
+      buf->stx_blksize = sb->st_blksize;
+      buf->stx_nlink = sb->st_nlink;
+      buf->stx_uid = sb->st_uid;
+      buf->stx_gid = sb->st_gid;
+      buf->stx_mode = sb->st_mode;
+      buf->stx_ino = sb->st_ino;
+      buf->stx_size = sb->st_size;
+      buf->stx_blocks = sb->st_blocks;
+      buf->stx_atime.tv_sec = sb->st_atim.tv_sec;
+      buf->stx_atime.tv_nsec = sb->st_atim.tv_nsec;
+      buf->stx_ctime.tv_sec = sb->st_ctim.tv_sec;
+      buf->stx_ctime.tv_nsec = sb->st_ctim.tv_nsec;
+      buf->stx_mtime.tv_sec = sb->st_mtim.tv_sec;
+      buf->stx_mtime.tv_nsec = sb->st_mtim.tv_nsec;
+      buf->stx_rdev_major = major(sb->st_rdev);
+      buf->stx_rdev_minor = minor(sb->st_rdev);
+      buf->stx_dev_major = major(sb->st_dev);
+      buf->stx_dev_minor = minor(sb->st_dev);
+    }
+  }
+
+  int FileSystem::getFileStatusX(const char * path, unsigned int mask, struct statx * buf, bool follow_link,
+    int dir_fd)
+  {
+    int at_flags = follow_link ? 0 : AT_SYMLINK_NOFOLLOW;
+    if (!statx_unsupported) {
+      if (statx(dir_fd, path, at_flags | AT_STATX_SYNC_AS_STAT, mask, buf) == 0) {
+        return 0;
+      }
+      if (errno != ENOSYS) {
+        return -1;
+      }
+      statx_unsupported = 1;
+    }
+    struct stat sb;
+    if (fstatat(dir_fd, path, &sb, at_flags) < 0) {
+      return -1;
+    }
+    toStatx(&sb, buf);
+    return 0;
+  }
+
+  int FileSystem::treeWalk(const char * dir_path, int(*fn)(const TreeEntry * entry, void * arg), void * fn_last_arg,
+    int num_threads, int flags)
+  {
+    int fd = open(dir_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+      return -1;
+    }
+    if (num_threads <= 0 && (num_threads = (int) HardwareInfo::numOfProcessors()) <= 0) {
+      num_threads = 1;
+    }
+    TreeWalker walker(fn, fn_last_arg, flags, num_threads);
+    return walker.run(fd, dir_path);
+  }
+
+  int FileSystem::parseMode(const char * mode, mode_t * result)
+  {
+    static const char letters[] = "rwxrwxrwx";
+    static const mode_t special[3] =
+    { S_ISUID, S_ISGID, S_ISVTX };
+    mode_t m = 0;
+    for (int i = 0; i < 9; ++i) {
+      char c = mode[i];
+      mode_t bit = (mode_t) 1 << (8 - i);
+      if (c == letters[i]) {
+        m |= bit;
+      }
+      else if (i % 3 == 2 && (c == (i == 8 ? 't' : 's') || c == (i == 8 ? 'T' : 'S'))) {
+        // lower case: special bit plus execute, upper case: special bit only
+        m |= special[i / 3] | (c >= 'a' ? bit : 0);
+      }
+      else if (c != '-') {
+        return -1;
+      }
+    }
+    if (mode[9] != '\0') {
+      return -1;
+    }
+    *result = m;
+    return 0;
+  }
+
+  int FileSystem::mkdir(const char * pathname, bool recursive, const char * mode)
+  {
+    mode_t m;
+    if (parseMode(mode, &m) < 0) {
+      errno = EINVAL;
+      return -1;
+    }
+    if (!recursive) {
+      return ::mkdir(pathname, m);
+    }
+    DirectoryCreator creator(m);
+    return creator.create(pathname);
+  }
+
+  int FileSystem::rmdir(const char * pathname, bool recursive)
+  {
+    if (!recursive) {
+      return ::rmdir(pathname);
+    }
+    struct stat sb;
+    if (lstat(pathname, &sb) < 0) {
+      return -1;
+    }
+    if (!S_ISDIR(sb.st_mode)) {
+      errno = ENOTDIR;
+      return -1;
+    }
+    return removeTree(pathname);
+  }
+
+  namespace
+  {
+    void recordError(FileSystem::RemoveProgress * progress, int error)
+    {
+      __sync_fetch_and_add(&progress->errors, 1);
+      __sync_bool_compare_and_swap(&progress->first_error, 0, error);
+    }
+
+    int removeEntry(const FileSystem::TreeEntry * entry, void * arg)
+    {
+      FileSystem::RemoveProgress * progress = (FileSystem::RemoveProgress *) arg;
+      if (entry->type == DT_DIR) {
+        // removed once the whole tree was walked and all of them are empty
+      }
+      else if (unlinkat(entry->dir_fd, entry->name, 0) == 0) {
+        __sync_fetch_and_add(&progress->files, 1);
+      }
+      else {
+        recordError(progress, errno);
+      }
+      return FileSystem::TW_CONTINUE;
+    }
+
+    enum
+    {
+      MAX_OPEN_DIRECTORIES = 64 // bounds number of open descriptors per thread
+    };
+
+    struct RemoveFrame
+    {
+      DIR * dir; // NULL while closed to bound the number of open descriptors
+      std::string name; // in the parent directory
+      dev_t dev;
+      ino_t ino;
+      std::set<std::string> failed; // subdirectories which could not be removed
+    };
+
+    bool isDotOrDotDot(const char * name)
+    {
+      return name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2]));
+    }
+
+    bool isSubdirectory(int fd, const struct dirent * d)
+    {
+      struct stat sb;
+      return d->d_type == DT_DIR || (d->d_type == DT_UNKNOWN //
+          && fstatat(fd, d->d_name, &sb, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(sb.st_mode));
+    }
+
+    /*
+     * Takes over `fd', which is closed on failure.
+     */
+    RemoveFrame * openFrame(int fd, const char * name)
+    {
+      struct stat sb;
+      DIR * dir = NULL;
+      if (fstat(fd, &sb) < 0 || !(dir = fdopendir(fd))) {
+        int ec = errno;
+        close(fd);
+        errno = ec;
+        return NULL;
+      }
+      RemoveFrame * frame = new RemoveFrame;
+      frame->dir = dir;
+      frame->name = name;
+      frame->dev = sb.st_dev;
+      frame->ino = sb.st_ino;
+      return frame;
+    }
+
+    /*
+     * Opens again the directory of `frame', closed meanwhile, as ".." of
+     * its subdirectory `child_fd'.
+     */
+    int reopenFrame(RemoveFrame * frame, int child_fd)
+    {
+      int fd = openat(child_fd, "..", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (fd < 0) {
+        return -1;
+      }
+      struct stat sb;
+      if (fstat(fd, &sb) < 0 || sb.st_dev != frame->dev || sb.st_ino != frame->ino) {
+        close(fd);
+        errno = ENOENT; // moved away meanwhile
+        return -1;
+      }
+      if (!(frame->dir = fdopendir(fd))) {
+        int ec = errno;
+        close(fd);
+        errno = ec;
+        return -1;
+      }
+      return 0;
+    }
+
+    /*
+     * Removes the subdirectories of directory `fd' (closed before
+     * returning), depth first, each relative to the descriptor of its
+     * parent, so that nothing is resolved by path again.  The descent uses
+     * an explicit stack and keeps only the deepest MAX_OPEN_DIRECTORIES
+     * directories open, a directory closed meanwhile is opened again as ".."
+     * of its child and read from the start, skipping the subdirectories
+     * which could not be removed.
+     */
+    void removeDirectories(int fd, FileSystem::RemoveProgress * progress)
+    {
+      RemoveFrame * root = openFrame(fd, "");
+      if (!root) {
+        recordError(progress, errno);
+        return;
+      }
+      std::vector<RemoveFrame *> stack(1, root);
+      size_t num_open = 1;
+      while (!stack.empty()) {
+        RemoveFrame * top = stack.back();
+        int top_fd = dirfd(top->dir);
+        struct dirent * d = readdir(top->dir);
+        if (d) {
+          if (isDotOrDotDot(d->d_name) || !isSubdirectory(top_fd, d) || top->failed.count(d->d_name)) {
+            continue; // non-directories could not be unlinked, already counted
+          }
+          int sub_fd = openat(top_fd, d->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+          RemoveFrame * sub = sub_fd < 0 ? NULL : openFrame(sub_fd, d->d_name);
+          if (!sub) {
+            recordError(progress, errno);
+            top->failed.insert(d->d_name);
+            continue;
+          }
+          stack.push_back(sub);
+          if (++num_open > MAX_OPEN_DIRECTORIES) {
+            RemoveFrame * shallowest = stack[stack.size() - num_open];
+            closedir(shallowest->dir);
+            shallowest->dir = NULL;
+            --num_open;
+          }
+          continue;
+        }
+
+        // all that could be removed from `top' is gone
+        stack.pop_back();
+        if (stack.empty()) {
+          closedir(top->dir);
+          delete top;
+          break;
+        }
+        RemoveFrame * parent = stack.back();
+        if (!parent->dir) {
+          if (reopenFrame(parent, top_fd) < 0) {
+            recordError(progress, errno);
+            closedir(top->dir);
+            delete top;
+            for (size_t i = 0; i < stack.size(); ++i) {
+              if (stack[i]->dir) {
+                closedir(stack[i]->dir);
+              }
+              delete stack[i];
+            }
+            return;
+          }
+          ++num_open;
+        }
+        closedir(top->dir);
+        --num_open;
+        if (unlinkat(dirfd(parent->dir), top->name.c_str(), AT_REMOVEDIR) == 0) {
+          __sync_fetch_and_add(&progress->directories, 1);
+        }
+        else {
+          recordError(progress, errno);
+          parent->failed.insert(top->name);
+        }
+        delete top;
+      }
+    }
+
+    /*
+     * Subdirectories of the top directory, handed out to the threads
+     * removing them.
+     */
+    struct RemovePass
+    {
+      int fd;
+      std::vector<std::string> names;
+      volatile size_t next;
+      FileSystem::RemoveProgress * progress;
+    };
+
+    void removeSubtrees(RemovePass * pass)
+    {
+      size_t i;
+      while ((i = __sync_fetch_and_add(&pass->next, 1)) < pass->names.size()) {
+        const char * name = pass->names[i].c_str();
+        int fd = openat(pass->fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) {
+          recordError(pass->progress, errno);
+          continue;
+        }
+        removeDirectories(fd, pass->progress);
+        if (unlinkat(pass->fd, name, AT_REMOVEDIR) == 0) {
+          __sync_fetch_and_add(&pass->progress->directories, 1);
+        }
+        else {
+          recordError(pass->progress, errno);
+        }
+      }
+    }
+
+    class SubtreeRemover: public Thread
+    {
+    private:
+      RemovePass * pass_;
+    public:
+      SubtreeRemover() :
+        pass_(NULL)
+      {
+      }
+
+      void setPass(RemovePass * pass)
+      {
+        pass_ = pass;
+      }
+
+      void * routine()
+      {
+        removeSubtrees(pass_);
+        return NULL;
+      }
+    };
+
+    /*
+     * Removes the subdirectories of `pathname', those of the top directory
+     * spread over `num_threads' threads, the calling thread included.
+     */
+    void removeDirectories(const char * pathname, FileSystem::RemoveProgress * progress, int num_threads)
+    {
+      int fd = open(pathname, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+      DIR * dir = fd < 0 ? NULL : fdopendir(fd);
+      if (!dir) {
+        recordError(progress, errno);
+        if (fd >= 0) {
+          close(fd);
+        }
+        return;
+      }
+      RemovePass pass;
+      pass.fd = fd;
+      pass.next = 0;
+      pass.progress = progress;
+      struct dirent * d;
+      while ((d = readdir(dir))) {
+        if (!isDotOrDotDot(d->d_name) && isSubdirectory(fd, d)) {
+          pass.names.push_back(d->d_name);
+        }
+      }
+
+      if (num_threads <= 0 && (num_threads = (int) HardwareInfo::numOfProcessors()) <= 0) {
+        num_threads = 1;
+      }
+      int num_workers = (int) std::min((size_t) num_threads, pass.names.size()) - 1;
+      SubtreeRemover * workers = num_workers > 0 ? new SubtreeRemover[num_workers] : NULL;
+      int started = 0;
+      while (started < num_workers) {
+        workers[started].setPass(&pass);
+        if (workers[started].create()) {
+          break;
+        }
+        ++started;
+      }
+      removeSubtrees(&pass);
+      for (int i = 0; i < started; ++i) {
+        workers[i].join();
+      }
+      delete[] workers;
+      closedir(dir);
+    }
+  }
+
+  int FileSystem::removeTree(const char * pathname, RemoveProgress * progress, int num_threads)
+  {
+    RemoveProgress local;
+    if (!progress) {
+      memset(&local, 0, sizeof(local));
+      progress = &local;
+    }
+    struct stat sb;
+    if (lstat(pathname, &sb) < 0) {
+      return -1;
+    }
+    if (!S_ISDIR(sb.st_mode)) {
+      if (unlink(pathname) < 0) {
+        recordError(progress, errno);
+        return -1;
+      }
+      __sync_fetch_and_add(&progress->files, 1);
+      return 0;
+    }
+
+    if (treeWalk(pathname, removeEntry, progress, num_threads) < 0) {
+      recordError(progress, errno);
+      return -1;
+    }
+
+    removeDirectories(pathname, progress, num_threads);
+    if (::rmdir(pathname) == 0) {
+      __sync_fetch_and_add(&progress->directories, 1);
+    }
+    else {
+      recordError(progress, errno);
+    }
+    if (progress->errors) {
+      errno = progress->first_error;
+      return -1;
+    }
+    return 0;
+  }
+
+  DirectoryCreator::DirectoryCreator(mode_t mode) :
+    mode_(mode)
+  {
+    pthread_mutex_init(&lock_, NULL);
+  }
+
+  DirectoryCreator::~DirectoryCreator()
+  {
+    pthread_mutex_destroy(&lock_);
+  }
+
+  int DirectoryCreator::create(const char * pathname)
+  {
+    std::string path(pathname);
+    while (path.size() > 1 && path[path.size() - 1] == '/') {
+      path.resize(path.size() - 1);
+    }
+    if (path.empty()) {
+      errno = ENOENT;
+      return -1;
+    }
+    // the longest prefix first, in the common case the parent already exists;
+    // done for a known directory as well, which may have been removed since
+    bool known = isKnown(path);
+    struct stat sb;
+    if (::mkdir(path.c_str(), mode_) == 0
+        || (errno == EEXIST && (known || (stat(path.c_str(), &sb) == 0 && S_ISDIR(sb.st_mode))))) {
+      if (!known) {
+        remember(path);
+      }
+      return 0;
+    }
+    if (errno != ENOENT) {
+      return -1;
+    }
+    if (known) {
+      clear(); // removed together with some of its ancestors
+    }
+
+    // resume from the deepest ancestor known to exist
+    size_t start = 0;
+    for (size_t pos = path.rfind('/'); pos != std::string::npos && pos > 0; pos = path.rfind('/', pos - 1)) {
+      if (isKnown(path.substr(0, pos))) {
+        start = pos + 1;
+        break;
+      }
+    }
+    if (createFrom(path, start) == 0) {
+      return 0;
+    }
+    if (errno == ENOENT && start > 0) {
+      clear(); // some known directory was removed
+      return createFrom(path, 0);
+    }
+    return -1;
+  }
+
+  void DirectoryCreator::clear()
+  {
+    pthread_mutex_lock(&lock_);
+    known_.clear();
+    pthread_mutex_unlock(&lock_);
+  }
+
+  size_t DirectoryCreator::size()
+  {
+    pthread_mutex_lock(&lock_);
+    size_t n = known_.size();
+    pthread_mutex_unlock(&lock_);
+    return n;
+  }
+
+  bool DirectoryCreator::isKnown(const std::string & path)
+  {
+    pthread_mutex_lock(&lock_);
+    bool found = known_.find(path) != known_.end();
+    pthread_mutex_unlock(&lock_);
+    return found;
+  }
+
+  void DirectoryCreator::remember(const std::string & path)
+  {
+    pthread_mutex_lock(&lock_);
+    known_.insert(path);
+    pthread_mutex_unlock(&lock_);
+  }
+
+  /*
+   * Creates every component of `path' from offset `start' on, intermediate
+   * directories are always writable and searchable by the owner.
+   */
+  int DirectoryCreator::createFrom(const std::string & path, size_t start)
+  {
+    struct stat sb;
+    size_t pos = start;
+    for (;;) {
+      pos = path.find('/', pos);
+      bool last = pos == std::string::npos;
+      size_t len = last ? path.size() : pos;
+      if (len > 0 && path[len - 1] != '/') { // skip the root and empty components
+        std::string prefix(path, 0, len);
+        mode_t mode = last ? mode_ : (mode_ | S_IWUSR | S_IXUSR);
+        if (::mkdir(prefix.c_str(), mode) < 0
+            && (errno != EEXIST || stat(prefix.c_str(), &sb) < 0 || !S_ISDIR(sb.st_mode))) {
+          if (errno == EEXIST) {
+            errno = ENOTDIR;
+          }
+          return -1;
+        }
+        remember(prefix);
+      }
+      if (last) {
+        return 0;
+      }
+      ++pos;
+    }
+  }
+
   int FileSystem::fileTreeTraversal(const char * dir_path, //
     int(*fn)(const char * fpath, const struct stat * sb, void * arg), //
     void * fn_last_arg)
   {
     int rc = 0;
     DIR * dir;
-    struct dirent entry;
-    struct dirent * result;
+    struct dirent * entry;
     struct stat entry_stat;
     char entry_path[PATH_MAX];
     size_t used;
@@ -46,12 +879,13 @@ namespace nebula
     if (!String::endsWith(entry_path, "/")) {
       used = String::strlcat(entry_path, "/", sizeof(entry_path));
     }
-    while (!readdir_r(dir, &entry, &result) && result) {
-      if (!strcmp(entry.d_name, "..") || !strcmp(entry.d_name, ".")) {
+    // readdir() is thread safe as long as `dir' is not shared, readdir_r() is deprecated
+    while ((entry = readdir(dir))) {
+      if (!strcmp(entry->d_name, "..") || !strcmp(entry->d_name, ".")) {
         continue;
       }
       entry_path[used] = '\0';
-      String::strlcat(entry_path, entry.d_name, sizeof(entry_path));
+      String::strlcat(entry_path, entry->d_name, sizeof(entry_path));
       if ((rc = lstat(entry_path, &entry_stat))//
           || (rc = (*fn)(entry_path, &entry_stat, fn_last_arg))) {
         break;
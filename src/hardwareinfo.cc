@@ -24,7 +24,18 @@
  * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <strings.h>
+#include <unistd.h>
+#include <set>
+#include <string>
+#include <utility>
 #include "nebula/hardwareinfo.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
 
 namespace nebula
 {
@@ -40,6 +51,105 @@ namespace nebula
   uint64_t HardwareInfo::cpu_cache_size_ = 0;
   uint64_t HardwareInfo::memory_total_ = 0;
   uint64_t HardwareInfo::swap_total_ = 0;
+  pthread_once_t HardwareInfo::topology_loaded_ = PTHREAD_ONCE_INIT;
+  CpuTopology * HardwareInfo::topology_ = NULL;
+  pthread_once_t HardwareInfo::features_probed_ = PTHREAD_ONCE_INIT;
+  uint64_t HardwareInfo::cpu_features_ = 0;
+  SimdLevel::Constants HardwareInfo::simd_level_ = SimdLevel::SCALAR;
+
+  const char * CpuFeature::toString(Constants v)
+  {
+    switch (v) {
+      case SSE2:
+        return "sse2";
+      case SSSE3:
+        return "ssse3";
+      case SSE41:
+        return "sse4.1";
+      case SSE42:
+        return "sse4.2";
+      case POPCNT:
+        return "popcnt";
+      case AVX:
+        return "avx";
+      case AVX2:
+        return "avx2";
+      case FMA:
+        return "fma";
+      case BMI1:
+        return "bmi1";
+      case BMI2:
+        return "bmi2";
+      case LZCNT:
+        return "lzcnt";
+      case AVX512F:
+        return "avx512f";
+      case AVX512DQ:
+        return "avx512dq";
+      case AVX512BW:
+        return "avx512bw";
+      case AVX512VL:
+        return "avx512vl";
+      case ERMS:
+        return "erms";
+      case RDTSCP:
+        return "rdtscp";
+      case INVARIANT_TSC:
+        return "invariant_tsc";
+      default:
+        return "<unknown>";
+    }
+  }
+
+  const char * SimdLevel::toString(Constants v)
+  {
+    switch (v) {
+      case SCALAR:
+        return "scalar";
+      case SSE42:
+        return "sse4.2";
+      case AVX2:
+        return "avx2";
+      case AVX512:
+        return "avx512";
+      default:
+        return "<unknown>";
+    }
+  }
+
+  int SimdLevel::parse(const char * s)
+  {
+    for (int i = SCALAR; i < NUM_LEVELS; ++i) {
+      if (!strcasecmp(s, toString((Constants) i))) {
+        return i;
+      }
+    }
+    if (s[0] >= '0' && s[0] < '0' + NUM_LEVELS && !s[1]) {
+      return s[0] - '0';
+    }
+    return -1;
+  }
+
+  uint64_t SimdLevel::requiredFeatures(Constants level)
+  {
+    uint64_t features = 0;
+    switch (level) {
+      case AVX512:
+        features |= CpuFeature::AVX512F | CpuFeature::AVX512DQ | CpuFeature::AVX512BW | CpuFeature::AVX512VL;
+        // no break
+      case AVX2:
+        features |= CpuFeature::AVX | CpuFeature::AVX2 | CpuFeature::FMA | CpuFeature::BMI1 | CpuFeature::BMI2
+            | CpuFeature::LZCNT;
+        // no break
+      case SSE42:
+        features |= CpuFeature::SSE2 | CpuFeature::SSSE3 | CpuFeature::SSE41 | CpuFeature::SSE42
+            | CpuFeature::POPCNT;
+        // no break
+      default:
+        break;
+    }
+    return features;
+  }
 
   void HardwareInfo::rightTrim(char * line)
   {
@@ -157,5 +267,525 @@ namespace nebula
     String::strlcpy(cpu_model_name_, "unknown", sizeof(cpu_model_name_));
     parseProcFiles();
 #endif
+    if (!num_of_processors_) {
+      // no "model name" lines, e.g. on most ARM kernels
+      long n = sysconf(_SC_NPROCESSORS_ONLN);
+      num_of_processors_ = n > 0 ? n : 1;
+    }
+  }
+
+  void HardwareInfo::loadTopology()
+  {
+    // never deleted, it may be used until the very end of the process
+    CpuTopology * topology = new CpuTopology();
+    topology->load();
+    topology_ = topology;
+  }
+
+  void HardwareInfo::probeCpuFeatures()
+  {
+    uint64_t features = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int max_leaf = __get_cpuid_max(0, NULL);
+    unsigned int max_ext_leaf = __get_cpuid_max(0x80000000, NULL);
+
+    if (max_leaf >= 1) {
+      __cpuid(1, eax, ebx, ecx, edx);
+      bool osxsave = ecx & (1 << 27);
+      uint64_t xcr0 = 0;
+      if (osxsave) {
+        uint32_t lo, hi;
+        __asm__ __volatile__ ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+        xcr0 = ((uint64_t) hi << 32) | lo;
+      }
+      bool ymm_saved = (xcr0 & 0x06) == 0x06; // XMM and YMM state
+      bool zmm_saved = (xcr0 & 0xe6) == 0xe6; // and opmask, ZMM0-15, ZMM16-31
+
+      if (edx & (1 << 26)) features |= CpuFeature::SSE2;
+      if (ecx & (1 << 9)) features |= CpuFeature::SSSE3;
+      if (ecx & (1 << 19)) features |= CpuFeature::SSE41;
+      if (ecx & (1 << 20)) features |= CpuFeature::SSE42;
+      if (ecx & (1 << 23)) features |= CpuFeature::POPCNT;
+      if (ymm_saved && (ecx & (1 << 28))) features |= CpuFeature::AVX;
+      if (ymm_saved && (ecx & (1 << 12))) features |= CpuFeature::FMA;
+
+      if (max_leaf >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        if (ymm_saved && (ebx & (1 << 5))) features |= CpuFeature::AVX2;
+        if (ebx & (1 << 3)) features |= CpuFeature::BMI1;
+        if (ebx & (1 << 8)) features |= CpuFeature::BMI2;
+        if (ebx & (1 << 9)) features |= CpuFeature::ERMS;
+        if (zmm_saved) {
+          if (ebx & (1 << 16)) features |= CpuFeature::AVX512F;
+          if (ebx & (1 << 17)) features |= CpuFeature::AVX512DQ;
+          if (ebx & (1 << 30)) features |= CpuFeature::AVX512BW;
+          if (ebx & (1U << 31)) features |= CpuFeature::AVX512VL;
+        }
+      }
+    }
+    if (max_ext_leaf >= 0x80000001) {
+      __cpuid(0x80000001, eax, ebx, ecx, edx);
+      if (ecx & (1 << 5)) features |= CpuFeature::LZCNT;
+      if (edx & (1 << 27)) features |= CpuFeature::RDTSCP;
+    }
+    if (max_ext_leaf >= 0x80000007) {
+      __cpuid(0x80000007, eax, ebx, ecx, edx);
+      if (edx & (1 << 8)) features |= CpuFeature::INVARIANT_TSC;
+    }
+#endif
+    cpu_features_ = features;
+
+    simd_level_ = SimdLevel::SCALAR;
+    for (int i = SimdLevel::SCALAR + 1; i < SimdLevel::NUM_LEVELS; ++i) {
+      uint64_t required = SimdLevel::requiredFeatures((SimdLevel::Constants) i);
+      if ((features & required) != required) {
+        break;
+      }
+      simd_level_ = (SimdLevel::Constants) i;
+    }
+  }
+
+  int HardwareInfo::parseCpuList(const char * list, cpu_set_t * cpus)
+  {
+    int count = 0;
+    const char * p = list;
+    while (*p && *p != '\n') {
+      char * end;
+      long first = strtol(p, &end, 10);
+      if (end == p || first < 0) {
+        return -1;
+      }
+      long last = first;
+      p = end;
+      if (*p == '-') {
+        last = strtol(p + 1, &end, 10);
+        if (end == p + 1 || last < first) {
+          return -1;
+        }
+        p = end;
+      }
+      for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+        CPU_SET(cpu, cpus);
+        ++count;
+      }
+      if (*p == ',') {
+        ++p;
+      }
+      else if (*p && *p != '\n') {
+        return -1;
+      }
+    }
+    return count;
+  }
+
+  int HardwareInfo::numaNodeCpus(int node, cpu_set_t * cpus)
+  {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE * fin = fopen(path, "r");
+    if (!fin) {
+      return -1;
+    }
+    char line[4096];
+    int count = -1;
+    if (fgets(line, sizeof(line), fin)) {
+      if ((count = parseCpuList(line, cpus)) < 0) {
+        errno = EINVAL;
+      }
+    }
+    else {
+      errno = EIO;
+    }
+    fclose(fin);
+    return count;
+  }
+
+  namespace
+  {
+    const char * SYS_CPU = "/sys/devices/system/cpu";
+    const char * SYS_NODE = "/sys/devices/system/node";
+
+    /*
+     * Reads the first line of `root'`path' into `buf', without the '\n'.
+     */
+    int readLine(const char * root, const std::string & path, char * buf, size_t buflen)
+    {
+      std::string full(root);
+      full += path;
+      FILE * fin = fopen(full.c_str(), "r");
+      if (!fin) {
+        return -1;
+      }
+      int rc = 0;
+      if (fgets(buf, buflen, fin)) {
+        buf[strcspn(buf, "\n")] = '\0';
+      }
+      else {
+        errno = EIO;
+        rc = -1;
+      }
+      fclose(fin);
+      return rc;
+    }
+
+    int readInt(const char * root, const std::string & path, int default_value)
+    {
+      char buf[64];
+      return readLine(root, path, buf, sizeof(buf)) < 0 ? default_value : atoi(buf);
+    }
+
+    int readCpuList(const char * root, const std::string & path, cpu_set_t * cpus)
+    {
+      char buf[4096];
+      CPU_ZERO(cpus);
+      return readLine(root, path, buf, sizeof(buf)) < 0 ? -1 : HardwareInfo::parseCpuList(buf, cpus);
+    }
+
+    /*
+     * "32K", "8192K", "32M" or plain bytes.
+     */
+    uint64_t parseSize(const char * s)
+    {
+      char * end;
+      uint64_t v = strtoull(s, &end, 10);
+      switch (*end) {
+        case 'K':
+        case 'k':
+          return v << 10;
+        case 'M':
+        case 'm':
+          return v << 20;
+        case 'G':
+        case 'g':
+          return v << 30;
+        default:
+          return v;
+      }
+    }
+
+    std::string numbered(const char * prefix, int n, const char * suffix)
+    {
+      char buf[256];
+      snprintf(buf, sizeof(buf), "%s%d%s", prefix, n, suffix);
+      return buf;
+    }
+  }
+
+  CpuTopology::CpuTopology() :
+    num_online_(0), num_allowed_(0), num_cores_(0), num_packages_(0), cpu_quota_(-1)
+  {
+  }
+
+  int CpuTopology::load(const char * root)
+  {
+    cpus_.clear();
+    caches_.clear();
+    nodes_.clear();
+    num_online_ = num_allowed_ = num_cores_ = num_packages_ = 0;
+    cpu_quota_ = -1;
+
+    cpu_set_t possible;
+    errno = 0;
+    if (readCpuList(root, std::string(SYS_CPU) + "/possible", &possible) <= 0
+        && readCpuList(root, std::string(SYS_CPU) + "/present", &possible) <= 0) {
+      if (!errno) {
+        errno = EINVAL;
+      }
+      return -1;
+    }
+    for (int i = 0; i < CPU_SETSIZE; ++i) {
+      if (CPU_ISSET(i, &possible)) {
+        Cpu cpu;
+        memset(&cpu, 0, sizeof(cpu));
+        cpu.id = -1;
+        cpus_.resize(i + 1, cpu);
+        cpus_[i].id = i;
+        cpus_[i].package = cpus_[i].core = cpus_[i].node = -1;
+      }
+    }
+
+    loadCpus(root);
+    loadCaches(root);
+    loadNodes(root);
+    loadAllowed(root);
+    loadQuota(root);
+    return 0;
+  }
+
+  void CpuTopology::loadCpus(const char * root)
+  {
+    cpu_set_t online;
+    if (readCpuList(root, std::string(SYS_CPU) + "/online", &online) < 0) {
+      for (size_t i = 0; i < cpus_.size(); ++i) {
+        if (cpus_[i].id >= 0) {
+          CPU_SET(i, &online);
+        }
+      }
+    }
+    std::set<int> packages;
+    std::set<std::pair<int, int> > cores;
+    for (size_t i = 0; i < cpus_.size(); ++i) {
+      Cpu & cpu = cpus_[i];
+      if (cpu.id < 0 || !CPU_ISSET(i, &online)) {
+        continue;
+      }
+      cpu.online = true;
+      ++num_online_;
+      std::string dir = numbered((std::string(SYS_CPU) + "/cpu").c_str(), (int) i, "/topology/");
+      cpu.package = readInt(root, dir + "physical_package_id", 0);
+      cpu.core = readInt(root, dir + "core_id", (int) i);
+      if (readCpuList(root, dir + "thread_siblings_list", &cpu.siblings) <= 0) {
+        CPU_ZERO(&cpu.siblings);
+        CPU_SET(i, &cpu.siblings);
+      }
+      packages.insert(cpu.package);
+      cores.insert(std::make_pair(cpu.package, cpu.core));
+    }
+    num_packages_ = packages.size();
+    num_cores_ = cores.size();
+  }
+
+  void CpuTopology::loadCaches(const char * root)
+  {
+    for (size_t i = 0; i < cpus_.size(); ++i) {
+      if (!cpus_[i].online) {
+        continue;
+      }
+      std::string cpu_dir = numbered((std::string(SYS_CPU) + "/cpu").c_str(), (int) i, "/cache/index");
+      for (int idx = 0;; ++idx) {
+        std::string dir = numbered(cpu_dir.c_str(), idx, "/");
+        char buf[64];
+        if (readLine(root, dir + "level", buf, sizeof(buf)) < 0) {
+          break;
+        }
+        Cache cache;
+        memset(&cache, 0, sizeof(cache));
+        cache.level = atoi(buf);
+        if (readLine(root, dir + "type", cache.type, sizeof(cache.type)) < 0) {
+          String::strlcpy(cache.type, "Unified", sizeof(cache.type));
+        }
+        cache.size = readLine(root, dir + "size", buf, sizeof(buf)) < 0 ? 0 : parseSize(buf);
+        cache.line_size = readInt(root, dir + "coherency_line_size", 0);
+        cache.ways = readInt(root, dir + "ways_of_associativity", 0);
+        if (readCpuList(root, dir + "shared_cpu_list", &cache.shared_cpus) <= 0) {
+          CPU_ZERO(&cache.shared_cpus);
+          CPU_SET(i, &cache.shared_cpus);
+        }
+        cache.num_sharing = CPU_COUNT(&cache.shared_cpus);
+
+        bool known = false;
+        for (size_t j = 0; j < caches_.size() && !known; ++j) {
+          known = caches_[j].level == cache.level && !strcmp(caches_[j].type, cache.type)
+              && CPU_EQUAL(&caches_[j].shared_cpus, &cache.shared_cpus);
+        }
+        if (!known) {
+          caches_.push_back(cache);
+        }
+      }
+    }
+  }
+
+  void CpuTopology::loadNodes(const char * root)
+  {
+    cpu_set_t online; // node ids use the same list format
+    if (readCpuList(root, std::string(SYS_NODE) + "/online", &online) <= 0
+        && readCpuList(root, std::string(SYS_NODE) + "/possible", &online) <= 0) {
+      return; // kernel without NUMA support
+    }
+    for (int n = 0; n < CPU_SETSIZE; ++n) {
+      if (!CPU_ISSET(n, &online)) {
+        continue;
+      }
+      Node node;
+      node.id = -1;
+      CPU_ZERO(&node.cpus);
+      node.memory_total = 0;
+      nodes_.resize(n + 1, node);
+
+      std::string dir = numbered((std::string(SYS_NODE) + "/node").c_str(), n, "/");
+      nodes_[n].id = n;
+      readCpuList(root, dir + "cpulist", &nodes_[n].cpus);
+      char buf[1024];
+      if (readLine(root, dir + "distance", buf, sizeof(buf)) == 0) {
+        char * p = buf;
+        char * end;
+        for (long d = strtol(p, &end, 10); end != p; d = strtol(p, &end, 10)) {
+          nodes_[n].distances.push_back((int) d);
+          p = end;
+        }
+      }
+      // "Node 0 MemTotal:       16384 kB" is not the first line everywhere
+      std::string meminfo(root);
+      meminfo += dir + "meminfo";
+      FILE * fin = fopen(meminfo.c_str(), "r");
+      if (fin) {
+        while (fgets(buf, sizeof(buf), fin)) {
+          char * pos = strstr(buf, "MemTotal:");
+          if (pos) {
+            nodes_[n].memory_total = strtoull(pos + strlen("MemTotal:"), NULL, 10) << 10;
+            break;
+          }
+        }
+        fclose(fin);
+      }
+      for (size_t i = 0; i < cpus_.size(); ++i) {
+        if (CPU_ISSET(i, &nodes_[n].cpus)) {
+          cpus_[i].node = n;
+        }
+      }
+    }
+  }
+
+  void CpuTopology::loadAllowed(const char * root)
+  {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool found = false;
+    std::string status(root);
+    status += "/proc/self/status";
+    FILE * fin = fopen(status.c_str(), "r");
+    if (fin) {
+      char buf[4096];
+      while (fgets(buf, sizeof(buf), fin)) {
+        if (strstr(buf, "Cpus_allowed_list:") == buf) {
+          char * p = buf + strlen("Cpus_allowed_list:");
+          p += strspn(p, " \t");
+          found = HardwareInfo::parseCpuList(p, &allowed) >= 0;
+          break;
+        }
+      }
+      fclose(fin);
+    }
+    for (size_t i = 0; i < cpus_.size(); ++i) {
+      cpus_[i].allowed = cpus_[i].online && (!found || CPU_ISSET(i, &allowed));
+      if (cpus_[i].allowed) {
+        ++num_allowed_;
+      }
+    }
+  }
+
+  void CpuTopology::loadQuota(const char * root)
+  {
+    std::string cgroup(root);
+    cgroup += "/proc/self/cgroup";
+    FILE * fin = fopen(cgroup.c_str(), "r");
+    if (!fin) {
+      return;
+    }
+    char buf[4096];
+    while (fgets(buf, sizeof(buf), fin)) {
+      buf[strcspn(buf, "\n")] = '\0';
+      // "hierarchy-ID:controller-list:path"
+      char * controllers = strchr(buf, ':');
+      char * path = controllers ? strchr(controllers + 1, ':') : NULL;
+      if (!path) {
+        continue;
+      }
+      *controllers++ = '\0';
+      *path++ = '\0';
+
+      std::string base(root);
+      bool v2 = !strcmp(buf, "0") && !*controllers;
+      if (v2) {
+        base += "/sys/fs/cgroup";
+      }
+      else {
+        bool has_cpu = false;
+        for (char * c = strtok(controllers, ","); c && !has_cpu; c = strtok(NULL, ",")) {
+          has_cpu = !strcmp(c, "cpu");
+        }
+        if (!has_cpu) {
+          continue;
+        }
+        base += "/sys/fs/cgroup/cpu,cpuacct";
+        if (access(base.c_str(), F_OK) < 0) {
+          base = std::string(root) + "/sys/fs/cgroup/cpu";
+        }
+      }
+
+      // the limit of every ancestor applies as well, the path may also not be visible in a namespace
+      std::string rel(path);
+      for (;;) {
+        std::string dir = base + (rel == "/" ? "" : rel);
+        double quota = -1;
+        if (v2) {
+          char line[128];
+          std::string full = dir + "/cpu.max";
+          FILE * f = fopen(full.c_str(), "r");
+          if (f) {
+            if (fgets(line, sizeof(line), f) && strncmp(line, "max", 3)) {
+              double q, period;
+              if (sscanf(line, "%lf %lf", &q, &period) == 2 && period > 0) {
+                quota = q / period;
+              }
+            }
+            fclose(f);
+          }
+        }
+        else {
+          int q = readInt("", dir + "/cpu.cfs_quota_us", -1);
+          int period = readInt("", dir + "/cpu.cfs_period_us", 0);
+          if (q > 0 && period > 0) {
+            quota = (double) q / period;
+          }
+        }
+        if (quota > 0 && (cpu_quota_ < 0 || quota < cpu_quota_)) {
+          cpu_quota_ = quota;
+        }
+        if (rel == "/" || rel.empty()) {
+          break;
+        }
+        size_t pos = rel.rfind('/');
+        rel = pos == 0 ? "/" : rel.substr(0, pos);
+      }
+    }
+    fclose(fin);
+  }
+
+  int CpuTopology::numNodes() const
+  {
+    int n = 0;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      if (nodes_[i].id >= 0) {
+        ++n;
+      }
+    }
+    return n;
+  }
+
+  int CpuTopology::distance(int from, int to) const
+  {
+    if (from < 0 || (size_t) from >= nodes_.size() || to < 0 || (size_t) to >= nodes_[from].distances.size()) {
+      return -1;
+    }
+    return nodes_[from].distances[to];
+  }
+
+  const CpuTopology::Cache * CpuTopology::cache(int level, int cpu, bool instruction) const
+  {
+    for (size_t i = 0; i < caches_.size(); ++i) {
+      const Cache & c = caches_[i];
+      if (c.level == level && CPU_ISSET(cpu, &c.shared_cpus)
+          && (instruction ? !strcmp(c.type, "Instruction") : strcmp(c.type, "Instruction"))) {
+        return &c;
+      }
+    }
+    return NULL;
+  }
+
+  int CpuTopology::cacheLineSize() const
+  {
+    const Cache * c = cache(1);
+    return c && c->line_size > 0 ? c->line_size : 64;
+  }
+
+  int CpuTopology::effectiveCpus() const
+  {
+    int n = num_allowed_ ? num_allowed_ : num_online_;
+    if (cpu_quota_ > 0 && ceil(cpu_quota_) < n) {
+      n = (int) ceil(cpu_quota_);
+    }
+    return n > 0 ? n : 1;
   }
 }
@@ -0,0 +1,383 @@
+/*
+ * io_buffer.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <vector>
+#include "nebula/io_buffer.h"
+#include "nebula/object_pool.h"
+
+namespace nebula
+{
+  namespace
+  {
+    pthread_once_t pool_created = PTHREAD_ONCE_INIT;
+    // never destroyed, blocks may be released until the process exits
+    SlabPool * block_pool = NULL;
+
+    void createPool()
+    {
+      SlabPool * pool = new (std::nothrow) SlabPool(IoBlock::STANDARD_SIZE, 64);
+      if (pool && pool->init(0, 4 << 20) == 0) {
+        block_pool = pool;
+      }
+      else {
+        // blocks come from malloc() then
+        delete pool;
+      }
+    }
+  }
+
+  IoBlock * IoBlock::create(size_t capacity)
+  {
+    (void) pthread_once(&pool_created, createPool);
+    bool pooled = capacity == standardCapacity() && block_pool;
+    IoBlock * b = (IoBlock *) (pooled ? block_pool->allocate() : ::malloc(sizeof(IoBlock) + capacity));
+    if (!b) {
+      errno = ENOMEM;
+      return NULL;
+    }
+    b->refs = 1;
+    b->capacity = capacity;
+    b->pooled = pooled;
+    return b;
+  }
+
+  void IoBlock::unref()
+  {
+    if (__atomic_sub_fetch(&refs, 1, __ATOMIC_ACQ_REL) == 0) {
+      if (pooled) {
+        block_pool->free(this);
+      }
+      else {
+        ::free(this);
+      }
+    }
+  }
+
+  size_t IoBuffer::tailRoom() const
+  {
+    if (slices_.empty()) {
+      return 0;
+    }
+    const IoSlice & s = slices_.back();
+    return s.block->exclusive() ? s.block->capacity - s.end : 0;
+  }
+
+  void IoBuffer::clear()
+  {
+    for (size_t i = 0; i < slices_.size(); ++i) {
+      slices_[i].block->unref();
+    }
+    slices_.clear();
+    size_ = 0;
+  }
+
+  void IoBuffer::swap(IoBuffer & other)
+  {
+    slices_.swap(other.slices_);
+    std::swap(size_, other.size_);
+  }
+
+  int IoBuffer::append(const void * data, size_t len)
+  {
+    const char * p = (const char *) data;
+    size_t room = std::min(tailRoom(), len);
+    size_t cap = IoBlock::standardCapacity();
+
+    // allocate everything first, so that a failure changes nothing
+    std::vector<IoBlock *> fresh;
+    size_t blocks = (len - room + cap - 1) / cap;
+    for (size_t i = 0; i < blocks; ++i) {
+      IoBlock * b = IoBlock::create();
+      if (!b) {
+        for (size_t j = 0; j < fresh.size(); ++j) {
+          fresh[j]->unref();
+        }
+        return -1;
+      }
+      fresh.push_back(b);
+    }
+
+    if (room) {
+      IoSlice & s = slices_.back();
+      ::memcpy(s.block->data() + s.end, p, room);
+      s.end += room;
+      p += room;
+    }
+    size_t left = len - room;
+    for (size_t i = 0; i < blocks; ++i) {
+      size_t n = std::min(left, cap);
+      ::memcpy(fresh[i]->data(), p, n);
+      IoSlice s = { fresh[i], 0, (uint32_t) n };
+      slices_.push_back(s);
+      p += n;
+      left -= n;
+    }
+    size_ += len;
+    return 0;
+  }
+
+  int IoBuffer::prepend(const void * data, size_t len)
+  {
+    if (!len) {
+      return 0;
+    }
+    if (!slices_.empty() && slices_.front().begin >= len && slices_.front().block->exclusive()) {
+      IoSlice & s = slices_.front();
+      s.begin -= len;
+      ::memcpy(s.block->data() + s.begin, data, len);
+      size_ += len;
+      return 0;
+    }
+
+    // fill blocks from their end, so that the next prepend() has room
+    IoBuffer front;
+    size_t cap = IoBlock::standardCapacity();
+    const char * p = (const char *) data;
+    for (size_t left = len; left;) {
+      size_t n = left % cap ? left % cap : cap;
+      IoBlock * b = IoBlock::create();
+      if (!b) {
+        return -1;
+      }
+      ::memcpy(b->data() + cap - n, p, n);
+      IoSlice s = { b, (uint32_t) (cap - n), (uint32_t) cap };
+      front.slices_.push_back(s);
+      front.size_ += n;
+      p += n;
+      left -= n;
+    }
+    front.append(*this);
+    swap(front);
+    return 0;
+  }
+
+  void IoBuffer::append(IoBuffer & other)
+  {
+    if (&other == this) {
+      return;
+    }
+    slices_.insert(slices_.end(), other.slices_.begin(), other.slices_.end());
+    size_ += other.size_;
+    other.slices_.clear();
+    other.size_ = 0;
+  }
+
+  void IoBuffer::appendShared(const IoBuffer & other)
+  {
+    // copied first, `other' may be this buffer
+    std::vector<IoSlice> shared(other.slices_.begin(), other.slices_.end());
+    for (size_t i = 0; i < shared.size(); ++i) {
+      shared[i].block->ref();
+      slices_.push_back(shared[i]);
+    }
+    size_ += other.size_;
+  }
+
+  void IoBuffer::split(size_t len, IoBuffer * front)
+  {
+    len = std::min(len, size_);
+    size_ -= len;
+    front->size_ += len;
+    while (len) {
+      IoSlice & s = slices_.front();
+      if (s.size() <= len) {
+        len -= s.size();
+        front->slices_.push_back(s);
+        slices_.pop_front();
+      }
+      else {
+        s.block->ref();
+        IoSlice head = { s.block, s.begin, (uint32_t) (s.begin + len) };
+        front->slices_.push_back(head);
+        s.begin += len;
+        len = 0;
+      }
+    }
+  }
+
+  void IoBuffer::consume(size_t len)
+  {
+    len = std::min(len, size_);
+    size_ -= len;
+    while (len) {
+      IoSlice & s = slices_.front();
+      if (s.size() <= len) {
+        len -= s.size();
+        s.block->unref();
+        slices_.pop_front();
+      }
+      else {
+        s.begin += len;
+        len = 0;
+      }
+    }
+  }
+
+  size_t IoBuffer::copyOut(void * dst, size_t len) const
+  {
+    char * p = (char *) dst;
+    size_t copied = 0;
+    for (size_t i = 0; i < slices_.size() && copied < len; ++i) {
+      size_t n = std::min(slices_[i].size(), len - copied);
+      ::memcpy(p + copied, slices_[i].data(), n);
+      copied += n;
+    }
+    return copied;
+  }
+
+  const char * IoBuffer::coalesce(size_t len)
+  {
+    static const char nothing = '\0';
+    len = std::min(len, size_);
+    if (!len) {
+      return &nothing;
+    }
+    if (slices_.front().size() >= len) {
+      return slices_.front().data();
+    }
+
+    IoBlock * b = IoBlock::create(std::max((size_t) IoBlock::standardCapacity(), len));
+    if (!b) {
+      return NULL;
+    }
+    copyOut(b->data(), len);
+    consume(len);
+    IoSlice s = { b, 0, (uint32_t) len };
+    slices_.push_front(s);
+    size_ += len;
+    return b->data();
+  }
+
+  size_t IoBuffer::peekIov(struct iovec * iov, size_t max) const
+  {
+    size_t n = std::min(max, slices_.size());
+    for (size_t i = 0; i < n; ++i) {
+      iov[i].iov_base = (void *) slices_[i].data();
+      iov[i].iov_len = slices_[i].size();
+    }
+    return n;
+  }
+
+  ssize_t IoBuffer::readFrom(int fd)
+  {
+    struct iovec iov[1 + READ_BLOCKS];
+    IoBlock * fresh[READ_BLOCKS];
+    size_t n = 0, num_fresh = 0;
+
+    size_t room = tailRoom();
+    if (room) {
+      IoSlice & s = slices_.back();
+      iov[n].iov_base = s.block->data() + s.end;
+      iov[n++].iov_len = room;
+    }
+    for (; num_fresh < READ_BLOCKS; ++num_fresh) {
+      IoBlock * b = IoBlock::create();
+      if (!b) {
+        break;
+      }
+      fresh[num_fresh] = b;
+      iov[n].iov_base = b->data();
+      iov[n++].iov_len = b->capacity;
+    }
+    if (!n) {
+      return -1;
+    }
+
+    ssize_t nr;
+    while ((nr = readv(fd, iov, n)) < 0 && errno == EINTR) {
+    }
+
+    size_t left = nr > 0 ? nr : 0;
+    size_ += left;
+    if (room) {
+      size_t k = std::min(room, left);
+      slices_.back().end += k;
+      left -= k;
+    }
+    for (size_t i = 0; i < num_fresh; ++i) {
+      if (left) {
+        size_t k = std::min((size_t) fresh[i]->capacity, left);
+        IoSlice s = { fresh[i], 0, (uint32_t) k };
+        slices_.push_back(s);
+        left -= k;
+      }
+      else {
+        fresh[i]->unref();
+      }
+    }
+    return nr;
+  }
+
+  ssize_t IoBuffer::writeTo(int fd)
+  {
+    struct iovec iov[MAX_IOV];
+    size_t n = peekIov(iov, MAX_IOV);
+    if (!n) {
+      return 0;
+    }
+    ssize_t nw;
+    while ((nw = writev(fd, iov, n)) < 0 && errno == EINTR) {
+    }
+    if (nw > 0) {
+      consume(nw);
+    }
+    return nw;
+  }
+
+  ssize_t IoBuffer::sendTo(int sockfd, size_t max)
+  {
+    struct iovec iov[MAX_IOV];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    size_t n = peekIov(iov, MAX_IOV);
+    for (size_t i = 0; i < n; ++i) {
+      if (iov[i].iov_len >= max) {
+        iov[i].iov_len = max;
+        n = i + 1;
+        break;
+      }
+      max -= iov[i].iov_len;
+    }
+    if (!n || !iov[n - 1].iov_len) {
+      return 0;
+    }
+    msg.msg_iovlen = n;
+    ssize_t nw;
+    while ((nw = sendmsg(sockfd, &msg, MSG_NOSIGNAL)) < 0 && errno == EINTR) {
+    }
+    if (nw > 0) {
+      consume(nw);
+    }
+    return nw;
+  }
+}
@@ -0,0 +1,108 @@
+/*
+ * multiversion.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include "nebula/multiversion.h"
+
+namespace nebula
+{
+  MultiversionBase * MultiversionBase::head_ = NULL;
+  pthread_mutex_t MultiversionBase::lock_ = PTHREAD_MUTEX_INITIALIZER;
+  pthread_once_t MultiversionBase::limit_read_ = PTHREAD_ONCE_INIT;
+  int MultiversionBase::limit_ = SimdLevel::NUM_LEVELS - 1;
+
+  void MultiversionBase::attach()
+  {
+    pthread_mutex_lock(&lock_);
+    if (attached_) {
+      pthread_mutex_unlock(&lock_);
+      return;
+    }
+    resolve(level());
+    attached_ = true;
+    prev_ = NULL;
+    next_ = head_;
+    if (head_) {
+      head_->prev_ = this;
+    }
+    head_ = this;
+    pthread_mutex_unlock(&lock_);
+  }
+
+  void MultiversionBase::detach()
+  {
+    pthread_mutex_lock(&lock_);
+    if (!attached_) {
+      pthread_mutex_unlock(&lock_);
+      return;
+    }
+    attached_ = false;
+    if (prev_) {
+      prev_->next_ = next_;
+    }
+    else {
+      head_ = next_;
+    }
+    if (next_) {
+      next_->prev_ = prev_;
+    }
+    pthread_mutex_unlock(&lock_);
+  }
+
+  void MultiversionBase::readLimit()
+  {
+    const char * env = getenv("NEBULA_SIMD_LEVEL");
+    int limit = env ? SimdLevel::parse(env) : -1;
+    if (limit >= 0) {
+      limit_ = limit;
+    }
+  }
+
+  SimdLevel::Constants MultiversionBase::levelLimit()
+  {
+    (void) pthread_once(&limit_read_, readLimit);
+    return (SimdLevel::Constants) __atomic_load_n(&limit_, __ATOMIC_RELAXED);
+  }
+
+  SimdLevel::Constants MultiversionBase::level()
+  {
+    SimdLevel::Constants machine = HardwareInfo::simdLevel();
+    SimdLevel::Constants limit = levelLimit();
+    return limit < machine ? limit : machine;
+  }
+
+  void MultiversionBase::limitLevel(SimdLevel::Constants limit)
+  {
+    (void) pthread_once(&limit_read_, readLimit);
+    pthread_mutex_lock(&lock_);
+    __atomic_store_n(&limit_, (int) limit, __ATOMIC_RELAXED);
+    SimdLevel::Constants current = level();
+    for (MultiversionBase * p = head_; p; p = p->next_) {
+      p->resolve(current);
+    }
+    pthread_mutex_unlock(&lock_);
+  }
+}
@@ -0,0 +1,298 @@
+/*
+ * object_pool.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "nebula/object_pool.h"
+
+namespace nebula
+{
+  SlabPool::SlabPool(size_t object_size, size_t align) :
+    object_size_(0), slab_size_(DEFAULT_SLAB_SIZE), flags_(0), initialized_(false), full_(NULL), empty_(NULL),
+        num_full_(0), num_full_blocks_(0), num_empty_(0), caches_(NULL), num_caches_(0), retired_allocs_(0),
+        retired_frees_(0), slab_ptr_(NULL), slab_end_(NULL), huge_page_slabs_(0)
+  {
+    // a free block is never linked through itself, but keep blocks apart
+    // enough for the alignment asked for
+    if (align < sizeof(void *)) {
+      align = sizeof(void *);
+    }
+    object_size_ = (object_size + align - 1) & ~(align - 1);
+  }
+
+  SlabPool::~SlabPool()
+  {
+    if (!initialized_) {
+      return;
+    }
+    pthread_key_delete(key_);
+    while (caches_) {
+      ThreadCache * c = caches_;
+      caches_ = c->next_cache;
+      ::free(c->loaded);
+      ::free(c->previous);
+      delete c;
+    }
+    Magazine * lists[2] = { full_, empty_ };
+    for (int i = 0; i < 2; ++i) {
+      while (lists[i]) {
+        Magazine * m = lists[i];
+        lists[i] = m->next;
+        ::free(m);
+      }
+    }
+    for (size_t i = 0; i < slabs_.size(); ++i) {
+      munmap(slabs_[i].first, slabs_[i].second);
+    }
+  }
+
+  int SlabPool::init(int flags, size_t slab_size)
+  {
+    if (initialized_) {
+      errno = EINVAL;
+      return -1;
+    }
+    if (flags & HUGE_PAGES) {
+      slab_size = (slab_size + HUGE_PAGE_SIZE - 1) & ~((size_t) HUGE_PAGE_SIZE - 1);
+    }
+    // at least one full magazine per slab
+    if (slab_size < object_size_ * MAGAZINE_SIZE) {
+      slab_size = object_size_ * MAGAZINE_SIZE;
+    }
+    int rc = pthread_key_create(&key_, threadExit);
+    if (rc) {
+      errno = rc;
+      return -1;
+    }
+    flags_ = flags;
+    slab_size_ = slab_size;
+    initialized_ = true;
+    return 0;
+  }
+
+  SlabPool::ThreadCache * SlabPool::attach()
+  {
+    ThreadCache * c = new (std::nothrow) ThreadCache();
+    if (!c) {
+      return NULL;
+    }
+    c->loaded = (Magazine *) ::malloc(sizeof(Magazine));
+    c->previous = (Magazine *) ::malloc(sizeof(Magazine));
+    if (!c->loaded || !c->previous || pthread_setspecific(key_, c)) {
+      ::free(c->loaded);
+      ::free(c->previous);
+      delete c;
+      return NULL;
+    }
+    c->loaded->count = 0;
+    c->previous->count = 0;
+    c->pool = this;
+
+    ScopedLock<AdaptiveMutex> guard(lock_);
+    c->prev_cache = NULL;
+    c->next_cache = caches_;
+    if (caches_) {
+      caches_->prev_cache = c;
+    }
+    caches_ = c;
+    ++num_caches_;
+    return c;
+  }
+
+  void SlabPool::detach(ThreadCache * c)
+  {
+    {
+      ScopedLock<AdaptiveMutex> guard(lock_);
+      Magazine * mags[2] = { c->loaded, c->previous };
+      for (int i = 0; i < 2; ++i) {
+        Magazine * m = mags[i];
+        if (m->count) {
+          m->next = full_;
+          full_ = m;
+          ++num_full_;
+          num_full_blocks_ += m->count;
+        }
+        else {
+          m->next = empty_;
+          empty_ = m;
+          ++num_empty_;
+        }
+      }
+      retired_allocs_ += c->allocs;
+      retired_frees_ += c->frees;
+      if (c->prev_cache) {
+        c->prev_cache->next_cache = c->next_cache;
+      }
+      else {
+        caches_ = c->next_cache;
+      }
+      if (c->next_cache) {
+        c->next_cache->prev_cache = c->prev_cache;
+      }
+      --num_caches_;
+    }
+    delete c;
+  }
+
+  void SlabPool::threadExit(void * cache)
+  {
+    ThreadCache * c = (ThreadCache *) cache;
+    c->pool->detach(c);
+  }
+
+  int SlabPool::mapSlab()
+  {
+    void * p = MAP_FAILED;
+    bool huge = false;
+    if (flags_ & HUGE_PAGES) {
+      p = mmap(NULL, slab_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      huge = p != MAP_FAILED;
+    }
+    if (p == MAP_FAILED) {
+      p = mmap(NULL, slab_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (p == MAP_FAILED) {
+        errno = ENOMEM;
+        return -1;
+      }
+#ifdef MADV_HUGEPAGE
+      // no reserved huge pages, ask for transparent ones
+      if ((flags_ & HUGE_PAGES) && madvise(p, slab_size_, MADV_HUGEPAGE) == 0) {
+        huge = true;
+      }
+#endif
+    }
+    slabs_.push_back(std::make_pair(p, slab_size_));
+    huge_page_slabs_ += huge;
+    slab_ptr_ = (char *) p;
+    slab_end_ = slab_ptr_ + slab_size_;
+    return 0;
+  }
+
+  int SlabPool::refill(Magazine * m)
+  {
+    if ((size_t) (slab_end_ - slab_ptr_) < object_size_ && mapSlab() < 0) {
+      return -1;
+    }
+    while (m->count < MAGAZINE_SIZE && (size_t) (slab_end_ - slab_ptr_) >= object_size_) {
+      m->blocks[m->count++] = slab_ptr_;
+      slab_ptr_ += object_size_;
+    }
+    return 0;
+  }
+
+  void * SlabPool::allocateSlow(ThreadCache * c)
+  {
+    if (!c) {
+      errno = ENOMEM;
+      return NULL;
+    }
+    if (c->previous->count) {
+      std::swap(c->loaded, c->previous);
+    }
+    else {
+      ScopedLock<AdaptiveMutex> guard(lock_);
+      if (full_) {
+        // trade the empty previous magazine for a full one
+        Magazine * m = full_;
+        full_ = m->next;
+        --num_full_;
+        num_full_blocks_ -= m->count;
+        c->previous->next = empty_;
+        empty_ = c->previous;
+        ++num_empty_;
+        c->previous = c->loaded;
+        c->loaded = m;
+      }
+      else if (refill(c->loaded) < 0) {
+        return NULL;
+      }
+    }
+    __atomic_store_n(&c->allocs, c->allocs + 1, __ATOMIC_RELAXED);
+    return c->loaded->blocks[--c->loaded->count];
+  }
+
+  void SlabPool::freeSlow(ThreadCache * c, void * block)
+  {
+    if (c && !c->previous->count) {
+      std::swap(c->loaded, c->previous);
+    }
+    else {
+      ScopedLock<AdaptiveMutex> guard(lock_);
+      Magazine * m = empty_;
+      if (m) {
+        empty_ = m->next;
+        --num_empty_;
+      }
+      else if ((m = (Magazine *) ::malloc(sizeof(Magazine)))) {
+        m->count = 0;
+      }
+      else {
+        // nowhere to keep it, the block is lost until the pool goes away
+        return;
+      }
+      if (!c) {
+        m->blocks[m->count++] = block;
+        m->next = full_;
+        full_ = m;
+        ++num_full_;
+        ++num_full_blocks_;
+        ++retired_frees_;
+        return;
+      }
+      // trade the full previous magazine for an empty one
+      c->previous->next = full_;
+      full_ = c->previous;
+      ++num_full_;
+      num_full_blocks_ += c->previous->count;
+      c->previous = c->loaded;
+      c->loaded = m;
+    }
+    __atomic_store_n(&c->frees, c->frees + 1, __ATOMIC_RELAXED);
+    c->loaded->blocks[c->loaded->count++] = block;
+  }
+
+  ObjectPoolStats SlabPool::stats()
+  {
+    ObjectPoolStats s;
+    ScopedLock<AdaptiveMutex> guard(lock_);
+    uint64_t allocs = retired_allocs_, frees = retired_frees_;
+    for (ThreadCache * c = caches_; c; c = c->next_cache) {
+      allocs += __atomic_load_n(&c->allocs, __ATOMIC_RELAXED);
+      frees += __atomic_load_n(&c->frees, __ATOMIC_RELAXED);
+    }
+    s.object_size = object_size_;
+    s.live_objects = allocs >= frees ? allocs - frees : 0;
+    s.depot_magazines = num_full_;
+    s.depot_objects = num_full_blocks_;
+    s.empty_magazines = num_empty_;
+    s.threads = num_caches_;
+    s.slabs = slabs_.size();
+    s.huge_page_slabs = huge_page_slabs_;
+    s.slab_bytes = slabs_.size() * slab_size_;
+    return s;
+  }
+}
@@ -0,0 +1,173 @@
+/*
+ * random.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "nebula/attributes.h"
+#include "nebula/multiversion.h"
+#include "nebula/random.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace nebula
+{
+  namespace
+  {
+    typedef uint64_t LaneState[4][Xoshiro256x8::LANES];
+
+    INLINE uint64_t rotl(uint64_t x, int k)
+    {
+      return (x << k) | (x >> (64 - k));
+    }
+
+    /*
+     * Each kernel writes `blocks' * 8 values to `dst' (which need not be
+     * aligned) and leaves the lanes advanced by `blocks' steps.
+     */
+    void fillScalar(LaneState & s, char * dst, size_t blocks)
+    {
+      // one lane at a time, so that its state stays in registers
+      for (int k = 0; k < Xoshiro256x8::LANES; ++k) {
+        uint64_t s0 = s[0][k], s1 = s[1][k], s2 = s[2][k], s3 = s[3][k];
+        char * p = dst + k * sizeof(uint64_t);
+        for (size_t b = 0; b < blocks; ++b, p += Xoshiro256x8::BLOCK_SIZE) {
+          uint64_t result = rotl(s1 * 5, 7) * 9;
+          uint64_t t = s1 << 17;
+          s2 ^= s0;
+          s3 ^= s1;
+          s1 ^= s2;
+          s0 ^= s3;
+          s2 ^= t;
+          s3 = rotl(s3, 45);
+          memcpy(p, &result, sizeof(result));
+        }
+        s[0][k] = s0;
+        s[1][k] = s1;
+        s[2][k] = s2;
+        s[3][k] = s3;
+      }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    TARGET("avx2")
+    INLINE __m256i rotl256(__m256i x, int k)
+    {
+      return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+    }
+
+    TARGET("avx2")
+    void fillAvx2(LaneState & s, char * dst, size_t blocks)
+    {
+      // lanes 0-3 in the first register of every pair, 4-7 in the second
+      __m256i s0[2], s1[2], s2[2], s3[2];
+      for (int h = 0; h < 2; ++h) {
+        s0[h] = _mm256_load_si256((const __m256i *) &s[0][4 * h]);
+        s1[h] = _mm256_load_si256((const __m256i *) &s[1][4 * h]);
+        s2[h] = _mm256_load_si256((const __m256i *) &s[2][4 * h]);
+        s3[h] = _mm256_load_si256((const __m256i *) &s[3][4 * h]);
+      }
+      for (size_t b = 0; b < blocks; ++b, dst += Xoshiro256x8::BLOCK_SIZE) {
+        for (int h = 0; h < 2; ++h) {
+          // no 64 bit multiplication in AVX2: x * 5 = (x << 2) + x, x * 9 = (x << 3) + x
+          __m256i x = _mm256_add_epi64(_mm256_slli_epi64(s1[h], 2), s1[h]);
+          x = rotl256(x, 7);
+          __m256i result = _mm256_add_epi64(_mm256_slli_epi64(x, 3), x);
+          __m256i t = _mm256_slli_epi64(s1[h], 17);
+          s2[h] = _mm256_xor_si256(s2[h], s0[h]);
+          s3[h] = _mm256_xor_si256(s3[h], s1[h]);
+          s1[h] = _mm256_xor_si256(s1[h], s2[h]);
+          s0[h] = _mm256_xor_si256(s0[h], s3[h]);
+          s2[h] = _mm256_xor_si256(s2[h], t);
+          s3[h] = rotl256(s3[h], 45);
+          _mm256_storeu_si256((__m256i *) (dst + 32 * h), result);
+        }
+      }
+      for (int h = 0; h < 2; ++h) {
+        _mm256_store_si256((__m256i *) &s[0][4 * h], s0[h]);
+        _mm256_store_si256((__m256i *) &s[1][4 * h], s1[h]);
+        _mm256_store_si256((__m256i *) &s[2][4 * h], s2[h]);
+        _mm256_store_si256((__m256i *) &s[3][4 * h], s3[h]);
+      }
+    }
+
+    // GCC 12 warns about the deliberately undefined vector inside the AVX-512 shift intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+    TARGET("avx512f,avx512dq")
+    void fillAvx512(LaneState & s, char * dst, size_t blocks)
+    {
+      __m512i s0 = _mm512_load_si512((const void *) s[0]);
+      __m512i s1 = _mm512_load_si512((const void *) s[1]);
+      __m512i s2 = _mm512_load_si512((const void *) s[2]);
+      __m512i s3 = _mm512_load_si512((const void *) s[3]);
+      const __m512i five = _mm512_set1_epi64(5);
+      const __m512i nine = _mm512_set1_epi64(9);
+      for (size_t b = 0; b < blocks; ++b, dst += Xoshiro256x8::BLOCK_SIZE) {
+        __m512i result = _mm512_mullo_epi64(_mm512_rol_epi64(_mm512_mullo_epi64(s1, five), 7), nine);
+        __m512i t = _mm512_slli_epi64(s1, 17);
+        s2 = _mm512_xor_si512(s2, s0);
+        s3 = _mm512_xor_si512(s3, s1);
+        s1 = _mm512_xor_si512(s1, s2);
+        s0 = _mm512_xor_si512(s0, s3);
+        s2 = _mm512_xor_si512(s2, t);
+        s3 = _mm512_rol_epi64(s3, 45);
+        _mm512_storeu_si512((void *) dst, result);
+      }
+      _mm512_store_si512((void *) s[0], s0);
+      _mm512_store_si512((void *) s[1], s1);
+      _mm512_store_si512((void *) s[2], s2);
+      _mm512_store_si512((void *) s[3], s3);
+    }
+#pragma GCC diagnostic pop
+
+    Multiversion<void (*)(LaneState &, char *, size_t)> fill_impl(fillScalar, NULL, fillAvx2, fillAvx512);
+#else
+    Multiversion<void (*)(LaneState &, char *, size_t)> fill_impl(fillScalar, NULL, NULL, NULL);
+#endif
+  }
+
+  void Xoshiro256x8::initialize(uint64_t seed)
+  {
+    SplitMix64 sm(seed);
+    for (int k = 0; k < LANES; ++k) {
+      for (int w = 0; w < 4; ++w) {
+        s_[w][k] = sm.randomU64();
+      }
+    }
+  }
+
+  void Xoshiro256x8::fill(void * buf, size_t len)
+  {
+    char * dst = (char *) buf;
+    size_t blocks = len / BLOCK_SIZE;
+    fill_impl.get()(s_, dst, blocks);
+    len -= blocks * BLOCK_SIZE;
+    if (len) {
+      char last[BLOCK_SIZE];
+      fill_impl.get()(s_, last, 1);
+      memcpy(dst + blocks * BLOCK_SIZE, last, len);
+    }
+  }
+}
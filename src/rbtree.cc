@@ -0,0 +1,312 @@
+/*
+ * rbtree.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "nebula/rbtree.h"
+
+namespace nebula
+{
+  void RbTreeBase::replace(RbNode * old_child, RbNode * new_child, RbNode * parent)
+  {
+    if (!parent) {
+      root_ = new_child;
+    }
+    else if (parent->left == old_child) {
+      parent->left = new_child;
+    }
+    else {
+      parent->right = new_child;
+    }
+    if (new_child) {
+      new_child->parent = parent;
+    }
+  }
+
+  void RbTreeBase::rotateLeft(RbNode * x)
+  {
+    RbNode * y = x->right;
+    x->right = y->left;
+    if (y->left) {
+      y->left->parent = x;
+    }
+    replace(x, y, x->parent);
+    y->left = x;
+    x->parent = y;
+  }
+
+  void RbTreeBase::rotateRight(RbNode * x)
+  {
+    RbNode * y = x->left;
+    x->left = y->right;
+    if (y->right) {
+      y->right->parent = x;
+    }
+    replace(x, y, x->parent);
+    y->right = x;
+    x->parent = y;
+  }
+
+  void RbTreeBase::link(RbNode * node, RbNode * parent, bool left)
+  {
+    node->parent = parent;
+    node->left = node->right = NULL;
+    node->color = RED;
+    if (!parent) {
+      root_ = leftmost_ = node;
+    }
+    else if (left) {
+      parent->left = node;
+      if (parent == leftmost_) {
+        leftmost_ = node;
+      }
+    }
+    else {
+      parent->right = node;
+    }
+    ++size_;
+
+    RbNode * p;
+    while ((p = node->parent) && p->color == RED) {
+      RbNode * g = p->parent; // exists, the root is black
+      if (p == g->left) {
+        RbNode * uncle = g->right;
+        if (uncle && uncle->color == RED) {
+          p->color = uncle->color = BLACK;
+          g->color = RED;
+          node = g;
+          continue;
+        }
+        if (node == p->right) {
+          rotateLeft(p);
+          node = p;
+          p = node->parent;
+        }
+        p->color = BLACK;
+        g->color = RED;
+        rotateRight(g);
+      }
+      else {
+        RbNode * uncle = g->left;
+        if (uncle && uncle->color == RED) {
+          p->color = uncle->color = BLACK;
+          g->color = RED;
+          node = g;
+          continue;
+        }
+        if (node == p->left) {
+          rotateRight(p);
+          node = p;
+          p = node->parent;
+        }
+        p->color = BLACK;
+        g->color = RED;
+        rotateLeft(g);
+      }
+    }
+    root_->color = BLACK;
+  }
+
+  void RbTreeBase::unlink(RbNode * z)
+  {
+    if (z == leftmost_) {
+      leftmost_ = next(z);
+    }
+    --size_;
+
+    RbNode * x; // takes the place of the node actually removed from its position
+    RbNode * x_parent;
+    int removed_color = z->color;
+    if (!z->left || !z->right) {
+      x = z->left ? z->left : z->right;
+      x_parent = z->parent;
+      replace(z, x, z->parent);
+    }
+    else {
+      // the successor `y' takes the place of `z'
+      RbNode * y = z->right;
+      while (y->left) {
+        y = y->left;
+      }
+      removed_color = y->color;
+      x = y->right;
+      if (y->parent == z) {
+        x_parent = y;
+      }
+      else {
+        x_parent = y->parent;
+        replace(y, x, y->parent);
+        y->right = z->right;
+        y->right->parent = y;
+      }
+      replace(z, y, z->parent);
+      y->left = z->left;
+      y->left->parent = y;
+      y->color = z->color;
+    }
+    if (removed_color == RED) {
+      return;
+    }
+
+    // `x' is short of one black node
+    while (x != root_ && (!x || x->color == BLACK)) {
+      if (x == x_parent->left) {
+        RbNode * w = x_parent->right;
+        if (w->color == RED) {
+          w->color = BLACK;
+          x_parent->color = RED;
+          rotateLeft(x_parent);
+          w = x_parent->right;
+        }
+        if ((!w->left || w->left->color == BLACK) && (!w->right || w->right->color == BLACK)) {
+          w->color = RED;
+          x = x_parent;
+          x_parent = x->parent;
+        }
+        else {
+          if (!w->right || w->right->color == BLACK) {
+            w->left->color = BLACK;
+            w->color = RED;
+            rotateRight(w);
+            w = x_parent->right;
+          }
+          w->color = x_parent->color;
+          x_parent->color = BLACK;
+          if (w->right) {
+            w->right->color = BLACK;
+          }
+          rotateLeft(x_parent);
+          x = root_;
+        }
+      }
+      else {
+        RbNode * w = x_parent->left;
+        if (w->color == RED) {
+          w->color = BLACK;
+          x_parent->color = RED;
+          rotateRight(x_parent);
+          w = x_parent->left;
+        }
+        if ((!w->left || w->left->color == BLACK) && (!w->right || w->right->color == BLACK)) {
+          w->color = RED;
+          x = x_parent;
+          x_parent = x->parent;
+        }
+        else {
+          if (!w->left || w->left->color == BLACK) {
+            w->right->color = BLACK;
+            w->color = RED;
+            rotateLeft(w);
+            w = x_parent->left;
+          }
+          w->color = x_parent->color;
+          x_parent->color = BLACK;
+          if (w->left) {
+            w->left->color = BLACK;
+          }
+          rotateRight(x_parent);
+          x = root_;
+        }
+      }
+    }
+    if (x) {
+      x->color = BLACK;
+    }
+  }
+
+  RbNode * RbTreeBase::next(const RbNode * node)
+  {
+    if (node->right) {
+      RbNode * n = node->right;
+      while (n->left) {
+        n = n->left;
+      }
+      return n;
+    }
+    RbNode * p = node->parent;
+    while (p && node == p->right) {
+      node = p;
+      p = p->parent;
+    }
+    return p;
+  }
+
+  RbNode * RbTreeBase::prev(const RbNode * node)
+  {
+    if (node->left) {
+      RbNode * n = node->left;
+      while (n->right) {
+        n = n->right;
+      }
+      return n;
+    }
+    RbNode * p = node->parent;
+    while (p && node == p->left) {
+      node = p;
+      p = p->parent;
+    }
+    return p;
+  }
+
+  namespace
+  {
+    int verifySubtree(const RbNode * n, const RbNode * parent, size_t * count)
+    {
+      if (!n) {
+        return 1;
+      }
+      if (n->parent != parent) {
+        return -1;
+      }
+      if (n->color == RbTreeBase::RED && ((n->left && n->left->color == RbTreeBase::RED) //
+          || (n->right && n->right->color == RbTreeBase::RED))) {
+        return -1;
+      }
+      ++*count;
+      int left = verifySubtree(n->left, n, count);
+      int right = verifySubtree(n->right, n, count);
+      if (left < 0 || left != right) {
+        return -1;
+      }
+      return left + (n->color == RbTreeBase::BLACK);
+    }
+  }
+
+  int RbTreeBase::verify() const
+  {
+    if (root_ && root_->color != BLACK) {
+      return -1;
+    }
+    const RbNode * leftmost = root_;
+    while (leftmost && leftmost->left) {
+      leftmost = leftmost->left;
+    }
+    if (leftmost != leftmost_) {
+      return -1;
+    }
+    size_t count = 0;
+    int height = verifySubtree(root_, NULL, &count);
+    return count == size_ ? height : -1;
+  }
+}
@@ -0,0 +1,543 @@
+/*
+ * stream_reader.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+#include "nebula/attributes.h"
+#include "nebula/stream_reader.h"
+#include "nebula/string.h"
+#include "nebula/thread.h"
+
+namespace nebula
+{
+  namespace internal
+  {
+    struct StreamSource
+    {
+      int fd_;
+      bool own_fd_;
+      bool decompress_;
+      bool detected_;
+      volatile bool compressed_;
+      bool input_eof_;
+#ifdef USE_ZLIB
+      z_stream zs_;
+      bool zs_ready_;
+      unsigned char * zin_;
+      size_t zin_size_;
+#endif
+
+      StreamSource(int fd, bool own_fd, bool decompress) :
+        fd_(fd), own_fd_(own_fd), decompress_(decompress), detected_(false), compressed_(false), input_eof_(false)
+      {
+#ifdef USE_ZLIB
+        memset(&zs_, 0, sizeof(zs_));
+        zs_ready_ = false;
+        zin_ = NULL;
+        zin_size_ = 0;
+#endif
+      }
+
+      ~StreamSource()
+      {
+#ifdef USE_ZLIB
+        if (zs_ready_) {
+          inflateEnd(&zs_);
+        }
+        if (zin_) {
+          free(zin_);
+        }
+#endif
+        if (own_fd_ && fd_ >= 0) {
+          ::close(fd_);
+        }
+      }
+
+      /*
+       * Description:
+       *   read() which retries on EINTR and waits if `fd_' is in non-blocking
+       *   mode.  When called from the read-ahead thread this is the only place
+       *   where the thread may be cancelled.
+       */
+      ssize_t readSome(void * buf, size_t count, bool cancellable)
+      {
+        ssize_t nr;
+        int old_state;
+        for (;;) {
+          if (cancellable) {
+            pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_state);
+          }
+          nr = ::read(fd_, buf, count);
+          if (nr < 0 && errno == EAGAIN) {
+            struct pollfd pfd;
+            pfd.fd = fd_;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            (void) poll(&pfd, 1, -1);
+          }
+          if (cancellable) {
+            int saved = errno;
+            pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_state);
+            errno = saved;
+          }
+          if (nr >= 0 || (errno != EINTR && errno != EAGAIN)) {
+            return nr;
+          }
+        }
+      }
+
+      size_t fillRaw(char * buf, size_t capacity, bool * eof, int * error, bool cancellable)
+      {
+        size_t filled = 0;
+        while (filled < capacity) {
+          ssize_t nr = readSome(buf + filled, capacity - filled, cancellable);
+          if (nr < 0) {
+            *error = errno;
+            break;
+          }
+          if (nr == 0) {
+            input_eof_ = true;
+            *eof = true;
+            break;
+          }
+          filled += (size_t) nr;
+        }
+        return filled;
+      }
+
+#ifdef USE_ZLIB
+      bool startInflate(const char * data, size_t length, size_t capacity, int * error)
+      {
+        if (!(zin_ = (unsigned char *) malloc(capacity))) {
+          *error = ENOMEM;
+          return false;
+        }
+        zin_size_ = capacity;
+        memcpy(zin_, data, length);
+        if (inflateInit2(&zs_, 15 + 16) != Z_OK) { // gzip format only
+          *error = ENOMEM;
+          return false;
+        }
+        zs_ready_ = true;
+        zs_.next_in = zin_;
+        zs_.avail_in = (uInt) length;
+        return true;
+      }
+
+      bool refillInput(int * error, bool cancellable)
+      {
+        ssize_t nr = readSome(zin_, zin_size_, cancellable);
+        if (nr < 0) {
+          *error = errno;
+          return false;
+        }
+        if (nr == 0) {
+          input_eof_ = true;
+        }
+        zs_.next_in = zin_;
+        zs_.avail_in = (uInt) nr;
+        return true;
+      }
+
+      size_t fillInflated(char * buf, size_t capacity, bool * eof, int * error, bool cancellable)
+      {
+        zs_.next_out = (Bytef *) buf;
+        zs_.avail_out = (uInt) capacity;
+        while (zs_.avail_out) {
+          if (!zs_.avail_in && !input_eof_ && !refillInput(error, cancellable)) {
+            break;
+          }
+          int rc = inflate(&zs_, Z_NO_FLUSH);
+          if (rc == Z_STREAM_END) {
+            // concatenated gzip members are allowed, as gunzip(1) does
+            if (!zs_.avail_in && !input_eof_ && !refillInput(error, cancellable)) {
+              break;
+            }
+            if (!zs_.avail_in) {
+              *eof = true;
+              break;
+            }
+            inflateReset(&zs_);
+          }
+          else if (rc == Z_BUF_ERROR && !zs_.avail_in && input_eof_) {
+            *error = EIO; // truncated input
+            break;
+          }
+          else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            *error = (rc == Z_MEM_ERROR) ? ENOMEM : EIO;
+            break;
+          }
+        }
+        return capacity - zs_.avail_out;
+      }
+#endif
+
+      size_t fill(char * buf, size_t capacity, bool * eof, int * error, bool cancellable)
+      {
+        *eof = false;
+        *error = 0;
+        if (!detected_) {
+          detected_ = true;
+          size_t filled = fillRaw(buf, capacity, eof, error, cancellable);
+#ifdef USE_ZLIB
+          if (decompress_ && filled >= 2 && (unsigned char) buf[0] == 0x1f && (unsigned char) buf[1] == 0x8b) {
+            if (!startInflate(buf, filled, capacity, error)) {
+              return 0;
+            }
+            compressed_ = true;
+            *eof = false;
+            return fillInflated(buf, capacity, eof, error, cancellable);
+          }
+#endif
+          return filled;
+        }
+#ifdef USE_ZLIB
+        if (compressed_) {
+          return fillInflated(buf, capacity, eof, error, cancellable);
+        }
+#endif
+        return fillRaw(buf, capacity, eof, error, cancellable);
+      }
+    }; /* struct StreamSource */
+
+    class ReadAheadThread: public Thread
+    {
+    private:
+      StreamReader * owner_;
+      bool stopping_; // protected by owner_->lock_
+
+    public:
+      ReadAheadThread(StreamReader * owner) :
+        owner_(owner), stopping_(false)
+      {
+
+      }
+
+      void requestStop()
+      {
+        pthread_mutex_lock(&owner_->lock_);
+        stopping_ = true;
+        pthread_cond_broadcast(&owner_->cond_);
+        pthread_mutex_unlock(&owner_->lock_);
+      }
+
+      virtual void * routine()
+      {
+        int old_state;
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_state);
+        int idx = 0;
+        for (;;) {
+          StreamReader::Buffer * b = owner_->buffers_ + idx;
+          pthread_mutex_lock(&owner_->lock_);
+          while (b->full_ && !stopping_) {
+            pthread_cond_wait(&owner_->cond_, &owner_->lock_);
+          }
+          if (stopping_) {
+            pthread_mutex_unlock(&owner_->lock_);
+            break;
+          }
+          pthread_mutex_unlock(&owner_->lock_);
+
+          // the consumer never touches a buffer which is not full
+          b->length_ = owner_->source_->fill(b->data_, owner_->buffer_size_, &b->eof_, &b->error_, true);
+
+          pthread_mutex_lock(&owner_->lock_);
+          b->full_ = true;
+          pthread_cond_broadcast(&owner_->cond_);
+          pthread_mutex_unlock(&owner_->lock_);
+          if (b->eof_ || b->error_) {
+            break;
+          }
+          idx ^= 1;
+        }
+        return NULL;
+      }
+    }; /* class ReadAheadThread */
+  } /* namespace internal */
+
+  StreamReader::StreamReader(size_t buffer_size) :
+    buffer_size_(buffer_size < MIN_BUFFER_SIZE ? (size_t) MIN_BUFFER_SIZE : buffer_size), current_(-1), pos_(0),
+        carry_(NULL), carry_size_(0), error_(0), finished_(true), flags_(SR_NONE), source_(NULL), reader_(NULL)
+  {
+    memset(buffers_, 0, sizeof(buffers_));
+    name_[0] = '\0';
+    pthread_mutex_init(&lock_, NULL);
+    pthread_cond_init(&cond_, NULL);
+  }
+
+  StreamReader::~StreamReader()
+  {
+    close();
+    for (int i = 0; i < 2; ++i) {
+      if (buffers_[i].data_) {
+        free(buffers_[i].data_);
+      }
+    }
+    if (carry_) {
+      free(carry_);
+    }
+    pthread_cond_destroy(&cond_);
+    pthread_mutex_destroy(&lock_);
+  }
+
+  int StreamReader::open(const char * path, int flags)
+  {
+    if (!strcmp(path, "-")) {
+      return attach(STDIN_FILENO, flags, false, "-");
+    }
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return -1;
+    }
+    (void) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    // on failure attach() has closed `fd' already
+    return attach(fd, flags, true, path);
+  }
+
+  int StreamReader::attach(int fd, int flags, bool take_ownership, const char * name)
+  {
+    close();
+    if (flags & (~(SR_READ_AHEAD | SR_DECOMPRESS))) {
+      if (take_ownership) {
+        ::close(fd);
+      }
+      errno = EINVAL;
+      return -1;
+    }
+    // one extra byte, so that the last line can always be NUL terminated in place
+    for (int i = 0; i < 2; ++i) {
+      if (!buffers_[i].data_ && !(buffers_[i].data_ = (char *) malloc(buffer_size_ + 1))) {
+        if (take_ownership) {
+          ::close(fd);
+        }
+        errno = ENOMEM;
+        return -1;
+      }
+      buffers_[i].length_ = 0;
+      buffers_[i].error_ = 0;
+      buffers_[i].eof_ = false;
+      buffers_[i].full_ = false;
+    }
+    if (name) {
+      String::strlcpy(name_, name, sizeof(name_));
+    }
+    else {
+      snprintf(name_, sizeof(name_), "fd:%d", fd);
+    }
+    flags_ = flags;
+    current_ = -1;
+    pos_ = 0;
+    error_ = 0;
+    finished_ = false;
+    source_ = new internal::StreamSource(fd, take_ownership, (flags & SR_DECOMPRESS) != 0);
+    if (flags & SR_READ_AHEAD) {
+      reader_ = new internal::ReadAheadThread(this);
+      int rc;
+      if ((rc = reader_->create())) {
+        delete reader_;
+        reader_ = NULL;
+        close(); // closes `fd' through source_ if owned
+        errno = rc;
+        return -1;
+      }
+    }
+    return 0;
+  }
+
+  void StreamReader::close()
+  {
+    if (reader_) {
+      reader_->requestStop();
+      reader_->cancel(); // in case it is blocked in read()
+      reader_->join();
+      delete reader_;
+      reader_ = NULL;
+    }
+    if (source_) {
+      delete source_;
+      source_ = NULL;
+    }
+    current_ = -1;
+    pos_ = 0;
+    finished_ = true;
+  }
+
+  bool StreamReader::isCompressed() const
+  {
+    return source_ && source_->compressed_;
+  }
+
+  bool StreamReader::hasDecompressionSupport()
+  {
+#ifdef USE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void StreamReader::releaseBuffer()
+  {
+    if (reader_) {
+      pthread_mutex_lock(&lock_);
+      buffers_[current_].full_ = false;
+      pthread_cond_broadcast(&cond_);
+      pthread_mutex_unlock(&lock_);
+    }
+    else {
+      buffers_[current_].full_ = false;
+    }
+  }
+
+  bool StreamReader::nextBuffer()
+  {
+    if (finished_) {
+      return false;
+    }
+    int idx = 0;
+    if (current_ >= 0) {
+      Buffer * b = buffers_ + current_;
+      bool last = b->eof_ || b->error_;
+      error_ = b->error_;
+      releaseBuffer();
+      if (last) {
+        current_ = -1;
+        finished_ = true;
+        return false;
+      }
+      idx = reader_ ? (current_ ^ 1) : 0;
+    }
+
+    Buffer * b = buffers_ + idx;
+    if (reader_) {
+      pthread_mutex_lock(&lock_);
+      while (!b->full_) {
+        pthread_cond_wait(&cond_, &lock_);
+      }
+      pthread_mutex_unlock(&lock_);
+    }
+    else {
+      b->length_ = source_->fill(b->data_, buffer_size_, &b->eof_, &b->error_, false);
+      b->full_ = true;
+    }
+    current_ = idx;
+    pos_ = 0;
+    return true;
+  }
+
+  bool StreamReader::appendCarry(size_t used, const char * data, size_t length)
+  {
+    if (used + length + 1 > carry_size_) {
+      size_t new_size = carry_size_ ? carry_size_ : 256;
+      while (new_size < used + length + 1) {
+        new_size *= 2;
+      }
+      char * temp = (char *) realloc(carry_, new_size);
+      if (!temp) {
+        error_ = ENOMEM;
+        return false;
+      }
+      carry_ = temp;
+      carry_size_ = new_size;
+    }
+    memcpy(carry_ + used, data, length);
+    carry_[used + length] = '\0';
+    return true;
+  }
+
+  ssize_t StreamReader::readLine(char ** line)
+  {
+    size_t carried = 0;
+    for (;;) {
+      if (current_ < 0 || pos_ >= buffers_[current_].length_) {
+        if (!nextBuffer()) {
+          if (carried && !error_) {
+            *line = carry_;
+            return (ssize_t) carried;
+          }
+          return -1;
+        }
+        continue;
+      }
+
+      Buffer * b = buffers_ + current_;
+      char * start = b->data_ + pos_;
+      size_t avail = b->length_ - pos_;
+      char * nl = (char *) memchr(start, '\n', avail);
+      if (likely(nl != NULL)) {
+        size_t length = (size_t) (nl - start);
+        pos_ += length + 1;
+        if (likely(!carried)) {
+          *nl = '\0';
+          *line = start;
+          return (ssize_t) length;
+        }
+        if (!appendCarry(carried, start, length)) {
+          return -1;
+        }
+        *line = carry_;
+        return (ssize_t) (carried + length);
+      }
+
+      pos_ = b->length_;
+      if (!carried && (b->eof_ && !b->error_)) {
+        // last line of input without the trailing '\n'
+        start[avail] = '\0';
+        *line = start;
+        return (ssize_t) avail;
+      }
+      if (!appendCarry(carried, start, avail)) {
+        return -1;
+      }
+      carried += avail;
+    }
+  }
+
+  ssize_t StreamReader::readChunk(const char ** data)
+  {
+    if (current_ < 0 || pos_ >= buffers_[current_].length_) {
+      while (nextBuffer()) {
+        if (pos_ < buffers_[current_].length_) {
+          break;
+        }
+      }
+      if (current_ < 0) {
+        return error_ ? -1 : 0;
+      }
+    }
+    *data = buffers_[current_].data_ + pos_;
+    size_t length = buffers_[current_].length_ - pos_;
+    pos_ = buffers_[current_].length_;
+    return (ssize_t) length;
+  }
+}
@@ -24,10 +24,287 @@
  * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
+#include "nebula/attributes.h"
+#include "nebula/multiversion.h"
 #include "nebula/string.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 namespace nebula
 {
+  namespace
+  {
+    /*
+     * SWAR (SIMD within a register) helpers, `v' holds 8 characters loaded
+     * from memory in little endian order, i.e. the first character is in the
+     * lowest byte.
+     */
+    INLINE bool isEightDigits(uint64_t v)
+    {
+      return (((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+          == 0x3333333333333333ULL);
+    }
+
+    INLINE uint32_t parseEightDigits(uint64_t v)
+    {
+      v -= 0x3030303030303030ULL;
+      v = (v * 10) + (v >> 8); // pairs of digits
+      v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)))
+          + (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+      return (uint32_t) v;
+    }
+
+    /*
+     * Accumulates decimal digits starting at `p' into `*val', stops at the
+     * first non-digit character or when `*val' would overflow, `*num_digits'
+     * is increased by the number of digits consumed.
+     */
+    INLINE const char * accumulateDigits(const char * p, const char * end, uint64_t * val, int * num_digits,
+      bool * overflow)
+    {
+      uint64_t v = *val;
+      int n = 0;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+      // 19 decimal digits always fit in 64 bits
+      while (end - p >= 8 && *num_digits + n + 8 <= 19) {
+        uint64_t chunk;
+        memcpy(&chunk, p, sizeof(chunk));
+        if (!isEightDigits(chunk)) {
+          break;
+        }
+        v = v * 100000000ULL + parseEightDigits(chunk);
+        p += 8;
+        n += 8;
+      }
+#endif
+      while (p < end && (unsigned char) (*p - '0') < 10) {
+        if (__builtin_mul_overflow(v, (uint64_t) 10, &v) || __builtin_add_overflow(v, (uint64_t) (*p - '0'), &v)) {
+          *overflow = true;
+          break;
+        }
+        ++p;
+        ++n;
+      }
+      *val = v;
+      *num_digits += n;
+      return p;
+    }
+
+    INLINE bool suffixMultiplier(char c, uint64_t * multiplier)
+    {
+      switch (c) {
+        case 'K':
+          *multiplier = (1 << 10);
+          return true;
+        case 'k':
+          *multiplier = 1000;
+          return true;
+        case 'M':
+          *multiplier = (1 << 20);
+          return true;
+        case 'm':
+          *multiplier = 1000000;
+          return true;
+        case 'G':
+          *multiplier = (1 << 30);
+          return true;
+        case 'g':
+          *multiplier = 1000000000;
+          return true;
+        default:
+          return false;
+      }
+    }
+
+    String::ParseResult::Constants parseMagnitude(const char * p, const char * end, uint64_t * out,
+      bool parse_suffix)
+    {
+      uint64_t val = 0;
+      int num_digits = 0;
+      bool overflow = false;
+      p = accumulateDigits(p, end, &val, &num_digits, &overflow);
+      if (overflow) {
+        return String::ParseResult::OUT_OF_RANGE;
+      }
+      if (!num_digits) {
+        return String::ParseResult::INVALID_FORMAT;
+      }
+      if (p != end) {
+        uint64_t multiplier;
+        if (!parse_suffix || end - p != 1 || !suffixMultiplier(*p, &multiplier)) {
+          return String::ParseResult::INVALID_FORMAT;
+        }
+        if (__builtin_mul_overflow(val, multiplier, &val)) {
+          return String::ParseResult::OUT_OF_RANGE;
+        }
+      }
+      *out = val;
+      return String::ParseResult::SUCCESS;
+    }
+
+    const double exact_powers_of_ten[] =
+    { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+      1e20, 1e21, 1e22 };
+
+    locale_t cLocale()
+    {
+      static locale_t c_locale = newlocale(LC_ALL_MASK, "C", (locale_t) 0);
+      return c_locale;
+    }
+
+    String::ParseResult::Constants parseDoubleSlow(const char * s, size_t len, double * out)
+    {
+      // leading white spaces, which strtod() would skip
+      if (*s == ' ' || (unsigned char) (*s - '\t') <= '\r' - '\t') {
+        return String::ParseResult::INVALID_FORMAT;
+      }
+      char local_buf[128];
+      char * buf = local_buf;
+      if (len >= sizeof(local_buf) && !(buf = (char *) malloc(len + 1))) {
+        return String::ParseResult::NO_MEMORY;
+      }
+      memcpy(buf, s, len);
+      buf[len] = '\0';
+
+      String::ParseResult::Constants rc = String::ParseResult::SUCCESS;
+      char * ptr = NULL;
+      errno = 0;
+      double val = strtod_l(buf, &ptr, cLocale());
+      if (ptr != buf + len) {
+        rc = String::ParseResult::INVALID_FORMAT;
+      }
+      else if (errno == ERANGE && (val == HUGE_VAL || val == -HUGE_VAL)) {
+        rc = String::ParseResult::OUT_OF_RANGE;
+      }
+      else {
+        *out = val;
+      }
+      if (buf != local_buf) {
+        free(buf);
+      }
+      return rc;
+    }
+  } /* anonymous namespace */
+
+  String::ParseResult::Constants String::parseU64(const char * s, size_t len, uint64_t * out, bool parse_suffix)
+  {
+    if (!len) {
+      return ParseResult::EMPTY_INPUT;
+    }
+    const char * end = s + len;
+    if (*s == '+') {
+      ++s;
+    }
+    return parseMagnitude(s, end, out, parse_suffix);
+  }
+
+  String::ParseResult::Constants String::parseI64(const char * s, size_t len, int64_t * out, bool parse_suffix)
+  {
+    if (!len) {
+      return ParseResult::EMPTY_INPUT;
+    }
+    const char * end = s + len;
+    bool negative = false;
+    if (*s == '-' || *s == '+') {
+      negative = (*s == '-');
+      ++s;
+    }
+    uint64_t magnitude;
+    ParseResult::Constants rc = parseMagnitude(s, end, &magnitude, parse_suffix);
+    if (rc != ParseResult::SUCCESS) {
+      return rc;
+    }
+    if (negative) {
+      if (magnitude > ((uint64_t) INT64_MAX) + 1) {
+        return ParseResult::OUT_OF_RANGE;
+      }
+      *out = (int64_t) (0 - magnitude);
+    }
+    else {
+      if (magnitude > (uint64_t) INT64_MAX) {
+        return ParseResult::OUT_OF_RANGE;
+      }
+      *out = (int64_t) magnitude;
+    }
+    return ParseResult::SUCCESS;
+  }
+
+  String::ParseResult::Constants String::parseDouble(const char * s, size_t len, double * out)
+  {
+    if (!len) {
+      return ParseResult::EMPTY_INPUT;
+    }
+    const char * p = s;
+    const char * end = s + len;
+    bool negative = false;
+    if (*p == '-' || *p == '+') {
+      negative = (*p == '-');
+      ++p;
+    }
+
+    // mantissa, as an integer with at most 19 digits, and a decimal exponent
+    uint64_t mantissa = 0;
+    int num_digits = 0;
+    int frac_digits = 0;
+    bool overflow = false;
+    p = accumulateDigits(p, end, &mantissa, &num_digits, &overflow);
+    if (!overflow && p < end && *p == '.') {
+      ++p;
+      int before = num_digits;
+      p = accumulateDigits(p, end, &mantissa, &num_digits, &overflow);
+      frac_digits = num_digits - before;
+    }
+    if (overflow || !num_digits) {
+      // too many digits, or inf/nan/hex
+      return parseDoubleSlow(s, len, out);
+    }
+
+    int exponent = 0;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+      ++p;
+      bool negative_exp = false;
+      if (p < end && (*p == '-' || *p == '+')) {
+        negative_exp = (*p == '-');
+        ++p;
+      }
+      if (p == end || (unsigned char) (*p - '0') >= 10) {
+        return ParseResult::INVALID_FORMAT;
+      }
+      while (p < end && (unsigned char) (*p - '0') < 10) {
+        if (exponent < 100000) {
+          exponent = exponent * 10 + (*p - '0');
+        }
+        ++p;
+      }
+      if (negative_exp) {
+        exponent = -exponent;
+      }
+    }
+    if (p != end) {
+      return ParseResult::INVALID_FORMAT;
+    }
+    exponent -= frac_digits;
+
+    // both `mantissa' and 10^|exponent| are exactly representable, so is the result of one multiplication or
+    // division (Clinger's fast path)
+    if (likely(mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)) {
+      double val = (double) mantissa;
+      if (exponent < 0) {
+        val /= exact_powers_of_ten[-exponent];
+      }
+      else {
+        val *= exact_powers_of_ten[exponent];
+      }
+      *out = negative ? -val : val;
+      return ParseResult::SUCCESS;
+    }
+    return parseDoubleSlow(s, len, out);
+  }
+
   int64_t String::strToI64(const char * s, bool parse_suffix)
   {
     char * ptr = NULL;
@@ -114,6 +391,75 @@ namespace nebula
     return strncmp(src_str + la - lb, suffix, lb) == 0;
   }
 
+  namespace
+  {
+    size_t countCharScalar(const char * s, size_t len, char c)
+    {
+      size_t count = 0;
+      for (size_t i = 0; i < len; ++i) {
+        count += s[i] == c;
+      }
+      return count;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    TARGET("sse4.2,popcnt")
+    size_t countCharSse42(const char * s, size_t len, char c)
+    {
+      const __m128i needle = _mm_set1_epi8(c);
+      size_t count = 0;
+      size_t i = 0;
+      for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (s + i));
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+      }
+      return count + countCharScalar(s + i, len - i, c);
+    }
+
+    TARGET("avx2,popcnt")
+    size_t countCharAvx2(const char * s, size_t len, char c)
+    {
+      const __m256i needle = _mm256_set1_epi8(c);
+      size_t count = 0;
+      size_t i = 0;
+      for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (s + i));
+        count += __builtin_popcount((uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+      }
+      return count + countCharScalar(s + i, len - i, c);
+    }
+
+    TARGET("avx512f,avx512bw,popcnt")
+    size_t countCharAvx512(const char * s, size_t len, char c)
+    {
+      const __m512i needle = _mm512_set1_epi8(c);
+      size_t count = 0;
+      size_t i = 0;
+      for (; i + 64 <= len; i += 64) {
+        __m512i v = _mm512_loadu_si512((const void *) (s + i));
+        count += __builtin_popcountll(_mm512_cmpeq_epi8_mask(v, needle));
+      }
+      if (i < len) {
+        // masked load of the tail, never touches bytes past the end
+        __mmask64 tail = ~0ULL >> (64 - (len - i));
+        __m512i v = _mm512_maskz_loadu_epi8(tail, (const void *) (s + i));
+        count += __builtin_popcountll(_mm512_mask_cmpeq_epi8_mask(tail, v, needle));
+      }
+      return count;
+    }
+
+    Multiversion<size_t (*)(const char *, size_t, char)> count_char_impl(countCharScalar, countCharSse42,
+        countCharAvx2, countCharAvx512);
+#else
+    Multiversion<size_t (*)(const char *, size_t, char)> count_char_impl(countCharScalar, NULL, NULL, NULL);
+#endif
+  }
+
+  size_t String::countChar(const char * s, size_t len, char c)
+  {
+    return count_char_impl.get()(s, len, c);
+  }
+
   char * String::toUpperCase(char * input)
   {
     size_t len = strlen(input);
@@ -0,0 +1,85 @@
+/*
+ * thread.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include "nebula/hardwareinfo.h"
+#include "nebula/thread.h"
+
+namespace nebula
+{
+  namespace
+  {
+    // from <linux/mempolicy.h>, not installed everywhere
+    const int NEBULA_MPOL_PREFERRED = 1;
+    const int NEBULA_MPOL_BIND = 2;
+    const int MAX_NUMA_NODES = 1024;
+  }
+
+  int Thread::applySetup()
+  {
+    if (name_[0]) {
+      int ec = pthread_setname_np(pthread_self(), name_);
+      if (ec) {
+        return ec;
+      }
+    }
+
+    if (numa_node_ >= 0) {
+      if (numa_node_ >= MAX_NUMA_NODES) {
+        return EINVAL;
+      }
+      if (!has_affinity_) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        if (HardwareInfo::numaNodeCpus(numa_node_, &cpus) < 0) {
+          return errno;
+        }
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0) {
+          return errno;
+        }
+      }
+      // pages are allocated on first touch, this covers the rest of the stack as well
+      unsigned long nodes[MAX_NUMA_NODES / (8 * sizeof(unsigned long))];
+      memset(nodes, 0, sizeof(nodes));
+      nodes[numa_node_ / (8 * sizeof(unsigned long))] |= 1UL << (numa_node_ % (8 * sizeof(unsigned long)));
+      if (syscall(SYS_set_mempolicy, numa_strict_ ? NEBULA_MPOL_BIND : NEBULA_MPOL_PREFERRED, nodes,
+        MAX_NUMA_NODES + 1) < 0) {
+        return errno;
+      }
+    }
+
+    if (nice_ != NO_NICE) {
+      // the nice value is a per-thread attribute on Linux
+      if (setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), nice_) < 0) {
+        return errno;
+      }
+    }
+    return 0;
+  }
+}
@@ -0,0 +1,213 @@
+/*
+ * arena_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "nebula/arena.h"
+
+using nebula::Arena;
+using nebula::ArenaAllocator;
+using nebula::ArenaScope;
+
+namespace
+{
+  std::vector<int> destroyed;
+
+  struct Tracked
+  {
+    int id;
+    std::string name;
+
+    Tracked() :
+      id(0)
+    {
+    }
+
+    ~Tracked()
+    {
+      destroyed.push_back(id);
+    }
+  };
+
+  void * getThreadArena(void * arg)
+  {
+    *(Arena **) arg = Arena::threadLocal();
+    return NULL;
+  }
+}
+
+class ArenaTS: public testing::Test
+{
+};
+
+TEST_F(ArenaTS, caseAllocate)
+{
+  Arena arena(4096);
+  EXPECT_EQ(0u, arena.bytesAllocated());
+
+  const size_t aligns[] = { 1, 2, 4, 8, 16, 64, 256, 4096 };
+  for (size_t i = 0; i < sizeof(aligns) / sizeof(aligns[0]); ++i) {
+    for (size_t size = 0; size < 100; size += 7) {
+      void * p = arena.allocate(size, aligns[i]);
+      ASSERT_TRUE(p != NULL);
+      ASSERT_EQ(0u, (uintptr_t) p % aligns[i]);
+      memset(p, 0xa5, size);
+    }
+  }
+
+  // chained chunks, allocations do not overlap
+  std::vector<char *> blocks;
+  for (int i = 0; i < 1000; ++i) {
+    char * p = (char *) arena.allocate(100);
+    ASSERT_TRUE(p != NULL);
+    memset(p, i & 0xff, 100);
+    blocks.push_back(p);
+  }
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ((char) (i & 0xff), blocks[i][0]);
+    ASSERT_EQ((char) (i & 0xff), blocks[i][99]);
+  }
+  EXPECT_GE(arena.bytesAllocated(), 100000u);
+
+  char * s = arena.strdup("hello, world", 5);
+  EXPECT_STREQ("hello", s);
+  int * ints = arena.allocateArray<int>(10);
+  EXPECT_EQ(0u, (uintptr_t) ints % __alignof__(int));
+  EXPECT_TRUE(arena.allocateArray<int64_t>((size_t) -1 / 4) == NULL);
+}
+
+TEST_F(ArenaTS, caseMarkAndRewind)
+{
+  Arena arena(4096);
+  void * first = arena.allocate(16);
+  Arena::Mark m = arena.mark();
+  void * second = arena.allocate(16);
+  for (int i = 0; i < 100; ++i) {
+    arena.allocate(1000);
+  }
+  // a large allocation gets its own chunk, the current one stays in use
+  char * large = (char *) arena.allocate(100000);
+  ASSERT_TRUE(large != NULL);
+  memset(large, 0, 100000);
+  void * after_large = arena.allocate(16);
+  EXPECT_GE(arena.bytesAllocated(), 100 * 1000u + 100000u);
+
+  arena.rewind(m);
+  EXPECT_LT(arena.bytesAllocated(), 3 * 4096u);
+  EXPECT_EQ(second, arena.allocate(16));
+  EXPECT_NE(first, second);
+  (void) after_large;
+
+  arena.reset();
+  // one chunk is kept and reused
+  EXPECT_EQ(4096u, arena.bytesAllocated());
+  EXPECT_TRUE(arena.allocate(16) != NULL);
+  EXPECT_EQ(4096u, arena.bytesAllocated());
+
+  {
+    ArenaScope outer(&arena);
+    void * p = outer.arena().allocate(16);
+    {
+      ArenaScope inner(&arena);
+      arena.allocate(3000);
+      arena.allocate(3000);
+    }
+    EXPECT_EQ((char *) p + 16, arena.allocate(1, 1));
+  }
+}
+
+TEST_F(ArenaTS, caseCreate)
+{
+  destroyed.clear();
+  Arena arena(1024);
+  Arena::Mark m = arena.mark();
+  for (int i = 0; i < 100; ++i) {
+    Tracked * t = arena.create<Tracked>();
+    ASSERT_TRUE(t != NULL);
+    t->id = i;
+    t->name = "a string long enough to be allocated on the heap";
+  }
+  int * plain = arena.create<int>(42);
+  EXPECT_EQ(42, *plain);
+  EXPECT_TRUE(destroyed.empty());
+
+  arena.rewind(m);
+  ASSERT_EQ(100u, destroyed.size());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(99 - i, destroyed[i]);
+  }
+
+  destroyed.clear();
+  {
+    Arena other;
+    other.create<Tracked>()->id = 7;
+  }
+  ASSERT_EQ(1u, destroyed.size());
+  EXPECT_EQ(7, destroyed[0]);
+}
+
+TEST_F(ArenaTS, caseAllocator)
+{
+  Arena arena(1024);
+  {
+    typedef std::vector<int, ArenaAllocator<int> > IntVector;
+    IntVector v((ArenaAllocator<int>(&arena)));
+    for (int i = 0; i < 10000; ++i) {
+      v.push_back(i);
+    }
+    EXPECT_EQ(9999, v.back());
+
+    typedef std::map<int, int, std::less<int>, ArenaAllocator<std::pair<const int, int> > > IntMap;
+    IntMap map((std::less<int>()), ArenaAllocator<std::pair<const int, int> >(&arena));
+    for (int i = 0; i < 1000; ++i) {
+      map[i] = -i;
+    }
+    EXPECT_EQ(-500, map[500]);
+    EXPECT_TRUE(ArenaAllocator<int>(&arena) == map.get_allocator());
+  }
+  EXPECT_GT(arena.bytesAllocated(), 10000 * sizeof(int));
+}
+
+TEST_F(ArenaTS, caseThreadLocal)
+{
+  Arena * mine = Arena::threadLocal();
+  ASSERT_TRUE(mine != NULL);
+  EXPECT_EQ(mine, Arena::threadLocal());
+
+  Arena * theirs = NULL;
+  pthread_t tid;
+  ASSERT_EQ(0, pthread_create(&tid, NULL, getThreadArena, &theirs));
+  ASSERT_EQ(0, pthread_join(tid, NULL));
+  EXPECT_TRUE(theirs != NULL);
+  EXPECT_NE(mine, theirs);
+
+  ArenaScope scope(Arena::threadLocal());
+  EXPECT_TRUE(scope.arena().allocate(100) != NULL);
+}
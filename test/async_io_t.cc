@@ -24,10 +24,35 @@
  * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string>
 #include <gtest/gtest.h>
 #include "nebula/async_io.h"
 
 using nebula::AsyncIo;
+using nebula::SplicePipe;
+
+namespace
+{
+  std::string pattern(size_t len)
+  {
+    std::string s(len, '\0');
+    for (size_t i = 0; i < len; ++i) {
+      s[i] = (char) ('a' + (i * 7 + i / 4096) % 26);
+    }
+    return s;
+  }
+
+  std::string readAll(int fd, size_t len)
+  {
+    std::string s;
+    char buf[4096];
+    ssize_t n;
+    while (s.size() < len && (n = read(fd, buf, sizeof(buf))) > 0) {
+      s.append(buf, n);
+    }
+    return s;
+  }
+}
 
 class AsyncIoTS: public testing::Test
 {
@@ -110,3 +135,85 @@ TEST_F(AsyncIoTS, pipe2_closeOnExec_nonblock)
   EXPECT_TRUE(AsyncIo::isNonblock_3state(pipefds_[0]) == 1);
   EXPECT_TRUE(AsyncIo::isNonblock_3state(pipefds_[1]) == 1);
 }
+
+TEST_F(AsyncIoTS, copyFileRange)
+{
+  std::string data = pattern(1 << 20);
+  ASSERT_EQ((ssize_t) data.size(), write(open_fd_, data.data(), data.size()));
+
+  char copy_name[64];
+  strncpy(copy_name, name_template_, sizeof(copy_name));
+  int copy_fd = mkstemp(copy_name);
+  ASSERT_GE(copy_fd, 0);
+  off_t in_off = 1000, out_off = 0;
+  EXPECT_EQ(500000, AsyncIo::copyFileRange(open_fd_, &in_off, copy_fd, &out_off, 500000));
+  EXPECT_EQ(501000, in_off);
+  EXPECT_EQ(500000, out_off);
+  // short at end of input
+  in_off = data.size() - 10;
+  EXPECT_EQ(10, AsyncIo::copyFileRange(open_fd_, &in_off, copy_fd, &out_off, 100));
+
+  EXPECT_EQ(0, lseek(copy_fd, 0, SEEK_SET));
+  EXPECT_TRUE(readAll(copy_fd, 500010) == data.substr(1000, 500000) + data.substr(data.size() - 10));
+  close(copy_fd);
+  unlink(copy_name);
+}
+
+TEST_F(AsyncIoTS, sendFile)
+{
+  std::string data = pattern(100000);
+  ASSERT_EQ((ssize_t) data.size(), write(open_fd_, data.data(), data.size()));
+  int sv[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+  off_t offset = 10;
+  EXPECT_EQ(50000, AsyncIo::sendFile(sv[0], open_fd_, &offset, 50000));
+  EXPECT_EQ(50010, offset);
+  EXPECT_TRUE(readAll(sv[1], 50000) == data.substr(10, 50000));
+  offset = data.size();
+  EXPECT_EQ(0, AsyncIo::sendFile(sv[0], open_fd_, &offset, 10));
+  close(sv[0]);
+  close(sv[1]);
+}
+
+TEST_F(AsyncIoTS, splicePipe)
+{
+  int in[2], out[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, in));
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, out));
+  ASSERT_EQ(0, AsyncIo::setNonblock(in[1]));
+  ASSERT_EQ(0, AsyncIo::setNonblock(out[0]));
+
+  SplicePipe pipe, mirror;
+  EXPECT_EQ(-1, pipe.fill(in[1], 1000));
+  EXPECT_EQ(EAGAIN, errno);
+  ASSERT_EQ(11, write(in[0], "hello world", 11));
+  EXPECT_EQ(11, pipe.fill(in[1], 1000));
+  EXPECT_EQ(11u, pipe.buffered());
+  EXPECT_EQ(5, pipe.tee(mirror, 5));
+  EXPECT_EQ(11u, pipe.buffered());
+  EXPECT_EQ(5u, mirror.buffered());
+  EXPECT_EQ(6, pipe.drain(out[0], 6));
+  EXPECT_EQ(5, pipe.drain(out[0], 100));
+  EXPECT_EQ(0u, pipe.buffered());
+  EXPECT_EQ(5, mirror.drain(out[0], 100));
+  EXPECT_EQ("hello worldhello", readAll(out[1], 16));
+
+  // a pipe given back empty is reused
+  pipe.release();
+  EXPECT_EQ(-1, pipe.fill(in[1], 1000));
+  EXPECT_EQ(EAGAIN, errno);
+
+  // the output full, the bytes stay in the pipe
+  char junk[4096] = { 0 };
+  while (write(out[0], junk, sizeof(junk)) > 0) {
+  }
+  ASSERT_EQ(5, write(in[0], "again", 5));
+  EXPECT_EQ(5, pipe.fill(in[1], 1000));
+  EXPECT_EQ(-1, pipe.drain(out[0], 100));
+  EXPECT_EQ(EAGAIN, errno);
+  EXPECT_EQ(5u, pipe.buffered());
+  close(in[0]);
+  close(in[1]);
+  close(out[0]);
+  close(out[1]);
+}
@@ -0,0 +1,263 @@
+/*
+ * big_int_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <string>
+#include <gtest/gtest.h>
+#include "nebula/big_int.h"
+#include "nebula/random.h"
+
+using nebula::BigInt;
+
+namespace
+{
+  BigInt randomBigInt(nebula::Prng & prng, size_t limbs, bool allow_negative = true)
+  {
+    static const char digits[] = "0123456789abcdef";
+    std::string s = allow_negative && prng.nextBool() ? "-0x" : "0x";
+    for (size_t i = 0; i < limbs * 16; ++i) {
+      s += digits[prng.nextBelow(16)];
+    }
+    BigInt r;
+    EXPECT_EQ(0, BigInt::parse(s.data(), s.size(), &r));
+    return r;
+  }
+
+  BigInt parsed(const char * s)
+  {
+    BigInt r;
+    EXPECT_EQ(0, BigInt::parse(s, &r)) << s;
+    return r;
+  }
+}
+
+class BigIntTS: public testing::Test
+{
+};
+
+TEST_F(BigIntTS, caseSmallValues)
+{
+  BigInt zero;
+  EXPECT_TRUE(zero.isZero());
+  EXPECT_EQ("0", zero.toString());
+  EXPECT_EQ("0x0", zero.toString(16));
+  EXPECT_EQ(0u, zero.bitLength());
+
+  BigInt min(INT64_MIN);
+  EXPECT_TRUE(min.isNegative());
+  EXPECT_TRUE(min.fitsI64());
+  EXPECT_EQ(INT64_MIN, min.toI64());
+  EXPECT_EQ("-9223372036854775808", min.toString());
+  EXPECT_FALSE((min - BigInt(1)).fitsI64());
+  EXPECT_FALSE(BigInt::fromU64(UINT64_MAX).fitsI64());
+  EXPECT_EQ("18446744073709551615", BigInt::fromU64(UINT64_MAX).toString());
+  EXPECT_EQ("-0xffffffffffffffff", (-BigInt::fromU64(UINT64_MAX)).toString(16));
+
+  // everything below 128 bits stays inline
+  BigInt big = BigInt::fromU64(UINT64_MAX) * BigInt::fromU64(UINT64_MAX);
+  EXPECT_EQ(2u, big.numLimbs());
+  EXPECT_EQ(128u, big.bitLength());
+  EXPECT_EQ("340282366920938463426481119284349108225", big.toString());
+
+  nebula::Prng prng(7);
+  for (int i = 0; i < 20000; ++i) {
+    int64_t a = prng.nextInRange(-2000000000, 2000000000);
+    int64_t b = prng.nextInRange(-2000000000, 2000000000);
+    BigInt x(a), y(b);
+    ASSERT_EQ(a + b, (x + y).toI64());
+    ASSERT_EQ(a - b, (x - y).toI64());
+    ASSERT_EQ(a * b, (x * y).toI64());
+    ASSERT_EQ(a < b, x < y);
+    ASSERT_EQ(a == b, x == y);
+    if (b) {
+      ASSERT_EQ(a / b, (x / y).toI64());
+      ASSERT_EQ(a % b, (x % y).toI64());
+    }
+  }
+}
+
+TEST_F(BigIntTS, caseKnownValues)
+{
+  BigInt factorial(1);
+  for (int i = 2; i <= 100; ++i) {
+    factorial *= BigInt(i);
+  }
+  EXPECT_EQ("93326215443944152681699238856266700490715968264381621468592963895217599993229915608941463976156518286253697920827223758251185210916864000000000000000000000000", factorial.toString());
+
+  BigInt mersenne = (BigInt(1) << 521) - BigInt(1);
+  EXPECT_EQ("6864797660130609714981900799081393217269435300143305409394463459185543183397656052122559640661454554977296311391480858037121987999716643812574028291115057151", mersenne.toString());
+  EXPECT_EQ(521u, mersenne.bitLength());
+
+  EXPECT_EQ("0x1fd5863c3eb0469ec21a937a76f3432ffd73d97e447606b683ecf6f6e4a7ae225bfaff1eaaf8b0a1", BigInt::pow(BigInt(3), 200).toString(16));
+
+  BigInt x = parsed("123456789012345678901234567890123456789012345678901234567890");
+  BigInt y = parsed("-98765432109876543210987654321");
+  EXPECT_EQ("-12193263113702179522618503273374485596337448559633744855963362292333223746380111126352690", (x * y).toString());
+  BigInt q, r;
+  ASSERT_EQ(0, BigInt::divMod(x, y, &q, &r));
+  EXPECT_EQ("-1249999988609375000142382812499", q.toString());
+  EXPECT_EQ("46440971104644097110464409711", r.toString());
+  ASSERT_EQ(0, BigInt::divMod(-x, y, &q, &r));
+  EXPECT_EQ("1249999988609375000142382812499", q.toString());
+  EXPECT_EQ("-46440971104644097110464409711", r.toString());
+
+  errno = 0;
+  EXPECT_EQ(-1, BigInt::divMod(x, BigInt(), &q, &r));
+  EXPECT_EQ(EDOM, errno);
+}
+
+TEST_F(BigIntTS, caseParse)
+{
+  const char * bad[] = { "", "-", "+", "0x", "-0x", "12a", "0x12g", " 1", "1 ", "--1", "0b1" };
+  BigInt v(42);
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+    errno = 0;
+    EXPECT_EQ(-1, BigInt::parse(bad[i], &v)) << bad[i];
+    EXPECT_EQ(EINVAL, errno);
+    EXPECT_EQ(42, v.toI64());
+  }
+
+  EXPECT_EQ("0", parsed("-0").toString());
+  EXPECT_FALSE(parsed("-0x0").isNegative());
+  EXPECT_EQ("123", parsed("+000123").toString());
+  EXPECT_EQ("-255", parsed("-0xFf").toString());
+  EXPECT_EQ("0x123456789abcdef0123456789abcdef", parsed("0X0123456789ABCDEF0123456789abcdef").toString(16));
+}
+
+TEST_F(BigIntTS, caseKaratsubaMatchesSchoolbook)
+{
+  size_t saved = BigInt::karatsubaThreshold();
+  nebula::Prng prng(11);
+  const size_t sizes[][2] = { { 4, 4 }, { 5, 4 }, { 33, 32 }, { 64, 64 }, { 100, 37 }, { 300, 300 }, { 257, 129 },
+                              { 1000, 10 }, { 700, 650 } };
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    BigInt a = randomBigInt(prng, sizes[i][0]);
+    BigInt b = randomBigInt(prng, sizes[i][1]);
+    BigInt::setKaratsubaThreshold(1 << 30);
+    BigInt school = a * b;
+    BigInt::setKaratsubaThreshold(4);
+    BigInt karatsuba = a * b;
+    EXPECT_TRUE(school == karatsuba) << sizes[i][0] << " x " << sizes[i][1];
+    EXPECT_TRUE(karatsuba == b * a);
+
+    // all ones limbs exercise every carry
+    BigInt ones = (BigInt(1) << (64 * sizes[i][0])) - BigInt(1);
+    BigInt::setKaratsubaThreshold(1 << 30);
+    school = ones * ones;
+    BigInt::setKaratsubaThreshold(4);
+    EXPECT_TRUE(school == ones * ones);
+  }
+  BigInt::setKaratsubaThreshold(saved);
+  EXPECT_EQ(saved, BigInt::karatsubaThreshold());
+}
+
+TEST_F(BigIntTS, caseDivision)
+{
+  nebula::Prng prng(13);
+  const uint64_t small[] = { 1, 2, 3, 7, 10, 1000000007, 10000000000000000000ULL, UINT64_MAX, 1ULL << 63 };
+  for (size_t i = 0; i < sizeof(small) / sizeof(small[0]); ++i) {
+    BigInt a = randomBigInt(prng, 50, false);
+    BigInt q(a);
+    uint64_t r = q.divModSmall(small[i]);
+    EXPECT_LT(r, small[i]);
+    BigInt back(q);
+    back.mulAddSmall(small[i], r);
+    EXPECT_TRUE(back == a) << small[i];
+  }
+
+  for (int i = 0; i < 300; ++i) {
+    BigInt a = randomBigInt(prng, 1 + prng.nextBelow(80));
+    BigInt b = randomBigInt(prng, 1 + prng.nextBelow(40));
+    if (i % 3 == 0) {
+      // divisors with a small top limb need the largest normalization shifts
+      b >>= 64 - 1 - prng.nextBelow(63);
+    }
+    if (b.isZero()) {
+      continue;
+    }
+    BigInt q, r;
+    ASSERT_EQ(0, BigInt::divMod(a, b, &q, &r));
+    ASSERT_TRUE(q * b + r == a);
+    ASSERT_LT(r.compareAbs(b), 0);
+    ASSERT_TRUE(r.isZero() || r.isNegative() == a.isNegative());
+  }
+
+  // quotient digits where the first estimate is off
+  BigInt b = (BigInt(1) << 128) - BigInt(1);
+  BigInt a = (BigInt(1) << 1024) - BigInt(1);
+  BigInt q, r;
+  ASSERT_EQ(0, BigInt::divMod(a, b, &q, &r));
+  EXPECT_TRUE(q * b + r == a);
+  EXPECT_TRUE(r.isZero());
+
+  // results may be written over the operands
+  BigInt x(100), y(7);
+  ASSERT_EQ(0, BigInt::divMod(x, y, &x, &y));
+  EXPECT_EQ(14, x.toI64());
+  EXPECT_EQ(2, y.toI64());
+}
+
+TEST_F(BigIntTS, caseConversions)
+{
+  nebula::Prng prng(17);
+  const size_t sizes[] = { 1, 2, 3, 39, 40, 41, 100, 333, 1000, 2500 };
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    BigInt a = randomBigInt(prng, sizes[i]);
+    std::string dec = a.toString();
+    std::string hex = a.toString(16);
+    BigInt b, c;
+    ASSERT_EQ(0, BigInt::parse(dec.data(), dec.size(), &b));
+    ASSERT_EQ(0, BigInt::parse(hex.data(), hex.size(), &c));
+    EXPECT_TRUE(a == b) << sizes[i];
+    EXPECT_TRUE(a == c) << sizes[i];
+  }
+
+  // zeros in the middle of the recursion must be padded
+  for (size_t n = 1; n < 12000; n = n * 3 + 1) {
+    BigInt p = BigInt::pow(BigInt(10), n);
+    EXPECT_EQ("1" + std::string(n, '0'), p.toString()) << n;
+    EXPECT_EQ(std::string(n, '9'), (p - BigInt(1)).toString()) << n;
+    EXPECT_EQ("-" + std::string(n, '9'), (BigInt(1) - p).toString()) << n;
+    EXPECT_TRUE(parsed(("1" + std::string(n, '0')).c_str()) == p) << n;
+  }
+}
+
+TEST_F(BigIntTS, caseShifts)
+{
+  nebula::Prng prng(19);
+  for (int i = 0; i < 200; ++i) {
+    BigInt a = randomBigInt(prng, 1 + prng.nextBelow(20));
+    size_t bits = prng.nextBelow(300);
+    BigInt shifted = a << bits;
+    EXPECT_TRUE(shifted == a * BigInt::pow(BigInt(2), bits));
+    EXPECT_TRUE((shifted >> bits) == a);
+    EXPECT_EQ(a.bitLength() + bits, shifted.bitLength());
+  }
+  EXPECT_TRUE((BigInt(-5) >> 1) == BigInt(-2));
+  EXPECT_TRUE((BigInt(5) >> 200).isZero());
+  EXPECT_TRUE((BigInt(-5) >> 3).isZero());
+  EXPECT_FALSE((BigInt(-5) >> 3).isNegative());
+}
@@ -0,0 +1,272 @@
+/*
+ * byte_buffer_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include "nebula/byte_buffer.h"
+
+using nebula::ByteReader;
+using nebula::ByteWriter;
+using nebula::Varint;
+
+class ByteBufferTS: public testing::Test
+{
+protected:
+  static std::vector<uint8_t> bytes(const ByteWriter & w)
+  {
+    return std::vector<uint8_t>(w.data(), w.data() + w.size());
+  }
+};
+
+TEST_F(ByteBufferTS, caseFixedWidth)
+{
+  ByteWriter w;
+  EXPECT_EQ(0, w.putU8(0x01));
+  EXPECT_EQ(0, w.putBe16(0x0203));
+  EXPECT_EQ(0, w.putBe32(0x04050607));
+  EXPECT_EQ(0, w.putBe64(0x08090a0b0c0d0e0fULL));
+  EXPECT_EQ(0, w.putLe16(0x1110));
+  EXPECT_EQ(0, w.putLe32(0x15141312));
+  EXPECT_EQ(0, w.putLe64(0x1d1c1b1a19181716ULL));
+  EXPECT_EQ(0, w.putBytes("\x1e\x1f", 2));
+  ASSERT_EQ(31U, w.size());
+  for (size_t i = 0; i < w.size(); ++i) {
+    EXPECT_EQ(i + 1, w.data()[i]) << i;
+  }
+
+  ByteReader r(w);
+  uint8_t u8;
+  uint16_t u16;
+  uint32_t u32;
+  uint64_t u64;
+  char raw[2];
+  EXPECT_EQ(0, r.getU8(&u8));
+  EXPECT_EQ(0x01, u8);
+  EXPECT_EQ(0, r.getBe16(&u16));
+  EXPECT_EQ(0x0203, u16);
+  EXPECT_EQ(0, r.getBe32(&u32));
+  EXPECT_EQ(0x04050607U, u32);
+  EXPECT_EQ(0, r.getBe64(&u64));
+  EXPECT_EQ(0x08090a0b0c0d0e0fULL, u64);
+  EXPECT_EQ(0, r.getLe16(&u16));
+  EXPECT_EQ(0x1110, u16);
+  EXPECT_EQ(0, r.getLe32(&u32));
+  EXPECT_EQ(0x15141312U, u32);
+  EXPECT_EQ(0, r.getLe64(&u64));
+  EXPECT_EQ(0x1d1c1b1a19181716ULL, u64);
+  EXPECT_EQ(0, r.getBytes(raw, 2));
+  EXPECT_EQ(0, memcmp(raw, "\x1e\x1f", 2));
+  EXPECT_EQ(0U, r.remaining());
+
+  errno = 0;
+  EXPECT_EQ(-1, r.getU8(&u8));
+  EXPECT_EQ(ENODATA, errno);
+}
+
+TEST_F(ByteBufferTS, caseBoundsAndUnaligned)
+{
+  uint8_t buf[16];
+  for (size_t i = 0; i < sizeof(buf); ++i) {
+    buf[i] = i;
+  }
+  // every odd offset, the position is unchanged after a failure
+  ByteReader r(buf + 1, 7);
+  uint64_t u64 = 42;
+  uint32_t u32;
+  EXPECT_EQ(-1, r.getBe64(&u64));
+  EXPECT_EQ(ENODATA, errno);
+  EXPECT_EQ(42U, u64);
+  EXPECT_EQ(0U, r.position());
+  EXPECT_EQ(0, r.getBe32(&u32));
+  EXPECT_EQ(0x01020304U, u32);
+  EXPECT_EQ(-1, r.getLe32(&u32));
+  EXPECT_EQ(3U, r.remaining());
+  EXPECT_EQ(-1, r.skip(4));
+  EXPECT_EQ(0, r.skip(3));
+  EXPECT_EQ(-1, r.seek(8));
+  EXPECT_EQ(EINVAL, errno);
+  EXPECT_EQ(0, r.seek(1));
+  EXPECT_EQ(2, *r.current());
+}
+
+TEST_F(ByteBufferTS, caseVarintEncoding)
+{
+  ByteWriter w;
+  w.putVarU32(0);
+  w.putVarU32(1);
+  w.putVarU32(127);
+  w.putVarU32(128);
+  w.putVarU32(300);
+  w.putVarI32(-1);
+  w.putVarI32(1);
+  w.putVarI64(-64);
+  w.putVarU64(UINT64_MAX);
+  const uint8_t expected[] = { 0x00, 0x01, 0x7f, 0x80, 0x01, 0xac, 0x02, 0x01, 0x02, 0x7f, //
+      0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01 };
+  EXPECT_EQ(std::vector<uint8_t>(expected, expected + sizeof(expected)), bytes(w));
+
+  EXPECT_EQ(0U, Varint::zigZag64(0));
+  EXPECT_EQ(1U, Varint::zigZag64(-1));
+  EXPECT_EQ(2U, Varint::zigZag64(1));
+  EXPECT_EQ(UINT64_MAX, Varint::zigZag64(INT64_MIN));
+  EXPECT_EQ(UINT32_MAX - 1, Varint::zigZag32(INT32_MAX));
+  EXPECT_EQ(INT64_MIN, Varint::unZigZag64(UINT64_MAX));
+  EXPECT_EQ(INT32_MAX, Varint::unZigZag32(UINT32_MAX - 1));
+}
+
+TEST_F(ByteBufferTS, caseVarintAllLengths)
+{
+  // every bit length, decoded with and without the 8 byte fast path
+  for (int bits = 0; bits <= 64; ++bits) {
+    uint64_t values[3] = { bits ? 1ULL << (bits - 1) : 0, bits ? ~0ULL >> (64 - bits) : 0, 0 };
+    values[2] = values[0] | (values[1] & 0x5555555555555555ULL);
+    for (int k = 0; k < 3; ++k) {
+      uint64_t v = values[k];
+      ByteWriter w;
+      ASSERT_EQ(0, w.putVarU64(v));
+      ASSERT_EQ(Varint::length(v), w.size()) << v;
+      size_t len = w.size();
+
+      for (size_t padding = 0; padding <= 10; padding += 10) {
+        w.truncate(len);
+        for (size_t i = 0; i < padding; ++i) {
+          w.putU8(0xff);
+        }
+        ByteReader r(w);
+        uint64_t out = 0;
+        ASSERT_EQ(0, r.getVarU64(&out)) << v;
+        EXPECT_EQ(v, out);
+        EXPECT_EQ(len, r.position());
+
+        // truncated
+        ByteReader t(w.data(), len - 1);
+        errno = 0;
+        EXPECT_EQ(-1, t.getVarU64(&out));
+        EXPECT_EQ(ENODATA, errno);
+      }
+
+      ByteWriter s;
+      s.putVarI64((int64_t) v);
+      ByteReader r(s);
+      int64_t sv;
+      ASSERT_EQ(0, r.getVarI64(&sv));
+      EXPECT_EQ((int64_t) v, sv);
+    }
+  }
+}
+
+TEST_F(ByteBufferTS, caseMalformedVarint)
+{
+  uint64_t u64;
+  uint32_t u32;
+  int32_t i32;
+
+  // 11 bytes
+  const uint8_t too_long[] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00 };
+  ByteReader a(too_long, sizeof(too_long));
+  EXPECT_EQ(-1, a.getVarU64(&u64));
+  EXPECT_EQ(EBADMSG, errno);
+  EXPECT_EQ(0U, a.position());
+
+  // 10th byte with more than the 64th bit
+  const uint8_t overflow[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x02 };
+  ByteReader b(overflow, sizeof(overflow));
+  EXPECT_EQ(-1, b.getVarU64(&u64));
+  EXPECT_EQ(EBADMSG, errno);
+
+  // fits 64 bits, not 32
+  ByteWriter w;
+  w.putVarU64(1ULL << 32);
+  w.putVarI64(INT64_MIN);
+  ByteReader c(w);
+  EXPECT_EQ(-1, c.getVarU32(&u32));
+  EXPECT_EQ(ERANGE, errno);
+  EXPECT_EQ(0U, c.position());
+  EXPECT_EQ(0, c.getVarU64(&u64));
+  EXPECT_EQ(-1, c.getVarI32(&i32));
+  EXPECT_EQ(ERANGE, errno);
+
+  // non minimal encodings are accepted
+  const uint8_t padded[] = { 0x81, 0x80, 0x80, 0x00 };
+  ByteReader d(padded, sizeof(padded));
+  EXPECT_EQ(0, d.getVarU64(&u64));
+  EXPECT_EQ(1U, u64);
+}
+
+TEST_F(ByteBufferTS, caseReuse)
+{
+  ByteWriter w(100);
+  EXPECT_LE(100U, w.capacity());
+  const uint8_t * storage = w.data();
+  for (int round = 0; round < 10; ++round) {
+    w.clear();
+    for (int i = 0; i < 25; ++i) {
+      w.putBe32(i);
+    }
+    EXPECT_EQ(100U, w.size());
+    EXPECT_EQ(storage, w.data());
+  }
+
+  EXPECT_EQ(0, w.reserve(10000));
+  EXPECT_LE(10000U, w.capacity());
+  EXPECT_EQ(100U, w.size());
+  size_t capacity = w.capacity();
+  EXPECT_EQ(0, w.reserve(10));
+  EXPECT_EQ(capacity, w.capacity());
+
+  // length prefix patched once the record is written
+  w.clear();
+  w.putBe32(0);
+  w.putBytes("hello", 5);
+  EXPECT_EQ(0, w.patchBe32(0, w.size() - 4));
+  EXPECT_EQ(-1, w.patchBe32(6, 0));
+  uint32_t len;
+  ByteReader r(w);
+  r.getBe32(&len);
+  EXPECT_EQ(5U, len);
+
+  ByteWriter other;
+  other.swap(w);
+  EXPECT_EQ(0U, w.size());
+  EXPECT_EQ(9U, other.size());
+
+  // grows from nothing
+  ByteWriter g;
+  EXPECT_EQ(0U, g.capacity());
+  for (int i = 0; i < 100000; ++i) {
+    ASSERT_EQ(0, g.putVarI32(-i));
+  }
+  ByteReader gr(g);
+  for (int i = 0; i < 100000; ++i) {
+    int32_t v;
+    ASSERT_EQ(0, gr.getVarI32(&v));
+    ASSERT_EQ(-i, v);
+  }
+  EXPECT_EQ(0U, gr.remaining());
+}
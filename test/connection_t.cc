@@ -0,0 +1,340 @@
+/*
+ * connection_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "nebula/connection.h"
+
+using nebula::AsyncEvent;
+using nebula::Connection;
+using nebula::IoBuffer;
+
+namespace
+{
+  std::string pattern(size_t len, int seed)
+  {
+    std::string s(len, '\0');
+    for (size_t i = 0; i < len; ++i) {
+      s[i] = (char) ('a' + (i * 7 + seed) % 26);
+    }
+    return s;
+  }
+
+  struct Peer
+  {
+    std::string received;
+    std::vector<int> closed;    // errors passed to the close callback
+    std::vector<bool> watermarks;
+    size_t expected;
+    bool echo;
+  };
+
+  void onMessage(Connection * conn, IoBuffer * input, void * data)
+  {
+    Peer * peer = (Peer *) data;
+    if (peer->echo) {
+      EXPECT_EQ(0, conn->send(*input));
+      EXPECT_TRUE(input->empty());
+      return;
+    }
+    size_t n = peer->received.size();
+    peer->received.resize(n + input->size());
+    input->copyOut(&peer->received[n], input->size());
+    input->consume(input->size());
+    if (peer->received.size() == peer->expected) {
+      conn->close();
+    }
+  }
+
+  void onClose(Connection * conn, int error, void * data)
+  {
+    ((Peer *) data)->closed.push_back(error);
+  }
+
+  void onWatermark(Connection * conn, bool above, void * data)
+  {
+    ((Peer *) data)->watermarks.push_back(above);
+    if (above) {
+      conn->pauseReading();
+    }
+    else {
+      conn->resumeReading();
+    }
+  }
+
+  uint32_t stopLoop(uint64_t time_event_id, void * data, AsyncEvent * ae)
+  {
+    ae->stop();
+    return 0;
+  }
+
+  // reads `fd' to end of file, running `ae' in between
+  std::string receive(int fd, AsyncEvent * ae)
+  {
+    std::string received;
+    char buf[64 << 10];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+      received.append(buf, n);
+      uint64_t id;
+      EXPECT_EQ(0, ae->addTimeEvent(1, stopLoop, NULL, &id));
+      ae->start();
+      ae->eventLoop();
+    }
+    return received;
+  }
+}
+
+class ConnectionTS: public testing::Test
+{
+protected:
+  AsyncEvent ae;
+  int fds[2];
+
+  virtual void SetUp()
+  {
+    ASSERT_EQ(0, ae.initialize());
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  }
+
+  virtual void TearDown()
+  {
+    EXPECT_EQ(0, ae.numMonitoredFds());
+    EXPECT_EQ(0, ae.numReadyFds());
+  }
+};
+
+TEST_F(ConnectionTS, caseEcho)
+{
+  Peer server = { "", std::vector<int>(), std::vector<bool>(), 0, true };
+  Peer client = { "", std::vector<int>(), std::vector<bool>(), 0, false };
+  Connection s(&ae, fds[0]), c(&ae, fds[1]);
+  s.setCallbacks(onMessage, onClose, &server);
+  c.setCallbacks(onMessage, onClose, &client);
+  ASSERT_EQ(0, s.init());
+  ASSERT_EQ(0, c.init());
+
+  // more than the socket buffers hold, so that both sides queue
+  std::string request = pattern(8 << 20, 1);
+  client.expected = request.size();
+  ASSERT_EQ(0, c.send(request.data(), request.size()));
+  EXPECT_GT(c.pendingOutput(), 0u);
+  ae.eventLoop();
+
+  EXPECT_TRUE(client.received == request);
+  ASSERT_EQ(1u, client.closed.size());
+  EXPECT_EQ(0, client.closed[0]);
+  // the client closed, the server saw end of file
+  ASSERT_EQ(1u, server.closed.size());
+  EXPECT_EQ(0, server.closed[0]);
+  EXPECT_EQ(request.size(), s.bytesRead());
+  EXPECT_EQ(request.size(), s.bytesWritten());
+  EXPECT_FALSE(c.connected());
+  EXPECT_EQ(-1, c.send("x", 1));
+  EXPECT_EQ(EPIPE, errno);
+}
+
+TEST_F(ConnectionTS, caseWatermarks)
+{
+  Peer server = { "", std::vector<int>(), std::vector<bool>(), 0, false };
+  Connection s(&ae, fds[0]);
+  s.setCallbacks(onMessage, onClose, &server);
+  s.setWatermarks(256 << 10, 64 << 10, onWatermark);
+  ASSERT_EQ(0, s.init());
+
+  // nobody reads the other end
+  std::string data = pattern(1 << 20, 2);
+  ASSERT_EQ(0, s.send(data.data(), data.size()));
+  ASSERT_EQ(1u, server.watermarks.size());
+  EXPECT_TRUE(server.watermarks[0]);
+  size_t pending = s.pendingOutput();
+  EXPECT_GT(pending, 256u << 10);
+
+  // graceful close waits for the output
+  s.shutdown();
+  EXPECT_TRUE(server.closed.empty());
+  EXPECT_EQ(-1, s.send("x", 1));
+
+  std::string received;
+  char buf[64 << 10];
+  while (received.size() < data.size()) {
+    ssize_t n = read(fds[1], buf, sizeof(buf));
+    ASSERT_GT(n, 0);
+    received.append(buf, n);
+    uint64_t id;
+    ASSERT_EQ(0, ae.addTimeEvent(1, stopLoop, NULL, &id));
+    ae.start();
+    ae.eventLoop();
+  }
+  EXPECT_TRUE(received == data);
+  EXPECT_EQ(0, read(fds[1], buf, sizeof(buf)));
+  ASSERT_EQ(2u, server.watermarks.size());
+  EXPECT_FALSE(server.watermarks[1]);
+  ASSERT_EQ(1u, server.closed.size());
+  EXPECT_EQ(0, server.closed[0]);
+  close(fds[1]);
+}
+
+TEST_F(ConnectionTS, casePeerGone)
+{
+  Peer server = { "", std::vector<int>(), std::vector<bool>(), 0, false };
+  Connection s(&ae, fds[0]);
+  s.setCallbacks(onMessage, onClose, &server);
+  ASSERT_EQ(0, s.init());
+  close(fds[1]);
+
+  // no SIGPIPE, the write error closes the connection
+  EXPECT_EQ(-1, s.send("hello", 5));
+  EXPECT_EQ(EPIPE, errno);
+  ASSERT_EQ(1u, server.closed.size());
+  EXPECT_EQ(EPIPE, server.closed[0]);
+  EXPECT_FALSE(s.connected());
+}
+
+TEST_F(ConnectionTS, casePauseReading)
+{
+  Peer server = { "", std::vector<int>(), std::vector<bool>(), 5, false };
+  Connection s(&ae, fds[0]);
+  s.setCallbacks(onMessage, onClose, &server);
+  ASSERT_EQ(0, s.init());
+  s.pauseReading();
+  ASSERT_EQ(5, write(fds[1], "hello", 5));
+  uint64_t id;
+  ASSERT_EQ(0, ae.addTimeEvent(10, stopLoop, NULL, &id));
+  ae.eventLoop();
+  EXPECT_TRUE(server.received.empty());
+
+  // data which arrived while paused is reported when resumed
+  s.resumeReading();
+  ae.start();
+  ae.eventLoop();
+  EXPECT_EQ("hello", server.received);
+  ASSERT_EQ(1u, server.closed.size());
+  close(fds[1]);
+}
+
+TEST_F(ConnectionTS, caseSendFile)
+{
+  char name[] = "ts_connection_XXXXXX";
+  int file_fd = mkstemp(name);
+  ASSERT_GE(file_fd, 0);
+  unlink(name);
+  std::string contents = pattern(3 << 20, 3);
+  ASSERT_EQ((ssize_t) contents.size(), write(file_fd, contents.data(), contents.size()));
+
+  Peer server = { "", std::vector<int>(), std::vector<bool>(), 0, false };
+  Connection s(&ae, fds[0]);
+  s.setCallbacks(onMessage, onClose, &server);
+  ASSERT_EQ(0, s.init());
+
+  // in order with the buffered output around it
+  ASSERT_EQ(0, s.send("head", 4));
+  ASSERT_EQ(0, s.sendFile(file_fd, 100, contents.size() - 200, true));
+  ASSERT_EQ(0, s.send("tail", 4));
+  EXPECT_EQ(4u, s.pendingOutput());
+  s.shutdown();
+
+  EXPECT_TRUE(receive(fds[1], &ae) == "head" + contents.substr(100, contents.size() - 200) + "tail");
+  ASSERT_EQ(1u, server.closed.size());
+  EXPECT_EQ(0, server.closed[0]);
+  // closed with the connection
+  EXPECT_EQ(-1, fcntl(file_fd, F_GETFD));
+  close(fds[1]);
+}
+
+TEST_F(ConnectionTS, casePeerGoneWithPendingFile)
+{
+  char name[] = "ts_connection_XXXXXX";
+  int file_fd = mkstemp(name);
+  ASSERT_GE(file_fd, 0);
+  unlink(name);
+  std::string contents = pattern(3 << 20, 5);
+  ASSERT_EQ((ssize_t) contents.size(), write(file_fd, contents.data(), contents.size()));
+
+  Peer server = { "", std::vector<int>(), std::vector<bool>(), 0, false };
+  Connection s(&ae, fds[0]);
+  s.setCallbacks(onMessage, onClose, &server);
+  ASSERT_EQ(0, s.init());
+
+  // far more than the socket buffer, and nothing else queued
+  ASSERT_EQ(0, s.sendFile(file_fd, 0, contents.size(), true));
+  EXPECT_EQ(0u, s.pendingOutput());
+  // nothing left unread, which would make it a reset
+  char buf[64 << 10];
+  ASSERT_EQ(0, fcntl(fds[1], F_SETFL, O_NONBLOCK));
+  while (read(fds[1], buf, sizeof(buf)) > 0) {
+  }
+  close(fds[1]);
+  uint64_t id;
+  ASSERT_EQ(0, ae.addTimeEvent(10, stopLoop, NULL, &id));
+  ae.eventLoop();
+
+  // the rest of the file was dropped, not an orderly close
+  ASSERT_EQ(1u, server.closed.size());
+  EXPECT_EQ(EPIPE, server.closed[0]);
+  EXPECT_FALSE(s.connected());
+}
+
+TEST_F(ConnectionTS, caseSpliceFrom)
+{
+  int pipefd[2];
+  ASSERT_EQ(0, nebula::AsyncIo::pipe2(pipefd));
+  Peer server = { "", std::vector<int>(), std::vector<bool>(), 0, false };
+  Connection s(&ae, fds[0]);
+  s.setCallbacks(onMessage, onClose, &server);
+  ASSERT_EQ(0, s.init());
+
+  EXPECT_EQ(-1, s.spliceFrom(pipefd[0], 1 << 20));
+  EXPECT_EQ(EAGAIN, errno);
+
+  std::string data = pattern(2 << 20, 4), expected;
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = write(pipefd[1], data.data() + written, std::min((size_t) 50000, data.size() - written));
+    ASSERT_GT(n, 0);
+    written += n;
+    ASSERT_EQ(n, s.spliceFrom(pipefd[0], 1 << 20));
+    ASSERT_EQ(0, s.send("|", 1));
+    expected += data.substr(written - n, n) + "|";
+  }
+  EXPECT_GT(s.pendingOutput(), 0u);
+  close(pipefd[1]);
+  EXPECT_EQ(0, s.spliceFrom(pipefd[0], 1 << 20));
+  close(pipefd[0]);
+  s.shutdown();
+
+  EXPECT_TRUE(receive(fds[1], &ae) == expected);
+  ASSERT_EQ(1u, server.closed.size());
+  EXPECT_EQ(0, server.closed[0]);
+  close(fds[1]);
+}
@@ -24,11 +24,17 @@
  * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <arpa/inet.h>
+#include <stdlib.h>
 #include <iostream>
+#include <vector>
 #include <gtest/gtest.h>
 #include "nebula/endian.h"
+#include "nebula/multiversion.h"
 
 using nebula::Endian;
+using nebula::HardwareInfo;
+using nebula::MultiversionBase;
+using nebula::SimdLevel;
 
 TEST(EndianTS, caseSimple)
 {
@@ -81,3 +87,63 @@ TEST(EndianTS, caseSimple)
   EXPECT_EQ(Endian::toBe64(Endian::fromBe64(uc)), uc);
   EXPECT_EQ(Endian::toLe64(Endian::fromLe64(uc)), uc);
 }
+
+template<typename T>
+static void checkBulk(void (*bulk)(T *, const T *, size_t), T (*single)(T), const char * name)
+{
+  std::vector<T> src(300);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = (T) (((uint64_t) random() << 33) ^ ((uint64_t) random() << 11) ^ random());
+  }
+  std::vector<T> dst(src.size() + 1);
+
+  // every length and alignment around the vector widths
+  for (size_t offset = 0; offset < 20; ++offset) {
+    for (size_t n = 0; n + offset < src.size(); ++n) {
+      dst[n] = 0x5a;
+      bulk(&dst[0], &src[offset], n);
+      for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(single(src[offset + i]), dst[i]) << name << " offset " << offset << " n " << n << " i " << i;
+      }
+      ASSERT_EQ((T) 0x5a, dst[n]) << name << " wrote past the end, n " << n;
+    }
+  }
+
+  // in place
+  std::vector<T> copy(src);
+  bulk(&copy[1], &copy[1], copy.size() - 1);
+  EXPECT_EQ(src[0], copy[0]);
+  for (size_t i = 1; i < copy.size(); ++i) {
+    ASSERT_EQ(single(src[i]), copy[i]) << name << " in place, i " << i;
+  }
+}
+
+TEST(EndianTS, caseBulk)
+{
+  srandom(20261019);
+  SimdLevel::Constants saved = MultiversionBase::levelLimit();
+  for (int level = SimdLevel::SCALAR; level <= HardwareInfo::simdLevel(); ++level) {
+    MultiversionBase::limitLevel((SimdLevel::Constants) level);
+    SCOPED_TRACE(SimdLevel::toString((SimdLevel::Constants) level));
+
+    checkBulk<uint16_t>(Endian::toBe16, Endian::toBe16, "toBe16");
+    checkBulk<uint16_t>(Endian::toLe16, Endian::toLe16, "toLe16");
+    checkBulk<uint16_t>(Endian::fromBe16, Endian::fromBe16, "fromBe16");
+    checkBulk<uint16_t>(Endian::fromLe16, Endian::fromLe16, "fromLe16");
+    checkBulk<uint32_t>(Endian::toBe32, Endian::toBe32, "toBe32");
+    checkBulk<uint32_t>(Endian::toLe32, Endian::toLe32, "toLe32");
+    checkBulk<uint32_t>(Endian::fromBe32, Endian::fromBe32, "fromBe32");
+    checkBulk<uint32_t>(Endian::fromLe32, Endian::fromLe32, "fromLe32");
+    checkBulk<uint64_t>(Endian::toBe64, Endian::toBe64, "toBe64");
+    checkBulk<uint64_t>(Endian::toLe64, Endian::toLe64, "toLe64");
+    checkBulk<uint64_t>(Endian::fromBe64, Endian::fromBe64, "fromBe64");
+    checkBulk<uint64_t>(Endian::fromLe64, Endian::fromLe64, "fromLe64");
+  }
+  MultiversionBase::limitLevel(saved);
+
+  uint32_t be[2] = { htonl(1), htonl(0xdeadbeef) };
+  uint32_t host[2];
+  Endian::fromBe32(host, be, 2);
+  EXPECT_EQ(1U, host[0]);
+  EXPECT_EQ(0xdeadbeefU, host[1]);
+}
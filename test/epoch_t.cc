@@ -0,0 +1,283 @@
+/*
+ * epoch_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <sched.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include "nebula/epoch.h"
+
+using nebula::EpochDomain;
+using nebula::EpochGuard;
+
+static volatile int num_deleted = 0;
+
+static void countDeletion(void * ptr)
+{
+  __sync_fetch_and_add(&num_deleted, 1);
+}
+
+class EpochTS: public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    num_deleted = 0;
+  }
+
+  virtual void TearDown()
+  {
+  }
+};
+
+class BlockingReader: public nebula::EpochThread
+{
+public:
+  volatile int entered_;
+  volatile int release_;
+
+  BlockingReader(EpochDomain * domain) :
+    nebula::EpochThread(domain), entered_(0), release_(0)
+  {
+  }
+
+  void * routine()
+  {
+    EpochGuard guard(*domain());
+    __atomic_store_n(&entered_, 1, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&release_, __ATOMIC_ACQUIRE)) {
+      sched_yield();
+    }
+    return NULL;
+  }
+};
+
+TEST_F(EpochTS, caseInit)
+{
+  EpochDomain domain;
+  ASSERT_EQ(0, domain.init());
+  EXPECT_EQ(-1, domain.init());
+  EXPECT_EQ(EINVAL, errno);
+
+  // no pthread key left
+  std::vector<pthread_key_t> keys;
+  pthread_key_t key;
+  while (pthread_key_create(&key, NULL) == 0) {
+    keys.push_back(key);
+  }
+  EpochDomain starved;
+  EXPECT_EQ(-1, starved.init());
+  EXPECT_EQ(EAGAIN, errno);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    pthread_key_delete(keys[i]);
+  }
+  EXPECT_EQ(0, starved.init());
+  int object;
+  starved.retire(&object, countDeletion);
+  starved.synchronize();
+  EXPECT_EQ(1, num_deleted);
+  starved.unregisterThread();
+}
+
+TEST_F(EpochTS, caseReaderBlocksReclamation)
+{
+  EpochDomain domain;
+  ASSERT_EQ(0, domain.init());
+  BlockingReader reader(&domain);
+  ASSERT_EQ(0, reader.create());
+  while (!__atomic_load_n(&reader.entered_, __ATOMIC_ACQUIRE)) {
+    sched_yield();
+  }
+
+  int objects[10];
+  for (int i = 0; i < 10; ++i) {
+    domain.retire(objects + i, countDeletion);
+  }
+  for (int i = 0; i < 10; ++i) {
+    domain.reclaim();
+  }
+  // the epoch moves at most once past the reader
+  EXPECT_TRUE(domain.epoch() <= 1);
+  EXPECT_EQ(0, num_deleted);
+  EXPECT_EQ(10u, domain.pending());
+
+  __atomic_store_n(&reader.release_, 1, __ATOMIC_RELEASE);
+  reader.join();
+  domain.synchronize();
+  EXPECT_EQ(10, num_deleted);
+  EXPECT_EQ(0u, domain.pending());
+}
+
+TEST_F(EpochTS, caseNestingAndBatches)
+{
+  EpochDomain domain;
+  ASSERT_EQ(0, domain.init());
+  domain.enter();
+  domain.enter();
+  domain.leave();
+  int objects[EpochDomain::RECLAIM_BATCH * 4];
+  // retired inside a critical section of this very thread, nothing can go
+  for (int i = 0; i < EpochDomain::RECLAIM_BATCH * 4; ++i) {
+    domain.retire(objects + i, countDeletion);
+  }
+  EXPECT_EQ(0, num_deleted);
+  domain.leave();
+
+  // batches are reclaimed as more objects are retired
+  for (int i = 0; i < EpochDomain::RECLAIM_BATCH * 4; ++i) {
+    domain.retire(objects + i, countDeletion);
+  }
+  EXPECT_TRUE(num_deleted >= EpochDomain::RECLAIM_BATCH * 4);
+  domain.synchronize();
+  EXPECT_EQ(EpochDomain::RECLAIM_BATCH * 8, num_deleted);
+  domain.unregisterThread();
+}
+
+class Retirer: public nebula::Thread
+{
+private:
+  EpochDomain * domain_;
+  int * objects_;
+  int num_objects_;
+
+public:
+  Retirer(EpochDomain * domain, int * objects, int num_objects) :
+    domain_(domain), objects_(objects), num_objects_(num_objects)
+  {
+  }
+
+  void * routine()
+  {
+    for (int i = 0; i < num_objects_; ++i) {
+      domain_->retire(objects_ + i, countDeletion);
+    }
+    return NULL; // pending objects are handed over by the key destructor
+  }
+};
+
+TEST_F(EpochTS, caseExitedThread)
+{
+  EpochDomain domain;
+  ASSERT_EQ(0, domain.init());
+  int objects[10];
+  Retirer retirer(&domain, objects, 10);
+  ASSERT_EQ(0, retirer.create());
+  retirer.join();
+  EXPECT_EQ(10u, domain.pending());
+  domain.synchronize();
+  EXPECT_EQ(10, num_deleted);
+  domain.unregisterThread();
+}
+
+struct Node
+{
+  enum
+  {
+    MAGIC = 0x5a5a5a5a
+  };
+
+  volatile int magic;
+  long value;
+
+  static volatile int num_alive;
+
+  Node(long v) :
+    magic(MAGIC), value(v)
+  {
+    __sync_fetch_and_add(&num_alive, 1);
+  }
+
+  ~Node()
+  {
+    magic = 0;
+    __sync_fetch_and_sub(&num_alive, 1);
+  }
+};
+
+volatile int Node::num_alive = 0;
+
+class NodeReader: public nebula::EpochThread
+{
+private:
+  Node ** shared_;
+  volatile int * stop_;
+
+public:
+  long corrupted_;
+  long reads_;
+
+  NodeReader(EpochDomain * domain = NULL, Node ** shared = NULL, volatile int * stop = NULL) :
+    nebula::EpochThread(domain), shared_(shared), stop_(stop), corrupted_(0), reads_(0)
+  {
+  }
+
+  void * routine()
+  {
+    long last = 0;
+    while (!__atomic_load_n(stop_, __ATOMIC_RELAXED)) {
+      EpochGuard guard(*domain());
+      Node * node = __atomic_load_n(shared_, __ATOMIC_ACQUIRE);
+      if (node->magic != Node::MAGIC || node->value < last) {
+        ++corrupted_;
+      }
+      last = node->value;
+      ++reads_;
+    }
+    return NULL;
+  }
+};
+
+TEST_F(EpochTS, caseStress)
+{
+  {
+    EpochDomain domain;
+    ASSERT_EQ(0, domain.init());
+    Node * shared = new Node(0);
+    volatile int stop = 0;
+    NodeReader readers[4] =
+    { NodeReader(&domain, &shared, &stop), NodeReader(&domain, &shared, &stop), NodeReader(&domain, &shared, &stop),
+      NodeReader(&domain, &shared, &stop) };
+    for (int i = 0; i < 4; ++i) {
+      ASSERT_EQ(0, readers[i].create());
+    }
+    for (long v = 1; v <= 50000; ++v) {
+      Node * old = __atomic_exchange_n(&shared, new Node(v), __ATOMIC_ACQ_REL);
+      domain.retire(old);
+      if (v % 1000 == 0) {
+        sched_yield();
+      }
+    }
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < 4; ++i) {
+      readers[i].join();
+      EXPECT_EQ(0, readers[i].corrupted_);
+    }
+    domain.synchronize();
+    EXPECT_EQ(1, Node::num_alive);
+    delete shared;
+  }
+  EXPECT_EQ(0, Node::num_alive);
+}
@@ -0,0 +1,237 @@
+/*
+ * file_status_cache_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include "nebula/file_status_cache.h"
+
+using nebula::FileStatusCache;
+
+static int removeItem(const char * fpath, const struct stat * sb, int typeflag, struct FTW * ftwbuf)
+{
+  return remove(fpath);
+}
+
+class FileStatusCacheTS: public testing::Test
+{
+protected:
+  char base_[64];
+  char file_[128];
+  char link_[128];
+  char missing_[128];
+
+  virtual void SetUp()
+  {
+    strcpy(base_, "testsuite_FileStatusCache_XXXXXX");
+    ASSERT_TRUE(mkdtemp(base_) != NULL);
+    snprintf(file_, sizeof(file_), "%s/file", base_);
+    snprintf(link_, sizeof(link_), "%s/link", base_);
+    snprintf(missing_, sizeof(missing_), "%s/missing", base_);
+    touch(file_, 1000);
+    ASSERT_EQ(0, symlink("file", link_));
+  }
+
+  virtual void TearDown()
+  {
+    nftw(base_, removeItem, 16, FTW_DEPTH | FTW_PHYS);
+  }
+
+  void touch(const char * path, time_t mtime)
+  {
+    int fd = open(path, O_CREAT | O_WRONLY, 0644);
+    ASSERT_TRUE(fd >= 0);
+    close(fd);
+    struct timespec times[2];
+    times[0].tv_sec = times[1].tv_sec = mtime;
+    times[0].tv_nsec = times[1].tv_nsec = 0;
+    ASSERT_EQ(0, utimensat(AT_FDCWD, path, times, 0));
+  }
+
+  // wait for the watcher thread to process an event
+  time_t waitForMtime(FileStatusCache * cache, const char * path, time_t expected)
+  {
+    time_t mtime = cache->mtime(path);
+    for (int i = 0; i < 200 && mtime != expected; ++i) {
+      usleep(10000);
+      mtime = cache->mtime(path);
+    }
+    return mtime;
+  }
+};
+
+TEST_F(FileStatusCacheTS, caseHitsAndManualInvalidation)
+{
+  FileStatusCache cache(STATX_MTIME, FileStatusCache::FSC_NONE);
+  ASSERT_EQ(0, cache.init());
+  EXPECT_TRUE(cache.fd() >= 0);
+
+  EXPECT_EQ(1000, cache.mtime(file_));
+  EXPECT_EQ(1000, cache.mtime(file_));
+  EXPECT_EQ(1000, cache.mtime(file_));
+  EXPECT_EQ(1u, cache.misses());
+  EXPECT_EQ(2u, cache.hits());
+  EXPECT_EQ(1u, cache.size());
+
+  // the change is not seen until events are processed
+  touch(file_, 2000);
+  EXPECT_EQ(1000, cache.mtime(file_));
+  EXPECT_TRUE(cache.processEvents() > 0);
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(2000, cache.mtime(file_));
+  EXPECT_EQ(0, cache.processEvents());
+
+  cache.invalidate(file_);
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(2000, cache.mtime(file_));
+  cache.clear();
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST_F(FileStatusCacheTS, caseDirectoryContentChanged)
+{
+  FileStatusCache cache(STATX_MTIME, FileStatusCache::FSC_NONE);
+  ASSERT_EQ(0, cache.init());
+
+  char dir[128];
+  char entry[192];
+  snprintf(dir, sizeof(dir), "%s/dir", base_);
+  snprintf(entry, sizeof(entry), "%s/entry", dir);
+  ASSERT_EQ(0, mkdir(dir, 0755));
+  struct timespec times[2];
+  times[0].tv_sec = times[1].tv_sec = 1000;
+  times[0].tv_nsec = times[1].tv_nsec = 0;
+  ASSERT_EQ(0, utimensat(AT_FDCWD, dir, times, 0));
+  EXPECT_EQ(1000, cache.mtime(dir));
+  EXPECT_EQ(1000, cache.mtime(dir));
+  EXPECT_EQ(1u, cache.hits());
+
+  // only the directory itself raises an event
+  touch(entry, 2000);
+  struct stat sb;
+  ASSERT_EQ(0, stat(dir, &sb));
+  ASSERT_NE(1000, sb.st_mtime);
+  EXPECT_TRUE(cache.processEvents() > 0);
+  EXPECT_EQ(sb.st_mtime, cache.mtime(dir));
+
+  ASSERT_EQ(0, utimensat(AT_FDCWD, dir, times, 0));
+  EXPECT_TRUE(cache.processEvents() > 0);
+  EXPECT_EQ(1000, cache.mtime(dir));
+  ASSERT_EQ(0, unlink(entry));
+  EXPECT_TRUE(cache.processEvents() > 0);
+  ASSERT_EQ(0, stat(dir, &sb));
+  EXPECT_EQ(sb.st_mtime, cache.mtime(dir));
+}
+
+TEST_F(FileStatusCacheTS, caseMissingFile)
+{
+  FileStatusCache cache(STATX_MTIME, FileStatusCache::FSC_NONE);
+  ASSERT_EQ(0, cache.init());
+
+  struct statx sx;
+  EXPECT_EQ(-1, cache.getFileStatus(missing_, &sx));
+  EXPECT_EQ(ENOENT, errno);
+  errno = 0;
+  EXPECT_EQ(-1, cache.getFileStatus(missing_, &sx));
+  EXPECT_EQ(ENOENT, errno);
+  EXPECT_EQ(1u, cache.hits());
+
+  touch(missing_, 3000);
+  EXPECT_TRUE(cache.processEvents() > 0);
+  EXPECT_EQ(3000, cache.mtime(missing_));
+
+  // parent directory does not exist, not cached
+  EXPECT_EQ((time_t) -1, cache.mtime("testsuite_FileStatusCache_nonexistent/file"));
+  EXPECT_EQ((time_t) -1, cache.mtime("testsuite_FileStatusCache_nonexistent/file"));
+  EXPECT_EQ(1u, cache.size());
+}
+
+TEST_F(FileStatusCacheTS, caseReplacedAndRemoved)
+{
+  FileStatusCache cache(STATX_MTIME | STATX_INO, FileStatusCache::FSC_NONE);
+  ASSERT_EQ(0, cache.init());
+  struct statx before, after;
+  ASSERT_EQ(0, cache.getFileStatus(file_, &before));
+
+  // atomic replacement, as done by editors and configuration management tools
+  char tmp[128];
+  snprintf(tmp, sizeof(tmp), "%s/file.tmp", base_);
+  touch(tmp, 4000);
+  ASSERT_EQ(0, rename(tmp, file_));
+  cache.processEvents();
+  ASSERT_EQ(0, cache.getFileStatus(file_, &after));
+  EXPECT_EQ(4000, after.stx_mtime.tv_sec);
+  EXPECT_NE(before.stx_ino, after.stx_ino);
+
+  ASSERT_EQ(0, unlink(file_));
+  cache.processEvents();
+  EXPECT_EQ((time_t) -1, cache.mtime(file_));
+}
+
+TEST_F(FileStatusCacheTS, caseFollowLink)
+{
+  FileStatusCache nofollow(STATX_TYPE, FileStatusCache::FSC_NONE);
+  FileStatusCache follow(STATX_MTIME, FileStatusCache::FSC_FOLLOW_LINK);
+  ASSERT_EQ(0, nofollow.init());
+  ASSERT_EQ(0, follow.init());
+
+  struct statx sx;
+  ASSERT_EQ(0, nofollow.getFileStatus(link_, &sx));
+  EXPECT_TRUE(S_ISLNK(sx.stx_mode));
+  EXPECT_EQ(1u, nofollow.size());
+
+  ASSERT_EQ(0, follow.getFileStatus(link_, &sx));
+  EXPECT_TRUE(S_ISREG(sx.stx_mode));
+  EXPECT_EQ(1000, sx.stx_mtime.tv_sec);
+  EXPECT_EQ(0u, follow.size()); // symbolic links are never cached
+}
+
+TEST_F(FileStatusCacheTS, caseWatcherThread)
+{
+  FileStatusCache cache;
+  ASSERT_EQ(0, cache.init());
+  EXPECT_EQ(1000, cache.mtime(file_));
+  touch(file_, 5000);
+  EXPECT_EQ(5000, waitForMtime(&cache, file_, 5000));
+  touch(file_, 6000);
+  EXPECT_EQ(6000, waitForMtime(&cache, file_, 6000));
+}
+
+TEST_F(FileStatusCacheTS, caseWithoutInit)
+{
+  FileStatusCache cache;
+  EXPECT_EQ(-1, cache.fd());
+  EXPECT_EQ(1000, cache.mtime(file_));
+  EXPECT_EQ(1000, cache.mtime(file_));
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(2u, cache.misses());
+  EXPECT_EQ(-1, cache.processEvents());
+}
@@ -23,12 +23,19 @@
  * You should have received a copy of the GNU General Public License
  * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <errno.h>
+#include <ftw.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
 #include <iostream>
 #include <gtest/gtest.h>
 #include "nebula/file_system.h"
 
 using nebula::FileSystem;
+using nebula::DirectoryCreator;
 
 class FileSystemTS: public testing::Test
 {
@@ -58,3 +65,310 @@ TEST_F(FileSystemTS, caseListHomeAndRoot)
   std::cout << "contents of /:" << std::endl;
   FileSystem::fileTreeTraversal("/", printItemName, NULL);
 }
+
+//---------------------------------------------------------------------------------------------------------------------
+
+static int removeItem(const char * fpath, const struct stat * sb, int typeflag, struct FTW * ftwbuf)
+{
+  return remove(fpath);
+}
+
+class FileSystemTreeWalkTS: public testing::Test
+{
+protected:
+  char base_[64];
+
+  enum
+  {
+    NUM_DIRS = 4, NUM_SUBDIRS = 3, NUM_FILES = 5
+  };
+
+  virtual void SetUp()
+  {
+    // base/{file,link}, base/d*/s*/f*
+    strcpy(base_, "testsuite_FileSystem_XXXXXX");
+    ASSERT_TRUE(mkdtemp(base_) != NULL);
+    char path[256];
+    for (int i = 0; i < NUM_DIRS; ++i) {
+      snprintf(path, sizeof(path), "%s/d%d", base_, i);
+      ASSERT_EQ(0, ::mkdir(path, 0755));
+      for (int j = 0; j < NUM_SUBDIRS; ++j) {
+        snprintf(path, sizeof(path), "%s/d%d/s%d", base_, i, j);
+        ASSERT_EQ(0, ::mkdir(path, 0755));
+        for (int k = 0; k < NUM_FILES; ++k) {
+          snprintf(path, sizeof(path), "%s/d%d/s%d/f%d", base_, i, j, k);
+          int fd = open(path, O_CREAT | O_WRONLY, 0644);
+          ASSERT_TRUE(fd >= 0);
+          close(fd);
+        }
+      }
+    }
+    snprintf(path, sizeof(path), "%s/file", base_);
+    int fd = open(path, O_CREAT | O_WRONLY, 0644);
+    ASSERT_TRUE(fd >= 0);
+    close(fd);
+    snprintf(path, sizeof(path), "%s/link", base_);
+    ASSERT_EQ(0, symlink("d0", path));
+  }
+
+  virtual void TearDown()
+  {
+    nftw(base_, removeItem, 16, FTW_DEPTH | FTW_PHYS);
+  }
+};
+
+struct WalkCounters
+{
+  volatile int dirs;
+  volatile int files;
+  volatile int links;
+  volatile int bad_paths;
+  volatile int stated;
+  const char * skip;
+};
+
+static int countEntry(const FileSystem::TreeEntry * entry, void * arg)
+{
+  WalkCounters * counters = (WalkCounters *) arg;
+  char path[512];
+  struct stat sb;
+  entry->fullPath(path, sizeof(path));
+  // base_ is relative and has no '/', so depth equals the number of '/' in the full path
+  if (lstat(path, &sb) < 0 || fstatat(entry->dir_fd, entry->name, &sb, AT_SYMLINK_NOFOLLOW) < 0 //
+      || entry->dir_path[entry->dir_path_len - 1] != '/' //
+      || entry->depth != (int) std::count(path, path + strlen(path), '/')) {
+    __sync_fetch_and_add(&counters->bad_paths, 1);
+  }
+  if (entry->sb) {
+    __sync_fetch_and_add(&counters->stated, 1);
+  }
+  switch (entry->type) {
+    case DT_DIR:
+      __sync_fetch_and_add(&counters->dirs, 1);
+      if (counters->skip && !strcmp(entry->name, counters->skip)) {
+        return FileSystem::TW_SKIP_SUBTREE;
+      }
+      break;
+    case DT_REG:
+      __sync_fetch_and_add(&counters->files, 1);
+      break;
+    case DT_LNK:
+      __sync_fetch_and_add(&counters->links, 1);
+      break;
+    default:
+      break;
+  }
+  return FileSystem::TW_CONTINUE;
+}
+
+TEST_F(FileSystemTreeWalkTS, caseTreeWalk)
+{
+  int num_threads[] =
+  { 1, 2, 4, 0 };
+  for (size_t i = 0; i < sizeof(num_threads) / sizeof(num_threads[0]); ++i) {
+    WalkCounters counters;
+    memset(&counters, 0, sizeof(counters));
+    EXPECT_EQ(0, FileSystem::treeWalk(base_, countEntry, &counters, num_threads[i]));
+    EXPECT_EQ(NUM_DIRS * (1 + NUM_SUBDIRS), counters.dirs);
+    EXPECT_EQ(NUM_DIRS * NUM_SUBDIRS * NUM_FILES + 1, counters.files);
+    EXPECT_EQ(1, counters.links);
+    EXPECT_EQ(0, counters.bad_paths);
+  }
+}
+
+TEST_F(FileSystemTreeWalkTS, caseTreeWalkStatAndSkip)
+{
+  WalkCounters counters;
+  memset(&counters, 0, sizeof(counters));
+  counters.skip = "d1";
+  EXPECT_EQ(0, FileSystem::treeWalk(base_, countEntry, &counters, 2, FileSystem::TW_STAT));
+  EXPECT_EQ(NUM_DIRS + (NUM_DIRS - 1) * NUM_SUBDIRS, counters.dirs);
+  EXPECT_EQ((NUM_DIRS - 1) * NUM_SUBDIRS * NUM_FILES + 1, counters.files);
+  EXPECT_EQ(counters.dirs + counters.files + counters.links, counters.stated);
+}
+
+static int stopAtFile(const FileSystem::TreeEntry * entry, void * arg)
+{
+  __sync_fetch_and_add((volatile int *) arg, 1);
+  return entry->type == DT_REG ? 42 : FileSystem::TW_CONTINUE;
+}
+
+TEST_F(FileSystemTreeWalkTS, caseTreeWalkStop)
+{
+  volatile int visited = 0;
+  EXPECT_EQ(42, FileSystem::treeWalk(base_, stopAtFile, (void *) &visited, 1));
+  EXPECT_TRUE(visited < NUM_DIRS * (1 + NUM_SUBDIRS) + NUM_DIRS * NUM_SUBDIRS * NUM_FILES + 2);
+  EXPECT_EQ(-1, FileSystem::treeWalk("/nonexistent/testsuite_FileSystem", stopAtFile, (void *) &visited));
+}
+
+TEST_F(FileSystemTreeWalkTS, caseFileStatus)
+{
+  char path[256], link[256];
+  snprintf(path, sizeof(path), "%s/file", base_);
+  snprintf(link, sizeof(link), "%s/link", base_);
+  struct timespec times[2];
+  times[0].tv_sec = times[1].tv_sec = 1000000000;
+  times[0].tv_nsec = times[1].tv_nsec = 0;
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path, times, 0));
+  EXPECT_EQ(1000000000, FileSystem::mtime(path));
+  EXPECT_EQ(1000000000, FileSystem::atime(path));
+
+  struct statx sx;
+  ASSERT_EQ(0, FileSystem::getFileStatusX(path, STATX_MTIME | STATX_SIZE, &sx));
+  EXPECT_TRUE(sx.stx_mask & STATX_MTIME);
+  EXPECT_EQ(1000000000, sx.stx_mtime.tv_sec);
+  EXPECT_EQ(0u, sx.stx_size);
+
+  // link -> d0
+  ASSERT_EQ(0, FileSystem::getFileStatusX(link, STATX_TYPE, &sx));
+  EXPECT_TRUE(S_ISLNK(sx.stx_mode));
+  ASSERT_EQ(0, FileSystem::getFileStatusX(link, STATX_TYPE, &sx, true));
+  EXPECT_TRUE(S_ISDIR(sx.stx_mode));
+  int dir_fd = open(base_, O_RDONLY | O_DIRECTORY);
+  EXPECT_EQ(0, FileSystem::getFileStatusX("file", STATX_TYPE, &sx, false, dir_fd));
+  EXPECT_TRUE(S_ISREG(sx.stx_mode));
+  close(dir_fd);
+
+  struct stat sb;
+  ASSERT_EQ(0, FileSystem::getFileStatus(link, &sb, true));
+  EXPECT_TRUE(S_ISDIR(sb.st_mode));
+  ASSERT_EQ(0, FileSystem::getFileStatus(link, &sb));
+  EXPECT_TRUE(S_ISLNK(sb.st_mode));
+
+  snprintf(path, sizeof(path), "%s/missing", base_);
+  EXPECT_EQ(-1, FileSystem::getFileStatusX(path, STATX_MTIME, &sx));
+  EXPECT_EQ(ENOENT, errno);
+  EXPECT_EQ((time_t) -1, FileSystem::mtime(path));
+}
+
+TEST_F(FileSystemTreeWalkTS, caseParseMode)
+{
+  mode_t mode;
+  EXPECT_EQ(0, FileSystem::parseMode("rwxr-xr-x", &mode));
+  EXPECT_EQ(0755u, mode);
+  EXPECT_EQ(0, FileSystem::parseMode("rw-------", &mode));
+  EXPECT_EQ(0600u, mode);
+  EXPECT_EQ(0, FileSystem::parseMode("rwsr-S--T", &mode));
+  EXPECT_EQ((mode_t) (S_ISUID | S_ISGID | S_ISVTX | 0740), mode);
+  EXPECT_EQ(-1, FileSystem::parseMode("rwxr-xr-", &mode));
+  EXPECT_EQ(-1, FileSystem::parseMode("rwxr-xr-xx", &mode));
+  EXPECT_EQ(-1, FileSystem::parseMode("0755", &mode));
+}
+
+TEST_F(FileSystemTreeWalkTS, caseMkdir)
+{
+  char path[256];
+  struct stat sb;
+  snprintf(path, sizeof(path), "%s/m/n/o", base_);
+  EXPECT_EQ(-1, FileSystem::mkdir(path));
+  EXPECT_EQ(ENOENT, errno);
+  EXPECT_EQ(0, FileSystem::mkdir(path, true, "rwx------"));
+  ASSERT_EQ(0, stat(path, &sb));
+  EXPECT_TRUE(S_ISDIR(sb.st_mode));
+  EXPECT_EQ(0700u, sb.st_mode & 0777);
+  EXPECT_EQ(0, FileSystem::mkdir(path, true));
+  EXPECT_EQ(-1, FileSystem::mkdir(path, true, "bad"));
+  EXPECT_EQ(EINVAL, errno);
+
+  snprintf(path, sizeof(path), "%s/file/x", base_);
+  EXPECT_EQ(-1, FileSystem::mkdir(path, true));
+  snprintf(path, sizeof(path), "%s/file", base_);
+  EXPECT_EQ(-1, FileSystem::mkdir(path, true));
+  EXPECT_EQ(EEXIST, errno);
+}
+
+TEST_F(FileSystemTreeWalkTS, caseDirectoryCreator)
+{
+  DirectoryCreator creator;
+  char path[256];
+  struct stat sb;
+  for (int i = 0; i < 10; ++i) {
+    snprintf(path, sizeof(path), "%s/c/x/y%d//", base_, i);
+    EXPECT_EQ(0, creator.create(path));
+    EXPECT_EQ(0, stat(path, &sb));
+  }
+  // base_ (found to exist), base_/c, base_/c/x and the 10 leaves
+  EXPECT_EQ(13u, creator.size());
+
+  // removed behind its back
+  snprintf(path, sizeof(path), "%s/c", base_);
+  EXPECT_EQ(0, FileSystem::rmdir(path, true));
+  snprintf(path, sizeof(path), "%s/c/x/z", base_);
+  EXPECT_EQ(0, creator.create(path));
+  EXPECT_EQ(0, stat(path, &sb));
+
+  // the very directory removed, then asked for again
+  EXPECT_EQ(0, rmdir(path));
+  EXPECT_EQ(0, creator.create(path));
+  EXPECT_EQ(0, stat(path, &sb));
+  EXPECT_TRUE(S_ISDIR(sb.st_mode));
+  snprintf(path, sizeof(path), "%s/c", base_);
+  EXPECT_EQ(0, FileSystem::rmdir(path, true));
+  snprintf(path, sizeof(path), "%s/c/x/z", base_);
+  EXPECT_EQ(0, creator.create(path));
+  EXPECT_EQ(0, stat(path, &sb));
+}
+
+TEST_F(FileSystemTreeWalkTS, caseRemoveTree)
+{
+  char path[256];
+  snprintf(path, sizeof(path), "%s/d0", base_);
+  EXPECT_EQ(-1, FileSystem::rmdir(path));
+  EXPECT_EQ(ENOTEMPTY, errno);
+
+  FileSystem::RemoveProgress progress;
+  memset(&progress, 0, sizeof(progress));
+  EXPECT_EQ(0, FileSystem::removeTree(path, &progress, 4));
+  EXPECT_EQ((uint64_t) NUM_SUBDIRS * NUM_FILES, progress.files);
+  EXPECT_EQ((uint64_t) NUM_SUBDIRS + 1, progress.directories);
+  EXPECT_EQ(0u, progress.errors);
+  EXPECT_EQ(-1, access(path, F_OK));
+
+  snprintf(path, sizeof(path), "%s/file", base_);
+  EXPECT_EQ(-1, FileSystem::rmdir(path, true));
+  EXPECT_EQ(ENOTDIR, errno);
+  EXPECT_EQ(0, access(path, F_OK));
+  EXPECT_EQ(0, FileSystem::removeTree(path));
+  EXPECT_EQ(-1, access(path, F_OK));
+
+  // base_/link still points to the removed d0, only the link itself goes away
+  memset(&progress, 0, sizeof(progress));
+  EXPECT_EQ(0, FileSystem::removeTree(base_, &progress, 1));
+  EXPECT_EQ((uint64_t) (NUM_DIRS - 1) * NUM_SUBDIRS * NUM_FILES + 1, progress.files);
+  EXPECT_EQ(-1, access(base_, F_OK));
+  EXPECT_EQ(-1, FileSystem::removeTree(base_));
+  EXPECT_EQ(ENOENT, errno);
+}
+
+TEST_F(FileSystemTreeWalkTS, caseRemoveDeepTree)
+{
+  // far deeper than the number of directories kept open
+  const int depth = 300;
+  char path[256];
+  snprintf(path, sizeof(path), "%s/deep", base_);
+  ASSERT_EQ(0, mkdir(path, 0755));
+  int fd = open(path, O_RDONLY | O_DIRECTORY);
+  ASSERT_TRUE(fd >= 0);
+  for (int i = 0; i < depth; ++i) {
+    ASSERT_EQ(0, mkdirat(fd, "d", 0755));
+    if (i % 7 == 0) {
+      ASSERT_EQ(0, mkdirat(fd, "e", 0755));
+    }
+    int sub_fd = openat(fd, "d", O_RDONLY | O_DIRECTORY);
+    ASSERT_TRUE(sub_fd >= 0);
+    close(fd);
+    fd = sub_fd;
+  }
+  int file_fd = openat(fd, "file", O_CREAT | O_WRONLY, 0644);
+  ASSERT_TRUE(file_fd >= 0);
+  close(file_fd);
+  close(fd);
+
+  FileSystem::RemoveProgress progress;
+  memset(&progress, 0, sizeof(progress));
+  EXPECT_EQ(0, FileSystem::removeTree(path, &progress, 2));
+  EXPECT_EQ(1u, progress.files);
+  EXPECT_EQ((uint64_t) depth + (depth + 6) / 7 + 1, progress.directories);
+  EXPECT_EQ(0u, progress.errors);
+  EXPECT_EQ(-1, access(path, F_OK));
+}
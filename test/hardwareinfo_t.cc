@@ -24,12 +24,20 @@
  * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <ftw.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <iostream>
+#include <string>
 #include <gtest/gtest.h>
 #include "nebula/hardwareinfo.h"
 
 using nebula::HardwareInfo;
 
+// before main(), possibly before the static data of HardwareInfo is initialized
+static int early_online_cpus = HardwareInfo::topology().numOnlineCpus();
+
 class HardwareInfoTS: public testing::Test
 {
 protected:
@@ -52,3 +60,199 @@ TEST_F(HardwareInfoTS, caseSimple)
       << "Memory total:   " << HardwareInfo::memoryTotal() << std::endl //
       << "Swap total:     " << HardwareInfo::swapTotal() << std::endl;
 }
+
+TEST_F(HardwareInfoTS, caseCpuFeatures)
+{
+  using nebula::CpuFeature;
+  using nebula::SimdLevel;
+
+  uint64_t features = HardwareInfo::cpuFeatures();
+  std::cout << "CPU features:  ";
+  for (int i = 0; i < CpuFeature::NUM_FEATURES; ++i) {
+    if (features & (1ULL << i)) {
+      std::cout << " " << CpuFeature::toString((CpuFeature::Constants) (1 << i));
+    }
+  }
+  std::cout << std::endl << "SIMD level:     " << SimdLevel::toString(HardwareInfo::simdLevel()) << std::endl;
+
+  EXPECT_EQ(0U, features & ~((1ULL << CpuFeature::NUM_FEATURES) - 1));
+  EXPECT_TRUE(HardwareInfo::hasCpuFeatures(0));
+  EXPECT_TRUE(HardwareInfo::hasCpuFeatures(SimdLevel::requiredFeatures(HardwareInfo::simdLevel())));
+  if (HardwareInfo::simdLevel() + 1 < SimdLevel::NUM_LEVELS) {
+    SimdLevel::Constants next = (SimdLevel::Constants) (HardwareInfo::simdLevel() + 1);
+    EXPECT_FALSE(HardwareInfo::hasCpuFeatures(SimdLevel::requiredFeatures(next)));
+  }
+  if (features & CpuFeature::AVX2) {
+    EXPECT_TRUE(features & CpuFeature::AVX);
+  }
+  if (features & CpuFeature::AVX512BW) {
+    EXPECT_TRUE(features & CpuFeature::AVX512F);
+  }
+#if defined(__x86_64__)
+  EXPECT_TRUE(features & CpuFeature::SSE2);
+#endif
+}
+
+TEST_F(HardwareInfoTS, caseParseCpuList)
+{
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  EXPECT_EQ(7, HardwareInfo::parseCpuList("0-3,8,10-11\n", &cpus));
+  EXPECT_TRUE(CPU_ISSET(2, &cpus));
+  EXPECT_TRUE(CPU_ISSET(8, &cpus));
+  EXPECT_FALSE(CPU_ISSET(9, &cpus));
+  EXPECT_EQ(7, CPU_COUNT(&cpus));
+  EXPECT_EQ(0, HardwareInfo::parseCpuList("", &cpus));
+  EXPECT_EQ(-1, HardwareInfo::parseCpuList("3-1", &cpus));
+  EXPECT_EQ(-1, HardwareInfo::parseCpuList("0,a", &cpus));
+}
+
+static int removeItem(const char * fpath, const struct stat * sb, int typeflag, struct FTW * ftwbuf)
+{
+  return remove(fpath);
+}
+
+/*
+ * A copy of the relevant parts of /sys and /proc of a machine with two
+ * packages of two cores with two SMT threads each, processor 7 offline,
+ * one NUMA node per package, a cpuset of 0-5 and a quota of 1.5 processors.
+ */
+class CpuTopologyTS: public testing::Test
+{
+protected:
+  char root_[64];
+
+  void writeFile(const std::string & path, const std::string & content)
+  {
+    std::string full = std::string(root_) + path;
+    for (size_t pos = full.find('/', strlen(root_) + 1); pos != std::string::npos; pos = full.find('/', pos + 1)) {
+      mkdir(full.substr(0, pos).c_str(), 0755);
+    }
+    FILE * fout = fopen(full.c_str(), "w");
+    ASSERT_TRUE(fout != NULL);
+    fputs(content.c_str(), fout);
+    fclose(fout);
+  }
+
+  virtual void SetUp()
+  {
+    strcpy(root_, "testsuite_CpuTopology_XXXXXX");
+    ASSERT_TRUE(mkdtemp(root_) != NULL);
+    writeFile("/sys/devices/system/cpu/possible", "0-7\n");
+    writeFile("/sys/devices/system/cpu/online", "0-6\n");
+    for (int cpu = 0; cpu < 7; ++cpu) {
+      char dir[128], buf[64];
+      int package = cpu / 4, core = (cpu % 4) / 2;
+      snprintf(dir, sizeof(dir), "/sys/devices/system/cpu/cpu%d/", cpu);
+      snprintf(buf, sizeof(buf), "%d\n", package);
+      writeFile(std::string(dir) + "topology/physical_package_id", buf);
+      snprintf(buf, sizeof(buf), "%d\n", core);
+      writeFile(std::string(dir) + "topology/core_id", buf);
+      snprintf(buf, sizeof(buf), "%d-%d\n", cpu & ~1, cpu | 1);
+      writeFile(std::string(dir) + "topology/thread_siblings_list", buf);
+
+      const char * types[] =
+      { "Data", "Instruction", "Unified", "Unified" };
+      const char * sizes[] =
+      { "32K", "32K", "1024K", "16M" };
+      for (int idx = 0; idx < 4; ++idx) {
+        char index[160];
+        snprintf(index, sizeof(index), "%scache/index%d/", dir, idx);
+        snprintf(buf, sizeof(buf), "%d\n", idx < 2 ? 1 : idx);
+        writeFile(std::string(index) + "level", buf);
+        writeFile(std::string(index) + "type", std::string(types[idx]) + "\n");
+        writeFile(std::string(index) + "size", std::string(sizes[idx]) + "\n");
+        writeFile(std::string(index) + "coherency_line_size", "64\n");
+        writeFile(std::string(index) + "ways_of_associativity", "8\n");
+        if (idx < 3) {
+          snprintf(buf, sizeof(buf), "%d-%d\n", cpu & ~1, cpu | 1);
+        }
+        else {
+          snprintf(buf, sizeof(buf), "%d-%d\n", package * 4, package * 4 + 3);
+        }
+        writeFile(std::string(index) + "shared_cpu_list", buf);
+      }
+    }
+    writeFile("/sys/devices/system/node/online", "0-1\n");
+    writeFile("/sys/devices/system/node/node0/cpulist", "0-3\n");
+    writeFile("/sys/devices/system/node/node0/distance", "10 21\n");
+    writeFile("/sys/devices/system/node/node0/meminfo", "Node 0 MemTotal:       16384 kB\nNode 0 MemFree: 1 kB\n");
+    writeFile("/sys/devices/system/node/node1/cpulist", "4-7\n");
+    writeFile("/sys/devices/system/node/node1/distance", "21 10\n");
+    writeFile("/sys/devices/system/node/node1/meminfo", "Node 1 MemTotal:       32768 kB\n");
+    writeFile("/proc/self/status", "Name:\ttest\nCpus_allowed:\t3f\nCpus_allowed_list:\t0-5\n");
+    writeFile("/proc/self/cgroup", "0::/service/worker\n");
+    writeFile("/sys/fs/cgroup/service/cpu.max", "200000 100000\n");
+    writeFile("/sys/fs/cgroup/service/worker/cpu.max", "150000 100000\n");
+  }
+
+  virtual void TearDown()
+  {
+    nftw(root_, removeItem, 16, FTW_DEPTH | FTW_PHYS);
+  }
+};
+
+TEST_F(CpuTopologyTS, caseFakeMachine)
+{
+  nebula::CpuTopology topology;
+  ASSERT_EQ(0, topology.load(root_));
+  EXPECT_EQ(8u, topology.cpus().size());
+  EXPECT_EQ(7, topology.numOnlineCpus());
+  EXPECT_EQ(6, topology.numAllowedCpus());
+  EXPECT_EQ(4, topology.numPhysicalCores());
+  EXPECT_EQ(2, topology.numPackages());
+  EXPECT_FALSE(topology.cpus()[7].online);
+  EXPECT_FALSE(topology.cpus()[6].allowed);
+  EXPECT_EQ(1, topology.cpus()[5].package);
+  EXPECT_EQ(0, topology.cpus()[5].core);
+  EXPECT_TRUE(CPU_ISSET(4, &topology.cpus()[5].siblings));
+
+  // 4 cores with L1d, L1i and L2 each, 2 L3
+  EXPECT_EQ(14u, topology.caches().size());
+  const nebula::CpuTopology::Cache * l1i = topology.cache(1, 3, true);
+  ASSERT_TRUE(l1i != NULL);
+  EXPECT_STREQ("Instruction", l1i->type);
+  EXPECT_EQ(32u << 10, l1i->size);
+  const nebula::CpuTopology::Cache * l3 = topology.cache(3, 5);
+  ASSERT_TRUE(l3 != NULL);
+  EXPECT_EQ(16u << 20, l3->size);
+  EXPECT_EQ(4, l3->num_sharing);
+  EXPECT_EQ(2, topology.cache(2, 1)->num_sharing);
+  EXPECT_TRUE(topology.cache(4) == NULL);
+  EXPECT_EQ(64, topology.cacheLineSize());
+
+  EXPECT_EQ(2, topology.numNodes());
+  EXPECT_EQ(21, topology.distance(0, 1));
+  EXPECT_EQ(10, topology.distance(1, 1));
+  EXPECT_EQ(-1, topology.distance(0, 2));
+  EXPECT_EQ(32768u << 10, topology.nodes()[1].memory_total);
+  EXPECT_EQ(1, topology.cpus()[6].node);
+
+  EXPECT_DOUBLE_EQ(1.5, topology.cpuQuota());
+  EXPECT_EQ(2, topology.effectiveCpus());
+}
+
+TEST_F(CpuTopologyTS, caseCgroupV1)
+{
+  writeFile("/proc/self/cgroup", "4:memory:/x\n3:cpu,cpuacct:/batch\n");
+  writeFile("/sys/fs/cgroup/cpu,cpuacct/batch/cpu.cfs_quota_us", "400000\n");
+  writeFile("/sys/fs/cgroup/cpu,cpuacct/batch/cpu.cfs_period_us", "100000\n");
+  nebula::CpuTopology topology;
+  ASSERT_EQ(0, topology.load(root_));
+  EXPECT_DOUBLE_EQ(4, topology.cpuQuota());
+  EXPECT_EQ(4, topology.effectiveCpus());
+}
+
+TEST_F(CpuTopologyTS, caseThisMachine)
+{
+  const nebula::CpuTopology & topology = HardwareInfo::topology();
+  EXPECT_TRUE(topology.numOnlineCpus() >= 1);
+  EXPECT_TRUE(topology.numPhysicalCores() >= 1);
+  EXPECT_TRUE(topology.numPhysicalCores() <= topology.numOnlineCpus());
+  EXPECT_TRUE(topology.effectiveCpus() >= 1);
+  EXPECT_TRUE(topology.effectiveCpus() <= topology.numOnlineCpus());
+  EXPECT_EQ(early_online_cpus, topology.numOnlineCpus());
+
+  nebula::CpuTopology missing;
+  EXPECT_EQ(-1, missing.load("/nonexistent/testsuite_CpuTopology"));
+}
@@ -0,0 +1,249 @@
+/*
+ * hash_map_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "nebula/hash_map.h"
+#include "nebula/random.h"
+
+using nebula::FlatHashMap;
+
+namespace
+{
+  // counts live instances, to check that every entry is destroyed once
+  struct Counted
+  {
+    static int live;
+    int value;
+
+    Counted(int v = 0) :
+      value(v)
+    {
+      ++live;
+    }
+
+    Counted(const Counted & other) :
+      value(other.value)
+    {
+      ++live;
+    }
+
+    ~Counted()
+    {
+      --live;
+    }
+  };
+
+  int Counted::live = 0;
+
+  // every key in the same probe sequence, with the same control bits
+  struct CollidingHash
+  {
+    size_t operator()(int) const
+    {
+      return 42;
+    }
+  };
+}
+
+class HashMapTS: public testing::Test
+{
+};
+
+TEST_F(HashMapTS, caseSimple)
+{
+  FlatHashMap<int, int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0u, map.capacity());
+  EXPECT_TRUE(map.begin() == map.end());
+  EXPECT_TRUE(map.find(1) == map.end());
+  EXPECT_EQ(0u, map.erase(1));
+
+  EXPECT_TRUE(map.insert(1, 10).second);
+  EXPECT_FALSE(map.insert(1, 11).second);
+  EXPECT_EQ(10, map.find(1)->second);
+  map[2] = 20;
+  map[3] += 30;
+  EXPECT_EQ(3u, map.size());
+  EXPECT_EQ(15u, map.capacity());
+  EXPECT_EQ(30, map[3]);
+  EXPECT_TRUE(map.contains(2));
+  EXPECT_FALSE(map.contains(4));
+
+  EXPECT_EQ(1u, map.erase(2));
+  EXPECT_EQ(0u, map.erase(2));
+  EXPECT_FALSE(map.contains(2));
+  EXPECT_EQ(2u, map.size());
+
+  int sum = 0;
+  for (FlatHashMap<int, int>::const_iterator it = map.begin(); it != map.end(); ++it) {
+    sum += it->first * 100 + it->second;
+  }
+  EXPECT_EQ(100 + 10 + 300 + 30, sum);
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(15u, map.capacity());
+  EXPECT_TRUE(map.begin() == map.end());
+}
+
+TEST_F(HashMapTS, caseRandomAgainstStdMap)
+{
+  FlatHashMap<uint64_t, uint64_t> map;
+  std::map<uint64_t, uint64_t> expected;
+  nebula::Prng prng(5);
+  for (int round = 0; round < 200000; ++round) {
+    uint64_t key = prng.nextBelow(5000);
+    switch (prng.nextBelow(3)) {
+      case 0:
+        ASSERT_EQ(expected.insert(std::make_pair(key, round)).second, map.insert(key, round).second);
+        break;
+      case 1:
+        ASSERT_EQ(expected.erase(key), map.erase(key));
+        break;
+      default:
+        ASSERT_EQ(expected.count(key) != 0, map.contains(key));
+        if (expected.count(key)) {
+          ASSERT_EQ(expected[key], map.find(key)->second);
+        }
+    }
+    ASSERT_EQ(expected.size(), map.size());
+  }
+
+  size_t visited = 0;
+  for (FlatHashMap<uint64_t, uint64_t>::iterator it = map.begin(); it != map.end(); ++it, ++visited) {
+    ASSERT_EQ(expected[it->first], it->second);
+  }
+  EXPECT_EQ(expected.size(), visited);
+  // churn over a bounded key set must not grow the table without bound
+  EXPECT_LE(map.capacity(), 16383u);
+}
+
+TEST_F(HashMapTS, caseCollisions)
+{
+  FlatHashMap<int, int, CollidingHash> map;
+  for (int i = 0; i < 100; ++i) {
+    map[i] = i;
+  }
+  for (int i = 0; i < 100; i += 2) {
+    EXPECT_EQ(1u, map.erase(i));
+  }
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i % 2 == 1, map.contains(i)) << i;
+  }
+  for (int i = 0; i < 100; i += 2) {
+    map[i] = -i;
+  }
+  EXPECT_EQ(100u, map.size());
+  EXPECT_EQ(-40, map[40]);
+}
+
+TEST_F(HashMapTS, caseReserveKeepsEntriesInPlace)
+{
+  FlatHashMap<int, int> map;
+  ASSERT_EQ(0, map.reserve(1000));
+  size_t capacity = map.capacity();
+  EXPECT_GE(capacity - capacity / 8, 1000u);
+
+  std::vector<int *> values;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back(&map[i]);
+    *values.back() = i;
+  }
+  EXPECT_EQ(capacity, map.capacity());
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(values[i], &map[i]);
+    EXPECT_EQ(i, *values[i]);
+  }
+  EXPECT_EQ(0, map.reserve(10));
+  EXPECT_EQ(capacity, map.capacity());
+}
+
+TEST_F(HashMapTS, caseEraseWhileIterating)
+{
+  FlatHashMap<int, Counted> map;
+  for (int i = 0; i < 1000; ++i) {
+    map.insert(i, Counted(i));
+  }
+  EXPECT_EQ(1000, Counted::live);
+
+  for (FlatHashMap<int, Counted>::iterator it = map.begin(); it != map.end();) {
+    if (it->first % 3) {
+      it = map.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+  EXPECT_EQ(334u, map.size());
+  EXPECT_EQ(334, Counted::live);
+  for (FlatHashMap<int, Counted>::iterator it = map.begin(); it != map.end(); ++it) {
+    EXPECT_EQ(0, it->first % 3);
+    EXPECT_EQ(it->first, it->second.value);
+  }
+
+  // growing copies the entries over and destroys the old ones
+  for (int i = 1000; i < 5000; ++i) {
+    map[i].value = i;
+  }
+  EXPECT_EQ(4334, Counted::live);
+  map.clear();
+  EXPECT_EQ(0, Counted::live);
+  map[1].value = 1;
+  {
+    FlatHashMap<int, Counted> other;
+    other.swap(map);
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(1, Counted::live);
+  }
+  EXPECT_EQ(0, Counted::live);
+}
+
+TEST_F(HashMapTS, caseHeterogeneousLookup)
+{
+  FlatHashMap<std::string, int> map;
+  char name[32];
+  for (int i = 0; i < 300; ++i) {
+    snprintf(name, sizeof(name), "client-%d", i);
+    map[name] = i;
+  }
+  EXPECT_EQ(300u, map.size());
+  EXPECT_EQ(17, map.find("client-17")->second);
+  EXPECT_TRUE(map.contains("client-299"));
+  EXPECT_FALSE(map.contains("client-300"));
+  EXPECT_TRUE(map.find(std::string("client-5")) != map.end());
+  EXPECT_EQ(1u, map.erase("client-5"));
+  EXPECT_FALSE(map.contains("client-5"));
+
+  // the const char * and std::string hashes agree, including tails
+  nebula::FlatHash<std::string> hash;
+  for (size_t len = 0; len < 40; ++len) {
+    std::string s(len, 'x');
+    EXPECT_EQ(hash(s), hash(s.c_str()));
+  }
+}
@@ -0,0 +1,176 @@
+/*
+ * io_buffer_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <string>
+#include <gtest/gtest.h>
+#include "nebula/async_io.h"
+#include "nebula/io_buffer.h"
+
+using nebula::IoBlock;
+using nebula::IoBuffer;
+
+namespace
+{
+  std::string pattern(size_t len, int seed)
+  {
+    std::string s(len, '\0');
+    for (size_t i = 0; i < len; ++i) {
+      s[i] = (char) ('a' + (i * 7 + seed) % 26);
+    }
+    return s;
+  }
+
+  std::string contents(const IoBuffer & buf)
+  {
+    std::string s(buf.size(), '\0');
+    EXPECT_EQ(buf.size(), buf.copyOut(&s[0], s.size()));
+    return s;
+  }
+}
+
+class IoBufferTS: public testing::Test
+{
+};
+
+TEST_F(IoBufferTS, caseAppendPrepend)
+{
+  IoBuffer buf;
+  EXPECT_TRUE(buf.empty());
+  ASSERT_EQ(0, buf.append("world", 5));
+  ASSERT_EQ(0, buf.prepend("hello, ", 7));
+  EXPECT_EQ("hello, world", contents(buf));
+
+  // small appends share a block
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(0, buf.append("!", 1));
+  }
+  EXPECT_EQ(2u, buf.numSlices());
+
+  std::string big = pattern(100000, 1);
+  ASSERT_EQ(0, buf.append(big.data(), big.size()));
+  std::string front = pattern(40000, 2);
+  ASSERT_EQ(0, buf.prepend(front.data(), front.size()));
+  std::string expected = front + "hello, world" + std::string(100, '!') + big;
+  EXPECT_EQ(expected.size(), buf.size());
+  EXPECT_EQ(expected, contents(buf));
+
+  buf.consume(front.size() + 7);
+  EXPECT_EQ(expected.substr(front.size() + 7), contents(buf));
+  buf.consume(1 << 30);
+  EXPECT_TRUE(buf.empty());
+  EXPECT_EQ(0u, buf.numSlices());
+}
+
+TEST_F(IoBufferTS, caseSplitAndShare)
+{
+  IoBuffer buf;
+  std::string data = pattern(50000, 3);
+  ASSERT_EQ(0, buf.append(data.data(), data.size()));
+
+  IoBuffer head;
+  buf.split(20000, &head);
+  EXPECT_EQ(data.substr(0, 20000), contents(head));
+  EXPECT_EQ(data.substr(20000), contents(buf));
+  // the slice cut in two shares its block, which neither side may write
+  EXPECT_EQ(2, head.slice(head.numSlices() - 1).block->refs);
+  ASSERT_EQ(0, head.append("xyz", 3));
+  EXPECT_EQ(data.substr(20000), contents(buf));
+  EXPECT_EQ(data.substr(0, 20000) + "xyz", contents(head));
+
+  IoBuffer copy;
+  copy.appendShared(buf);
+  EXPECT_EQ(contents(buf), contents(copy));
+  ASSERT_EQ(0, buf.append("tail", 4));
+  ASSERT_EQ(0, copy.append("other", 5));
+  EXPECT_EQ(data.substr(20000) + "tail", contents(buf));
+  EXPECT_EQ(data.substr(20000) + "other", contents(copy));
+
+  size_t total = head.size() + buf.size();
+  head.append(buf);
+  EXPECT_TRUE(buf.empty());
+  EXPECT_EQ(total, head.size());
+
+  head.appendShared(head);
+  EXPECT_EQ(2 * total, head.size());
+}
+
+TEST_F(IoBufferTS, caseCoalesce)
+{
+  IoBuffer buf;
+  std::string data = pattern(IoBlock::standardCapacity() * 3, 4);
+  ASSERT_EQ(0, buf.append(data.data(), 100));
+  IoBuffer other;
+  ASSERT_EQ(0, other.append(data.data() + 100, data.size() - 100));
+  buf.append(other);
+  EXPECT_EQ(data.substr(0, 50), std::string(buf.coalesce(50), 50));
+  EXPECT_EQ(data.substr(0, 1000), std::string(buf.coalesce(1000), 1000));
+  // larger than a block
+  size_t len = IoBlock::standardCapacity() * 2;
+  EXPECT_EQ(data.substr(0, len), std::string(buf.coalesce(len), len));
+  EXPECT_EQ(len, buf.slice(0).size());
+  EXPECT_EQ(data, contents(buf));
+  EXPECT_TRUE(buf.coalesce(0) != NULL);
+}
+
+TEST_F(IoBufferTS, caseReadWriteNonblocking)
+{
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT_EQ(0, nebula::AsyncIo::setNonblock(fds[0]));
+  ASSERT_EQ(0, nebula::AsyncIo::setNonblock(fds[1]));
+
+  IoBuffer out, in;
+  std::string data = pattern(3 << 20, 5);
+  ASSERT_EQ(0, out.append(data.data(), data.size()));
+
+  errno = 0;
+  EXPECT_EQ(-1, in.readFrom(fds[1]));
+  EXPECT_EQ(EAGAIN, errno);
+  EXPECT_TRUE(in.empty());
+
+  // alternate until everything went through the socket
+  while (!out.empty() || in.size() < data.size()) {
+    ssize_t nw;
+    while (!out.empty() && (nw = out.writeTo(fds[0])) > 0) {
+    }
+    if (!out.empty()) {
+      ASSERT_EQ(EAGAIN, errno);
+    }
+    ssize_t nr;
+    while ((nr = in.readFrom(fds[1])) > 0) {
+    }
+    ASSERT_EQ(-1, nr);
+    ASSERT_EQ(EAGAIN, errno);
+  }
+  EXPECT_EQ(data, contents(in));
+
+  close(fds[0]);
+  EXPECT_EQ(0, in.readFrom(fds[1]));
+  close(fds[1]);
+}
@@ -0,0 +1,177 @@
+/*
+ * multiversion_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "nebula/multiversion.h"
+#include "nebula/string.h"
+
+using nebula::HardwareInfo;
+using nebula::Multiversion;
+using nebula::MultiversionBase;
+using nebula::SimdLevel;
+using nebula::String;
+
+namespace
+{
+  int implScalar()
+  {
+    return SimdLevel::SCALAR;
+  }
+
+  int implSse42()
+  {
+    return SimdLevel::SSE42;
+  }
+
+  int implAvx2()
+  {
+    return SimdLevel::AVX2;
+  }
+
+  int implAvx512()
+  {
+    return SimdLevel::AVX512;
+  }
+
+  extern Multiversion<int (*)()> late_impl;
+
+  // dynamically initialized before late_impl in declaration order, and so
+  // only works because late_impl is constant initialized
+  int early_result = late_impl.get()();
+
+  Multiversion<int (*)()> late_impl(implScalar, NULL, NULL, NULL);
+}
+
+class MultiversionTS: public testing::Test
+{
+protected:
+  SimdLevel::Constants saved_limit_;
+
+  virtual void SetUp()
+  {
+    saved_limit_ = MultiversionBase::levelLimit();
+  }
+
+  virtual void TearDown()
+  {
+    MultiversionBase::limitLevel(saved_limit_);
+  }
+
+  static SimdLevel::Constants expected(SimdLevel::Constants limit)
+  {
+    return limit < HardwareInfo::simdLevel() ? limit : HardwareInfo::simdLevel();
+  }
+};
+
+TEST_F(MultiversionTS, caseResolve)
+{
+  Multiversion<int (*)()> all(implScalar, implSse42, implAvx2, implAvx512);
+  EXPECT_EQ(MultiversionBase::level(), all.selectedLevel());
+  EXPECT_EQ((int) MultiversionBase::level(), all.get()());
+
+  for (int i = SimdLevel::SCALAR; i < SimdLevel::NUM_LEVELS; ++i) {
+    SimdLevel::Constants limit = (SimdLevel::Constants) i;
+    MultiversionBase::limitLevel(limit);
+    EXPECT_EQ(limit, MultiversionBase::levelLimit());
+    EXPECT_EQ(expected(limit), MultiversionBase::level());
+    EXPECT_EQ(expected(limit), all.selectedLevel()) << SimdLevel::toString(limit);
+    EXPECT_EQ((int) expected(limit), all.get()());
+  }
+}
+
+TEST_F(MultiversionTS, caseMissingLevels)
+{
+  // only scalar and AVX2 implementations, SSE4.2 and AVX-512 fall back
+  Multiversion<int (*)()> sparse(implScalar, NULL, implAvx2, NULL);
+  EXPECT_EQ(NULL, sparse.implementation(SimdLevel::SSE42));
+  EXPECT_TRUE(sparse.implementation(SimdLevel::AVX2) == implAvx2);
+
+  MultiversionBase::limitLevel(SimdLevel::SSE42);
+  EXPECT_EQ(SimdLevel::SCALAR, sparse.selectedLevel());
+  EXPECT_EQ(SimdLevel::SCALAR, sparse.get()());
+
+  MultiversionBase::limitLevel(SimdLevel::AVX512);
+  SimdLevel::Constants level = HardwareInfo::simdLevel() >= SimdLevel::AVX2 ? SimdLevel::AVX2 : SimdLevel::SCALAR;
+  EXPECT_EQ(level, sparse.selectedLevel());
+  EXPECT_EQ(level, sparse.get()());
+}
+
+TEST_F(MultiversionTS, caseStaticInitialization)
+{
+  EXPECT_EQ(SimdLevel::SCALAR, early_result);
+  EXPECT_EQ(SimdLevel::SCALAR, late_impl.selectedLevel());
+  EXPECT_EQ(SimdLevel::SCALAR, late_impl.get()());
+}
+
+TEST_F(MultiversionTS, caseLevelNames)
+{
+  for (int i = SimdLevel::SCALAR; i < SimdLevel::NUM_LEVELS; ++i) {
+    EXPECT_EQ(i, SimdLevel::parse(SimdLevel::toString((SimdLevel::Constants) i)));
+  }
+  EXPECT_EQ(SimdLevel::AVX2, SimdLevel::parse("AVX2"));
+  EXPECT_EQ(SimdLevel::SSE42, SimdLevel::parse("1"));
+  EXPECT_EQ(-1, SimdLevel::parse("4"));
+  EXPECT_EQ(-1, SimdLevel::parse("neon"));
+  EXPECT_EQ(0U, SimdLevel::requiredFeatures(SimdLevel::SCALAR));
+  uint64_t sse42 = SimdLevel::requiredFeatures(SimdLevel::SSE42);
+  uint64_t avx2 = SimdLevel::requiredFeatures(SimdLevel::AVX2);
+  uint64_t avx512 = SimdLevel::requiredFeatures(SimdLevel::AVX512);
+  EXPECT_EQ(sse42, avx2 & sse42);
+  EXPECT_EQ(avx2, avx512 & avx2);
+  EXPECT_NE(avx2, avx512);
+}
+
+TEST_F(MultiversionTS, caseCountCharAllLevels)
+{
+  std::vector<char> buf(1000);
+  srandom(20261019);
+  for (size_t i = 0; i < buf.size(); ++i) {
+    buf[i] = "ab\n\xff"[random() % 4];
+  }
+  const char needles[] = { 'a', '\n', '\xff', 'z' };
+
+  for (int level = SimdLevel::SCALAR; level <= HardwareInfo::simdLevel(); ++level) {
+    MultiversionBase::limitLevel((SimdLevel::Constants) level);
+    ASSERT_EQ(level, MultiversionBase::level());
+    // every length and alignment around the vector widths
+    for (size_t offset = 0; offset < 70; offset += 3) {
+      for (size_t len = 0; len + offset <= 300; ++len) {
+        for (size_t k = 0; k < sizeof(needles); ++k) {
+          size_t expected = 0;
+          for (size_t j = 0; j < len; ++j) {
+            expected += buf[offset + j] == needles[k];
+          }
+          ASSERT_EQ(expected, String::countChar(&buf[offset], len, needles[k]))
+              << SimdLevel::toString((SimdLevel::Constants) level) << " offset " << offset << " len " << len;
+        }
+      }
+    }
+    EXPECT_EQ((size_t) 0, String::countChar(NULL, 0, 'a'));
+  }
+}
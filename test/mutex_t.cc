@@ -24,8 +24,11 @@
  * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <sched.h>
+#include <string.h>
 #include <gtest/gtest.h>
 #include "nebula/mutex.h"
+#include "nebula/thread.h"
 
 using nebula::Mutex;
 
@@ -53,3 +56,257 @@ TEST_F(MutexTS, caseSimple)
   EXPECT_FALSE(mutex_.try_lock());
   mutex_.unlock();
 }
+
+template<typename LockType>
+class Incrementer: public nebula::Thread
+{
+private:
+  LockType * lock_;
+  volatile long * counter_;
+  int num_iterations_;
+
+public:
+  Incrementer() :
+    lock_(NULL), counter_(NULL), num_iterations_(0)
+  {
+  }
+
+  void setup(LockType * lock, volatile long * counter, int num_iterations)
+  {
+    lock_ = lock;
+    counter_ = counter;
+    num_iterations_ = num_iterations;
+  }
+
+  void * routine()
+  {
+    for (int i = 0; i < num_iterations_; ++i) {
+      nebula::ScopedLock<LockType> guard(*lock_);
+      // not atomic, lost updates show up if mutual exclusion is broken
+      *counter_ = *counter_ + 1;
+    }
+    return NULL;
+  }
+};
+
+template<typename LockType>
+static void checkTryLock(LockType * lock)
+{
+  lock->lock();
+  EXPECT_FALSE(lock->try_lock());
+  lock->unlock();
+
+  EXPECT_TRUE(lock->try_lock());
+  EXPECT_FALSE(lock->try_lock());
+  lock->unlock();
+  {
+    nebula::ScopedLock<LockType> guard(*lock);
+    EXPECT_FALSE(lock->try_lock());
+  }
+  EXPECT_TRUE(lock->try_lock());
+  lock->unlock();
+}
+
+template<typename LockType>
+static void checkContended(LockType * lock, int num_threads = 8, int num_iterations = 20000)
+{
+  volatile long counter = 0;
+  Incrementer<LockType> * threads = new Incrementer<LockType> [num_threads];
+  for (int i = 0; i < num_threads; ++i) {
+    threads[i].setup(lock, &counter, num_iterations);
+    ASSERT_EQ(0, threads[i].create());
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    threads[i].join();
+  }
+  delete[] threads;
+  EXPECT_EQ((long) num_threads * num_iterations, counter);
+}
+
+TEST_F(MutexTS, caseContended)
+{
+  checkContended(&mutex_);
+}
+
+TEST(AdaptiveMutexTS, caseSimple)
+{
+  nebula::AdaptiveMutex lock;
+  checkTryLock(&lock);
+  checkContended(&lock);
+  nebula::AdaptiveMutex no_spin(0);
+  checkContended(&no_spin);
+}
+
+TEST(SpinLockTS, caseSimple)
+{
+  nebula::SpinLock lock;
+  checkTryLock(&lock);
+  checkContended(&lock);
+}
+
+TEST(TicketLockTS, caseSimple)
+{
+  nebula::TicketLock lock;
+  checkTryLock(&lock);
+  checkContended(&lock);
+}
+
+struct Pair
+{
+  long a;
+  long b;
+};
+
+class PairWriter: public nebula::Thread
+{
+private:
+  nebula::DistributedRWLock * lock_;
+  Pair * pair_;
+  int num_iterations_;
+
+public:
+  PairWriter(nebula::DistributedRWLock * lock, Pair * pair, int num_iterations) :
+    lock_(lock), pair_(pair), num_iterations_(num_iterations)
+  {
+  }
+
+  void * routine()
+  {
+    for (int i = 0; i < num_iterations_; ++i) {
+      nebula::ScopedLock<nebula::DistributedRWLock> guard(*lock_);
+      ++pair_->a;
+      sched_yield();
+      ++pair_->b;
+    }
+    return NULL;
+  }
+};
+
+class PairReader: public nebula::Thread
+{
+private:
+  nebula::DistributedRWLock * lock_;
+  Pair * pair_;
+  volatile int * stop_;
+
+public:
+  long inconsistent_;
+  long reads_;
+
+  PairReader(nebula::DistributedRWLock * lock = NULL, Pair * pair = NULL, volatile int * stop = NULL) :
+    lock_(lock), pair_(pair), stop_(stop), inconsistent_(0), reads_(0)
+  {
+  }
+
+  void * routine()
+  {
+    while (!__atomic_load_n(stop_, __ATOMIC_RELAXED)) {
+      nebula::ScopedSharedLock guard(*lock_);
+      if (pair_->a != pair_->b) {
+        ++inconsistent_;
+      }
+      ++reads_;
+    }
+    return NULL;
+  }
+};
+
+TEST(DistributedRWLockTS, caseReadersAndWriters)
+{
+  nebula::DistributedRWLock lock;
+  Pair pair =
+  { 0, 0 };
+  volatile int stop = 0;
+
+  int slot = lock.lockShared();
+  int slot2 = lock.lockShared(); // shared mode is recursive
+  lock.unlockShared(slot2);
+  lock.unlockShared(slot);
+
+  PairReader readers[4] =
+  { PairReader(&lock, &pair, &stop), PairReader(&lock, &pair, &stop), PairReader(&lock, &pair, &stop), PairReader(
+      &lock, &pair, &stop) };
+  PairWriter writer1(&lock, &pair, 500), writer2(&lock, &pair, 500);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, readers[i].create());
+  }
+  ASSERT_EQ(0, writer1.create());
+  ASSERT_EQ(0, writer2.create());
+  writer1.join();
+  writer2.join();
+  __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+  for (int i = 0; i < 4; ++i) {
+    readers[i].join();
+    EXPECT_EQ(0, readers[i].inconsistent_);
+  }
+  EXPECT_EQ(1000, pair.a);
+  EXPECT_EQ(1000, pair.b);
+}
+
+struct Snapshot
+{
+  long values[5];
+  char tag;
+};
+
+class SnapshotReader: public nebula::Thread
+{
+private:
+  nebula::SeqLock<Snapshot> * lock_;
+  volatile int * stop_;
+
+public:
+  long inconsistent_;
+
+  SnapshotReader(nebula::SeqLock<Snapshot> * lock, volatile int * stop) :
+    lock_(lock), stop_(stop), inconsistent_(0)
+  {
+  }
+
+  void * routine()
+  {
+    Snapshot s;
+    while (!__atomic_load_n(stop_, __ATOMIC_RELAXED)) {
+      lock_->read(&s);
+      for (int i = 1; i < 5; ++i) {
+        if (s.values[i] != s.values[0]) {
+          ++inconsistent_;
+        }
+      }
+      if (s.tag != (char) s.values[0]) {
+        ++inconsistent_;
+      }
+    }
+    return NULL;
+  }
+};
+
+TEST(SeqLockTS, caseSnapshots)
+{
+  Snapshot init;
+  memset(&init, 0, sizeof(init));
+  nebula::SeqLock<Snapshot> lock(init);
+  EXPECT_EQ(0, lock.read().values[4]);
+
+  volatile int stop = 0;
+  SnapshotReader reader1(&lock, &stop), reader2(&lock, &stop);
+  ASSERT_EQ(0, reader1.create());
+  ASSERT_EQ(0, reader2.create());
+  Snapshot s;
+  for (long v = 1; v <= 20000; ++v) {
+    for (int i = 0; i < 5; ++i) {
+      s.values[i] = v;
+    }
+    s.tag = (char) v;
+    lock.write(s);
+    if (v % 100 == 0) {
+      sched_yield(); // let readers run on a single processor
+    }
+  }
+  __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+  reader1.join();
+  reader2.join();
+  EXPECT_EQ(0, reader1.inconsistent_);
+  EXPECT_EQ(0, reader2.inconsistent_);
+  EXPECT_EQ(20000, lock.read().values[3]);
+}
@@ -0,0 +1,252 @@
+/*
+ * object_pool_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <set>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "nebula/object_pool.h"
+#include "nebula/ring_buffer.h"
+
+using nebula::ObjectPool;
+using nebula::ObjectPoolStats;
+using nebula::SlabPool;
+
+namespace
+{
+  struct Connection
+  {
+    static int live;
+    int fd;
+    std::string peer;
+    char buffer[100];
+
+    Connection() :
+      fd(-1)
+    {
+      __atomic_add_fetch(&live, 1, __ATOMIC_RELAXED);
+    }
+
+    ~Connection()
+    {
+      __atomic_sub_fetch(&live, 1, __ATOMIC_RELAXED);
+    }
+  };
+
+  int Connection::live = 0;
+
+  const int TRANSFERS = 200000;
+
+  struct Transfer
+  {
+    ObjectPool<Connection> * pool;
+    nebula::SpscRing<Connection *> * ring;
+  };
+
+  void * produce(void * arg)
+  {
+    Transfer * t = (Transfer *) arg;
+    for (int i = 0; i < TRANSFERS; ++i) {
+      Connection * c = t->pool->create();
+      c->fd = i;
+      while (!t->ring->push(c)) {
+        sched_yield();
+      }
+    }
+    return NULL;
+  }
+
+  void * consume(void * arg)
+  {
+    Transfer * t = (Transfer *) arg;
+    for (int i = 0; i < TRANSFERS; ++i) {
+      Connection * c;
+      while (!t->ring->pop(&c)) {
+        sched_yield();
+      }
+      EXPECT_EQ(i, c->fd);
+      t->pool->destroy(c);
+    }
+    return NULL;
+  }
+
+  struct Leftover
+  {
+    SlabPool * pool;
+    std::vector<void *> kept;
+  };
+
+  void * allocateAndExit(void * arg)
+  {
+    Leftover * l = (Leftover *) arg;
+    std::vector<void *> blocks;
+    for (int i = 0; i < 1000; ++i) {
+      blocks.push_back(l->pool->allocate());
+    }
+    for (int i = 0; i < 1000; ++i) {
+      if (i % 2) {
+        l->pool->free(blocks[i]);
+      }
+      else {
+        l->kept.push_back(blocks[i]);
+      }
+    }
+    return NULL;
+  }
+}
+
+class ObjectPoolTS: public testing::Test
+{
+};
+
+TEST_F(ObjectPoolTS, caseSingleThread)
+{
+  SlabPool pool(20, 8);
+  ASSERT_EQ(0, pool.init(0, 4096));
+  errno = 0;
+  EXPECT_EQ(-1, pool.init());
+  EXPECT_EQ(EINVAL, errno);
+  EXPECT_EQ(24u, pool.objectSize());
+
+  std::set<char *> seen;
+  std::vector<char *> blocks;
+  for (int i = 0; i < 10000; ++i) {
+    char * p = (char *) pool.allocate();
+    ASSERT_TRUE(p != NULL);
+    ASSERT_EQ(0u, (uintptr_t) p % 8);
+    ASSERT_TRUE(seen.insert(p).second);
+    memset(p, i & 0xff, 20);
+    blocks.push_back(p);
+  }
+  for (int i = 0; i < 10000; ++i) {
+    ASSERT_EQ((char) (i & 0xff), blocks[i][19]);
+  }
+
+  ObjectPoolStats s = pool.stats();
+  EXPECT_EQ(10000u, s.live_objects);
+  EXPECT_EQ(1u, s.threads);
+  size_t slabs = s.slabs;
+  EXPECT_GE(slabs * 4096, 10000u * 24);
+
+  for (int i = 0; i < 10000; ++i) {
+    pool.free(blocks[i]);
+  }
+  s = pool.stats();
+  EXPECT_EQ(0u, s.live_objects);
+  EXPECT_GT(s.depot_objects, 0u);
+
+  // freed blocks are reused, no new slab
+  for (int i = 0; i < 10000; ++i) {
+    ASSERT_TRUE(seen.count((char *) pool.allocate()));
+  }
+  EXPECT_EQ(slabs, pool.stats().slabs);
+}
+
+TEST_F(ObjectPoolTS, caseObjects)
+{
+  ObjectPool<Connection> pool;
+  ASSERT_EQ(0, pool.init());
+  std::vector<Connection *> all;
+  for (int i = 0; i < 1000; ++i) {
+    Connection * c = pool.create();
+    ASSERT_TRUE(c != NULL);
+    EXPECT_EQ(0u, (uintptr_t) c % __alignof__(Connection));
+    EXPECT_EQ(-1, c->fd);
+    c->peer = "a peer name longer than the small string buffer";
+    all.push_back(c);
+  }
+  EXPECT_EQ(1000, Connection::live);
+  for (size_t i = 0; i < all.size(); ++i) {
+    pool.destroy(all[i]);
+  }
+  EXPECT_EQ(0, Connection::live);
+  EXPECT_EQ(0u, pool.stats().live_objects);
+}
+
+TEST_F(ObjectPoolTS, caseCrossThreadFree)
+{
+  ObjectPool<Connection> pool;
+  ASSERT_EQ(0, pool.init());
+  nebula::SpscRing<Connection *> ring;
+  ASSERT_EQ(0, ring.init(1024));
+  Transfer t = { &pool, &ring };
+
+  pthread_t producer, consumer;
+  ASSERT_EQ(0, pthread_create(&producer, NULL, produce, &t));
+  ASSERT_EQ(0, pthread_create(&consumer, NULL, consume, &t));
+  pthread_join(producer, NULL);
+  pthread_join(consumer, NULL);
+
+  ObjectPoolStats s = pool.stats();
+  EXPECT_EQ(0u, s.live_objects);
+  EXPECT_EQ(0, Connection::live);
+  // both threads exited, every block is back in the depot
+  EXPECT_EQ(0u, s.threads);
+  // the consumer's magazines went back to the producer through the depot,
+  // which bounds the memory to what was in flight, not what was allocated
+  EXPECT_LT(s.slab_bytes, TRANSFERS * sizeof(Connection) / 4);
+}
+
+TEST_F(ObjectPoolTS, caseThreadExit)
+{
+  SlabPool pool(64, 64);
+  ASSERT_EQ(0, pool.init());
+  Leftover l;
+  l.pool = &pool;
+  pthread_t tid;
+  ASSERT_EQ(0, pthread_create(&tid, NULL, allocateAndExit, &l));
+  pthread_join(tid, NULL);
+
+  ObjectPoolStats s = pool.stats();
+  EXPECT_EQ(0u, s.threads);
+  EXPECT_EQ(500u, s.live_objects);
+  EXPECT_GE(s.depot_objects, 500u);
+
+  for (size_t i = 0; i < l.kept.size(); ++i) {
+    EXPECT_EQ(0u, (uintptr_t) l.kept[i] % 64);
+    pool.free(l.kept[i]);
+  }
+  s = pool.stats();
+  EXPECT_EQ(1u, s.threads);
+  EXPECT_EQ(0u, s.live_objects);
+}
+
+TEST_F(ObjectPoolTS, caseHugePages)
+{
+  SlabPool pool(256, 16);
+  ASSERT_EQ(0, pool.init(SlabPool::HUGE_PAGES, 4096));
+  void * p = pool.allocate();
+  ASSERT_TRUE(p != NULL);
+  memset(p, 0, 256);
+  ObjectPoolStats s = pool.stats();
+  EXPECT_EQ(1u, s.slabs);
+  EXPECT_EQ((size_t) SlabPool::HUGE_PAGE_SIZE, s.slab_bytes);
+  pool.free(p);
+}
@@ -24,11 +24,23 @@
  * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
 #include <stdio.h>
+#include <algorithm>
+#include <vector>
 #include <gtest/gtest.h>
+#include "nebula/multiversion.h"
 #include "nebula/random.h"
 
+using nebula::HardwareInfo;
+using nebula::LibcPrng;
+using nebula::MultiversionBase;
+using nebula::Pcg32;
 using nebula::Prng;
+using nebula::SimdLevel;
+using nebula::SplitMix64;
+using nebula::Xoshiro256ss;
+using nebula::Xoshiro256x8;
 
 class RandomTS: public testing::Test
 {
@@ -56,3 +68,241 @@ TEST_F(RandomTS, caseSimple)
     printf("rand u64: 0x%016lx\n", prng.randomU64());
   }
 }
+
+TEST_F(RandomTS, caseReferenceValues)
+{
+  SplitMix64 sm(0);
+  EXPECT_EQ(0xe220a8397b1dcdafULL, sm.randomU64());
+  EXPECT_EQ(0x6e789e6aa1b965f4ULL, sm.randomU64());
+
+  const uint64_t state[4] = { 1, 2, 3, 4 };
+  Xoshiro256ss x;
+  x.setState(state);
+  EXPECT_EQ(11520U, x.randomU64());
+  EXPECT_EQ(0U, x.randomU64());
+  EXPECT_EQ(0x5a007080ULL, x.randomU64());
+
+  x.setState(state);
+  x.jump();
+  EXPECT_EQ(0xbbd2f312298443d8ULL, x.randomU64());
+  EXPECT_EQ(0x62e57db2d5706577ULL, x.randomU64());
+  x.setState(state);
+  x.longJump();
+  EXPECT_EQ(0x527752a1d792704dULL, x.randomU64());
+
+  // seeded through SplitMix64
+  Xoshiro256ss seeded(1);
+  EXPECT_EQ(0xb3f2af6d0fc710c5ULL, seeded.randomU64());
+  Prng prng(1);
+  EXPECT_EQ(0xb3f2af6d0fc710c5ULL, prng.randomU64());
+
+  // pcg32-demo, pcg32_srandom(42, 54)
+  Pcg32 pcg(42, 54);
+  const uint32_t expected[] = { 0xa15c02b7, 0x7b47f409, 0xba1d3330, 0x83d2f293, 0xbfa4784b, 0xcbed606e };
+  for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+    EXPECT_EQ(expected[i], pcg.randomU32()) << i;
+  }
+}
+
+TEST_F(RandomTS, caseStreams)
+{
+  // jump() gives a stream which does not start with the same values
+  Xoshiro256ss a(2026);
+  Xoshiro256ss b(a);
+  b.jump();
+  std::vector<uint64_t> first;
+  for (int i = 0; i < 1000; ++i) {
+    first.push_back(a.randomU64());
+  }
+  for (int i = 0; i < 1000; ++i) {
+    uint64_t v = b.randomU64();
+    EXPECT_TRUE(std::find(first.begin(), first.end(), v) == first.end());
+  }
+
+  // advance() equals drawing
+  Pcg32 p(7, 3);
+  Pcg32 q(7, 3);
+  for (int i = 0; i < 12345; ++i) {
+    (void) p.randomU32();
+  }
+  q.advance(12345);
+  EXPECT_EQ(p.randomU32(), q.randomU32());
+
+  Pcg32 other_stream(7, 4);
+  Pcg32 same_stream(7, 3);
+  EXPECT_NE(same_stream.randomU64(), other_stream.randomU64());
+
+  // reproducible
+  Prng c(99);
+  Prng d(98);
+  d.initialize(99);
+  EXPECT_EQ(c.randomU64(), d.randomU64());
+}
+
+template<typename G>
+static void checkBitBalance(G & g, const char * name)
+{
+  // every bit is set in about half of the draws: n = 100000, sigma = 158
+  const int n = 100000;
+  int ones[64] = { 0 };
+  for (int i = 0; i < n; ++i) {
+    uint64_t v = g.randomU64();
+    for (int b = 0; b < 64; ++b) {
+      ones[b] += (v >> b) & 1;
+    }
+  }
+  for (int b = 0; b < 64; ++b) {
+    EXPECT_NEAR(n / 2, ones[b], 1000) << name << " bit " << b;
+  }
+}
+
+template<typename G>
+static void checkUniform(G & g, const char * name)
+{
+  // chi-square of nextBelow(10), 9 degrees of freedom, p = 0.001 at 27.88
+  const int n = 100000;
+  int counts[10] = { 0 };
+  for (int i = 0; i < n; ++i) {
+    uint32_t v = g.nextBelow(10);
+    ASSERT_LT(v, 10U);
+    ++counts[v];
+  }
+  double chi2 = 0;
+  for (int i = 0; i < 10; ++i) {
+    double d = counts[i] - n / 10.0;
+    chi2 += d * d / (n / 10.0);
+  }
+  EXPECT_LT(chi2, 27.88) << name;
+
+  // bias of the modulo method: 3 * 2^30 values, `% n' would draw the lower
+  // third twice as often as the rest
+  int lower = 0;
+  for (int i = 0; i < n; ++i) {
+    lower += g.nextBelow(3U << 30) < (1U << 30);
+  }
+  EXPECT_NEAR(n / 3, lower, 1000) << name;
+
+  double sum = 0;
+  for (int i = 0; i < n; ++i) {
+    double d = g.nextDouble();
+    ASSERT_GE(d, 0.0);
+    ASSERT_LT(d, 1.0);
+    sum += d;
+  }
+  // mean of U(0,1) is 1/2, sigma of the mean is 1 / sqrt(12 n) < 0.001
+  EXPECT_NEAR(0.5, sum / n, 0.005) << name;
+
+  for (int i = 0; i < 1000; ++i) {
+    float f = g.nextFloat();
+    ASSERT_GE(f, 0.0f);
+    ASSERT_LT(f, 1.0f);
+    ASSERT_LT(g.nextBelow64(1000000000000ULL), 1000000000000ULL);
+    int64_t r = g.nextInRange(-5, 5);
+    ASSERT_GE(r, -5);
+    ASSERT_LE(r, 5);
+  }
+  EXPECT_EQ(0U, g.nextBelow(1));
+}
+
+TEST_F(RandomTS, caseStatistics)
+{
+  Prng prng(12345);
+  SplitMix64 sm(12345);
+  Pcg32 pcg(12345);
+  LibcPrng libc(12345);
+
+  checkBitBalance(prng, "xoshiro256**");
+  checkBitBalance(sm, "splitmix64");
+  checkBitBalance(pcg, "pcg32");
+  checkUniform(prng, "xoshiro256**");
+  checkUniform(sm, "splitmix64");
+  checkUniform(pcg, "pcg32");
+  checkUniform(libc, "random_r");
+}
+
+TEST_F(RandomTS, caseBulkFill)
+{
+  // reference: 8 independent xoshiro256** seeded from consecutive SplitMix64 outputs, interleaved
+  const uint64_t seed = 31337;
+  Xoshiro256ss lanes[Xoshiro256x8::LANES];
+  SplitMix64 sm(seed);
+  for (int k = 0; k < Xoshiro256x8::LANES; ++k) {
+    uint64_t state[4];
+    for (int w = 0; w < 4; ++w) {
+      state[w] = sm.randomU64();
+    }
+    lanes[k].setState(state);
+  }
+  // calls of 3, 64, 0, 1000 and 61 values consume 1, 8, 0, 125 and 8 steps
+  const size_t sizes[] = { 3, 64, 0, 1000, 61 };
+  std::vector<std::vector<uint64_t> > expected;
+  for (size_t c = 0; c < sizeof(sizes) / sizeof(sizes[0]); ++c) {
+    std::vector<uint64_t> values;
+    size_t steps = (sizes[c] + Xoshiro256x8::LANES - 1) / Xoshiro256x8::LANES;
+    for (size_t i = 0; i < steps * Xoshiro256x8::LANES; ++i) {
+      uint64_t v = lanes[i % Xoshiro256x8::LANES].randomU64();
+      if (i < sizes[c]) {
+        values.push_back(v);
+      }
+    }
+    expected.push_back(values);
+  }
+
+  SimdLevel::Constants saved = MultiversionBase::levelLimit();
+  for (int level = SimdLevel::SCALAR; level <= HardwareInfo::simdLevel(); ++level) {
+    MultiversionBase::limitLevel((SimdLevel::Constants) level);
+    SCOPED_TRACE(SimdLevel::toString((SimdLevel::Constants) level));
+
+    Xoshiro256x8 bulk(seed);
+    for (size_t c = 0; c < expected.size(); ++c) {
+      // unaligned destination, guard values after the end
+      std::vector<char> buf(sizes[c] * sizeof(uint64_t) + 1 + 8, 'x');
+      bulk.fill(&buf[1], sizes[c] * sizeof(uint64_t));
+      for (size_t i = 0; i < sizes[c]; ++i) {
+        uint64_t v;
+        memcpy(&v, &buf[1 + i * sizeof(v)], sizeof(v));
+        ASSERT_EQ(expected[c][i], v) << "call " << c << " value " << i;
+      }
+      EXPECT_EQ('x', buf[0]);
+      EXPECT_EQ('x', buf[buf.size() - 8]);
+    }
+
+    // partial values
+    Xoshiro256x8 bytes(seed);
+    char three[3];
+    bytes.fill(three, sizeof(three));
+    EXPECT_EQ(0, memcmp(three, &expected[0][0], sizeof(three)));
+
+    // the same for every level
+    Prng prng(5);
+    std::vector<uint32_t> u32(10000);
+    prng.fillU32(&u32[0], u32.size());
+    Prng again(5);
+    Xoshiro256x8 inner(again.randomU64());
+    std::vector<uint32_t> reference(u32.size());
+    inner.fillU32(&reference[0], reference.size());
+    EXPECT_TRUE(u32 == reference);
+  }
+  MultiversionBase::limitLevel(saved);
+
+  // small fills draw from the Prng itself
+  Prng small(8);
+  uint64_t v[4];
+  small.fillU64(v, 4);
+  Prng check(8);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(check.randomU64(), v[i]);
+  }
+
+  // bit balance of a large fill
+  std::vector<uint64_t> values(100000);
+  Xoshiro256x8 stats(1);
+  stats.fillU64(&values[0], values.size());
+  for (int b = 0; b < 64; b += 7) {
+    int ones = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+      ones += (values[i] >> b) & 1;
+    }
+    EXPECT_NEAR(50000, ones, 1000) << "bit " << b;
+  }
+}
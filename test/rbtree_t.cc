@@ -0,0 +1,205 @@
+/*
+ * rbtree_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "nebula/rbtree.h"
+
+using nebula::RbNode;
+using nebula::RbTree;
+
+namespace
+{
+  struct Item
+  {
+    int key;
+    int id;
+    RbNode by_key;
+    std::string name;
+    RbNode by_name;
+  };
+
+  typedef RbTree<Item, int, &Item::key, &Item::by_key> ItemsByKey;
+  typedef RbTree<Item, std::string, &Item::name, &Item::by_name, std::greater<std::string> > ItemsByNameDesc;
+}
+
+class RbTreeTS: public testing::Test
+{
+};
+
+TEST_F(RbTreeTS, caseSimple)
+{
+  ItemsByKey tree;
+  EXPECT_TRUE(tree.empty());
+  EXPECT_TRUE(tree.first() == NULL);
+  EXPECT_TRUE(tree.last() == NULL);
+  EXPECT_TRUE(tree.begin() == tree.end());
+  EXPECT_EQ(1, tree.verify()); // the NULL leaves
+
+  std::vector<Item> items(10);
+  const int keys[] = { 50, 20, 80, 20, 10, 90, 60, 20, 70, 30 };
+  for (int i = 0; i < 10; ++i) {
+    items[i].key = keys[i];
+    items[i].id = i;
+    tree.insert(&items[i]);
+    ASSERT_LT(0, tree.verify());
+  }
+  EXPECT_EQ(10U, tree.size());
+  EXPECT_EQ(10, tree.first()->key);
+  EXPECT_EQ(90, tree.last()->key);
+
+  // in order, equal keys in insertion order
+  const int expected_ids[] = { 4, 1, 3, 7, 9, 0, 6, 8, 2, 5 };
+  int i = 0;
+  for (ItemsByKey::Iterator it = tree.begin(); it != tree.end(); ++it, ++i) {
+    EXPECT_EQ(expected_ids[i], it->id);
+  }
+  EXPECT_EQ(10, i);
+  i = 9;
+  for (Item * p = tree.last(); p; p = ItemsByKey::prev(p), --i) {
+    EXPECT_EQ(expected_ids[i], p->id);
+  }
+
+  EXPECT_EQ(1, tree.find(20)->id);
+  EXPECT_TRUE(tree.find(25) == NULL);
+  EXPECT_EQ(1, tree.lowerBound(20)->id);
+  EXPECT_EQ(9, tree.upperBound(20)->id);
+  EXPECT_EQ(9, tree.lowerBound(21)->id);
+  EXPECT_EQ(4, tree.lowerBound(-5)->id);
+  EXPECT_TRUE(tree.lowerBound(91) == NULL);
+  EXPECT_TRUE(tree.upperBound(90) == NULL);
+
+  Item dup;
+  dup.key = 60;
+  EXPECT_EQ(&items[6], tree.insertUnique(&dup));
+  dup.key = 65;
+  EXPECT_EQ(&dup, tree.insertUnique(&dup));
+  EXPECT_EQ(11U, tree.size());
+  EXPECT_EQ(&dup, ItemsByKey::next(&items[6]));
+  tree.erase(&dup);
+
+  // deadline queue
+  int last = -1;
+  while (Item * p = tree.popFirst()) {
+    EXPECT_LE(last, p->key);
+    last = p->key;
+    ASSERT_LE(0, tree.verify());
+  }
+  EXPECT_TRUE(tree.empty());
+}
+
+TEST_F(RbTreeTS, caseTwoTrees)
+{
+  ItemsByKey by_key;
+  ItemsByNameDesc by_name;
+  std::vector<Item> items(26);
+  for (int i = 0; i < 26; ++i) {
+    items[i].key = (i * 7) % 26;
+    items[i].name = std::string(1, 'a' + i);
+    by_key.insert(&items[i]);
+    by_name.insert(&items[i]);
+  }
+  EXPECT_EQ("z", by_name.first()->name);
+  EXPECT_EQ("y", ItemsByNameDesc::next(by_name.first())->name);
+  EXPECT_EQ(0, by_key.first()->key);
+  EXPECT_EQ(&items[0], by_key.first());
+
+  by_key.erase(&items[0]);
+  EXPECT_EQ(1, by_key.first()->key);
+  EXPECT_EQ(26U, by_name.size());
+  EXPECT_EQ(&items[0], by_name.last());
+  EXPECT_EQ(&items[2], by_name.lowerBound("c"));
+  EXPECT_EQ(&items[1], by_name.upperBound("c"));
+}
+
+TEST_F(RbTreeTS, caseRandomAgainstMultimap)
+{
+  const int n = 2000;
+  std::vector<Item> items(n);
+  std::vector<bool> in_tree(n, false);
+  ItemsByKey tree;
+  std::multimap<int, int> reference;
+  srandom(43);
+
+  for (int op = 0; op < 50000; ++op) {
+    int i = random() % n;
+    if (!in_tree[i]) {
+      items[i].key = random() % 500;
+      items[i].id = i;
+      tree.insert(&items[i]);
+      reference.insert(std::make_pair(items[i].key, i));
+      in_tree[i] = true;
+    }
+    else {
+      tree.erase(&items[i]);
+      std::multimap<int, int>::iterator it = reference.lower_bound(items[i].key);
+      while (it->second != i) {
+        ++it;
+      }
+      reference.erase(it);
+      in_tree[i] = false;
+    }
+    if (op % 1000 == 0) {
+      ASSERT_LT(0, tree.verify()) << op;
+    }
+
+    int k = random() % 520 - 10;
+    Item * lb = tree.lowerBound(k);
+    std::multimap<int, int>::iterator rlb = reference.lower_bound(k);
+    ASSERT_EQ(rlb == reference.end(), lb == NULL);
+    if (lb) {
+      ASSERT_EQ(rlb->first, lb->key);
+    }
+    Item * ub = tree.upperBound(k);
+    std::multimap<int, int>::iterator rub = reference.upper_bound(k);
+    ASSERT_EQ(rub == reference.end(), ub == NULL);
+    if (ub) {
+      ASSERT_EQ(rub->first, ub->key);
+    }
+  }
+
+  ASSERT_EQ(reference.size(), tree.size());
+  ASSERT_LT(0, tree.verify());
+  std::multimap<int, int>::iterator rit = reference.begin();
+  for (ItemsByKey::Iterator it = tree.begin(); it != tree.end(); ++it, ++rit) {
+    ASSERT_EQ(rit->first, it->key);
+  }
+  EXPECT_TRUE(rit == reference.end());
+
+  // height stays logarithmic: black height >= log2(n + 1) / 2
+  ItemsByKey sorted;
+  std::vector<Item> seq(100000);
+  for (size_t i = 0; i < seq.size(); ++i) {
+    seq[i].key = i;
+    sorted.insert(&seq[i]);
+  }
+  int black_height = sorted.verify();
+  EXPECT_LE(8, black_height);
+  EXPECT_GE(17, black_height);
+}
@@ -0,0 +1,298 @@
+/*
+ * ring_buffer_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sched.h>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "nebula/ring_buffer.h"
+#include "nebula/thread.h"
+
+using nebula::SpscByteRing;
+using nebula::SpscRing;
+using nebula::Thread;
+
+namespace
+{
+  struct Counted
+  {
+    static int alive;
+    int value;
+
+    Counted(int v = 0) :
+      value(v)
+    {
+      ++alive;
+    }
+
+    Counted(const Counted & other) :
+      value(other.value)
+    {
+      ++alive;
+    }
+
+    ~Counted()
+    {
+      --alive;
+    }
+  };
+
+  int Counted::alive = 0;
+
+  class RingProducer: public Thread
+  {
+  public:
+    SpscRing<uint64_t> * ring_;
+    uint64_t count_;
+    size_t batch_;
+
+    void * routine()
+    {
+      std::vector<uint64_t> items(batch_);
+      uint64_t next = 0;
+      while (next < count_) {
+        size_t n = 0;
+        for (; n < batch_ && next + n < count_; ++n) {
+          items[n] = next + n;
+        }
+        size_t pushed = ring_->pushBatch(&items[0], n);
+        if (!pushed) {
+          sched_yield();
+        }
+        next += pushed;
+      }
+      return NULL;
+    }
+  };
+
+  class ByteProducer: public Thread
+  {
+  public:
+    SpscByteRing * ring_;
+    size_t total_;
+
+    void * routine()
+    {
+      size_t written = 0;
+      unsigned seed = 1;
+      while (written < total_) {
+        size_t len;
+        char * p = ring_->reserve(1, &len);
+        if (!p) {
+          sched_yield();
+          continue;
+        }
+        // random chunk sizes, so that regions wrap around at every offset
+        size_t chunk = rand_r(&seed) % 5000 + 1;
+        if (chunk > len) {
+          chunk = len;
+        }
+        if (chunk > total_ - written) {
+          chunk = total_ - written;
+        }
+        for (size_t i = 0; i < chunk; ++i) {
+          p[i] = (char) ((written + i) * 131);
+        }
+        ring_->commit(chunk);
+        written += chunk;
+      }
+      return NULL;
+    }
+  };
+}
+
+class RingBufferTS: public testing::Test
+{
+};
+
+TEST_F(RingBufferTS, caseSingleThread)
+{
+  SpscRing<int> ring;
+  EXPECT_EQ(0, ring.init(5));
+  EXPECT_EQ(8U, ring.capacity());
+  EXPECT_EQ(-1, ring.init(8));
+  EXPECT_TRUE(ring.empty());
+
+  int v;
+  EXPECT_FALSE(ring.pop(&v));
+  EXPECT_TRUE(ring.front() == NULL);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(ring.push(i));
+  }
+  EXPECT_FALSE(ring.push(8));
+  EXPECT_EQ(8U, ring.size());
+  EXPECT_TRUE(ring.pop(&v));
+  EXPECT_EQ(0, v);
+  EXPECT_EQ(1, *ring.front());
+  ring.popFront();
+
+  // batches wrap around
+  int items[8] = { 10, 11, 12, 13, 14, 15, 16, 17 };
+  EXPECT_EQ(2U, ring.pushBatch(items, 8));
+  int out[16];
+  EXPECT_EQ(8U, ring.popBatch(out, 16));
+  EXPECT_EQ(2, out[0]);
+  EXPECT_EQ(7, out[5]);
+  EXPECT_EQ(11, out[7]);
+  EXPECT_TRUE(ring.empty());
+  for (int round = 0; round < 100; ++round) {
+    ASSERT_EQ(5U, ring.pushBatch(items, 5));
+    ASSERT_EQ(3U, ring.popBatch(out, 3));
+    ASSERT_EQ(10, out[0]);
+    ASSERT_EQ(2U, ring.popBatch(out, 3));
+    ASSERT_EQ(14, out[1]);
+  }
+
+  SpscRing<int> bad;
+  EXPECT_EQ(-1, bad.init(0));
+  EXPECT_EQ(EINVAL, errno);
+}
+
+TEST_F(RingBufferTS, caseElementLifetime)
+{
+  Counted::alive = 0;
+  {
+    SpscRing<Counted> ring;
+    ASSERT_EQ(0, ring.init(4));
+    EXPECT_EQ(0, Counted::alive);
+    ring.push(Counted(1));
+    ring.push(Counted(2));
+    ring.push(Counted(3));
+    EXPECT_EQ(3, Counted::alive);
+    Counted c;
+    EXPECT_TRUE(ring.pop(&c));
+    EXPECT_EQ(1, c.value);
+    EXPECT_EQ(3, Counted::alive); // two in the ring, plus `c'
+  }
+  EXPECT_EQ(0, Counted::alive);
+}
+
+TEST_F(RingBufferTS, caseTwoThreads)
+{
+  const uint64_t count = 2000000;
+  const size_t batches[] = { 1, 7, 64 };
+  for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); ++b) {
+    SpscRing<uint64_t> ring;
+    ASSERT_EQ(0, ring.init(1024));
+    RingProducer producer;
+    producer.ring_ = &ring;
+    producer.count_ = count;
+    producer.batch_ = batches[b];
+    ASSERT_EQ(0, producer.create());
+
+    uint64_t expected = 0;
+    uint64_t out[100];
+    while (expected < count) {
+      size_t n = ring.popBatch(out, batches[b] * 3 % 100 + 1);
+      if (!n) {
+        sched_yield();
+      }
+      for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(expected, out[i]);
+        ++expected;
+      }
+    }
+    EXPECT_EQ(0, producer.join());
+    EXPECT_TRUE(ring.empty());
+  }
+}
+
+TEST_F(RingBufferTS, caseByteRingMirror)
+{
+  SpscByteRing ring;
+  ASSERT_EQ(0, ring.init(100));
+  size_t capacity = ring.capacity();
+  EXPECT_EQ(0U, capacity & (capacity - 1));
+  EXPECT_LE((size_t) sysconf(_SC_PAGESIZE), capacity);
+
+  // move the indexes close to the end of the buffer
+  std::string filler(capacity - 10, 'f');
+  EXPECT_EQ(filler.size(), ring.write(filler.data(), filler.size()));
+  std::vector<char> sink(capacity);
+  EXPECT_EQ(filler.size(), ring.read(&sink[0], sink.size()));
+
+  // a region crossing the end is still contiguous
+  size_t len;
+  char * w = ring.reserve(100, &len);
+  ASSERT_TRUE(w != NULL);
+  EXPECT_EQ(capacity, len);
+  for (int i = 0; i < 100; ++i) {
+    w[i] = 'a' + i % 26;
+  }
+  ring.commit(100);
+  EXPECT_EQ(100U, ring.size());
+  EXPECT_TRUE(ring.reserve(capacity, &len) == NULL);
+
+  const char * r = ring.peek(100, &len);
+  ASSERT_TRUE(r != NULL);
+  EXPECT_EQ(100U, len);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ('a' + i % 26, r[i]) << i;
+  }
+  EXPECT_TRUE(ring.peek(101, &len) == NULL);
+  ring.consume(60);
+  char rest[64];
+  EXPECT_EQ(40U, ring.read(rest, sizeof(rest)));
+  EXPECT_EQ('a' + 60 % 26, rest[0]);
+  EXPECT_EQ(0U, ring.read(rest, sizeof(rest)));
+
+  // full
+  std::string big(capacity + 5, 'b');
+  EXPECT_EQ(capacity, ring.write(big.data(), big.size()));
+  EXPECT_EQ(0U, ring.write("x", 1));
+}
+
+TEST_F(RingBufferTS, caseByteRingTwoThreads)
+{
+  SpscByteRing ring;
+  ASSERT_EQ(0, ring.init(16384));
+  ByteProducer producer;
+  producer.ring_ = &ring;
+  producer.total_ = 20 << 20;
+  ASSERT_EQ(0, producer.create());
+
+  size_t received = 0;
+  unsigned seed = 2;
+  while (received < producer.total_) {
+    size_t len;
+    const char * p = ring.peek(1, &len);
+    if (!p) {
+      sched_yield();
+      continue;
+    }
+    size_t chunk = rand_r(&seed) % 7000 + 1;
+    if (chunk > len) {
+      chunk = len;
+    }
+    for (size_t i = 0; i < chunk; ++i) {
+      ASSERT_EQ((char) ((received + i) * 131), p[i]) << received + i;
+    }
+    ring.consume(chunk);
+    received += chunk;
+  }
+  EXPECT_EQ(0, producer.join());
+  EXPECT_EQ(0U, ring.size());
+}
@@ -0,0 +1,278 @@
+/*
+ * stream_reader_t.cc
+ *
+ *  Created on: Oct 19, 2026
+ *  Author:     Brian Y. ZHANG
+ *  Email:      brianlions at gmail dot com
+ */
+/*
+ * Copyright (c) 2011 Brian Yi ZHANG <brianlions at gmail dot com>
+ *
+ * This file is part of libnebula.
+ *
+ * libnebula is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnebula is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+#include "nebula/stream_reader.h"
+#include "nebula/text_file_parser.h"
+#include "nebula/thread.h"
+
+using nebula::StreamReader;
+using nebula::TextFileParser;
+using nebula::Tokens;
+
+class StreamReaderTS: public testing::Test
+{
+protected:
+  char fname_[64];
+  std::string contents_;
+  std::vector<std::string> lines_;
+
+  virtual void SetUp()
+  {
+    // short, empty and long lines, the last one is not terminated by '\n'
+    lines_.push_back("first line");
+    lines_.push_back("");
+    lines_.push_back(std::string(100, 'x'));
+    lines_.push_back("a b\tc");
+    lines_.push_back(std::string(37, 'y'));
+    lines_.push_back("last");
+    for (size_t i = 0; i < lines_.size(); ++i) {
+      contents_ += lines_[i];
+      if (i + 1 < lines_.size()) {
+        contents_ += "\n";
+      }
+    }
+    fname_[0] = '\0';
+  }
+
+  virtual void TearDown()
+  {
+    if (fname_[0]) {
+      unlink(fname_);
+    }
+  }
+
+  void createPlainFile()
+  {
+    strcpy(fname_, "testsuite_StreamReader_XXXXXX");
+    int fd = mkstemp(fname_);
+    ASSERT_TRUE(fd >= 0);
+    ASSERT_EQ((ssize_t) contents_.size(), write(fd, contents_.data(), contents_.size()));
+    close(fd);
+  }
+
+#ifdef USE_ZLIB
+  void createGzipFile(int num_members)
+  {
+    strcpy(fname_, "testsuite_StreamReader_XXXXXX");
+    int fd = mkstemp(fname_);
+    ASSERT_TRUE(fd >= 0);
+    close(fd);
+    // gzip members may simply be concatenated
+    size_t step = contents_.size() / num_members + 1;
+    for (size_t off = 0; off < contents_.size(); off += step) {
+      gzFile gz = gzopen(fname_, "ab");
+      ASSERT_TRUE(gz != NULL);
+      size_t len = std::min(step, contents_.size() - off);
+      ASSERT_EQ((int) len, gzwrite(gz, contents_.data() + off, (unsigned) len));
+      gzclose(gz);
+    }
+  }
+#endif
+
+  void expectLines(StreamReader & reader)
+  {
+    char * line;
+    ssize_t length;
+    size_t idx = 0;
+    while ((length = reader.readLine(&line)) >= 0) {
+      ASSERT_TRUE(idx < lines_.size());
+      EXPECT_EQ((size_t) length, lines_[idx].size());
+      EXPECT_STREQ(line, lines_[idx].c_str());
+      ++idx;
+    }
+    EXPECT_EQ(0, reader.error());
+    EXPECT_EQ(idx, lines_.size());
+  }
+};
+
+TEST_F(StreamReaderTS, casePlainFile)
+{
+  createPlainFile();
+  size_t buffer_sizes[] =
+  { 16, 33, 4096 };
+  int flags[] =
+  { StreamReader::SR_NONE, StreamReader::SR_READ_AHEAD, StreamReader::SR_READ_AHEAD | StreamReader::SR_DECOMPRESS };
+  for (size_t i = 0; i < sizeof(buffer_sizes) / sizeof(buffer_sizes[0]); ++i) {
+    for (size_t j = 0; j < sizeof(flags) / sizeof(flags[0]); ++j) {
+      StreamReader reader(buffer_sizes[i]);
+      ASSERT_EQ(0, reader.open(fname_, flags[j]));
+      expectLines(reader);
+      EXPECT_FALSE(reader.isCompressed());
+      EXPECT_STREQ(reader.name(), fname_);
+    }
+  }
+}
+
+TEST_F(StreamReaderTS, caseReadChunk)
+{
+  createPlainFile();
+  StreamReader reader(16);
+  ASSERT_EQ(0, reader.open(fname_));
+  std::string all;
+  const char * data;
+  ssize_t length;
+  while ((length = reader.readChunk(&data)) > 0) {
+    EXPECT_TRUE(length <= 16);
+    all.append(data, length);
+  }
+  EXPECT_EQ(0, length);
+  EXPECT_EQ(all, contents_);
+}
+
+TEST_F(StreamReaderTS, caseOpenFailure)
+{
+  StreamReader reader;
+  EXPECT_EQ(-1, reader.open("/nonexistent/testsuite_StreamReader"));
+  char * line;
+  EXPECT_EQ(-1, reader.readLine(&line));
+
+  // an owned descriptor is closed when attach() fails
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  EXPECT_EQ(-1, reader.attach(fds[0], 0x100, true));
+  EXPECT_EQ(EINVAL, errno);
+  EXPECT_EQ(-1, fcntl(fds[0], F_GETFD));
+  close(fds[1]);
+}
+
+#ifdef USE_ZLIB
+TEST_F(StreamReaderTS, caseGzipFile)
+{
+  ASSERT_TRUE(StreamReader::hasDecompressionSupport());
+  createGzipFile(3);
+  size_t buffer_sizes[] =
+  { 16, 4096 };
+  for (size_t i = 0; i < sizeof(buffer_sizes) / sizeof(buffer_sizes[0]); ++i) {
+    StreamReader reader(buffer_sizes[i]);
+    ASSERT_EQ(0, reader.open(fname_, StreamReader::SR_DECOMPRESS));
+    expectLines(reader);
+    EXPECT_TRUE(reader.isCompressed());
+
+    ASSERT_EQ(0, reader.open(fname_, StreamReader::SR_DECOMPRESS | StreamReader::SR_READ_AHEAD));
+    expectLines(reader);
+    EXPECT_TRUE(reader.isCompressed());
+  }
+
+  // not decompressed unless asked to
+  StreamReader reader;
+  ASSERT_EQ(0, reader.open(fname_, StreamReader::SR_NONE));
+  const char * data;
+  ASSERT_TRUE(reader.readChunk(&data) > 2);
+  EXPECT_EQ(0x1f, (unsigned char) data[0]);
+  EXPECT_EQ(0x8b, (unsigned char) data[1]);
+}
+
+TEST_F(StreamReaderTS, caseTruncatedGzipFile)
+{
+  createGzipFile(1);
+  ASSERT_EQ(0, truncate(fname_, 20));
+  StreamReader reader;
+  ASSERT_EQ(0, reader.open(fname_));
+  char * line;
+  while (reader.readLine(&line) >= 0) {
+  }
+  EXPECT_NE(0, reader.error());
+}
+#endif
+
+class PipeWriter: public nebula::Thread
+{
+private:
+  int fd_;
+  const std::string * contents_;
+
+public:
+  PipeWriter(int fd, const std::string * contents) :
+    fd_(fd), contents_(contents)
+  {
+
+  }
+
+  void * routine()
+  {
+    // write in small pieces so that the reader sees partial lines
+    for (size_t off = 0; off < contents_->size(); off += 7) {
+      size_t len = std::min((size_t) 7, contents_->size() - off);
+      if (write(fd_, contents_->data() + off, len) != (ssize_t) len) {
+        break;
+      }
+    }
+    close(fd_);
+    return NULL;
+  }
+};
+
+TEST_F(StreamReaderTS, casePipe)
+{
+  int flags[] =
+  { StreamReader::SR_NONE, StreamReader::SR_READ_AHEAD };
+  for (size_t j = 0; j < sizeof(flags) / sizeof(flags[0]); ++j) {
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    PipeWriter writer(fds[1], &contents_);
+    ASSERT_EQ(0, writer.create());
+    StreamReader reader(32);
+    ASSERT_EQ(0, reader.attach(fds[0], flags[j], true));
+    expectLines(reader);
+    writer.join();
+  }
+}
+
+TEST_F(StreamReaderTS, caseCloseWhileBlocked)
+{
+  // the read-ahead thread is blocked in read(), close() must not hang
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  StreamReader reader;
+  ASSERT_EQ(0, reader.attach(fds[0], StreamReader::SR_READ_AHEAD, true));
+  reader.close();
+  close(fds[1]);
+}
+
+static int countTokens(const char * filename, uint64_t line_num, const Tokens * tokens, void * arg)
+{
+  *(uint32_t *) arg += tokens->numOfTokens();
+  return 0;
+}
+
+TEST_F(StreamReaderTS, caseTextFileParser)
+{
+  createPlainFile();
+  StreamReader reader(16);
+  ASSERT_EQ(0, reader.open(fname_));
+  uint32_t num_tokens = 0;
+  TextFileParser parser;
+  EXPECT_EQ(0, parser.parseLineByLine(&reader, countTokens, &num_tokens));
+  EXPECT_EQ((uint32_t) 8, num_tokens);
+}
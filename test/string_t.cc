@@ -23,6 +23,7 @@
  * You should have received a copy of the GNU General Public License
  * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <stdio.h>
 #include <gtest/gtest.h>
 #include "nebula/string.h"
 
@@ -60,3 +61,117 @@ TEST_F(StringTS, caseUpperLower)
   EXPECT_STREQ("abcdefgxyz123", String::toLowerCase(s));
   EXPECT_STREQ("ABCDEFGXYZ123", String::toUpperCase(s));
 }
+
+static String::ParseResult::Constants parseI64(const char * s, int64_t * out, bool parse_suffix = false)
+{
+  return String::parseI64(s, strlen(s), out, parse_suffix);
+}
+
+static String::ParseResult::Constants parseU64(const char * s, uint64_t * out, bool parse_suffix = false)
+{
+  return String::parseU64(s, strlen(s), out, parse_suffix);
+}
+
+static String::ParseResult::Constants parseDouble(const char * s, double * out)
+{
+  return String::parseDouble(s, strlen(s), out);
+}
+
+TEST_F(StringTS, caseParseInteger)
+{
+  int64_t i = 0;
+  uint64_t u = 0;
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseI64("0", &i));
+  EXPECT_EQ(i, 0);
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseI64("-1234567890123", &i));
+  EXPECT_EQ(i, -1234567890123L);
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseI64("+00000000000000000000042", &i));
+  EXPECT_EQ(i, 42);
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseI64("9223372036854775807", &i));
+  EXPECT_EQ(i, INT64_MAX);
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseI64("-9223372036854775808", &i));
+  EXPECT_EQ(i, INT64_MIN);
+  EXPECT_EQ(String::ParseResult::OUT_OF_RANGE, parseI64("9223372036854775808", &i));
+  EXPECT_EQ(String::ParseResult::OUT_OF_RANGE, parseI64("-9223372036854775809", &i));
+  EXPECT_EQ(i, INT64_MIN); // untouched on failure
+
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseU64("18446744073709551615", &u));
+  EXPECT_EQ(u, UINT64_MAX);
+  EXPECT_EQ(String::ParseResult::OUT_OF_RANGE, parseU64("18446744073709551616", &u));
+  EXPECT_EQ(String::ParseResult::OUT_OF_RANGE, parseU64("123456789012345678901234567890", &u));
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseU64("1234567812345678", &u));
+  EXPECT_EQ(u, 1234567812345678UL);
+
+  EXPECT_EQ(String::ParseResult::EMPTY_INPUT, parseI64("", &i));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseI64("-", &i));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseI64(" 1", &i));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseI64("1 ", &i));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseI64("12345678a", &i));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseU64("-1", &u));
+
+  // only the first `len' bytes are examined
+  EXPECT_EQ(String::ParseResult::SUCCESS, String::parseU64("12345678901", 4, &u));
+  EXPECT_EQ(u, 1234UL);
+
+  // every length, so that both the SWAR and the scalar paths are exercised
+  char buf[32];
+  uint64_t expected = 0;
+  for (int len = 1; len <= 19; ++len) {
+    expected = expected * 10 + (len % 10);
+    snprintf(buf, sizeof(buf), "%lu", expected);
+    EXPECT_EQ(String::ParseResult::SUCCESS, parseU64(buf, &u));
+    EXPECT_EQ(u, expected);
+  }
+}
+
+TEST_F(StringTS, caseParseIntegerSuffix)
+{
+  int64_t i = 0;
+  uint64_t u = 0;
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseI64("4K", &i));
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseI64("4K", &i, true));
+  EXPECT_EQ(i, 4096);
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseI64("-3k", &i, true));
+  EXPECT_EQ(i, -3000);
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseU64("2M", &u, true));
+  EXPECT_EQ(u, 2UL << 20);
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseU64("2m", &u, true));
+  EXPECT_EQ(u, 2000000UL);
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseU64("5G", &u, true));
+  EXPECT_EQ(u, 5UL << 30);
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseU64("5g", &u, true));
+  EXPECT_EQ(u, 5000000000UL);
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseU64("5GB", &u, true));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseU64("K", &u, true));
+  EXPECT_EQ(String::ParseResult::OUT_OF_RANGE, parseU64("18446744073709551615k", &u, true));
+  EXPECT_EQ(String::ParseResult::OUT_OF_RANGE, parseI64("9000000000000000g", &i, true));
+}
+
+TEST_F(StringTS, caseParseDouble)
+{
+  const char * inputs[] =
+  { "0", "-0.5", "3.1415926", "1e10", "1E-5", "+2.5e+3", ".25", "7.", "123456789.123456789",
+    "0.000000000000000000001", "1.7976931348623157e308", "2.2250738585072014e-308", "4.9e-324",
+    "12345678901234567890123", "1e-400" };
+  double d = 0;
+  for (size_t k = 0; k < sizeof(inputs) / sizeof(inputs[0]); ++k) {
+    EXPECT_EQ(String::ParseResult::SUCCESS, parseDouble(inputs[k], &d)) << inputs[k];
+    EXPECT_EQ(d, strtod(inputs[k], NULL)) << inputs[k];
+  }
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseDouble("inf", &d));
+  EXPECT_TRUE(d > 1e308);
+  EXPECT_EQ(String::ParseResult::SUCCESS, parseDouble("-NaN", &d));
+  EXPECT_TRUE(d != d);
+
+  EXPECT_EQ(String::ParseResult::EMPTY_INPUT, parseDouble("", &d));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseDouble(".", &d));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseDouble("1e", &d));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseDouble("1.5x", &d));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseDouble("1,5", &d));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseDouble(" 1.5", &d));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseDouble("\n-1.5", &d));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseDouble(" inf", &d));
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, parseDouble("1.5 ", &d));
+  EXPECT_EQ(String::ParseResult::OUT_OF_RANGE, parseDouble("1e400", &d));
+  EXPECT_EQ(String::ParseResult::OUT_OF_RANGE, parseDouble("-1e400", &d));
+}
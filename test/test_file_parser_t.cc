@@ -29,6 +29,7 @@
 #include "nebula/string.h"
 
 using nebula::String;
+using nebula::DelimiterTable;
 using nebula::Tokens;
 using nebula::TextFileParser;
 
@@ -93,6 +94,89 @@ TEST_F(TextFileParserTS, caseSplitLineEmptyLine)
   EXPECT_TRUE(tokens_.numOfTokens() == 0);
 }
 
+TEST_F(TextFileParserTS, caseSplitLineTokenLength)
+{
+  tokens_.splitString(line, "\t; ");
+  EXPECT_TRUE(tokens_.numOfTokens() == 4);
+  for (uint32_t i = 0; i < tokens_.numOfTokens(); ++i) {
+    EXPECT_EQ(strlen(tokens_.token(i)), tokens_.tokenLength(i));
+  }
+  EXPECT_TRUE(tokens_.token(4) == NULL);
+  EXPECT_TRUE(tokens_.view(4) == NULL);
+}
+
+TEST_F(TextFileParserTS, caseSplitView)
+{
+  DelimiterTable table(" \t\n");
+  tokens_.splitView(line, strlen(line), table);
+  EXPECT_STREQ(line, line_template); // input left untouched
+  EXPECT_TRUE(tokens_.numOfTokens() == 4);
+  EXPECT_TRUE(tokens_.view(0)->equals("abc"));
+  EXPECT_TRUE(tokens_.view(1)->equals("def"));
+  EXPECT_TRUE(tokens_.view(2)->equals("ghi;jkl"));
+  EXPECT_TRUE(tokens_.view(3)->equalsIgnoreCase("abcd"));
+  EXPECT_FALSE(tokens_.view(3)->equals("ABC"));
+  EXPECT_FALSE(tokens_.view(3)->equals("ABCDE"));
+
+  char buf[4];
+  EXPECT_EQ(tokens_.view(2)->copyTo(buf, sizeof(buf)), (size_t) 7);
+  EXPECT_STREQ(buf, "ghi");
+
+  // only the first 5 bytes
+  tokens_.splitView(line, 5, table);
+  EXPECT_TRUE(tokens_.numOfTokens() == 2);
+  EXPECT_TRUE(tokens_.view(0)->equals("abc"));
+  EXPECT_TRUE(tokens_.view(1)->equals("d"));
+}
+
+TEST_F(TextFileParserTS, caseTokenToNumber)
+{
+  const char * input = "42\t-7 4K 2.5 x";
+  DelimiterTable table(" \t");
+  tokens_.splitView(input, strlen(input), table);
+  EXPECT_TRUE(tokens_.numOfTokens() == 5);
+  int64_t i;
+  uint64_t u;
+  double d;
+  EXPECT_EQ(String::ParseResult::SUCCESS, tokens_.view(0)->toU64(&u));
+  EXPECT_EQ(u, (uint64_t) 42);
+  EXPECT_EQ(String::ParseResult::SUCCESS, tokens_.view(1)->toI64(&i));
+  EXPECT_EQ(i, -7);
+  EXPECT_EQ(String::ParseResult::SUCCESS, tokens_.view(2)->toI64(&i, true));
+  EXPECT_EQ(i, 4096);
+  EXPECT_EQ(String::ParseResult::SUCCESS, tokens_.view(3)->toDouble(&d));
+  EXPECT_EQ(d, 2.5);
+  EXPECT_EQ(String::ParseResult::INVALID_FORMAT, tokens_.view(4)->toDouble(&d));
+}
+
+TEST_F(TextFileParserTS, caseDelimiterTable)
+{
+  DelimiterTable table("\t;\xff");
+  EXPECT_TRUE(table.isDelimiter('\t'));
+  EXPECT_TRUE(table.isDelimiter(';'));
+  EXPECT_TRUE(table.isDelimiter(0xff));
+  EXPECT_FALSE(table.isDelimiter(' '));
+  EXPECT_FALSE(table.isDelimiter('\0'));
+  EXPECT_FALSE(table.isEmpty());
+  table.assign("");
+  EXPECT_TRUE(table.isEmpty());
+}
+
+TEST_F(TextFileParserTS, caseSplitManyTokens)
+{
+  Tokens tokens(2);
+  char input[1024];
+  size_t used = 0;
+  for (int i = 0; i < 200; ++i) {
+    used += snprintf(input + used, sizeof(input) - used, "%d ", i);
+  }
+  EXPECT_TRUE(tokens.splitString(input, " "));
+  EXPECT_TRUE(tokens.numOfTokens() == 200);
+  for (uint32_t i = 0; i < tokens.numOfTokens(); ++i) {
+    EXPECT_EQ(atoi(tokens.token(i)), (int) i);
+  }
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 
 class TextFileParserTS2: public testing::Test
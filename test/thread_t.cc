@@ -24,6 +24,11 @@
  * along with libnebula.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <gtest/gtest.h>
 #include "nebula/thread.h"
 
@@ -79,3 +84,91 @@ TEST_F(ThreadTS, caseSimple)
     EXPECT_TRUE(ret == (void *) i);
   }
 }
+
+class Inspector: public Thread
+{
+public:
+  char name_[32];
+  int cpu_;
+  size_t stack_size_;
+  int nice_;
+  int mempolicy_;
+  bool ran_;
+
+  Inspector() :
+    cpu_(-1), stack_size_(0), nice_(0), mempolicy_(-1), ran_(false)
+  {
+    name_[0] = '\0';
+  }
+
+  void * routine()
+  {
+    ran_ = true;
+    pthread_getname_np(pthread_self(), name_, sizeof(name_));
+    cpu_ = sched_getcpu();
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+      pthread_attr_getstacksize(&attr, &stack_size_);
+      pthread_attr_destroy(&attr);
+    }
+    nice_ = getpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid));
+    unsigned long nodes[16];
+    if (syscall(SYS_get_mempolicy, &mempolicy_, nodes, sizeof(nodes) * 8, NULL, 0) < 0) {
+      mempolicy_ = -1;
+    }
+    return NULL;
+  }
+};
+
+TEST_F(ThreadTS, caseSettings)
+{
+  Inspector inspector;
+  EXPECT_EQ(0, inspector.setName("nebula-inspector-thread"));
+  EXPECT_EQ(0, inspector.setStackSize(4 << 20));
+  EXPECT_EQ(0, inspector.setGuardSize(64 << 10));
+  EXPECT_EQ(0, inspector.setAffinity(0));
+  EXPECT_EQ(0, inspector.setNice(5));
+  EXPECT_EQ(0, inspector.setSchedPolicy(SCHED_OTHER));
+  ASSERT_EQ(0, inspector.create());
+  inspector.join();
+  EXPECT_TRUE(inspector.ran_);
+  EXPECT_STREQ("nebula-inspecto", inspector.name_);
+  EXPECT_EQ(0, inspector.cpu_);
+  EXPECT_TRUE(inspector.stack_size_ >= (size_t) (4 << 20));
+  EXPECT_EQ(5, inspector.nice_);
+
+  EXPECT_EQ(EINVAL, inspector.setNice(20));
+  EXPECT_EQ(EINVAL, inspector.setAffinity(-1));
+  EXPECT_EQ(EINVAL, inspector.setNumaNode(-1));
+}
+
+TEST_F(ThreadTS, caseNumaNode)
+{
+  Inspector inspector;
+  EXPECT_EQ(0, inspector.setNumaNode(0));
+  int ec = inspector.create();
+  if (ec == EPERM || ec == ENOSYS) {
+    return; // NUMA policies are not allowed here
+  }
+  ASSERT_EQ(0, ec);
+  inspector.join();
+  EXPECT_TRUE(inspector.ran_);
+  EXPECT_EQ(1, inspector.mempolicy_); // MPOL_PREFERRED
+
+  Inspector absent;
+  EXPECT_EQ(0, absent.setNumaNode(1000));
+  EXPECT_NE(0, absent.create());
+  EXPECT_FALSE(absent.ran_);
+}
+
+TEST_F(ThreadTS, caseRealTimeWithoutPrivilege)
+{
+  Inspector inspector;
+  EXPECT_EQ(0, inspector.setSchedPolicy(SCHED_FIFO, 10));
+  int ec = inspector.create();
+  EXPECT_TRUE(ec == 0 || ec == EPERM);
+  if (!ec) {
+    inspector.join();
+    EXPECT_TRUE(inspector.ran_);
+  }
+}